@@ -0,0 +1,374 @@
+/**
+   @file
+   @ingroup benchmarks
+   @brief time the stages of the tracking pipeline on synthetic data
+
+   Example:
+     pgmlink_benchmark --objects 1000 --timesteps 20 --format json --output result.json
+
+   Every stage is run --repetitions times on freshly generated data (same
+   seed) and reported as one record per stage and repetition.
+*/
+
+// stl
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// boost
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/function.hpp>
+#include <boost/program_options.hpp>
+#include <boost/shared_ptr.hpp>
+
+// vigra
+#include <vigra/multi_array.hxx>
+#include <vigra/random_forest.hxx>
+
+// pgmlink
+#include "pgmlink/arc_features.h"
+#include "pgmlink/event.h"
+#include "pgmlink/feature.h"
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/log.h"
+#include "pgmlink/merger_resolving.h"
+#include "pgmlink/randomforest.h"
+#include "pgmlink/reasoner_constracking.h"
+#include "pgmlink/traxels.h"
+#include "synthetic_traxels.h"
+
+using namespace pgmlink;
+namespace po = boost::program_options;
+
+namespace {
+////
+//// class StageTimer
+////
+class StageTimer {
+ public:
+  StageTimer() : start_(boost::posix_time::microsec_clock::universal_time()) {}
+  double seconds() const {
+    boost::posix_time::time_duration d = boost::posix_time::microsec_clock::universal_time() - start_;
+    return d.total_microseconds() / 1e6;
+  }
+ private:
+  boost::posix_time::ptime start_;
+};
+
+
+struct StageResult {
+  StageResult(const std::string& stage, unsigned int repetition, double seconds, std::size_t items)
+    : stage(stage), repetition(repetition), seconds(seconds), items(items) {}
+  std::string stage;
+  unsigned int repetition;
+  double seconds;
+  std::size_t items; // number of processed elements (traxels, nodes, arcs, ...)
+};
+
+
+struct BenchmarkOptions {
+  benchmark::SyntheticOptions data;
+  unsigned int repetitions;
+  unsigned int max_nearest_neighbors;
+  double distance_threshold;
+  double ep_gap;
+  unsigned int rf_trees;
+  bool with_divisions;
+  bool with_tracklets;
+  bool with_rf;
+  bool with_mergers;
+};
+
+
+std::size_t count_events(const std::vector<std::vector<Event> >& ev) {
+  std::size_t n = 0;
+  for (std::vector<std::vector<Event> >::const_iterator it = ev.begin(); it != ev.end(); ++it) {
+    n += it->size();
+  }
+  return n;
+}
+
+
+void add_arc_distances(HypothesesGraph& g) {
+  g.add(arc_distance()).add(tracklet_intern_dist()).add(node_tracklet()).add(tracklet_intern_arc_ids()).add(traxel_arc_id());
+  compute_arc_features(g);
+}
+
+
+vigra::RandomForest<RF::RF_LABEL_TYPE> train_forest(const TraxelStore& ts, unsigned int n_trees) {
+  const std::size_t n_samples = ts.size();
+  const std::size_t n_features = ts.begin()->features.find("synthetic")->second.size();
+  vigra::MultiArray<2, RF::feature_type> features(RF::matrix_shape(n_samples, n_features));
+  vigra::MultiArray<2, RF::RF_LABEL_TYPE> labels(RF::matrix_shape(n_samples, 1));
+  std::size_t row = 0;
+  for (TraxelStore::const_iterator it = ts.begin(); it != ts.end(); ++it, ++row) {
+    const feature_array& f = it->features.find("synthetic")->second;
+    for (std::size_t col = 0; col < n_features; ++col) {
+      features(row, col) = f[col];
+    }
+    labels(row, 0) = it->features.find("divProb")->second[0] > 0.5 ? 1 : 0;
+  }
+  vigra::RandomForest<RF::RF_LABEL_TYPE> rf(vigra::RandomForestOptions().tree_count(n_trees));
+  rf.learn(features, labels);
+  return rf;
+}
+
+
+void run_once(const BenchmarkOptions& options, unsigned int repetition, std::vector<StageResult>& results) {
+  TraxelStore ts;
+  {
+    StageTimer timer;
+    benchmark::SyntheticStatistics stats = benchmark::generate_synthetic_traxels(ts, options.data);
+    results.push_back(StageResult("generate_synthetic_traxels", repetition, timer.seconds(), stats.n_traxels));
+  }
+
+  if (options.with_rf) {
+    vigra::RandomForest<RF::RF_LABEL_TYPE> rf = train_forest(ts, options.rf_trees);
+    std::vector<std::string> feature_names(1, "synthetic");
+    StageTimer timer;
+    RF::predict_traxels(ts, rf, feature_names, 1, "cellness");
+    results.push_back(StageResult("rf_predict_traxels", repetition, timer.seconds(), ts.size()));
+  }
+
+  boost::shared_ptr<HypothesesGraph> graph;
+  {
+    SingleTimestepTraxel_HypothesesBuilder::Options builder_opts(options.max_nearest_neighbors,
+                                                                 options.distance_threshold,
+                                                                 true, // forward_backward
+                                                                 options.with_divisions,
+                                                                 0.3); // division_threshold
+    SingleTimestepTraxel_HypothesesBuilder builder(&ts, builder_opts);
+    StageTimer timer;
+    graph = boost::shared_ptr<HypothesesGraph>(builder.build());
+    results.push_back(StageResult("hypotheses_builder", repetition, timer.seconds(), lemon::countArcs(*graph)));
+  }
+  {
+    StageTimer timer;
+    add_arc_distances(*graph);
+    results.push_back(StageResult("arc_distances", repetition, timer.seconds(), lemon::countArcs(*graph)));
+  }
+  {
+    HypothesesGraph tracklet_graph;
+    StageTimer timer;
+    std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> > tracklets = generateTrackletGraph2(*graph, tracklet_graph);
+    results.push_back(StageResult("generate_tracklet_graph2", repetition, timer.seconds(), tracklets.size()));
+  }
+
+  {
+    boost::function<double(const Traxel&, const size_t)> detection = NegLnDetection(10);
+    boost::function<double(const Traxel&, const size_t)> division = NegLnDivision(10);
+    boost::function<double(const double)> transition = NegLnTransition(10);
+    ConservationTracking pgm(options.data.max_number_objects,
+                             detection,
+                             division,
+                             transition,
+                             0, // forbidden_cost
+                             options.ep_gap,
+                             options.with_tracklets,
+                             options.with_divisions);
+    StageTimer formulate_timer;
+    pgm.formulate(*graph);
+    results.push_back(StageResult("constracking_formulate", repetition, formulate_timer.seconds(), lemon::countNodes(*graph)));
+    StageTimer infer_timer;
+    pgm.infer();
+    results.push_back(StageResult("constracking_infer", repetition, infer_timer.seconds(), lemon::countNodes(*graph)));
+    StageTimer conclude_timer;
+    pgm.conclude(*graph);
+    results.push_back(StageResult("constracking_conclude", repetition, conclude_timer.seconds(), lemon::countNodes(*graph)));
+  }
+  {
+    StageTimer timer;
+    state_of_nodes(*graph);
+    results.push_back(StageResult("state_of_nodes", repetition, timer.seconds(), lemon::countNodes(*graph)));
+  }
+  {
+    StageTimer timer;
+    prune_inactive(*graph);
+    results.push_back(StageResult("prune_inactive", repetition, timer.seconds(), lemon::countNodes(*graph)));
+  }
+  boost::shared_ptr<std::vector<std::vector<Event> > > ev;
+  {
+    StageTimer timer;
+    ev = events(*graph);
+    results.push_back(StageResult("events", repetition, timer.seconds(), count_events(*ev)));
+  }
+
+  if (options.with_mergers && options.data.max_number_objects > 1) {
+    HypothesesGraph resolved_graph;
+    HypothesesGraph::copy(*graph, resolved_graph);
+    StageTimer gmm_timer;
+    calculate_gmm_beforehand(resolved_graph, 1, 3);
+    results.push_back(StageResult("calculate_gmm_beforehand", repetition, gmm_timer.seconds(), lemon::countNodes(resolved_graph)));
+
+    FeatureExtractorMCOMsFromMCOMs extractor;
+    DistanceFromCOMs distance;
+    FeatureHandlerFromTraxels handler(extractor, distance);
+    MergerResolver m(&resolved_graph);
+    StageTimer resolve_timer;
+    m.resolve_mergers(handler);
+    results.push_back(StageResult("merger_resolver", repetition, resolve_timer.seconds(), lemon::countNodes(resolved_graph)));
+
+    HypothesesGraph g_res;
+    StageTimer graph_timer;
+    resolve_graph(resolved_graph, g_res, NegLnTransition(10), options.ep_gap, false, 5, true);
+    results.push_back(StageResult("resolve_graph", repetition, graph_timer.seconds(), lemon::countNodes(g_res)));
+  }
+
+  {
+    std::stringstream ss;
+    StageTimer timer;
+    {
+      boost::archive::text_oarchive oa(ss);
+      oa << ts;
+    }
+    results.push_back(StageResult("serialize_traxelstore", repetition, timer.seconds(), ss.str().size()));
+  }
+  {
+    std::stringstream ss;
+    StageTimer save_timer;
+    {
+      boost::archive::text_oarchive oa(ss);
+      const HypothesesGraph& g = *graph;
+      oa << g;
+    }
+    results.push_back(StageResult("serialize_hypotheses_graph", repetition, save_timer.seconds(), ss.str().size()));
+    HypothesesGraph loaded;
+    StageTimer load_timer;
+    {
+      boost::archive::text_iarchive ia(ss);
+      ia >> loaded;
+    }
+    results.push_back(StageResult("deserialize_hypotheses_graph", repetition, load_timer.seconds(), lemon::countNodes(loaded)));
+  }
+  {
+    std::stringstream ss;
+    StageTimer timer;
+    {
+      boost::archive::text_oarchive oa(ss);
+      oa << *ev;
+    }
+    results.push_back(StageResult("serialize_events", repetition, timer.seconds(), ss.str().size()));
+  }
+}
+
+
+void write_csv(std::ostream& os, const BenchmarkOptions& options, const std::vector<StageResult>& results) {
+  const benchmark::SyntheticOptions& d = options.data;
+  os << "stage,repetition,seconds,items,n_objects,n_timesteps,motion,division_rate,merger_rate,density,feature_dimension,max_number_objects\n";
+  for (std::vector<StageResult>::const_iterator r = results.begin(); r != results.end(); ++r) {
+    os << r->stage << ',' << r->repetition << ',' << r->seconds << ',' << r->items << ','
+       << d.n_objects << ',' << d.n_timesteps << ',' << d.motion << ',' << d.division_rate << ','
+       << d.merger_rate << ',' << d.density << ',' << d.feature_dimension << ',' << d.max_number_objects << '\n';
+  }
+}
+
+
+void write_json(std::ostream& os, const BenchmarkOptions& options, const std::vector<StageResult>& results) {
+  const benchmark::SyntheticOptions& d = options.data;
+  os << "{\n  \"config\": {"
+     << "\"n_objects\": " << d.n_objects
+     << ", \"n_timesteps\": " << d.n_timesteps
+     << ", \"motion\": \"" << d.motion << '"'
+     << ", \"step_size\": " << d.step_size
+     << ", \"division_rate\": " << d.division_rate
+     << ", \"merger_rate\": " << d.merger_rate
+     << ", \"density\": " << d.density
+     << ", \"feature_dimension\": " << d.feature_dimension
+     << ", \"max_number_objects\": " << d.max_number_objects
+     << ", \"seed\": " << d.seed
+     << ", \"repetitions\": " << options.repetitions
+     << "},\n  \"results\": [";
+  for (std::vector<StageResult>::const_iterator r = results.begin(); r != results.end(); ++r) {
+    os << (r == results.begin() ? "\n" : ",\n")
+       << "    {\"stage\": \"" << r->stage << '"'
+       << ", \"repetition\": " << r->repetition
+       << ", \"seconds\": " << r->seconds
+       << ", \"items\": " << r->items << '}';
+  }
+  os << "\n  ]\n}\n";
+}
+} // anonymous namespace
+
+
+int main(int argc, char** argv) {
+  BenchmarkOptions options;
+  std::string format, output;
+
+  po::options_description desc("pgmlink_benchmark options");
+  desc.add_options()
+      ("help,h", "print this message")
+      ("objects", po::value<unsigned int>(&options.data.n_objects)->default_value(100), "objects in the first frame")
+      ("timesteps", po::value<unsigned int>(&options.data.n_timesteps)->default_value(10), "number of frames")
+      ("motion", po::value<std::string>(&options.data.motion)->default_value("brownian"), "motion model: brownian or constant_velocity")
+      ("step-size", po::value<double>(&options.data.step_size)->default_value(2.0), "standard deviation of the per-frame displacement")
+      ("division-rate", po::value<double>(&options.data.division_rate)->default_value(0.01), "per object and frame division probability")
+      ("merger-rate", po::value<double>(&options.data.merger_rate)->default_value(0.01), "per object and frame merger probability")
+      ("density", po::value<double>(&options.data.density)->default_value(1e-4), "objects per unit volume in the first frame")
+      ("feature-dimension", po::value<unsigned int>(&options.data.feature_dimension)->default_value(16), "length of the synthetic feature vector")
+      ("max-objects", po::value<unsigned int>(&options.data.max_number_objects)->default_value(2), "maximal number of objects per traxel")
+      ("seed", po::value<unsigned int>(&options.data.seed)->default_value(42), "random seed")
+      ("repetitions", po::value<unsigned int>(&options.repetitions)->default_value(1), "number of repetitions")
+      ("neighbors", po::value<unsigned int>(&options.max_nearest_neighbors)->default_value(2), "max nearest neighbors in the hypotheses builder")
+      ("distance-threshold", po::value<double>(&options.distance_threshold)->default_value(20), "distance threshold in the hypotheses builder")
+      ("ep-gap", po::value<double>(&options.ep_gap)->default_value(0.01), "relative optimality gap")
+      ("rf-trees", po::value<unsigned int>(&options.rf_trees)->default_value(10), "trees of the random forest used for prediction")
+      ("without-divisions", "disable division hypotheses")
+      ("with-tracklets", "formulate on the tracklet graph")
+      ("without-rf", "skip the random forest stage")
+      ("without-mergers", "skip the merger resolving stages")
+      ("format", po::value<std::string>(&format)->default_value("csv"), "output format: csv or json")
+      ("output,o", po::value<std::string>(&output), "output file (default: stdout)")
+      ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << "\n" << desc << "\n";
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << "\n";
+    return 0;
+  }
+  if (format != "csv" && format != "json") {
+    std::cerr << "unknown output format: " << format << "\n";
+    return 1;
+  }
+  options.with_divisions = !vm.count("without-divisions");
+  options.with_tracklets = vm.count("with-tracklets") > 0;
+  options.with_rf = !vm.count("without-rf");
+  options.with_mergers = !vm.count("without-mergers");
+
+  std::vector<StageResult> results;
+  try {
+    for (unsigned int r = 0; r < options.repetitions; ++r) {
+      run_once(options, r, results);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "pgmlink_benchmark: " << e.what() << "\n";
+    return 1;
+  }
+
+  std::ofstream ofs;
+  if (!output.empty()) {
+    ofs.open(output.c_str());
+    if (!ofs) {
+      std::cerr << "could not open output file " << output << "\n";
+      return 1;
+    }
+  }
+  std::ostream& os = output.empty() ? std::cout : ofs;
+  if (format == "json") {
+    write_json(os, options, results);
+  } else {
+    write_csv(os, options, results);
+  }
+  return 0;
+}
@@ -0,0 +1,181 @@
+// stl
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// boost
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+
+// pgmlink
+#include "synthetic_traxels.h"
+
+namespace pgmlink {
+namespace benchmark {
+
+namespace {
+struct SyntheticObject {
+  double x, y, z;
+  double vx, vy, vz;
+};
+
+struct EmittedTraxel {
+  std::vector<double> centers; // x,y,z for every merged object
+  bool dividing;
+};
+
+double reflect(double v, double extent) {
+  if (v < 0) {
+    return -v;
+  } else if (v > extent) {
+    return 2*extent - v;
+  }
+  return v;
+}
+} // anonymous namespace
+
+
+////
+//// struct SyntheticOptions
+////
+double SyntheticOptions::extent() const {
+  if (density <= 0) {
+    throw std::runtime_error("SyntheticOptions::extent(): density has to be positive");
+  }
+  return std::pow(n_objects / density, 1./3.);
+}
+
+
+SyntheticStatistics generate_synthetic_traxels(TraxelStore& ts, const SyntheticOptions& options) {
+  if (options.motion != "brownian" && options.motion != "constant_velocity") {
+    throw std::runtime_error("generate_synthetic_traxels(): unknown motion model " + options.motion);
+  }
+  if (options.max_number_objects < 1) {
+    throw std::runtime_error("generate_synthetic_traxels(): max_number_objects has to be at least 1");
+  }
+
+  typedef boost::mt19937 Engine;
+  Engine engine(options.seed);
+  boost::variate_generator<Engine&, boost::uniform_01<> > uniform(engine, boost::uniform_01<>());
+  boost::variate_generator<Engine&, boost::normal_distribution<> > normal(engine, boost::normal_distribution<>(0., 1.));
+
+  const double extent = options.extent();
+  const bool constant_velocity = options.motion == "constant_velocity";
+  SyntheticStatistics stats;
+
+  std::vector<SyntheticObject> objects(options.n_objects);
+  for (std::vector<SyntheticObject>::iterator o = objects.begin(); o != objects.end(); ++o) {
+    o->x = uniform() * extent;
+    o->y = uniform() * extent;
+    o->z = uniform() * extent;
+    o->vx = normal() * options.step_size;
+    o->vy = normal() * options.step_size;
+    o->vz = normal() * options.step_size;
+  }
+
+  for (unsigned int t = 0; t < options.n_timesteps; ++t) {
+    std::vector<EmittedTraxel> emitted;
+    std::vector<SyntheticObject> daughters;
+
+    for (std::vector<SyntheticObject>::iterator o = objects.begin(); o != objects.end(); ++o) {
+      if (t > 0) {
+        if (constant_velocity) {
+          o->x += o->vx + normal() * 0.1 * options.step_size;
+          o->y += o->vy + normal() * 0.1 * options.step_size;
+          o->z += o->vz + normal() * 0.1 * options.step_size;
+        } else {
+          o->x += normal() * options.step_size;
+          o->y += normal() * options.step_size;
+          o->z += normal() * options.step_size;
+        }
+        o->x = reflect(o->x, extent);
+        o->y = reflect(o->y, extent);
+        o->z = reflect(o->z, extent);
+      }
+
+      // merge into a traxel already emitted in this frame
+      if (!emitted.empty() && uniform() < options.merger_rate) {
+        boost::uniform_int<std::size_t> pick(0, emitted.size() - 1);
+        EmittedTraxel& target = emitted[pick(engine)];
+        if (target.centers.size() / 3 < options.max_number_objects) {
+          if (target.centers.size() == 3) {
+            ++stats.n_mergers;
+          }
+          o->x = reflect(target.centers[0] + normal() * 0.5, extent);
+          o->y = reflect(target.centers[1] + normal() * 0.5, extent);
+          o->z = reflect(target.centers[2] + normal() * 0.5, extent);
+          target.centers.push_back(o->x);
+          target.centers.push_back(o->y);
+          target.centers.push_back(o->z);
+          continue;
+        }
+      }
+
+      EmittedTraxel e;
+      e.centers.push_back(o->x);
+      e.centers.push_back(o->y);
+      e.centers.push_back(o->z);
+      e.dividing = t + 1 < options.n_timesteps && uniform() < options.division_rate;
+      emitted.push_back(e);
+
+      if (e.dividing) {
+        ++stats.n_divisions;
+        SyntheticObject daughter = *o;
+        daughter.x = reflect(o->x + normal() * options.step_size, extent);
+        daughter.y = reflect(o->y + normal() * options.step_size, extent);
+        daughter.z = reflect(o->z + normal() * options.step_size, extent);
+        daughters.push_back(daughter);
+      }
+    }
+    objects.insert(objects.end(), daughters.begin(), daughters.end());
+
+    // convert to traxels
+    for (std::size_t i = 0; i < emitted.size(); ++i) {
+      const EmittedTraxel& e = emitted[i];
+      const std::size_t n_merged = e.centers.size() / 3;
+      FeatureMap features;
+
+      feature_array com(3, 0.);
+      for (std::size_t k = 0; k < n_merged; ++k) {
+        for (std::size_t d = 0; d < 3; ++d) {
+          com[d] += e.centers[3*k + d] / n_merged;
+        }
+      }
+      features["com"] = com;
+      features["count"] = feature_array(1, n_merged * options.points_per_object);
+
+      feature_array det_prob(options.max_number_objects + 1, 0.2 / options.max_number_objects);
+      det_prob[n_merged] = 0.8;
+      features["detProb"] = det_prob;
+      features["divProb"] = feature_array(1, e.dividing ? 0.8 : 0.1);
+
+      feature_array coordinates;
+      coordinates.reserve(3 * n_merged * options.points_per_object);
+      for (std::size_t k = 0; k < n_merged; ++k) {
+        for (unsigned int p = 0; p < options.points_per_object; ++p) {
+          for (std::size_t d = 0; d < 3; ++d) {
+            coordinates.push_back(e.centers[3*k + d] + normal());
+          }
+        }
+      }
+      features["coordinates"] = coordinates;
+
+      feature_array synthetic(options.feature_dimension);
+      for (unsigned int d = 0; d < options.feature_dimension; ++d) {
+        synthetic[d] = normal() + ((e.dividing && d < options.feature_dimension / 2) ? 2. : 0.);
+      }
+      features["synthetic"] = synthetic;
+
+      ts.insert(Traxel(i + 1, t, features));
+      ++stats.n_traxels;
+    }
+  }
+  return stats;
+}
+
+} /* namespace benchmark */
+} /* namespace pgmlink */
@@ -0,0 +1,88 @@
+/**
+   @file
+   @ingroup benchmarks
+   @brief synthetic traxel data for benchmarking
+*/
+
+#ifndef SYNTHETIC_TRAXELS_H
+#define SYNTHETIC_TRAXELS_H
+
+// stl
+#include <string>
+#include <vector>
+
+// pgmlink
+#include "pgmlink/traxels.h"
+
+namespace pgmlink {
+namespace benchmark {
+
+////
+//// struct SyntheticOptions
+////
+/**
+ * @brief Parameters of the synthetic traxel generator.
+ *
+ * Objects are placed uniformly in a cube whose side length is chosen such
+ * that n_objects/volume equals density. Each frame every object moves
+ * according to the motion model, divides with probability division_rate
+ * and merges into an already emitted traxel of the same frame with
+ * probability merger_rate.
+ */
+struct SyntheticOptions {
+  SyntheticOptions()
+    : n_objects(100),
+      n_timesteps(10),
+      motion("brownian"),
+      step_size(2.0),
+      division_rate(0.01),
+      merger_rate(0.01),
+      density(1e-4),
+      feature_dimension(16),
+      max_number_objects(2),
+      points_per_object(10),
+      seed(42) {}
+
+  unsigned int n_objects;
+  unsigned int n_timesteps;
+  std::string motion; // "brownian" or "constant_velocity"
+  double step_size;
+  double division_rate;
+  double merger_rate;
+  double density;
+  unsigned int feature_dimension;
+  unsigned int max_number_objects;
+  unsigned int points_per_object;
+  unsigned int seed;
+
+  /** side length of the cube the objects are initially placed in */
+  double extent() const;
+};
+
+
+////
+//// struct SyntheticStatistics
+////
+struct SyntheticStatistics {
+  SyntheticStatistics() : n_traxels(0), n_divisions(0), n_mergers(0) {}
+  unsigned int n_traxels;
+  unsigned int n_divisions;
+  unsigned int n_mergers;
+};
+
+
+/**
+ * @brief Fill ts with synthetic traxels.
+ *
+ * Every traxel carries the features com, count, detProb, divProb,
+ * coordinates (points_per_object pixels per merged object) and a random
+ * feature vector "synthetic" of length feature_dimension. The first
+ * feature_dimension/2 entries of the latter are shifted for dividing
+ * objects so that a classifier can be trained on them.
+ */
+SyntheticStatistics generate_synthetic_traxels(TraxelStore& ts, const SyntheticOptions& options);
+
+} /* namespace benchmark */
+} /* namespace pgmlink */
+
+#endif /* SYNTHETIC_TRAXELS_H */
@@ -0,0 +1,15 @@
+# This module finds the GNU Linear Programming Kit.
+#
+# It sets the following variables:
+#  GLPK_FOUND              - Set to false, or undefined, if glpk isn't found.
+#  GLPK_INCLUDE_DIR        - glpk include directory.
+#  GLPK_LIBRARIES          - glpk library files
+FIND_PATH(GLPK_INCLUDE_DIR glpk.h PATHS /usr/include /usr/local/include ${CMAKE_INCLUDE_PATH} ${CMAKE_PREFIX_PATH}/include $ENV{GLPK_ROOT}/include ENV C_INCLUDE_PATH ENV CPLUS_INCLUDE_PATH)
+FIND_LIBRARY(GLPK_LIBRARIES glpk PATHS $ENV{GLPK_ROOT}/lib ${CMAKE_PREFIX_PATH}/lib ENV LD_LIBRARY_PATH ENV LIBRARY_PATH)
+
+# handle the QUIETLY and REQUIRED arguments and set GLPK_FOUND to TRUE if 
+# all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(GLPK DEFAULT_MSG GLPK_LIBRARIES GLPK_INCLUDE_DIR)
+
+MARK_AS_ADVANCED( GLPK_INCLUDE_DIR GLPK_LIBRARIES )
@@ -0,0 +1,43 @@
+/**
+   @file
+   @ingroup tracking
+   @brief precomputed pairwise features of the arcs of a hypotheses graph
+*/
+
+#ifndef ARC_FEATURES_H
+#define ARC_FEATURES_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "pgmlink/feature_extraction.h"
+#include "pgmlink/graph.h"
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/pgmlink_export.h"
+
+namespace pgmlink {
+
+/**
+ * Pairwise feature stage: compute arc_distance and the arc_features table
+ * (see ArcFeatureTable) for all arcs of the graph in parallel. The table
+ * holds the features of the given extractors, filled by
+ * feature_extraction::PairwiseFeatureExtraction, and records the arcs and
+ * kind of distance computed here.
+ *
+ * arc_distance is the distance between the positions of source and target,
+ * with optical correction of the source position if requested. Reasoners
+ * read the distances from arc_distance instead of recomputing them; the
+ * extractor features are not used by any reasoner yet.
+ */
+PGMLINK_EXPORT void compute_arc_features(
+    HypothesesGraph& g,
+    bool with_optical_correction = false,
+    const std::vector<boost::shared_ptr<feature_extraction::FeatureExtractor> >& extractors =
+    std::vector<boost::shared_ptr<feature_extraction::FeatureExtractor> >());
+
+} /* namespace pgmlink */
+
+#endif /* ARC_FEATURES_H */
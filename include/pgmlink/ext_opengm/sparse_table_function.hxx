@@ -0,0 +1,228 @@
+#pragma once
+#ifndef OPENGM_SPARSETABLEFUNCTION_HXX
+#define OPENGM_SPARSETABLEFUNCTION_HXX
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+#include "opengm/opengm.hxx"
+#include "opengm/functions/function_properties_base.hxx"
+#include "opengm/functions/function_registration.hxx"
+
+namespace opengm {
+
+/// Sparse Table Function
+///
+/// Stores values only for explicitly set labelings and returns a
+/// default value for all other labelings. A labeling is keyed by
+/// its non-zero entries, so memory and lookup cost depend on the
+/// number of set labelings and their number of non-zero labels,
+/// not on the size of the full table.
+///
+/// Suited for factors over many binary variables where only a few
+/// labelings are allowed (e.g. at most two active transitions).
+///
+/// \ingroup functions
+template<class T, class I = size_t, class L = size_t>
+class SparseTableFunction
+  : public FunctionBase<SparseTableFunction<T, I, L>, T, I, L>
+{
+public:
+  typedef T ValueType;
+  typedef I IndexType;
+  typedef L LabelType;
+  /// (position, label) pairs of all non-zero labels in increasing position order
+  typedef std::vector<std::pair<size_t, LabelType> > KeyType;
+  typedef std::map<KeyType, ValueType> EntryMap;
+
+  SparseTableFunction() : default_(0) {}
+  template<class IT>
+  SparseTableFunction(IT shapeBegin, IT shapeEnd, ValueType default_value = 0.);
+
+  template<class ITERATOR> ValueType operator()(ITERATOR) const;
+  template<class ITERATOR> void set(ITERATOR labelingBegin, ValueType v);
+
+  size_t dimension() const { return shape_.size(); }
+  size_t shape(const IndexType i) const { return shape_[i]; }
+  size_t size() const;
+
+  ValueType min() const;
+  ValueType max() const;
+
+  void default_value( const ValueType& v ) { default_ = v; }
+  ValueType default_value() const { return default_; }
+  const EntryMap& entries() const { return entries_; }
+  size_t numberOfEntries() const { return entries_.size(); }
+
+private:
+  template<class ITERATOR> KeyType key(ITERATOR) const;
+
+  std::vector<LabelType> shape_;
+  EntryMap entries_;
+  ValueType default_;
+};
+
+
+
+/**/
+/* implementation */
+/**/
+  template<class T, class I, class L>
+  template<class IT>
+  SparseTableFunction<T,I,L>::SparseTableFunction(IT shapeBegin, IT shapeEnd, ValueType default_value)
+    : shape_(shapeBegin, shapeEnd), default_(default_value) {
+  }
+
+  template<class T, class I, class L>
+  template<class ITERATOR>
+  typename SparseTableFunction<T,I,L>::KeyType SparseTableFunction<T,I,L>::key(ITERATOR begin) const {
+    KeyType k;
+    for(size_t i = 0; i < shape_.size(); ++i, ++begin) {
+      if(*begin != 0) {
+	k.push_back(std::make_pair(i, static_cast<LabelType>(*begin)));
+      }
+    }
+    return k;
+  }
+
+  template<class T, class I, class L>
+  template<class ITERATOR>
+  inline typename SparseTableFunction<T,I,L>::ValueType SparseTableFunction<T,I,L>::operator()(ITERATOR begin) const {
+    typename EntryMap::const_iterator it = entries_.find(key(begin));
+    return it == entries_.end() ? default_ : it->second;
+  }
+
+  template<class T, class I, class L>
+  template<class ITERATOR>
+  inline void SparseTableFunction<T,I,L>::set(ITERATOR begin, ValueType v) {
+    entries_[key(begin)] = v;
+  }
+
+  template<class T, class I, class L>
+  size_t SparseTableFunction<T,I,L>::size() const {
+    if(shape_.empty()) {
+      return 0;
+    }
+    size_t s = 1;
+    for(size_t i = 0; i < shape_.size(); ++i) {
+      s *= shape_[i];
+    }
+    return s;
+  }
+
+  template<class T, class I, class L>
+  typename SparseTableFunction<T,I,L>::ValueType SparseTableFunction<T,I,L>::min() const {
+    ValueType m = default_;
+    bool covered = entries_.size() == size(); // no labeling falls back to the default
+    for(typename EntryMap::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+      if(covered && it == entries_.begin()) {
+	m = it->second;
+      }
+      m = std::min(m, it->second);
+    }
+    return m;
+  }
+
+  template<class T, class I, class L>
+  typename SparseTableFunction<T,I,L>::ValueType SparseTableFunction<T,I,L>::max() const {
+    ValueType m = default_;
+    bool covered = entries_.size() == size();
+    for(typename EntryMap::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+      if(covered && it == entries_.begin()) {
+	m = it->second;
+      }
+      m = std::max(m, it->second);
+    }
+    return m;
+  }
+
+
+/// \cond HIDDEN_SYMBOLS
+/// FunctionRegistration
+template<class T, class I, class L>
+struct FunctionRegistration<SparseTableFunction<T, I, L> > {
+  enum ID { Id = opengm::FUNCTION_TYPE_ID_OFFSET + 201 };
+};
+
+/// FunctionSerialization
+///
+/// index sequence: dimension, shape, number of entries and per entry
+/// the number of non-zero labels followed by (position, label) pairs;
+/// value sequence: default value followed by the entry values
+template<class T, class I, class L>
+class FunctionSerialization<SparseTableFunction<T, I, L> > {
+public:
+  typedef SparseTableFunction<T, I, L> FunctionType;
+  typedef typename FunctionType::ValueType ValueType;
+
+  static size_t indexSequenceSize(const FunctionType&);
+  static size_t valueSequenceSize(const FunctionType&);
+  template<class INDEX_OUTPUT_ITERATOR, class VALUE_OUTPUT_ITERATOR>
+  static void serialize(const FunctionType&, INDEX_OUTPUT_ITERATOR, VALUE_OUTPUT_ITERATOR);
+  template<class INDEX_INPUT_ITERATOR, class VALUE_INPUT_ITERATOR>
+  static void deserialize(INDEX_INPUT_ITERATOR, VALUE_INPUT_ITERATOR, FunctionType&);
+};
+/// \endcond
+
+  template<class T, class I, class L>
+  size_t FunctionSerialization<SparseTableFunction<T,I,L> >::indexSequenceSize(const FunctionType& f) {
+    size_t s = 2 + f.dimension();
+    for(typename FunctionType::EntryMap::const_iterator it = f.entries().begin(); it != f.entries().end(); ++it) {
+      s += 1 + 2 * it->first.size();
+    }
+    return s;
+  }
+
+  template<class T, class I, class L>
+  size_t FunctionSerialization<SparseTableFunction<T,I,L> >::valueSequenceSize(const FunctionType& f) {
+    return 1 + f.numberOfEntries();
+  }
+
+  template<class T, class I, class L>
+  template<class INDEX_OUTPUT_ITERATOR, class VALUE_OUTPUT_ITERATOR>
+  void FunctionSerialization<SparseTableFunction<T,I,L> >::serialize(const FunctionType& f,
+								      INDEX_OUTPUT_ITERATOR indexOutIterator,
+								      VALUE_OUTPUT_ITERATOR valueOutIterator) {
+    *indexOutIterator = f.dimension(); ++indexOutIterator;
+    for(size_t i = 0; i < f.dimension(); ++i) {
+      *indexOutIterator = f.shape(i); ++indexOutIterator;
+    }
+    *indexOutIterator = f.numberOfEntries(); ++indexOutIterator;
+    *valueOutIterator = f.default_value(); ++valueOutIterator;
+    for(typename FunctionType::EntryMap::const_iterator it = f.entries().begin(); it != f.entries().end(); ++it) {
+      *indexOutIterator = it->first.size(); ++indexOutIterator;
+      for(size_t k = 0; k < it->first.size(); ++k) {
+	*indexOutIterator = it->first[k].first; ++indexOutIterator;
+	*indexOutIterator = it->first[k].second; ++indexOutIterator;
+      }
+      *valueOutIterator = it->second; ++valueOutIterator;
+    }
+  }
+
+  template<class T, class I, class L>
+  template<class INDEX_INPUT_ITERATOR, class VALUE_INPUT_ITERATOR>
+  void FunctionSerialization<SparseTableFunction<T,I,L> >::deserialize(INDEX_INPUT_ITERATOR indexInIterator,
+									VALUE_INPUT_ITERATOR valueInIterator,
+									FunctionType& f) {
+    const size_t dim = *indexInIterator; ++indexInIterator;
+    std::vector<size_t> shape(dim);
+    for(size_t i = 0; i < dim; ++i) {
+      shape[i] = *indexInIterator; ++indexInIterator;
+    }
+    const size_t numberOfEntries = *indexInIterator; ++indexInIterator;
+    f = FunctionType(shape.begin(), shape.end(), *valueInIterator); ++valueInIterator;
+    std::vector<size_t> labeling(dim);
+    for(size_t e = 0; e < numberOfEntries; ++e) {
+      std::fill(labeling.begin(), labeling.end(), 0);
+      const size_t nonzero = *indexInIterator; ++indexInIterator;
+      for(size_t k = 0; k < nonzero; ++k) {
+	const size_t position = *indexInIterator; ++indexInIterator;
+	labeling[position] = *indexInIterator; ++indexInIterator;
+      }
+      f.set(labeling.begin(), *valueInIterator); ++valueInIterator;
+    }
+  }
+} // namespace opengm
+
+#endif // #ifndef OPENGM_SPARSETABLEFUNCTION_HXX
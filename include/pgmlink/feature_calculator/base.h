@@ -2,6 +2,7 @@
 #define FEATURE_CALCULATOR_BASE_H
 
 // stl
+#include <cstddef>
 #include <string>
 
 // pgmlink
@@ -22,6 +23,10 @@ class FeatureCalculator {
   virtual feature_array calculate(const feature_array& /* f1 */ ) const;
   virtual feature_array calculate(const feature_array& /* f1 */, const feature_array& /* f2 */) const;
   virtual feature_array calculate(const feature_array& /* f1 */, const feature_array& /* f2 */, const feature_array& /* f3 */) const;
+  // batch interface: write calculate(f1, f2) for two features of the same
+  // size to out, which must hold as many values as calculate() returns.
+  // The default copies the result of calculate().
+  virtual void calculate_into(const feature_type* f1, const feature_type* f2, size_t size, double* out) const;
   virtual const std::string& name() const;
 
   bool operator==(const FeatureCalculator& other);
@@ -20,6 +20,7 @@ class ElementWiseSquaredDistanceCalculator : public FeatureCalculator {
  public:
   virtual ~ElementWiseSquaredDistanceCalculator();
   virtual feature_array calculate(const feature_array& f1, const feature_array& f2) const;
+  virtual void calculate_into(const feature_type* f1, const feature_type* f2, size_t size, double* out) const;
 
   virtual const std::string& name() const;
 
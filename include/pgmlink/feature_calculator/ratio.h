@@ -22,6 +22,7 @@ class RatioCalculator : public FeatureCalculator {
 
   virtual ~RatioCalculator();
   virtual feature_array calculate(const feature_array& f1, const feature_array& f2) const;
+  virtual void calculate_into(const feature_type* f1, const feature_type* f2, size_t size, double* out) const;
   virtual feature_array calculate(const feature_array& f1, const feature_array& f2, const feature_array& f3) const;
   virtual const std::string& name() const;
 };
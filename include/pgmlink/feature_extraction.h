@@ -2,9 +2,11 @@
 #define FEATURE_EXTRACTION_STRATEGY_H
 
 // stl
+#include <cstddef>
 #include <string>
 #include <map>
 #include <utility>
+#include <vector>
 
 // boost
 #include <boost/shared_ptr.hpp>
@@ -32,6 +34,7 @@ class FeatureExtractor
   PGMLINK_EXPORT virtual feature_array extract(const Traxel& t1, const Traxel& t2) const;
   PGMLINK_EXPORT virtual feature_array extract(const Traxel& t1, const Traxel& t2, const Traxel& t3) const;
   PGMLINK_EXPORT boost::shared_ptr<FeatureCalculator> calculator() const;
+  PGMLINK_EXPORT const std::string& feature_name() const;
   PGMLINK_EXPORT virtual std::string name() const;
 
  protected:
@@ -57,6 +60,43 @@ class MultipleFeatureExtraction
 
 
 
+////
+//// class PairwiseFeatureExtraction
+////
+// Batch version of MultipleFeatureExtraction for many traxel pairs: the
+// calculators are resolved once and the features of all pairs are written
+// to a row-major matrix with one row per pair.
+class PairwiseFeatureExtraction
+{
+ public:
+  typedef std::pair<const Traxel*, const Traxel*> TraxelPair;
+
+  PGMLINK_EXPORT explicit PairwiseFeatureExtraction( const MultipleFeatureExtraction::FeatureList& features );
+  PGMLINK_EXPORT explicit PairwiseFeatureExtraction( const std::vector<boost::shared_ptr<FeatureExtractor> >& extractors );
+
+  // fix the columns from the features of a sample pair; returns dimension()
+  PGMLINK_EXPORT size_t set_layout( const Traxel& trax1, const Traxel& trax2 );
+
+  // number of values per pair
+  size_t dimension() const { return offsets_.empty() ? 0 : offsets_.back(); }
+  // the values of feature i are in the columns [offsets()[i], offsets()[i+1])
+  const std::vector<std::string>& names() const { return names_; }
+  const std::vector<size_t>& offsets() const { return offsets_; }
+
+  // out has to hold n * dimension() values; rows of pairs with a NULL traxel
+  // are left untouched. Throws if a feature is missing or differs in size
+  // from the layout.
+  PGMLINK_EXPORT void operator() ( const TraxelPair* pairs, size_t n, double* out ) const;
+
+ private:
+  std::vector<boost::shared_ptr<FeatureCalculator> > calculators_;
+  std::vector<std::string> feature_names_;
+  std::vector<std::string> names_;
+  std::vector<size_t> sizes_;
+  std::vector<size_t> offsets_;
+};
+
+
 ////
 //// helpers
 ////
@@ -7,6 +7,7 @@
 #ifndef FIELD_OF_VIEW_H
 #define FIELD_OF_VIEW_H
 
+#include <cstddef>
 #include <vector>
 #include "pgmlink/pgmlink_export.h"
 
@@ -20,7 +21,9 @@ namespace pgmlink {
    public:
     PGMLINK_EXPORT FieldOfView() 
     : lb_(4, 0), ub_(4, 0)
-    {}
+    {
+      update_faces();
+    }
 
     PGMLINK_EXPORT FieldOfView(double lt,
 		                       double lx,
@@ -59,13 +62,29 @@ namespace pgmlink {
      */
     PGMLINK_EXPORT double spatial_margin( double t, double x, double y, double z ) const;
     PGMLINK_EXPORT double spatial_distance_to_border( double t, double x, double y, double z, bool relative ) const;
+
+    /**
+     * spatial_distance_to_border() of n points given as coordinate arrays.
+     * The result for point i is written to distances[i].
+     */
+    PGMLINK_EXPORT void spatial_distance_to_border( const double* x, const double* y, const double* z, size_t n,
+                                                    bool relative, double* distances ) const;
     
     /** Shortest distance to the temporal boundary of the field of view. */
     PGMLINK_EXPORT double temporal_margin( double t, double x, double y, double z ) const;
 
   private:
+    void update_faces();
+
     std::vector<double> lb_; // lower bound
     std::vector<double> ub_; // upper bound
+
+    // The faces of the spatial cuboid are axis aligned planes. They are
+    // precomputed by set_boundingbox() for spatial_distance_to_border().
+    // In 2d (lz == uz) the z faces are placed at lz and 1 and ignored.
+    double face_ub_z_;    // upper z face
+    double extent_[3];    // extent in x, y and between the z faces
+    bool with_z_faces_;
   };
 
 } /* namespace pgmlink */
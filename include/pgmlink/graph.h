@@ -10,6 +10,7 @@
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <boost/any.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
@@ -27,6 +28,18 @@ namespace pgmlink {
     static const std::string name;
   };
 
+  /**
+   Compile time storage slot of a property
+
+   Properties with a non-negative slot are kept in a vector indexed by the slot
+   and retrieved without looking them up by name. Specialize this for frequently
+   accessed properties; slots have to be unique among the properties of a graph.
+  */
+  template<typename PropertyTag>
+    struct property_slot {
+    static const int value = -1;
+  };
+
   
   
   ////
@@ -40,10 +53,18 @@ namespace pgmlink {
   public:
     typedef Graph base_graph;
 
+    /**
+     * Copy of all properties by name. Use has_property() or properties()
+     * to avoid the copy.
+     */
     std::map<std::string, boost::any> getProperties() const {
 		return properties_;
 	}
 
+    const std::map<std::string, boost::any>& properties() const {
+      return properties_;
+    }
+
     template <typename PropertyTag>
       typename property_map<PropertyTag, Graph>::type &
       get(PropertyTag) const;
@@ -65,11 +86,25 @@ namespace pgmlink {
       PropertyGraph&
       insert(PropertyTag, typename property_map<PropertyTag, Graph>::type*);
 
+    /**
+     * Remove all properties. References to their maps become invalid.
+     */
+    void clear_properties() {
+      properties_.clear();
+      slots_.clear();
+    }
+
     static void copy(PropertyGraph<Graph> &src, PropertyGraph<Graph> &dest);
     
   private:
+    template<typename PropertyTag>
+      void
+      attach(PropertyTag, const boost::shared_ptr<typename property_map<PropertyTag, Graph>::type>&);
+
     typedef std::map<std::string, boost::any> properties_map;  
     properties_map properties_;
+    // properties with a property_slot, indexed by slot
+    std::vector<boost::shared_ptr<void> > slots_;
   };
 
 
@@ -82,14 +117,20 @@ namespace pgmlink {
     template <typename PropertyTag>
     typename property_map<PropertyTag, Graph>::type &
     PropertyGraph<Graph>::get(PropertyTag) const {
-  
-    std::string name = property_map<PropertyTag, Graph>::name;
+    typedef typename property_map<PropertyTag, Graph>::type map_type;
+
+    const int slot = property_slot<PropertyTag>::value;
+    if(slot >= 0 && static_cast<std::size_t>(slot) < slots_.size() && slots_[slot]) {
+      return *static_cast<map_type*>(slots_[slot].get());
+    }
+
+    const std::string& name = property_map<PropertyTag, Graph>::name;
     
     if(properties_.count(name) > 0) {
       // internally, boost::any stores a (stable) pointer to its content
       // therefore, the following cast is safe, even though the std::map guarantees only
       // stability of iterators to elements and not actual memory addresses
-      return *boost::any_cast<boost::shared_ptr<typename property_map<PropertyTag, Graph>::type> >(properties_.find(name)->second);
+      return *boost::any_cast<boost::shared_ptr<map_type> >(properties_.find(name)->second);
     } else {
       throw std::runtime_error("PropertyGraph::get(): property " + name + " not found");
     }
@@ -100,11 +141,12 @@ namespace pgmlink {
     PropertyGraph<Graph> & 
     PropertyGraph<Graph>::add(PropertyTag) {
 
-    std::string name = property_map<PropertyTag, Graph>::name;
+    if(has_property(PropertyTag())) {
+      return *this;
+    }
     // we have to use (shared) ptrs here, because some property maps have private copy constructors
     // and boost::any needs a copy of value during construction 
-    boost::any property = boost::make_shared<typename property_map<PropertyTag, Graph>::type >(*this);
-    properties_.insert(properties_map::value_type(name, property));
+    attach(PropertyTag(), boost::make_shared<typename property_map<PropertyTag, Graph>::type >(*this));
     return *this;
   }
 
@@ -112,7 +154,11 @@ namespace pgmlink {
     template <typename PropertyTag>
     bool 
     PropertyGraph<Graph>::has_property(PropertyTag) const {
-    std::string name = property_map<PropertyTag, Graph>::name;
+    const int slot = property_slot<PropertyTag>::value;
+    if(slot >= 0) {
+      return static_cast<std::size_t>(slot) < slots_.size() && slots_[slot];
+    }
+    const std::string& name = property_map<PropertyTag, Graph>::name;
     return properties_.count(name) ? true : false;
   }
   
@@ -121,11 +167,27 @@ namespace pgmlink {
     PropertyGraph<Graph> &
     PropertyGraph<Graph>::insert(PropertyTag, typename property_map<PropertyTag, Graph>::type* m) {
 
-    std::string name = property_map<PropertyTag, Graph>::name;
-    boost::any property = boost::shared_ptr<typename property_map<PropertyTag, Graph>::type>(m);
-    properties_.insert(properties_map::value_type(name, property));
+    boost::shared_ptr<typename property_map<PropertyTag, Graph>::type> property(m);
+    if(!has_property(PropertyTag())) {
+      attach(PropertyTag(), property);
+    }
     return *this;	
     }
 
+  template <typename Graph>
+    template<typename PropertyTag>
+    void
+    PropertyGraph<Graph>::attach(PropertyTag, const boost::shared_ptr<typename property_map<PropertyTag, Graph>::type>& m) {
+    const std::string& name = property_map<PropertyTag, Graph>::name;
+    properties_.insert(properties_map::value_type(name, boost::any(m)));
+    const int slot = property_slot<PropertyTag>::value;
+    if(slot >= 0) {
+      if(static_cast<std::size_t>(slot) >= slots_.size()) {
+        slots_.resize(slot + 1);
+      }
+      slots_[slot] = m;
+    }
+  }
+
 } /* namespace pgmlink */
 #endif /* GRAPH_H */
@@ -11,9 +11,17 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <cassert>
 #include <map>
 #include <boost/serialization/set.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
+#include <boost/tuple/tuple.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/utility/base_from_member.hpp>
+#include <lemon/adaptors.h>
 #include <lemon/list_graph.h>
 #include <lemon/maps.h>
 
@@ -21,6 +29,7 @@
 #include "pgmlink/graph.h"
 #include "pgmlink/log.h"
 #include "pgmlink/pgmlink_export.h"
+#include "pgmlink/spatial_index.h"
 #include "pgmlink/traxels.h"
 
 namespace pgmlink {
@@ -55,6 +64,10 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   ////
 
   // Properties of a HypothesesGraph
+  //
+  // Properties that are only accessed by node/arc are dense lemon NodeMaps/ArcMaps
+  // (vectors indexed by id). Iterable maps are used where items are looked up by
+  // value (timesteps, activity flags, traxels).
 
   // node_timestep
   struct node_timestep {};
@@ -65,6 +78,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<node_timestep,Graph>::name = "node_timestep";
+  template <>
+    struct property_slot<node_timestep> { static const int value = 0; };
 
   // node_traxel
   struct node_traxel {};
@@ -76,37 +91,58 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<node_traxel,Graph>::name = "node_traxel";
+  template <>
+    struct property_slot<node_traxel> { static const int value = 1; };
+
+  // node_traxel_ref
+  // traxels of a graph built with traxels by reference, see NodeTraxels
+  struct node_traxel_ref {};
+  template <typename Graph>
+    struct property_map<node_traxel_ref, Graph> {
+    typedef typename Graph::template NodeMap< const Traxel* > type;
+    static const std::string name;
+  };
+  template <typename Graph>
+    const std::string property_map<node_traxel_ref,Graph>::name = "node_traxel_ref";
+  template <>
+    struct property_slot<node_traxel_ref> { static const int value = 20; };
 
   // node_traxel
 	struct node_tracklet {};
 	template <typename Graph>
 	  struct property_map<node_tracklet, Graph> {
-	  typedef lemon::IterableValueMap< Graph, typename Graph::Node, std::vector<Traxel> > type;
+	  typedef typename Graph::template NodeMap< std::vector<Traxel> > type;
 	  static const std::string name;
 	};
 	template <typename Graph>
 	  const std::string property_map<node_tracklet,Graph>::name = "node_tracklet";
+	template <>
+	  struct property_slot<node_tracklet> { static const int value = 2; };
 
 
 	// tracklet_arcs
 	struct tracklet_intern_dist {};
 	template <typename Graph>
 	  struct property_map<tracklet_intern_dist, Graph> {
-	  typedef lemon::IterableValueMap< Graph, typename Graph::Node, std::vector<double> > type;
+	  typedef typename Graph::template NodeMap< std::vector<double> > type;
 	  static const std::string name;
 	};
 	template <typename Graph>
 	  const std::string property_map<tracklet_intern_dist,Graph>::name = "tracklet_intern_dist";
+	template <>
+	  struct property_slot<tracklet_intern_dist> { static const int value = 3; };
 
 	// tracklet_arcs
 	struct tracklet_intern_arc_ids {};
 	template <typename Graph>
 	  struct property_map<tracklet_intern_arc_ids, Graph> {
-	  typedef lemon::IterableValueMap< Graph, typename Graph::Node, std::vector<int> > type;
+	  typedef typename Graph::template NodeMap< std::vector<int> > type;
 	  static const std::string name;
 	};
 	template <typename Graph>
 	  const std::string property_map<tracklet_intern_arc_ids,Graph>::name = "tracklet_intern_arc_ids";
+	template <>
+	  struct property_slot<tracklet_intern_arc_ids> { static const int value = 4; };
 
   // node_active
   struct node_active {};
@@ -117,6 +153,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<node_active,Graph>::name = "node_active";
+  template <>
+    struct property_slot<node_active> { static const int value = 5; };
 
   // node_active2
     struct node_active2 {};
@@ -127,6 +165,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
     };
     template <typename Graph>
       const std::string property_map<node_active2,Graph>::name = "node_active2";
+    template <>
+      struct property_slot<node_active2> { static const int value = 6; };
 
   // node_offered
   struct node_offered {};
@@ -137,45 +177,55 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<node_offered,Graph>::name = "node_offered";
+  template <>
+    struct property_slot<node_offered> { static const int value = 7; };
 
   // arc_distance
   struct arc_distance {};
   template <typename Graph>
     struct property_map<arc_distance, Graph> {
-    typedef lemon::IterableValueMap< Graph, typename Graph::Arc, double> type;
+    typedef typename Graph::template ArcMap< double > type;
     static const std::string name;
   };
   template <typename Graph>
     const std::string property_map<arc_distance,Graph>::name = "arc_distance";
+  template <>
+    struct property_slot<arc_distance> { static const int value = 8; };
 
   // traxel_arc_id
   struct traxel_arc_id {};
     template <typename Graph>
       struct property_map<traxel_arc_id, Graph> {
-      typedef lemon::IterableValueMap< Graph, typename Graph::Arc, int> type;
+      typedef typename Graph::template ArcMap< int > type;
       static const std::string name;
     };
     template <typename Graph>
       const std::string property_map<traxel_arc_id,Graph>::name = "traxel_arc_id";
+    template <>
+      struct property_slot<traxel_arc_id> { static const int value = 9; };
 
   struct arc_vol_ratio {};
     template <typename Graph>
       struct property_map<arc_vol_ratio, Graph> {
-      typedef lemon::IterableValueMap< Graph, typename Graph::Arc, double> type;
+      typedef typename Graph::template ArcMap< double > type;
       static const std::string name;
     };
     template <typename Graph>
       const std::string property_map<arc_vol_ratio,Graph>::name = "arc_vol_ratio";
+    template <>
+      struct property_slot<arc_vol_ratio> { static const int value = 10; };
 
   // split_into
   struct split_from {};
   template <typename Graph>
     struct property_map<split_from, Graph> {
-    typedef lemon::IterableValueMap< Graph, typename Graph::Node, int> type;
+    typedef typename Graph::template NodeMap< int > type;
     static const std::string name;
   };
   template <typename Graph>
     const std::string property_map<split_from,Graph>::name = "split_from";
+  template <>
+    struct property_slot<split_from> { static const int value = 11; };
 
   // arc_from_timestep
   struct arc_from_timestep {};
@@ -186,6 +236,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<arc_from_timestep,Graph>::name = "arc_from_timestep";
+  template <>
+    struct property_slot<arc_from_timestep> { static const int value = 12; };
 
   // arc_to_timestep
   struct arc_to_timestep {};
@@ -196,6 +248,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<arc_to_timestep,Graph>::name = "arc_to_timestep";
+  template <>
+    struct property_slot<arc_to_timestep> { static const int value = 13; };
 
   // arc_active
   struct arc_active {};
@@ -206,6 +260,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
     const std::string property_map<arc_active,Graph>::name = "arc_active";
+  template <>
+    struct property_slot<arc_active> { static const int value = 14; };
 
   // division_active
     struct division_active {};
@@ -216,27 +272,33 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
     };
     template <typename Graph>
       const std::string property_map<division_active,Graph>::name = "division_active";
+    template <>
+      struct property_slot<division_active> { static const int value = 15; };
 
   // merger_resolved_to
   struct merger_resolved_to {};
   template <typename Graph>
   struct property_map<merger_resolved_to, Graph> {
     // typedef std::map<typename Graph::Node, std::vector<unsigned int> > type;
-    typedef lemon::IterableValueMap<Graph, typename Graph::Node, std::vector<unsigned int> > type;
+    typedef typename Graph::template NodeMap< std::vector<unsigned int> > type;
     static const std::string name;
   };
   template <typename Graph>
   const std::string property_map<merger_resolved_to, Graph>::name = "merger_resolved_to";
+  template <>
+    struct property_slot<merger_resolved_to> { static const int value = 16; };
 
   // node_originated_from
   struct node_originated_from {};
   template <typename Graph>
   struct property_map<node_originated_from, Graph> {
-    typedef lemon::IterableValueMap<Graph, typename Graph::Node, std::vector<unsigned int> > type;
+    typedef typename Graph::template NodeMap< std::vector<unsigned int> > type;
     static const std::string name;
   };
   template <typename Graph>
   const std::string property_map<node_originated_from, Graph>::name = "node_originated_from";
+  template <>
+    struct property_slot<node_originated_from> { static const int value = 17; };
 
   // node_resolution_candidate
   struct node_resolution_candidate {};
@@ -247,6 +309,8 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
   const std::string property_map<node_resolution_candidate, Graph>::name = "node_resolution_candidate";
+  template <>
+    struct property_slot<node_resolution_candidate> { static const int value = 18; };
 
   // arc_resolution_candidate
   struct arc_resolution_candidate {};
@@ -257,9 +321,22 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   };
   template <typename Graph>
   const std::string property_map<arc_resolution_candidate, Graph>::name = "arc_resolution_candidate";
+  template <>
+    struct property_slot<arc_resolution_candidate> { static const int value = 19; };
 
 
 
+  class HypothesesGraph;
+
+  // binary serialization of the topology, all properties of this header and the traxels;
+  // reading replaces the contents of the graph including all its properties. Traxels
+  // written by reference are read as references into ts, which has to outlive the graph
+  // (see NodeTraxels).
+  PGMLINK_EXPORT void write_binary( const HypothesesGraph&, std::ostream& os,
+		  bool traxels_by_reference=false );
+  PGMLINK_EXPORT void read_binary( HypothesesGraph&, std::istream& is,
+		  const TraxelStore* ts=NULL );
+
   class HypothesesGraph 
   : public PropertyGraph<lemon::ListDigraph> 
   {
@@ -294,17 +371,235 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
       void load( Archive&, const unsigned int /*version*/ );
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
+    // shared by boost serialize and the binary format
+    friend void write_binary( const HypothesesGraph&, std::ostream&, bool );
+    friend void read_binary( HypothesesGraph&, std::istream&, const TraxelStore* );
+    template< typename Archive >
+      void save_contents( Archive&, bool traxels_by_reference ) const;
+    template< typename Archive >
+      void load_contents( Archive&, const TraxelStore* ts );
+
     std::set<node_timestep_map::Value> timesteps_;      
   };
 
+  /**
+   * @brief Traxels of the nodes of a HypothesesGraph.
+   *
+   * Graphs built with traxels by reference (see
+   * SingleTimestepTraxel_HypothesesBuilder::Options) do not copy the traxels
+   * into node_traxel: their nodes point into the TraxelStore they were built
+   * from, which has to outlive the graph and must not lose traxels in between.
+   * Traxels set later on, e.g. for nodes added by merger resolution, are
+   * stored in node_traxel as usual and replace the reference.
+   *
+   * Read and set traxels through this map instead of node_traxel to support
+   * both kinds of graphs. It is a lemon ReadMap and cheap to construct.
+   */
+  class NodeTraxels {
+  public:
+    typedef HypothesesGraph::Node Key;
+    typedef Traxel Value;
+
+    PGMLINK_EXPORT explicit NodeTraxels(const HypothesesGraph&);
+
+    const Traxel& operator[](const Key& node) const {
+      if( refs_ != NULL ) {
+        const Traxel* traxel = (*refs_)[node];
+        if( traxel != NULL ) {
+          return *traxel;
+        }
+      }
+      return (*traxels_)[node];
+    }
+
+    // stores a copy of the traxel in node_traxel
+    PGMLINK_EXPORT void set(const Key&, const Traxel&);
+
+  private:
+    property_map<node_traxel_ref, HypothesesGraph::base_graph>::type* refs_;
+    property_map<node_traxel, HypothesesGraph::base_graph>::type* traxels_;
+  };
+
+  /**
+   * Replace the traxel references of a graph by copies in node_traxel, e.g.
+   * before the TraxelStore is destroyed or to access node_traxel directly.
+   */
+  PGMLINK_EXPORT void copy_referenced_traxels(HypothesesGraph&);
+
+  namespace feature_extraction {
+    class FeatureExtractor;
+  }
+  PGMLINK_EXPORT void compute_arc_features(HypothesesGraph&, bool,
+                                           const std::vector<boost::shared_ptr<feature_extraction::FeatureExtractor> >&);
+
+  /**
+   * @brief Dense table of pairwise features, one row per arc id.
+   *
+   * Filled by compute_arc_features() (see arc_features.h), together with
+   * arc_distance. The table observes the graph: arcs added afterwards, e.g.
+   * by merger resolution, have neither a row nor a precomputed distance, and
+   * contains() is false for them; compute their features on the fly. The
+   * table is serialized with the graph, whose arc ids are restored on
+   * loading, and remapped by HypothesesGraph::copy().
+   */
+  class ArcFeatureTable
+    : public lemon::ItemSetTraits<HypothesesGraph::base_graph, HypothesesGraph::Arc>::ItemNotifier::ObserverBase {
+  public:
+    typedef lemon::ItemSetTraits<HypothesesGraph::base_graph, HypothesesGraph::Arc>::ItemNotifier::ObserverBase Parent;
+
+    // for PropertyGraph::add()
+    explicit ArcFeatureTable(const HypothesesGraph::base_graph& g)
+      : Parent(g.notifier(HypothesesGraph::Arc())), dimension_(0), optical_correction_(false) {}
+
+    /** number of values per arc */
+    size_t dimension() const { return dimension_; }
+
+    /** names of the feature extractors; the values of extractor i are in [offsets()[i], offsets()[i+1]) */
+    const std::vector<std::string>& names() const { return names_; }
+    const std::vector<size_t>& offsets() const { return offsets_; }
+
+    /** whether arc_distance was computed with optical correction (Traxel::distance_to_corr()) */
+    bool optical_correction() const { return optical_correction_; }
+
+    /** whether the row and arc_distance of the arc were computed by compute_arc_features() */
+    bool contains(const HypothesesGraph::Arc& a) const {
+      const size_t id = HypothesesGraph::id(a);
+      return id < computed_.size() && computed_[id];
+    }
+
+    /** the features of the arc, NULL unless contains(a) */
+    const double* operator[](const HypothesesGraph::Arc& a) const {
+      return contains(a) ? &values_[HypothesesGraph::id(a) * dimension_] : NULL;
+    }
+
+    /** copy the rows of src for the arcs of a graph copy; arc_ref maps the arcs of src_graph to the copy */
+    template <typename ArcRef>
+      void assign(const ArcFeatureTable& src, const HypothesesGraph::base_graph& src_graph,
+                  const HypothesesGraph::base_graph& dest_graph, const ArcRef& arc_ref);
+
+  protected:
+    // arc ids are reused after erasing, so both invalidate the row
+    virtual void add(const HypothesesGraph::Arc& a) { invalidate(a); }
+    virtual void add(const std::vector<HypothesesGraph::Arc>& arcs) { invalidate(arcs); }
+    virtual void erase(const HypothesesGraph::Arc& a) { invalidate(a); }
+    virtual void erase(const std::vector<HypothesesGraph::Arc>& arcs) { invalidate(arcs); }
+    virtual void build() {}
+    virtual void clear() { computed_.clear(); }
+
+  private:
+    friend void compute_arc_features(HypothesesGraph&, bool,
+                                     const std::vector<boost::shared_ptr<feature_extraction::FeatureExtractor> >&);
+    friend class boost::serialization::access;
+    template< typename Archive >
+      void serialize( Archive& ar, const unsigned int /*version*/ ) {
+      ar & dimension_;
+      ar & names_;
+      ar & offsets_;
+      ar & values_;
+      ar & computed_;
+      ar & optical_correction_;
+    }
+
+    void invalidate(const HypothesesGraph::Arc& a) {
+      const size_t id = HypothesesGraph::id(a);
+      if( id < computed_.size() ) {
+        computed_[id] = false;
+      }
+    }
+    void invalidate(const std::vector<HypothesesGraph::Arc>& arcs) {
+      for( std::vector<HypothesesGraph::Arc>::const_iterator it = arcs.begin(); it != arcs.end(); ++it ) {
+        invalidate(*it);
+      }
+    }
+
+    size_t dimension_;
+    std::vector<std::string> names_;
+    std::vector<size_t> offsets_;
+    std::vector<double> values_;
+    std::vector<bool> computed_; // by arc id
+    bool optical_correction_;
+  };
+
+  // arc_features
+  struct arc_features {};
+  template <typename Graph>
+    struct property_map<arc_features, Graph> {
+    typedef ArcFeatureTable type;
+    static const std::string name;
+  };
+  template <typename Graph>
+    const std::string property_map<arc_features,Graph>::name = "arc_features";
+  template <>
+    struct property_slot<arc_features> { static const int value = 21; };
+
+  /**
+   * Activity of the nodes of a HypothesesGraph as a lemon ReadMap: reads
+   * node_active if present and node_active2 > 0 otherwise, like
+   * prune_inactive().
+   */
+  class ActiveNodeFilter {
+  public:
+    typedef HypothesesGraph::Node Key;
+    typedef bool Value;
+
+    PGMLINK_EXPORT explicit ActiveNodeFilter(const HypothesesGraph&);
+
+    bool operator[](const Key& node) const {
+      if( active_ != NULL ) {
+        return (*active_)[node];
+      }
+      return (*active2_)[node] > 0;
+    }
+
+  private:
+    property_map<node_active, HypothesesGraph::base_graph>::type* active_;
+    property_map<node_active2, HypothesesGraph::base_graph>::type* active2_;
+  };
+
+  /**
+   * @brief The active nodes and arcs of a HypothesesGraph.
+   *
+   * A lemon::SubDigraph filtered by ActiveNodeFilter and arc_active. It
+   * hides inactive hypotheses instead of erasing them like prune_inactive():
+   * construction is O(1), the items are those of the graph and the graph
+   * keeps all hypotheses, e.g. to solve it again. Changes of the activity
+   * maps after construction are reflected by the view.
+   */
+  class ActiveSubgraph
+    : private boost::base_from_member<ActiveNodeFilter>,
+      public lemon::SubDigraph<const HypothesesGraph::base_graph, ActiveNodeFilter,
+                               property_map<arc_active, HypothesesGraph::base_graph>::type> {
+  public:
+    typedef lemon::SubDigraph<const HypothesesGraph::base_graph, ActiveNodeFilter,
+                              property_map<arc_active, HypothesesGraph::base_graph>::type> base_view;
+
+    PGMLINK_EXPORT explicit ActiveSubgraph(const HypothesesGraph&);
+    // the filters of the copy refer to its own node filter
+    PGMLINK_EXPORT ActiveSubgraph(const ActiveSubgraph&);
+
+    const HypothesesGraph& graph() const { return *graph_; }
+
+  private:
+    ActiveSubgraph& operator=(const ActiveSubgraph&);
+
+    const HypothesesGraph* graph_;
+  };
+
+  // see hypotheses_snapshot.h
+  class HypothesesGraphSnapshot;
+
   PGMLINK_EXPORT void generateTrackletGraph(const HypothesesGraph& traxel_graph, HypothesesGraph& tracklet_graph);
   PGMLINK_EXPORT std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> > generateTrackletGraph2(
 		  const HypothesesGraph& traxel_graph, HypothesesGraph& tracklet_graph);
   PGMLINK_EXPORT HypothesesGraph& prune_inactive(HypothesesGraph&);
   PGMLINK_EXPORT boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGraph&);
+  PGMLINK_EXPORT boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGraphSnapshot&);
+  PGMLINK_EXPORT boost::shared_ptr<std::vector< std::vector<Event> > > events(const ActiveSubgraph&);
   PGMLINK_EXPORT boost::shared_ptr<std::vector< std::vector<Event> > > multi_frame_move_events(const HypothesesGraph& g);
   PGMLINK_EXPORT boost::shared_ptr<std::vector< std::vector<Event> > > merge_event_vectors(const std::vector<std::vector<Event> >& ev1, const std::vector<std::vector<Event> >& ev2);
   PGMLINK_EXPORT boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(const HypothesesGraph&);
+  PGMLINK_EXPORT boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(const HypothesesGraphSnapshot&);
+  PGMLINK_EXPORT boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(const ActiveSubgraph&);
 
   // lemon graph format (lgf) serialization
   PGMLINK_EXPORT void write_lgf( const HypothesesGraph&, std::ostream& os=std::cout,
@@ -342,16 +637,26 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
     {
 	    PGMLINK_EXPORT Options(unsigned int mnn = 6, double dt = 50,
 			                  bool forward_backward=false, bool consider_divisions=false,
-			                  double division_threshold = 0.5)
+			                  double division_threshold = 0.5,
+			                  SpatialIndexType neighbor_index = index_auto,
+			                  bool traxels_by_reference = false)
         : max_nearest_neighbors(mnn), distance_threshold(dt), forward_backward(forward_backward),
   		  consider_divisions(consider_divisions),
-  		  division_threshold(division_threshold)
+  		  division_threshold(division_threshold),
+  		  neighbor_index(neighbor_index),
+  		  traxels_by_reference(traxels_by_reference)
         {}
 
   	    unsigned int max_nearest_neighbors;
   	    double distance_threshold;
   	    bool forward_backward, consider_divisions;
   	    double division_threshold;
+  	    // index of the candidate positions in the next timestep; with index_auto
+  	    // a hash grid of cell size distance_threshold is used for dense frames
+  	    SpatialIndexType neighbor_index;
+  	    // let the nodes refer to the traxels in the TraxelStore instead of
+  	    // copying them; see NodeTraxels
+  	    bool traxels_by_reference;
     };
 
     PGMLINK_EXPORT SingleTimestepTraxel_HypothesesBuilder(const TraxelStore* ts, const Options& o = Options()) 
@@ -376,28 +681,360 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
   /**/
   /* implementation */
   /**/
+  template <typename ArcRef>
+    void ArcFeatureTable::assign(const ArcFeatureTable& src, const HypothesesGraph::base_graph& src_graph,
+                                 const HypothesesGraph::base_graph& dest_graph, const ArcRef& arc_ref) {
+    dimension_ = src.dimension_;
+    names_ = src.names_;
+    offsets_ = src.offsets_;
+    optical_correction_ = src.optical_correction_;
+    values_.assign((dest_graph.maxArcId() + 1) * dimension_, 0.);
+    computed_.assign(dest_graph.maxArcId() + 1, false);
+    for( HypothesesGraph::base_graph::ArcIt a(src_graph); a != lemon::INVALID; ++a ) {
+      if( src.contains(a) ) {
+        const std::size_t from = HypothesesGraph::base_graph::id(a) * dimension_;
+        const std::size_t to = HypothesesGraph::base_graph::id(arc_ref[a]);
+        std::copy(src.values_.begin() + from, src.values_.begin() + from + dimension_,
+                  values_.begin() + to * dimension_);
+        computed_[to] = true;
+      }
+    }
+  }
+
+  namespace detail {
+    // nodes and arcs of a graph in the order their properties are (de)serialized
+    struct SerializedItems {
+      std::vector<HypothesesGraph::Node> nodes;
+      std::vector<HypothesesGraph::Arc> arcs;
+      const std::vector<HypothesesGraph::Node>& of(HypothesesGraph::Node) const { return nodes; }
+      const std::vector<HypothesesGraph::Arc>& of(HypothesesGraph::Arc) const { return arcs; }
+    };
+
+    /**
+     * Calls visitor(Tag()) for every property defined in this header.
+     * The order is part of the serialization format: only append.
+     */
+    template <typename Visitor>
+      void for_each_property( Visitor& visitor ) {
+      visitor(node_timestep());
+      visitor(node_traxel());
+      visitor(node_tracklet());
+      visitor(tracklet_intern_dist());
+      visitor(tracklet_intern_arc_ids());
+      visitor(node_active());
+      visitor(node_active2());
+      visitor(node_offered());
+      visitor(arc_distance());
+      visitor(traxel_arc_id());
+      visitor(arc_vol_ratio());
+      visitor(split_from());
+      visitor(arc_from_timestep());
+      visitor(arc_to_timestep());
+      visitor(arc_active());
+      visitor(division_active());
+      visitor(merger_resolved_to());
+      visitor(node_originated_from());
+      visitor(node_resolution_candidate());
+      visitor(arc_resolution_candidate());
+      visitor(arc_features());
+    }
+
+    // property values; traxels may be stored as (timestep, id) keys into a TraxelStore
+    template <typename Archive, typename Value>
+      void save_property_value( Archive& ar, const Value& value, bool /*traxels_by_reference*/ ) {
+      ar << value;
+    }
+
+    template <typename Archive>
+      void save_property_value( Archive& ar, const Traxel& traxel, bool traxels_by_reference ) {
+      if( traxels_by_reference ) {
+        ar << traxel.Timestep;
+        ar << traxel.Id;
+      } else {
+        ar << traxel;
+      }
+    }
+
+    template <typename Archive>
+      void save_property_value( Archive& ar, const std::vector<Traxel>& traxels, bool traxels_by_reference ) {
+      const std::size_t size = traxels.size();
+      ar << size;
+      for( std::vector<Traxel>::const_iterator it = traxels.begin(); it != traxels.end(); ++it ) {
+        save_property_value(ar, *it, traxels_by_reference);
+      }
+    }
+
+    template <typename Archive, typename Value>
+      void load_property_value( Archive& ar, Value& value, bool /*traxels_by_reference*/, const TraxelStore* /*ts*/ ) {
+      ar >> value;
+    }
+
+    // the traxel in ts with the (timestep, id) key read from the archive
+    template <typename Archive>
+      const Traxel& load_traxel_reference( Archive& ar, const TraxelStore* ts ) {
+      int timestep;
+      unsigned int id;
+      ar >> timestep;
+      ar >> id;
+      if( ts == NULL ) {
+        throw std::runtime_error("HypothesesGraph: traxels were stored by reference, but no TraxelStore was given");
+      }
+      const TraxelStoreByTimeid& by_id = ts->get<by_timeid>();
+      TraxelStoreByTimeid::const_iterator it = by_id.find(boost::make_tuple(timestep, id));
+      if( it == by_id.end() ) {
+        std::stringstream msg;
+        msg << "HypothesesGraph: traxel " << id << " at timestep " << timestep << " not found in TraxelStore";
+        throw std::runtime_error(msg.str());
+      }
+      return *it;
+    }
+
+    template <typename Archive>
+      void load_property_value( Archive& ar, Traxel& traxel, bool traxels_by_reference, const TraxelStore* ts ) {
+      if( traxels_by_reference ) {
+        traxel = load_traxel_reference(ar, ts);
+      } else {
+        ar >> traxel;
+      }
+    }
+
+    template <typename Archive>
+      void load_property_value( Archive& ar, std::vector<Traxel>& traxels, bool traxels_by_reference, const TraxelStore* ts ) {
+      std::size_t size;
+      ar >> size;
+      traxels.resize(size);
+      for( std::vector<Traxel>::iterator it = traxels.begin(); it != traxels.end(); ++it ) {
+        load_property_value(ar, *it, traxels_by_reference, ts);
+      }
+    }
+
+    template <typename Archive>
+      class PropertySaver {
+    public:
+      PropertySaver( Archive& ar, const HypothesesGraph& g, const SerializedItems& items, bool traxels_by_reference )
+        : ar_(ar), g_(g), items_(items), traxels_by_reference_(traxels_by_reference) {}
+
+      template <typename PropertyTag>
+        void operator()( PropertyTag ) {
+        typedef typename property_map<PropertyTag, HypothesesGraph::base_graph>::type map_type;
+        typedef typename map_type::Key key_type;
+        const bool present = g_.has_property(PropertyTag());
+        ar_ << present;
+        if( !present ) {
+          return;
+        }
+        const map_type& m = g_.get(PropertyTag());
+        const std::vector<key_type>& keys = items_.of(key_type());
+        for( typename std::vector<key_type>::const_iterator k = keys.begin(); k != keys.end(); ++k ) {
+          save_property_value(ar_, m[*k], traxels_by_reference_);
+        }
+      }
+
+      // traxels are resolved, the references themselves are not saved
+      void operator()( node_traxel ) {
+        const bool present = g_.has_property(node_traxel());
+        ar_ << present;
+        if( !present ) {
+          return;
+        }
+        const NodeTraxels traxels(g_);
+        for( std::vector<HypothesesGraph::Node>::const_iterator n = items_.nodes.begin(); n != items_.nodes.end(); ++n ) {
+          save_property_value(ar_, traxels[*n], traxels_by_reference_);
+        }
+      }
+
+      // rows are indexed by arc id, which is restored on loading
+      void operator()( arc_features ) {
+        const bool present = g_.has_property(arc_features());
+        ar_ << present;
+        if( present ) {
+          const ArcFeatureTable& table = g_.get(arc_features());
+          ar_ << table;
+        }
+      }
+
+    private:
+      Archive& ar_;
+      const HypothesesGraph& g_;
+      const SerializedItems& items_;
+      bool traxels_by_reference_;
+    };
+
+    template <typename Archive>
+      class PropertyLoader {
+    public:
+      PropertyLoader( Archive& ar, HypothesesGraph& g, const SerializedItems& items, bool traxels_by_reference, const TraxelStore* ts )
+        : ar_(ar), g_(g), items_(items), traxels_by_reference_(traxels_by_reference), ts_(ts) {}
+
+      template <typename PropertyTag>
+        void operator()( PropertyTag ) {
+        load_values(PropertyTag());
+      }
+
+      // traxels saved by reference become references into the TraxelStore again
+      void operator()( node_traxel ) {
+        if( !traxels_by_reference_ ) {
+          load_values(node_traxel());
+          return;
+        }
+        bool present;
+        ar_ >> present;
+        if( !present ) {
+          return;
+        }
+        g_.add(node_traxel()).add(node_traxel_ref());
+        property_map<node_traxel_ref, HypothesesGraph::base_graph>::type& refs = g_.get(node_traxel_ref());
+        for( std::vector<HypothesesGraph::Node>::const_iterator n = items_.nodes.begin(); n != items_.nodes.end(); ++n ) {
+          refs.set(*n, &load_traxel_reference(ar_, ts_));
+        }
+      }
+
+      void operator()( arc_features ) {
+        bool present;
+        ar_ >> present;
+        if( present ) {
+          g_.add(arc_features());
+          ar_ >> g_.get(arc_features());
+        }
+      }
+
+    private:
+      template <typename PropertyTag>
+        void load_values( PropertyTag ) {
+        typedef typename property_map<PropertyTag, HypothesesGraph::base_graph>::type map_type;
+        typedef typename map_type::Key key_type;
+        typedef typename map_type::Value value_type;
+        bool present;
+        ar_ >> present;
+        if( !present ) {
+          return;
+        }
+        g_.add(PropertyTag());
+        map_type& m = g_.get(PropertyTag());
+        const std::vector<key_type>& keys = items_.of(key_type());
+        for( typename std::vector<key_type>::const_iterator k = keys.begin(); k != keys.end(); ++k ) {
+          value_type value;
+          load_property_value(ar_, value, traxels_by_reference_, ts_);
+          m.set(*k, value);
+        }
+      }
+
+      Archive& ar_;
+      HypothesesGraph& g_;
+      const SerializedItems& items_;
+      bool traxels_by_reference_;
+      const TraxelStore* ts_;
+    };
+  } /* namespace detail */
+
   template< typename Archive >
-    void HypothesesGraph::save( Archive& ar, const unsigned int /*version*/ ) const {
-    ar & timesteps_;
-    
-    bool with_n_traxel = false;
-    try {
-      this->get(node_traxel());
-      with_n_traxel = true;
-    } catch( std::runtime_error& e ) {}
-    ar & with_n_traxel;
+    void HypothesesGraph::save_contents( Archive& ar, bool traxels_by_reference ) const {
+    detail::SerializedItems items;
+    std::vector<int> node_ids, arc_ids, sources, targets;
+    for( NodeIt n(*this); n != lemon::INVALID; ++n ) {
+      items.nodes.push_back(n);
+      node_ids.push_back(id(n));
+    }
+    for( ArcIt a(*this); a != lemon::INVALID; ++a ) {
+      items.arcs.push_back(a);
+      arc_ids.push_back(id(a));
+      sources.push_back(id(source(a)));
+      targets.push_back(id(target(a)));
+    }
 
-    std::string lgf;
-    {
-      std::stringstream ss;
-      write_lgf(*this, ss, with_n_traxel);
-      lgf = ss.str();
+    ar << timesteps_;
+    ar << traxels_by_reference;
+    ar << node_ids;
+    ar << arc_ids;
+    ar << sources;
+    ar << targets;
+
+    detail::PropertySaver<Archive> saver(ar, *this, items, traxels_by_reference);
+    detail::for_each_property(saver);
+  }
+
+  template< typename Archive >
+    void HypothesesGraph::load_contents( Archive& ar, const TraxelStore* ts ) {
+    bool traxels_by_reference;
+    std::vector<int> node_ids, arc_ids, sources, targets;
+    ar >> timesteps_;
+    ar >> traxels_by_reference;
+    ar >> node_ids;
+    ar >> arc_ids;
+    ar >> sources;
+    ar >> targets;
+
+    // Only the properties in the archive are kept: the others, e.g. traxel
+    // references, would refer to the old topology.
+    clear_properties();
+    add(node_timestep());
+    add(arc_from_timestep());
+    add(arc_to_timestep());
+
+    // Restore the topology with the original ids: properties like traxel_arc_id
+    // refer to them. A cleared ListDigraph hands out ids sequentially; gaps are
+    // filled with placeholders that are erased afterwards.
+    clear();
+    const int max_node_id = node_ids.empty() ? -1 : *std::max_element(node_ids.begin(), node_ids.end());
+    const int max_arc_id = arc_ids.empty() ? -1 : *std::max_element(arc_ids.begin(), arc_ids.end());
+    std::vector<bool> node_used(max_node_id + 1, false);
+    for( std::vector<int>::const_iterator it = node_ids.begin(); it != node_ids.end(); ++it ) {
+      node_used[*it] = true;
     }
-    ar & lgf;
+    std::vector<int> arc_position(max_arc_id + 1, -1);
+    for( std::size_t i = 0; i < arc_ids.size(); ++i ) {
+      arc_position[arc_ids[i]] = i;
+    }
+
+    std::vector<Node> placeholder_nodes;
+    for( int i = 0; i <= max_node_id; ++i ) {
+      Node n = addNode();
+      assert(id(n) == i);
+      if( !node_used[i] ) {
+        placeholder_nodes.push_back(n);
+      }
+    }
+    std::vector<Arc> placeholder_arcs;
+    for( int i = 0; i <= max_arc_id; ++i ) {
+      if( arc_position[i] >= 0 ) {
+        Arc a = addArc(nodeFromId(sources[arc_position[i]]), nodeFromId(targets[arc_position[i]]));
+        assert(id(a) == i);
+      } else {
+        placeholder_arcs.push_back(addArc(nodeFromId(node_ids.front()), nodeFromId(node_ids.front())));
+      }
+    }
+    for( std::vector<Arc>::const_iterator it = placeholder_arcs.begin(); it != placeholder_arcs.end(); ++it ) {
+      erase(*it);
+    }
+    for( std::vector<Node>::const_iterator it = placeholder_nodes.begin(); it != placeholder_nodes.end(); ++it ) {
+      erase(*it);
+    }
+
+    detail::SerializedItems items;
+    for( std::vector<int>::const_iterator it = node_ids.begin(); it != node_ids.end(); ++it ) {
+      items.nodes.push_back(nodeFromId(*it));
+    }
+    for( std::vector<int>::const_iterator it = arc_ids.begin(); it != arc_ids.end(); ++it ) {
+      items.arcs.push_back(arcFromId(*it));
+    }
+
+    detail::PropertyLoader<Archive> loader(ar, *this, items, traxels_by_reference, ts);
+    detail::for_each_property(loader);
   }
 
   template< typename Archive >
-    void HypothesesGraph::load( Archive& ar, const unsigned int /*version*/ ) {
+    void HypothesesGraph::save( Archive& ar, const unsigned int /*version*/ ) const {
+    save_contents(ar, false);
+  }
+
+  template< typename Archive >
+    void HypothesesGraph::load( Archive& ar, const unsigned int version ) {
+    if( version > 0 ) {
+      load_contents(ar, NULL);
+      return;
+    }
+
+    // version 0: lgf with timestep maps and optional text archived traxels
     ar & timesteps_;
 
     bool with_n_traxel;
@@ -412,4 +1049,7 @@ Value& IterableEditableValueMap<Graph, Key, Value>::get_value(const Key& key) {
    }
 
 }
+
+BOOST_CLASS_VERSION(pgmlink::HypothesesGraph, 1)
+
 #endif /* HYPOTHESES_H */
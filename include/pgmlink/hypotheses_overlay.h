@@ -0,0 +1,177 @@
+/**
+   @file
+   @ingroup tracking
+   @brief reversible modifications of a HypothesesGraph
+*/
+
+#ifndef HYPOTHESES_OVERLAY_H
+#define HYPOTHESES_OVERLAY_H
+
+// stl
+#include <cstddef>
+#include <set>
+#include <utility>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+// lemon
+#include <lemon/core.h>
+
+// pgmlink
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/pgmlink_export.h"
+
+namespace pgmlink {
+
+////
+//// class HypothesesGraphOverlay
+////
+/**
+ * @brief Changes to a HypothesesGraph that are undone afterwards.
+ *
+ * The overlay shares the graph instead of copying it. It records the nodes
+ * and arcs added to the graph while it exists, and the previous values of
+ * properties changed through set() and set_traxel(). revert(), which is also
+ * called by the destructor, erases the added items and restores the values.
+ * Memory use and the cost of reverting therefore scale with the number of
+ * changes, not with the size of the graph.
+ *
+ * Nodes and arcs are added through graph() as usual. Properties of items
+ * that existed before the overlay have to be changed through the overlay;
+ * these items must not be erased. Properties added to the graph in between
+ * are kept. The overlay must not outlive the graph.
+ */
+class HypothesesGraphOverlay : private boost::noncopyable {
+ public:
+  typedef HypothesesGraph::Node Node;
+  typedef HypothesesGraph::Arc Arc;
+
+  PGMLINK_EXPORT explicit HypothesesGraphOverlay(HypothesesGraph& g);
+  PGMLINK_EXPORT ~HypothesesGraphOverlay();
+
+  HypothesesGraph& graph() const { return *graph_; }
+
+  /** set a property value; the value of an item of the original graph is restored by revert() */
+  template <typename PropertyTag, typename Item>
+  void set(PropertyTag, const Item& item,
+           const typename property_map<PropertyTag, HypothesesGraph::base_graph>::type::Value& value);
+
+  /** set the traxel of a node like NodeTraxels::set() */
+  PGMLINK_EXPORT void set_traxel(const Node& node, const Traxel& traxel);
+
+  bool added(const Node& node) const { return added_nodes_.contains(node); }
+  bool added(const Arc& arc) const { return added_arcs_.contains(arc); }
+  size_t added_node_count() const { return added_nodes_.items().size(); }
+  size_t added_arc_count() const { return added_arcs_.items().size(); }
+  size_t changed_value_count() const { return changes_.size(); }
+
+  /** erase the added nodes and arcs and restore the changed values */
+  PGMLINK_EXPORT void revert();
+
+ private:
+  // records the items added to the graph
+  template <typename Item>
+  class AddedItems : public lemon::ItemSetTraits<HypothesesGraph::base_graph, Item>::ItemNotifier::ObserverBase {
+   public:
+    typedef typename lemon::ItemSetTraits<HypothesesGraph::base_graph, Item>::ItemNotifier::ObserverBase Parent;
+
+    explicit AddedItems(const HypothesesGraph& g) : Parent(g.notifier(Item())) {}
+
+    bool contains(const Item& item) const { return items_.count(item) > 0; }
+    const std::set<Item>& items() const { return items_; }
+
+   protected:
+    virtual void add(const Item& item) { items_.insert(item); }
+    virtual void add(const std::vector<Item>& items) { items_.insert(items.begin(), items.end()); }
+    virtual void erase(const Item& item) { items_.erase(item); }
+    virtual void erase(const std::vector<Item>& items) {
+      for (typename std::vector<Item>::const_iterator it = items.begin(); it != items.end(); ++it) {
+        items_.erase(*it);
+      }
+    }
+    virtual void build() {}
+    virtual void clear() { items_.clear(); }
+
+   private:
+    std::set<Item> items_;
+  };
+
+  // previous value of a property
+  class Change {
+   public:
+    virtual ~Change() {}
+    virtual void undo() = 0;
+  };
+
+  template <typename Map>
+  class ValueChange : public Change {
+   public:
+    ValueChange(Map& map, const typename Map::Key& key)
+      : map_(map), key_(key), value_(static_cast<const Map&>(map)[key]) {}
+    virtual void undo() { map_.set(key_, value_); }
+
+   private:
+    Map& map_;
+    typename Map::Key key_;
+    typename Map::Value value_;
+  };
+
+  // store the value of item in map before its first change
+  template <typename Map, typename Item>
+  void record(Map& map, const Item& item);
+
+  // reset a dense node property of the added nodes, whose ids may be reused
+  template <typename PropertyTag>
+  void reset_added_nodes(PropertyTag,
+                         const typename property_map<PropertyTag, HypothesesGraph::base_graph>::type::Value& value);
+
+  HypothesesGraph* graph_;
+  AddedItems<Node> added_nodes_;
+  AddedItems<Arc> added_arcs_;
+  std::vector<boost::shared_ptr<Change> > changes_;
+  // (property map, item id) of the recorded values
+  std::set<std::pair<const void*, int> > recorded_;
+};
+
+
+
+/******************/
+/* Implementation */
+/******************/
+
+template <typename PropertyTag, typename Item>
+void HypothesesGraphOverlay::set(PropertyTag, const Item& item,
+                                 const typename property_map<PropertyTag, HypothesesGraph::base_graph>::type::Value& value) {
+  typename property_map<PropertyTag, HypothesesGraph::base_graph>::type& map = graph_->get(PropertyTag());
+  record(map, item);
+  map.set(item, value);
+}
+
+template <typename Map, typename Item>
+void HypothesesGraphOverlay::record(Map& map, const Item& item) {
+  if (added(item)) {
+    return;
+  }
+  if (recorded_.insert(std::make_pair(static_cast<const void*>(&map), HypothesesGraph::id(item))).second) {
+    changes_.push_back(boost::shared_ptr<Change>(new ValueChange<Map>(map, item)));
+  }
+}
+
+template <typename PropertyTag>
+void HypothesesGraphOverlay::reset_added_nodes(PropertyTag,
+                                               const typename property_map<PropertyTag, HypothesesGraph::base_graph>::type::Value& value) {
+  if (!graph_->has_property(PropertyTag())) {
+    return;
+  }
+  typename property_map<PropertyTag, HypothesesGraph::base_graph>::type& map = graph_->get(PropertyTag());
+  for (typename std::set<Node>::const_iterator it = added_nodes_.items().begin(); it != added_nodes_.items().end(); ++it) {
+    map.set(*it, value);
+  }
+}
+
+} /* namespace pgmlink */
+
+#endif /* HYPOTHESES_OVERLAY_H */
@@ -0,0 +1,122 @@
+/**
+   @file
+   @ingroup tracking
+   @brief immutable compressed sparse row view of a HypothesesGraph
+*/
+
+#ifndef HYPOTHESES_SNAPSHOT_H
+#define HYPOTHESES_SNAPSHOT_H
+
+// stl
+#include <cstddef>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// pgmlink
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/pgmlink_export.h"
+
+namespace pgmlink {
+
+////
+//// class HypothesesGraphSnapshot
+////
+/**
+ * @brief Frozen topology of a HypothesesGraph in compressed sparse row layout.
+ *
+ * Nodes and arcs are numbered 0..n-1 in the iteration order of
+ * HypothesesGraph::NodeIt and HypothesesGraph::ArcIt, so that passes ported
+ * from lemon iterators produce identical output. Out- and in-arcs of a node
+ * are stored contiguously (in OutArcIt/InArcIt order) and the nodes of every
+ * timestep occupy one contiguous range (in node_timestep ItemIt order).
+ *
+ * The snapshot only stores topology; properties are still read from the
+ * maps of graph() through node() and arc(). It must not outlive the graph
+ * and becomes invalid as soon as nodes or arcs are added or erased.
+ *
+ * A snapshot of an ActiveSubgraph contains only the active nodes and arcs,
+ * in the order of a graph pruned with prune_inactive().
+ */
+class HypothesesGraphSnapshot {
+ public:
+  typedef HypothesesGraph::Node Node;
+  typedef HypothesesGraph::Arc Arc;
+  typedef std::size_t index_type;
+  typedef std::vector<index_type>::const_iterator index_iterator;
+
+  static const index_type invalid_index;
+
+  PGMLINK_EXPORT explicit HypothesesGraphSnapshot(const HypothesesGraph& g);
+  PGMLINK_EXPORT explicit HypothesesGraphSnapshot(const ActiveSubgraph& view);
+
+  const HypothesesGraph& graph() const { return *graph_; }
+
+  index_type node_count() const { return nodes_.size(); }
+  index_type arc_count() const { return arcs_.size(); }
+
+  Node node(index_type n) const { return nodes_[n]; }
+  Arc arc(index_type a) const { return arcs_[a]; }
+  /** invalid_index if the node was not part of the graph when frozen */
+  PGMLINK_EXPORT index_type node_index(const Node& n) const;
+  PGMLINK_EXPORT index_type arc_index(const Arc& a) const;
+
+  index_type source(index_type a) const { return arc_source_[a]; }
+  index_type target(index_type a) const { return arc_target_[a]; }
+
+  /** arc indices of the outgoing arcs of node n */
+  index_iterator out_begin(index_type n) const { return out_arcs_.begin() + out_offsets_[n]; }
+  index_iterator out_end(index_type n) const { return out_arcs_.begin() + out_offsets_[n + 1]; }
+  index_type out_degree(index_type n) const { return out_offsets_[n + 1] - out_offsets_[n]; }
+
+  /** arc indices of the incoming arcs of node n */
+  index_iterator in_begin(index_type n) const { return in_arcs_.begin() + in_offsets_[n]; }
+  index_iterator in_end(index_type n) const { return in_arcs_.begin() + in_offsets_[n + 1]; }
+  index_type in_degree(index_type n) const { return in_offsets_[n + 1] - in_offsets_[n]; }
+
+  bool has_timesteps() const { return !timestep_offsets_.empty(); }
+  int earliest_timestep() const { return earliest_timestep_; }
+  int latest_timestep() const { return latest_timestep_; }
+
+  /** node indices of timestep t; empty range outside of [earliest, latest] */
+  PGMLINK_EXPORT index_iterator timestep_begin(int t) const;
+  PGMLINK_EXPORT index_iterator timestep_end(int t) const;
+
+ private:
+  template <typename Digraph>
+  void init(const Digraph& view);
+
+  const HypothesesGraph* graph_;
+
+  std::vector<Node> nodes_;
+  std::vector<Arc> arcs_;
+  std::vector<index_type> node_index_; // by lemon id
+  std::vector<index_type> arc_index_;  // by lemon id
+
+  std::vector<index_type> arc_source_;
+  std::vector<index_type> arc_target_;
+
+  std::vector<index_type> out_offsets_;
+  std::vector<index_type> out_arcs_;
+  std::vector<index_type> in_offsets_;
+  std::vector<index_type> in_arcs_;
+
+  int earliest_timestep_;
+  int latest_timestep_;
+  std::vector<index_type> timestep_offsets_;
+  std::vector<index_type> timestep_nodes_;
+};
+
+/**
+ * Build an immutable snapshot of the current topology of g.
+ *
+ * Freeze once after the graph has been built and pass the snapshot to all
+ * read-only passes instead of iterating the linked lists of the ListDigraph.
+ */
+PGMLINK_EXPORT boost::shared_ptr<const HypothesesGraphSnapshot> freeze(const HypothesesGraph& g);
+PGMLINK_EXPORT boost::shared_ptr<const HypothesesGraphSnapshot> freeze(const ActiveSubgraph& view);
+
+} /* namespace pgmlink */
+
+#endif /* HYPOTHESES_SNAPSHOT_H */
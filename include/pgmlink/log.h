@@ -24,6 +24,8 @@
 #include <iostream>
 #include <iomanip>
 
+#include "pgmlink/pgmlink_export.h"
+
 
 
 /**
@@ -49,6 +51,35 @@
  * The logging macro LOG ensures, that logging code will only be compiled into the final
  * binary, if it corresponds to the set plateu logging level.
  *
+ * Additionally, every translation unit may set its own (lower) floor via
+ * FILELOG_MODULE_MAX_LEVEL. The cmake variable LOGGING_MODULE_LEVELS does that per
+ * source file, e.g. "hypotheses=INFO;nearest_neighbors=WARNING".
+ *
+ * The arguments of a LOG statement are only evaluated if the message is actually
+ * written. Expensive preparation code outside of the statement can be guarded with
+ * LOG_ENABLED:
+ * @code
+ * if (LOG_ENABLED(logDEBUG4)) {
+ *   std::string s = expensive_summary(graph);
+ *   LOG(logDEBUG4) << s;
+ * }
+ * @endcode
+ *
+ *
+ *
+ * @section asynclogging Asynchronous output
+ * Messages are formatted in a per-thread buffer. By default they are written and flushed
+ * synchronously. After
+ * @code
+ * pgmlink::Output2FILE::setAsynchronous(true);
+ * @endcode
+ * complete messages are queued in a buffer of the calling thread, and a background writer
+ * collects and writes them in batches. Messages of one thread keep their order. Threads
+ * do not wait for each other, and synchronous output takes no lock.
+ * Output2FILE::flush() blocks until every pending message is written; this also happens
+ * at program exit and when switching back to synchronous output. On Windows the output
+ * stays synchronous.
+ *
  * <em>
  * As a consequence, don't use the Log API directly, but only via the provided macros.
  * </em>
@@ -142,10 +173,47 @@ public:
      * This function is used in the Log<T> and mandatory for every Redirector.
      */
     static void output(const std::string& msg);
+
+    // setAsynchronous()
+    /**
+     * Hand messages to a background writer instead of writing them in the calling thread.
+     *
+     * Switching back to synchronous output flushes all pending messages first.
+     */
+    PGMLINK_EXPORT static void setAsynchronous(bool async);
+
+    // isAsynchronous()
+    PGMLINK_EXPORT static bool isAsynchronous();
+
+    // flush()
+    /**
+     * Blocks until all pending messages are written to the file handle.
+     */
+    PGMLINK_EXPORT static void flush();
 };
 
 
 
+namespace detail {
+// implemented in log.cpp
+
+// thread_log_stream()
+/**
+ * The logging stream owned by the calling thread or NULL if thread local buffers
+ * are not available.
+ */
+PGMLINK_EXPORT std::ostringstream* thread_log_stream();
+
+// enqueue_log_message()
+/**
+ * Pass a formatted message to the background writer. Returns false if the message
+ * could not be queued and has to be written synchronously.
+ */
+PGMLINK_EXPORT bool enqueue_log_message(const std::string& msg);
+} /* namespace detail */
+
+
+
 // getRedirect()
 inline FILE*& pgmlink::Output2FILE::getRedirect()
 {
@@ -162,7 +230,12 @@ inline void pgmlink::Output2FILE::output(const std::string& msg)
     if (!pStream) {
         return;
     }
-    fprintf(pStream, "%s", msg.c_str());
+    // enqueueing fails unless the background writer is running
+    if (detail::enqueue_log_message(msg)) {
+        return;
+    }
+    // a single fwrite keeps messages from different threads apart
+    fwrite(msg.data(), 1, msg.size(), pStream);
     fflush(pStream);
 }
 
@@ -172,7 +245,9 @@ inline void pgmlink::Output2FILE::output(const std::string& msg)
 /**
  * A thread-safe logging tool
  *
- * The Log<T> passes its internal logging stream to a Redirector T.
+ * The Log<T> passes its internal logging stream to a Redirector T. The stream is a
+ * buffer owned by the current thread and reused for every message; nested messages
+ * (logging while streaming another message) fall back to a private stream.
  *
  * You have to provide a Redirector with the following interface:
  * @code
@@ -229,6 +304,16 @@ public:
      */
     static LogLevel fromString(const std::string& level);
 
+private:
+    // acquire_stream()
+    /**
+     * Returns the buffer of the current thread if it is not in use (i.e. empty), a new
+     * stream otherwise.
+     */
+    static std::ostringstream& acquire_stream(bool& owned);
+
+    bool owns_stream_;
+
 protected:
     // os_
     /**
@@ -236,7 +321,7 @@ protected:
      *
      * In the destructor, this stream is written to the Redirector T.
      */
-    std::ostringstream os_;
+    std::ostringstream& os_;
 
 private:
     // Declare copy constructor etc. as private, since we don't want them to be used.
@@ -246,9 +331,26 @@ private:
 
 
 
+// acquire_stream()
+template <typename T>
+std::ostringstream& pgmlink::Log<T>::acquire_stream(bool& owned)
+{
+    std::ostringstream* stream = detail::thread_log_stream();
+    if (stream && stream->tellp() == std::streampos(0)) {
+        owned = false;
+        return *stream;
+    }
+    owned = true;
+    return *(new std::ostringstream);
+}
+
+
+
 // Log()
 template <typename T>
 pgmlink::Log<T>::Log()
+    : owns_stream_(false),
+      os_(acquire_stream(owns_stream_))
 {
 }
 
@@ -279,8 +381,17 @@ std::ostringstream& pgmlink::Log<T>::get(LogLevel level)
 template <typename T>
 pgmlink::Log<T>::~Log()
 {
-    os_ << std::endl;
+    os_ << '\n';
     T::output(os_.str());
+    if (owns_stream_) {
+        delete &os_;
+    } else {
+        // reset the thread buffer for the next message
+        static const std::ostringstream pristine;
+        os_.str(std::string());
+        os_.clear();
+        os_.copyfmt(pristine);
+    }
 }
 
 
@@ -376,6 +487,19 @@ class FILELOG_DECLSPEC FILELog : public Log<Output2FILE> {};
 
 
 
+// FILELOG_MODULE_MAX_LEVEL
+#ifndef FILELOG_MODULE_MAX_LEVEL
+/**
+ * The deepest logging level to be compiled into the current translation unit.
+ *
+ * Has to be defined before log.h is included (or on the command line, see the cmake
+ * variable LOGGING_MODULE_LEVELS). Levels deeper than FILELOG_MAX_LEVEL are never compiled.
+ */
+#define FILELOG_MODULE_MAX_LEVEL FILELOG_MAX_LEVEL
+#endif
+
+
+
 // LOG()
 /**
  * Logs to a file handle.
@@ -390,12 +514,24 @@ class FILELOG_DECLSPEC FILELog : public Log<Output2FILE> {};
  * @endcode
  */
 #define LOG(level) \
-    if (level > FILELOG_MAX_LEVEL) ;\
-    else if (level > pgmlink::FILELog::getReportingLevel() || !pgmlink::Output2FILE::getRedirect()) ; \
+    if (!LOG_ENABLED(level)) ; \
     else pgmlink::FILELog().get(level)
 
 
 
+// LOG_ENABLED()
+/**
+ * True, if a message on the given level would be written.
+ *
+ * Evaluates to a compile time constant false for levels deeper than FILELOG_MAX_LEVEL or
+ * FILELOG_MODULE_MAX_LEVEL, such that guarded code is removed by the compiler.
+ */
+#define LOG_ENABLED(level) \
+    (!(level > FILELOG_MAX_LEVEL || level > FILELOG_MODULE_MAX_LEVEL) && \
+     !(level > pgmlink::FILELog::getReportingLevel() || !pgmlink::Output2FILE::getRedirect()))
+
+
+
 // nowTime()
 // We have to do the following yaketiyak, because the standard <ctime> is not thread safe.
 // (It is using static internal buffers in some functions like ctime() .)
@@ -0,0 +1,214 @@
+/**
+   @file
+   @ingroup pgm
+   @brief solver neutral (mixed integer) linear programs
+*/
+
+#ifndef LP_FORMULATION_H
+#define LP_FORMULATION_H
+
+// stl
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// pgmlink
+#include "pgmlink/pgmlink_export.h"
+
+namespace pgmlink {
+namespace lp {
+
+/** unbounded value for column and row bounds */
+const double infinity = std::numeric_limits<double>::infinity();
+
+////
+//// class LinearProgram
+////
+/**
+ * @brief Minimization problem min c'x s.t. l <= Ax <= u, lb <= x <= ub.
+ *
+ * The constraint matrix is stored row by row in compressed sparse row
+ * layout and is handed to the solver backends without further conversion.
+ * Rows are appended only; columns may be added at any time.
+ */
+class LinearProgram {
+ public:
+  typedef std::size_t index_type;
+
+  PGMLINK_EXPORT LinearProgram();
+
+  /** add a column and return its index */
+  PGMLINK_EXPORT index_type add_column(double lower, double upper, double objective, bool integer);
+  void add_objective(index_type column, double coefficient) { objective_.at(column) += coefficient; }
+  void add_objective_offset(double offset) { objective_offset_ += offset; }
+
+  /** add the row lower <= sum_k coeffs[k] * x[columns[k]] <= upper and return its index */
+  template <typename INDEX_ITER, typename COEFF_ITER>
+  index_type add_row(INDEX_ITER first_column, INDEX_ITER last_column, COEFF_ITER first_coefficient,
+                     double lower, double upper, const std::string& name = std::string());
+
+  index_type column_count() const { return objective_.size(); }
+  index_type row_count() const { return row_lower_.size(); }
+  index_type nonzero_count() const { return columns_.size(); }
+
+  double column_lower(index_type j) const { return column_lower_[j]; }
+  double column_upper(index_type j) const { return column_upper_[j]; }
+  double objective(index_type j) const { return objective_[j]; }
+  bool is_integer(index_type j) const { return integer_[j]; }
+  double objective_offset() const { return objective_offset_; }
+  bool has_integers() const { return integer_count_ > 0; }
+
+  /** nonzeros of row r are [row_begin(r), row_end(r)) in row_columns() and row_coefficients() */
+  index_type row_begin(index_type r) const { return row_offsets_[r]; }
+  index_type row_end(index_type r) const { return row_offsets_[r + 1]; }
+  const std::vector<index_type>& row_columns() const { return columns_; }
+  const std::vector<double>& row_coefficients() const { return coefficients_; }
+  double row_lower(index_type r) const { return row_lower_[r]; }
+  double row_upper(index_type r) const { return row_upper_[r]; }
+
+  /** row names are only stored if keep_row_names(true) was set before adding the rows */
+  void keep_row_names(bool keep) { keep_row_names_ = keep; }
+  PGMLINK_EXPORT std::string row_name(index_type r) const;
+
+  /** objective value of x including the offset */
+  PGMLINK_EXPORT double evaluate(const std::vector<double>& x) const;
+  /** check bounds, integrality and rows up to the given absolute tolerance */
+  PGMLINK_EXPORT bool is_feasible(const std::vector<double>& x, double tolerance = 1e-6) const;
+
+ private:
+  std::vector<double> column_lower_;
+  std::vector<double> column_upper_;
+  std::vector<double> objective_;
+  std::vector<bool> integer_;
+  index_type integer_count_;
+  double objective_offset_;
+
+  std::vector<index_type> row_offsets_;
+  std::vector<index_type> columns_;
+  std::vector<double> coefficients_;
+  std::vector<double> row_lower_;
+  std::vector<double> row_upper_;
+
+  bool keep_row_names_;
+  std::vector<std::string> row_names_;
+};
+
+
+
+////
+//// class DiscreteFormulation
+////
+/**
+ * @brief Integer linear program over discrete variables.
+ *
+ * Every discrete variable with L labels is represented by L binary
+ * indicator columns and the row sum_s x[var, s] = 1. Unary terms go
+ * directly into the objective. A higher order term is given by its
+ * non-default entries only: each entry whose value differs from the
+ * default gets one continuous column z linked to the indicators of
+ * its labeling (z <= x or z >= sum x - (k-1), depending on the sign of
+ * its cost), so labelings at the default value cost nothing in model
+ * size.
+ */
+class DiscreteFormulation {
+ public:
+  typedef LinearProgram::index_type index_type;
+
+  PGMLINK_EXPORT DiscreteFormulation();
+
+  /** add a discrete variable and return its index */
+  PGMLINK_EXPORT index_type add_variable(std::size_t number_of_labels);
+  index_type number_of_variables() const { return first_column_.size(); }
+  std::size_t number_of_labels(index_type var) const { return number_of_labels_[var]; }
+
+  /** column of the indicator "var takes label state" */
+  index_type column(index_type var, std::size_t state) const {
+    if (state >= number_of_labels_.at(var)) {
+      throw std::out_of_range("DiscreteFormulation::column(): state out of range");
+    }
+    return first_column_[var] + state;
+  }
+
+  /** add values[s] to the cost of var taking label s */
+  template <typename VALUE_ITER>
+  void add_unary(index_type var, VALUE_ITER first_value);
+
+  /**
+   * add a term over vars that assumes default_value everywhere except at
+   * the given labelings
+   *
+   * labelings holds one labeling of vars.size() labels per entry,
+   * concatenated.
+   */
+  PGMLINK_EXPORT void add_term(const std::vector<index_type>& vars,
+                               const std::vector<std::size_t>& labelings,
+                               const std::vector<double>& values,
+                               double default_value);
+
+  LinearProgram& program() { return program_; }
+  const LinearProgram& program() const { return program_; }
+
+  /** label of each discrete variable in the column solution x (largest indicator wins) */
+  PGMLINK_EXPORT void labeling(const std::vector<double>& x, std::vector<std::size_t>& labels) const;
+
+  /**
+   * column solution of a labeling; inverse of labeling()
+   *
+   * Sets the indicators of the given labels and every term column to
+   * the product of its indicators, which is its optimal value.
+   */
+  PGMLINK_EXPORT void columns(const std::vector<std::size_t>& labels, std::vector<double>& x) const;
+
+ private:
+  LinearProgram program_;
+  std::vector<index_type> first_column_;
+  std::vector<std::size_t> number_of_labels_;
+
+  // indicators of term column term_columns_[t] are
+  // term_indicators_[term_offsets_[t], term_offsets_[t + 1])
+  std::vector<index_type> term_columns_;
+  std::vector<index_type> term_offsets_;
+  std::vector<index_type> term_indicators_;
+};
+
+
+
+/******************/
+/* Implementation */
+/******************/
+
+template <typename INDEX_ITER, typename COEFF_ITER>
+LinearProgram::index_type LinearProgram::add_row(INDEX_ITER first_column, INDEX_ITER last_column,
+                                                 COEFF_ITER first_coefficient,
+                                                 double lower, double upper, const std::string& name) {
+  for (; first_column != last_column; ++first_column, ++first_coefficient) {
+    const index_type column = static_cast<index_type>(*first_column);
+    if (column >= column_count()) {
+      throw std::out_of_range("LinearProgram::add_row(): column index out of range");
+    }
+    columns_.push_back(column);
+    coefficients_.push_back(static_cast<double>(*first_coefficient));
+  }
+  row_offsets_.push_back(columns_.size());
+  row_lower_.push_back(lower);
+  row_upper_.push_back(upper);
+  if (keep_row_names_) {
+    row_names_.resize(row_lower_.size());
+    row_names_.back() = name;
+  }
+  return row_lower_.size() - 1;
+}
+
+template <typename VALUE_ITER>
+void DiscreteFormulation::add_unary(index_type var, VALUE_ITER first_value) {
+  for (std::size_t state = 0; state < number_of_labels_.at(var); ++state, ++first_value) {
+    program_.add_objective(first_column_[var] + state, *first_value);
+  }
+}
+
+} /* namespace lp */
+} /* namespace pgmlink */
+
+#endif /* LP_FORMULATION_H */
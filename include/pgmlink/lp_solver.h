@@ -0,0 +1,169 @@
+/**
+   @file
+   @ingroup pgm
+   @brief pluggable solver backends for LinearProgram
+*/
+
+#ifndef LP_SOLVER_H
+#define LP_SOLVER_H
+
+// stl
+#include <cmath>
+#include <string>
+#include <vector>
+
+// boost
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+// pgmlink
+#include "pgmlink/lp_formulation.h"
+#include "pgmlink/pgmlink_export.h"
+
+namespace pgmlink {
+namespace lp {
+
+/** search strategy of the branch and bound; numbered as CPLEX MIPEmphasis and Gurobi MIPFocus */
+enum MipEmphasis {
+  emphasis_balanced,
+  emphasis_feasibility,  // good incumbents early
+  emphasis_optimality,   // prove optimality of good incumbents
+  emphasis_bound         // move the lower bound
+};
+
+enum PresolveLevel {
+  presolve_auto,
+  presolve_off,
+  presolve_conservative,
+  presolve_aggressive
+};
+
+/**
+ * @brief Resource and strategy settings of a solver backend.
+ *
+ * The defaults leave every setting to the solver. Backends ignore
+ * settings they do not support (glpk is single threaded, keeps its
+ * search tree in memory and ignores memory_limit, since exceeding its
+ * process wide limit aborts the process).
+ */
+struct SolverSettings {
+  SolverSettings()
+    : threads(0), memory_limit(0.), emphasis(emphasis_balanced), presolve(presolve_auto) {}
+
+  int threads;                // 0: solver default
+  double memory_limit;        // MB of working memory, 0: no limit
+  std::string node_file_dir;  // if set, the search tree is swapped to node files in this directory
+  MipEmphasis emphasis;
+  PresolveLevel presolve;
+};
+
+/** state of a running branch and bound */
+struct Progress {
+  Progress() : objective(infinity), bound(-infinity), gap(infinity), elapsed(0.) {}
+
+  double objective;  // best incumbent, infinity before the first one was found
+  double bound;      // best known lower bound
+  double gap;        // relative gap as in Solution::gap(), infinity without incumbent
+  double elapsed;    // wall clock seconds since the start of the solve
+};
+
+/** called with every improved incumbent */
+typedef boost::function<void (const Progress&)> IncumbentCallback;
+
+/** polled during the search; returning true stops it with the best incumbent */
+typedef boost::function<bool (const Progress&)> StoppingRule;
+
+/** stop once an incumbent exists and the given wall clock time has passed */
+class WallClock {
+ public:
+  explicit WallClock(double seconds) : seconds_(seconds) {}
+  PGMLINK_EXPORT bool operator()(const Progress& progress) const;
+ private:
+  double seconds_;
+};
+
+/**
+ * stop once the gap has not shrunk by min_improvement (absolute, in units
+ * of the relative gap) during the last seconds
+ */
+class GapPlateau {
+ public:
+  GapPlateau(double min_improvement, double seconds)
+    : min_improvement_(min_improvement), seconds_(seconds), reference_gap_(infinity), reference_time_(0.) {}
+  PGMLINK_EXPORT bool operator()(const Progress& progress);
+ private:
+  double min_improvement_;
+  double seconds_;
+  double reference_gap_;
+  double reference_time_;
+};
+
+struct SolverParameters : public SolverSettings {
+  explicit SolverParameters(const SolverSettings& settings = SolverSettings())
+    : SolverSettings(settings), ep_gap(0.01), time_limit(1e75), verbose(false), relaxation(false) {}
+
+  double ep_gap;      // relative MIP gap at which the solver stops
+  double time_limit;  // seconds
+  bool verbose;
+  bool relaxation;    // ignore integrality and solve the LP relaxation
+
+  // anytime search of integer programs; every solve starts with fresh copies of the rules.
+  // The callback and the rules are called serially, even by multithreaded backends.
+  IncumbentCallback on_incumbent;
+  std::vector<StoppingRule> stopping_rules;
+};
+
+enum SolveStatus {
+  optimal,     // solved to the requested gap
+  feasible,    // stopped early (e.g. time limit) with a feasible solution
+  infeasible,
+  failed       // stopped without any feasible solution
+};
+
+struct Solution {
+  Solution() : status(failed), objective(0.), bound(-infinity) {}
+
+  bool has_values() const { return status == optimal || status == feasible; }
+  /** relative gap |objective - bound| / |objective| as reported by CPLEX */
+  double gap() const { return std::fabs(objective - bound) / (1e-10 + std::fabs(objective)); }
+
+  SolveStatus status;
+  std::vector<double> values;  // one value per column
+  double objective;            // including LinearProgram::objective_offset()
+  double bound;                // best known lower bound on the objective
+};
+
+
+
+////
+//// class Solver
+////
+/**
+ * @brief Interface of a (mixed integer) linear programming backend.
+ *
+ * Backends translate a LinearProgram into the native model of the
+ * wrapped library, solve it and return the column values. They do not
+ * keep any state between calls to solve().
+ */
+class Solver {
+ public:
+  virtual ~Solver() {}
+  virtual std::string name() const = 0;
+  virtual Solution solve(const LinearProgram& program, const SolverParameters& param) = 0;
+};
+
+/**
+ * Create the backend with the given name ("cplex", "gurobi", "glpk").
+ *
+ * An empty name selects the first available backend. Throws
+ * std::runtime_error if the backend was not compiled in.
+ */
+PGMLINK_EXPORT boost::shared_ptr<Solver> create_solver(const std::string& name = std::string());
+
+/** names of all backends compiled into this build, in order of preference */
+PGMLINK_EXPORT std::vector<std::string> available_solvers();
+
+} /* namespace lp */
+} /* namespace pgmlink */
+
+#endif /* LP_SOLVER_H */
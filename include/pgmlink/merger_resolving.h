@@ -21,6 +21,7 @@
 
 // pgmlink headers
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_overlay.h"
 #include "pgmlink/event.h"
 #include "pgmlink/traxels.h"
 #include "pgmlink/reasoner.h"
@@ -460,6 +461,10 @@ class ResolveAmbiguousArcsPgm : public ReasonerMaxOneArc, private ResolveAmbiguo
  * has to be fed with the additional information from those new objects. This class gives an implementation that
  * is as general as possible to allow for application in various settings.
  * The model must provide a HypothesesGraph and the properties node_active2, arc_active, arc_distance.
+ * Inactive hypotheses do not have to be pruned beforehand; they are ignored, and the resolved
+ * graph is read through an ActiveSubgraph.
+ * Constructed with a HypothesesGraphOverlay, the resolver changes the graph of the overlay only
+ * in ways that HypothesesGraphOverlay::revert() undoes, so no copy of the graph is needed.
  * The classes for application in the conservation tracking environment are provided. For the use in other settings, 
  * the appropriate classes have to be specified accordingly.
  */
@@ -468,9 +473,41 @@ class MergerResolver
 {
  private:
   HypothesesGraph* g_;
+  // changes of properties are recorded here, if set
+  HypothesesGraphOverlay* overlay_;
     
   // default constructor should be private (no object without specified graph allowed)
   MergerResolver();
+
+  // check and add the required properties
+  void initialize() {
+    if (!g_)
+      throw std::runtime_error("HypotesesGraph* g_ is a null pointer!");
+    if (!g_->has_property(merger_resolved_to()))
+      g_->add(merger_resolved_to());
+    if (!g_->has_property(node_active2()))
+      throw std::runtime_error("HypothesesGraph* g_ does not have property node_active2!");
+    if (!g_->has_property(arc_active()))
+      throw std::runtime_error("HypothesesGraph* g_ does not have property arc_active!");
+    if (!g_->has_property(arc_distance()))
+      throw std::runtime_error("HypothesesGraph* g_ does not have property arc_distance!");
+    if (!g_->has_property(node_originated_from()))
+      g_->add(node_originated_from());
+    if (!g_->has_property(node_resolution_candidate()))
+      g_->add(node_resolution_candidate());
+    if (!g_->has_property(arc_resolution_candidate()))
+      g_->add(arc_resolution_candidate());
+  }
+
+  // set a property of an existing node or arc
+  template <typename PropertyTag, typename Item, typename Value>
+  void set(PropertyTag, const Item& item, const Value& value) {
+    if (overlay_) {
+      overlay_->set(PropertyTag(), item, value);
+    } else {
+      g_->get(PropertyTag()).set(item, value);
+    }
+  }
     
   // collect arcs from ArcIterator and store them in vector
   // tested
@@ -506,24 +543,15 @@ class MergerResolver
 
  public:
   PGMLINK_EXPORT MergerResolver(HypothesesGraph* g) 
-  : g_(g)
+  : g_(g), overlay_(NULL)
   {
-    if (!g_)
-      throw std::runtime_error("HypotesesGraph* g_ is a null pointer!");
-    if (!g_->has_property(merger_resolved_to()))
-      g_->add(merger_resolved_to());
-    if (!g_->has_property(node_active2()))
-      throw std::runtime_error("HypothesesGraph* g_ does not have property node_active2!");
-    if (!g_->has_property(arc_active()))
-      throw std::runtime_error("HypothesesGraph* g_ does not have property arc_active!");
-    if (!g_->has_property(arc_distance()))
-      throw std::runtime_error("HypothesesGraph* g_ does not have property arc_distance!");
-    if (!g_->has_property(node_originated_from()))
-      g_->add(node_originated_from());
-    if (!g_->has_property(node_resolution_candidate()))
-      g_->add(node_resolution_candidate());
-    if (!g_->has_property(arc_resolution_candidate()))
-      g_->add(arc_resolution_candidate());
+    initialize();
+  }
+
+  PGMLINK_EXPORT MergerResolver(HypothesesGraphOverlay* overlay)
+  : g_(overlay ? &overlay->graph() : NULL), overlay_(overlay)
+  {
+    initialize();
   }
 
   PGMLINK_EXPORT HypothesesGraph* resolve_mergers(FeatureHandlerBase& handler);
@@ -534,7 +562,8 @@ class MergerResolver
 //// given a graph, do retracking
 ////
 PGMLINK_EXPORT void resolve_graph(HypothesesGraph& src, HypothesesGraph& dest, boost::function<double(const double)> transition, double ep_gap, bool with_tracklets,
-                   const double transition_parameter=5, const bool with_constraints=true);
+                   const double transition_parameter=5, const bool with_constraints=true,
+                   const std::string& solver_backend="", const lp::SolverSettings& solver_settings=lp::SolverSettings());
 // void resolve_graph(HypothesesGraph& src, HypothesesGraph& dest);
 
   
@@ -554,14 +583,14 @@ void copy_hypotheses_graph_subset(const HypothesesGraph& src,
 template <typename PropertyTag, typename KeyType>
 void translate_property_value_map(const HypothesesGraph& src,
                                   const HypothesesGraph& dest,
-                                  std::map<KeyType, KeyType> dict
+                                  const std::map<KeyType, KeyType>& dict
                                   );
 
 
 template <typename PropertyTag, typename KeyType>
 void translate_property_bool_map(const HypothesesGraph& src,
                                  const HypothesesGraph& dest,
-                                 std::map<KeyType,KeyType> dict
+                                 const std::map<KeyType,KeyType>& dict
                                  );
 
 
@@ -600,6 +629,8 @@ PGMLINK_EXPORT void merge_split_divisions(const HypothesesGraph& graph,
 
 
 PGMLINK_EXPORT void calculate_gmm_beforehand(HypothesesGraph& g, int n_trials, int n_dimensions);
+// changes the traxels of the mergers through the overlay
+PGMLINK_EXPORT void calculate_gmm_beforehand(HypothesesGraphOverlay& overlay, int n_trials, int n_dimensions);
 
 
 // extract coordinates in arma::mat
@@ -704,7 +735,7 @@ void copy_hypotheses_graph_subset(const HypothesesGraph& src,
                                   std::map<HypothesesGraph::Arc, HypothesesGraph::Arc>& acr
                                   ) {
   LOG(logDEBUG) << "copy_hypotheses_graph_subset(): entered";
-  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = src.get(node_traxel());
+  const NodeTraxels traxel_map(src);
 
   dest.add(node_originated_from());
 
@@ -761,19 +792,14 @@ void copy_hypotheses_graph_subset(const HypothesesGraph& src,
 template <typename PropertyTag, typename KeyType>
 void translate_property_value_map(const HypothesesGraph& src,
                                   const HypothesesGraph& dest,
-                                  std::map<KeyType, KeyType> dict
+                                  const std::map<KeyType, KeyType>& dict
                                   ) {
-  typedef typename property_map<PropertyTag, HypothesesGraph::base_graph>::type IterableMap;
-  IterableMap& src_map = src.get(PropertyTag());
-  IterableMap& dest_map = dest.get(PropertyTag());
-  typename IterableMap::ValueIt v_it;
-  for (v_it = src_map.beginValue(); v_it != src_map.endValue(); ++ v_it) {
-    typename IterableMap::ItemIt i_it(src_map, *v_it);
-    for (; i_it != lemon::INVALID; ++i_it) {
-      if (dict.count(i_it) > 0) {
-        dest_map.set(dict[i_it], *v_it);
-      }
-    }
+  // copy values along dict; works for iterable and dense property maps alike
+  typedef typename property_map<PropertyTag, HypothesesGraph::base_graph>::type PropertyMap;
+  PropertyMap& src_map = src.get(PropertyTag());
+  PropertyMap& dest_map = dest.get(PropertyTag());
+  for (typename std::map<KeyType, KeyType>::const_iterator it = dict.begin(); it != dict.end(); ++it) {
+    dest_map.set(it->second, src_map[it->first]);
   }
 }
 
@@ -781,27 +807,10 @@ void translate_property_value_map(const HypothesesGraph& src,
 template <typename PropertyTag, typename KeyType>
 void translate_property_bool_map(const HypothesesGraph& src,
                                  const HypothesesGraph& dest,
-                                 std::map<KeyType,KeyType> dict
+                                 const std::map<KeyType,KeyType>& dict
                                  ) {
-  // use c++11 and change for loop to:
-  // for(bool b : {false, true});
-
-  // C++11 !!!
-
   LOG(logDEBUG) << "translate_property_bool_map(): entering";
-    
-  bool const bools[] = {false, true};
-  typedef typename property_map<PropertyTag, HypothesesGraph::base_graph>::type IterableMap;
-  IterableMap& src_map = src.get(PropertyTag());
-  IterableMap& dest_map = dest.get(PropertyTag());
-  for (bool const* v_it(bools); v_it != bools + 2; ++v_it) {
-    typename IterableMap::ItemIt i_it(src_map, *v_it);
-    for(; i_it != lemon::INVALID; ++i_it) {
-      if (dict.count(i_it) > 0) {
-        dest_map.set(dict[i_it], *v_it);
-      }
-    }
-  }
+  translate_property_value_map<PropertyTag, KeyType>(src, dest, dict);
 }
 
 template <typename NodePropertyTag, typename ArcPropertyTag>
@@ -926,7 +935,7 @@ void update_labelimage(const TimestepIdCoordinateMapPtr& coordinates,
    void MergerResolver::calculate_centers(HypothesesGraph::Node node,					 
    int nMergers) {
    // get traxel map from graph to access traxel
-   property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g_->get(node_traxel());
+   NodeTraxels traxel_map(*g_);
    Traxel trax = traxel_map[node];
    feature_array mergerCOMs;
 
@@ -8,43 +8,56 @@
 #ifndef NEAREST_NEIGHBORS_H
 #define NEAREST_NEIGHBORS_H
 #include <map>
-#include <ANN/ANN.h>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 
 #include "pgmlink/pgmlink_export.h"
+#include "pgmlink/spatial_index.h"
 
 namespace pgmlink {
     class Traxel;
 
+    /**
+     * Nearest neighbor queries on the positions of a set of traxels.
+     *
+     * The points are the traxel coordinates (the corrected ones with
+     * reverse set); queries use the corrected coordinates of the query
+     * traxel unless reverse is set. All queries are const and thread safe.
+     *
+     * The points are indexed by a KdTree by default. A SpatialHashGrid with
+     * cells of size radius may be requested instead, or chosen by density
+     * with index_auto; it is meant for queries with exactly that radius.
+     */
     class NearestNeighborSearch
     {
       public:
+        typedef SpatialIndex::Neighbor Neighbor;
+
         template <typename InputIt>
         NearestNeighborSearch( InputIt traxel_begin,
                    InputIt traxel_end,
-                   const bool reverse = false);
-        ~NearestNeighborSearch();
+                   const bool reverse = false,
+                   SpatialIndexType index = index_kd_tree,
+                   double radius = 0 );
     
          /**
           * Returns (traxel id, distance*distance) map.
           */
-        PGMLINK_EXPORT std::map<unsigned int, double> knn_in_range( const Traxel& query, double radius, unsigned int knn, const bool reverse = false );
-        PGMLINK_EXPORT unsigned int count_in_range( const Traxel& query, double radius, const bool reverse = false );
+        PGMLINK_EXPORT std::map<unsigned int, double> knn_in_range( const Traxel& query, double radius, unsigned int knn, const bool reverse = false ) const;
 
-    private:
         /**
-         * Ctor helper: define points and association between traxels and points
+         * Writes at most knn (traxel id, distance*distance) pairs sorted by
+         * distance to neighbors, which must hold knn entries, without allocating.
+         * @return number of neighbors written
          */
-        template <typename InputIt>
-        void define_point_set( InputIt traxel_begin, InputIt traxel_end, const bool reverse = false );
-        ANNpoint point_from_traxel( const Traxel& traxel, const bool reverse = false );
+        PGMLINK_EXPORT size_t knn_in_range( const Traxel& query, double radius, unsigned int knn,
+                                            Neighbor* neighbors, const bool reverse = false ) const;
+        PGMLINK_EXPORT unsigned int count_in_range( const Traxel& query, double radius, const bool reverse = false ) const;
 
-        std::map<unsigned int, unsigned int> point_idx2traxel_id_;
-    
-        const int dim_;
-    
-        ANNpointArray points_;
-        boost::shared_ptr<ANNkd_tree> kd_tree_;
+    private:
+        void point_from_traxel( const Traxel& traxel, double point[3], const bool reverse = false ) const;
+
+        boost::shared_ptr<const SpatialIndex> index_;
     };
 
 } /* namespace pgmlink */
@@ -54,76 +67,35 @@ namespace pgmlink {
 /****
  Implementation
  ****/
-#include <cassert>
 #include <iterator>
-#include <boost/scoped_array.hpp>
 #include "pgmlink/traxels.h"
 #include <pgmlink/log.h>
 
 
 
 namespace pgmlink {
-using namespace std;
-using namespace boost;
 
 template <typename InputIt>
-NearestNeighborSearch::NearestNeighborSearch(InputIt traxel_begin, InputIt traxel_end, const bool reverse) 
-: dim_(3), points_(NULL) 
+NearestNeighborSearch::NearestNeighborSearch(InputIt traxel_begin, InputIt traxel_end, const bool reverse,
+                                             SpatialIndexType index, double radius) 
 {
-  size_t size(distance(traxel_begin, traxel_end));
-
-  if(size > 0) {
-    this->define_point_set( traxel_begin, traxel_end, reverse );
-    try {
-      kd_tree_ = boost::shared_ptr<ANNkd_tree>( new ANNkd_tree( points_, size, dim_ ) );
-    } catch(...) {
-      annDeallocPts(points_);
-      points_ = NULL;
-      throw;
-    }
-  }
-}
-
-template <typename InputIt>
-void NearestNeighborSearch::define_point_set( InputIt traxel_begin, InputIt traxel_end, const bool reverse ) {
-    // allocate memory for kd-tree nodes
-    size_t traxel_number = distance(traxel_begin, traxel_end);
-    points_ = annAllocPts( traxel_number, dim_ );
-    if( points_ == NULL ){
-      throw "Allocation of points for kd-tree failed";
-    }
-
-    // fill the nodes with coordinates
-    try 
-    {
-      point_idx2traxel_id_.clear();
-      size_t i = 0;
-      for( InputIt traxel = traxel_begin; traxel != traxel_end; ++traxel, ++i) {
-        ANNpoint point = points_[i];
-        assert(dim_ == 3);
+    std::vector<double> coordinates;
+    std::vector<unsigned int> ids;
+    for( InputIt traxel = traxel_begin; traxel != traxel_end; ++traxel ) {
         if (!reverse) {
-            point[0] = traxel->X();
-            point[1] = traxel->Y();
-            point[2] = traxel->Z();
-            LOG(logDEBUG4) << "NearestNeighborSearch::define_point_set (!reverse): " << *traxel <<
-                            " point = " << point[0] << "," << point[1] << "," << point[2];
+            coordinates.push_back(traxel->X());
+            coordinates.push_back(traxel->Y());
+            coordinates.push_back(traxel->Z());
         } else {
-            point[0] = traxel->X_corr();
-            point[1] = traxel->Y_corr();
-            point[2] = traxel->Z_corr();
-            LOG(logDEBUG4) << "NearestNeighborSearch::define_point_set: " << *traxel <<
-                                      " point = " << point[0] << "," << point[1] << "," << point[2];
+            coordinates.push_back(traxel->X_corr());
+            coordinates.push_back(traxel->Y_corr());
+            coordinates.push_back(traxel->Z_corr());
         }
-      
-        // save point <-> traxel association
-        point_idx2traxel_id_[i] = traxel->Id;
-      }
-    } catch(...) {
-      annDeallocPts(points_);
-      points_ = NULL;
-      point_idx2traxel_id_.clear();
-      throw;
+        LOG(logDEBUG4) << "NearestNeighborSearch: " << *traxel << " point = " << coordinates[coordinates.size() - 3]
+                       << "," << coordinates[coordinates.size() - 2] << "," << coordinates.back();
+        ids.push_back(traxel->Id);
     }
+    index_ = make_spatial_index(coordinates, ids, radius, index);
 }
 
 } /* namespace pgmlink */
@@ -16,6 +16,7 @@
 #include <opengm/functions/explicit_function.hxx>
 #include <pgmlink/ext_opengm/decorator_weighted.hxx>
 #include <pgmlink/ext_opengm/indicator_function.hxx>
+#include <pgmlink/ext_opengm/sparse_table_function.hxx>
 #include <opengm/operations/adder.hxx>
 #include <opengm/utilities/metaprogramming.hxx>
 
@@ -32,19 +33,24 @@ namespace pgmlink {
     typedef opengm::ExplicitFunction<double> ExplicitFunction;
     typedef opengm::FunctionDecoratorWeighted< opengm::IndicatorFunction<double> > FeatureFunction;
     typedef opengm::HammingFunction<double> LossFunction;
+    typedef opengm::SparseTableFunction<double> SparseFunction;
     typedef opengm::LoglinearModel<double,
       opengm::meta::TypeList<ExplicitFunction,
       opengm::meta::TypeList<FeatureFunction,
-      opengm::meta::TypeList<LossFunction, opengm::meta::ListEnd > > > > OpengmModel;
+      opengm::meta::TypeList<LossFunction,
+      opengm::meta::TypeList<SparseFunction, opengm::meta::ListEnd > > > > > OpengmModel;
 
     class OpengmModelDeprecated {
     public:
       typedef double Energy;
-      typedef opengm::GraphicalModel<Energy, opengm::Adder> ogmGraphicalModel;
+      typedef opengm::GraphicalModel<Energy, opengm::Adder,
+        opengm::meta::TypeList<opengm::ExplicitFunction<Energy>,
+        opengm::meta::TypeList<opengm::SparseTableFunction<Energy>, opengm::meta::ListEnd> > > ogmGraphicalModel;
       typedef opengm::Factor<ogmGraphicalModel> ogmFactor;
       typedef opengm::Minimizer ogmAccumulator;
       typedef opengm::Inference<ogmGraphicalModel, ogmAccumulator> ogmInference;
       typedef opengm::meta::TypeAtTypeList<ogmGraphicalModel::FunctionTypeList, 0>::type ExplicitFunctionType;
+      typedef opengm::meta::TypeAtTypeList<ogmGraphicalModel::FunctionTypeList, 1>::type SparseFunctionType;
       typedef ogmGraphicalModel::FunctionIdentifier FunctionIdentifier;
       
       OpengmModelDeprecated() {
@@ -107,6 +113,28 @@ namespace pgmlink {
       void init_( VALUE init, std::vector<size_t> states_vars );
     };    
  
+    /**
+       @brief Factor over discrete variables storing only explicitly set entries.
+
+       All other labelings assume the default value. Use instead of
+       OpengmExplicitFactor for high order factors with few admissible
+       labelings; memory is linear in the number of set entries.
+    */
+    template <typename VALUE>
+      class OpengmSparseFactor : public OpengmFactor<opengm::SparseTableFunction<VALUE> > {
+    public:
+      typedef typename OpengmFactor<opengm::SparseTableFunction<VALUE> >::FunctionType FunctionType;
+
+      OpengmSparseFactor( const std::vector<size_t>& ogm_var_indices, VALUE default_value=0, size_t states_per_var=2 );
+      template <typename ITER>
+	OpengmSparseFactor( ITER first_ogm_idx, ITER last_ogm_idx, VALUE default_value=0, size_t states_per_var=2 );
+
+      void set_value( std::vector<size_t> coords, VALUE v);
+
+    private:
+      void init_( VALUE default_value, size_t states_per_var );
+    };
+
     template <typename VALUE>
       class OpengmWeightedFeature
       : public OpengmFactor< opengm::FunctionDecoratorWeighted< opengm::IndicatorFunction<VALUE> > >
@@ -257,6 +285,38 @@ namespace pgmlink {
 
 
 
+////
+//// class OpengmSparseFactor
+////
+ template <typename VALUE>
+   OpengmSparseFactor<VALUE>::OpengmSparseFactor( const std::vector<size_t>& ogm_var_indices, VALUE default_value, size_t states_per_var )
+   : OpengmFactor<opengm::SparseTableFunction<VALUE> >(opengm::SparseTableFunction<VALUE>(), ogm_var_indices) {
+  init_( default_value, states_per_var );
+}
+ template <typename VALUE>
+   template< typename ITER >
+   OpengmSparseFactor<VALUE>::OpengmSparseFactor( ITER first_ogm_idx, ITER last_ogm_idx, VALUE default_value, size_t states_per_var )
+   : OpengmFactor<opengm::SparseTableFunction<VALUE> >(opengm::SparseTableFunction<VALUE>(), first_ogm_idx, last_ogm_idx) {
+  init_( default_value, states_per_var );
+ }
+
+ template <typename VALUE>
+   void OpengmSparseFactor<VALUE>::set_value( std::vector<size_t> coords, VALUE v) {
+   if( coords.size() != this->vi_.size() ) {
+     throw std::invalid_argument("OpengmSparseFactor::set_value(): coordinate dimension differs from factor dimension");
+   }
+   indexsorter::reorder( coords, this->order_ );
+   this->ogmfunction_.set( coords.begin(), v );
+ }
+
+ template <typename VALUE>
+   void OpengmSparseFactor<VALUE>::init_( VALUE default_value, size_t states_per_var ) {
+   std::vector<size_t> shape( this->vi_.size(), states_per_var );
+   this->ogmfunction_ = opengm::SparseTableFunction<VALUE>( shape.begin(), shape.end(), default_value );
+ }
+
+
+
 ////
 //// class OpengmWeightedFeature
 ////
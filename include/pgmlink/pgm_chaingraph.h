@@ -17,15 +17,18 @@
 #include <boost/bimap.hpp>
 #include <opengm/inference/inference.hxx>
 
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
 #include <opengm/inference/lpgurobi.hxx>
 #else
 #include <opengm/inference/lpcplex.hxx>
 #endif
+#endif
 
 #include "pgmlink/pgm.h"
 #include "pgmlink/hypotheses.h"
 #include "pgmlink/feature.h"
+#include "pgmlink/lp_formulation.h"
 
 // Both boost and lemon define the same template ignore_unused_variable_warning<T>.
 // Using boost templates with lemon types triggers ADL and the (MSVC++) compiler can't
@@ -43,10 +46,12 @@ namespace boost {
 namespace pgmlink {
   namespace pgm {
   namespace chaingraph {
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
   typedef opengm::LPGurobi<OpengmModel, opengm::Minimizer> OpengmLPCplex;
 #else
   typedef opengm::LPCplex<OpengmModel, opengm::Minimizer> OpengmLPCplex;
+#endif
 #endif
     using boost::function;
     using std::map;
@@ -172,14 +177,23 @@ namespace pgmlink {
       virtual chaingraph::Model* build( const HypothesesGraph& ) const = 0;      
 
       // refinement
+#ifdef WITH_OPENGM_LP
       void add_hard_constraints( const Model&, const HypothesesGraph&, OpengmLPCplex& );
       void fix_detections( const Model&, const HypothesesGraph&, OpengmLPCplex& );
+#endif
+      // same constraints for the direct formulation; every model variable has to be added to it in order
+      void add_hard_constraints( const Model&, const HypothesesGraph&, lp::DiscreteFormulation& );
+      void fix_detections( const Model&, const HypothesesGraph&, lp::DiscreteFormulation& );
 
       // cplex parameters
       void set_cplex_timeout( double seconds );
 
 
     protected:
+      // move() of an arc; SquaredDistance is read from arc_distance where compute_arc_features()
+      // computed it without optical correction
+      double move_energy( const HypothesesGraph&, const HypothesesGraph::Arc& ) const;
+
       void add_detection_vars( const HypothesesGraph&, Model& ) const;
       void add_assignment_vars( const HypothesesGraph&, Model& ) const;
 
@@ -192,8 +206,6 @@ namespace pgmlink {
 
 
     private:
-      static void couple( const chaingraph::Model&, const HypothesesGraph::Node&, const HypothesesGraph::Arc&, OpengmLPCplex& );
-      
       bool with_detection_vars_;
       bool with_divisions_;
 
@@ -0,0 +1,90 @@
+/**
+   @file
+   @ingroup matching
+   @brief solver free tracking by frame to frame assignment
+*/
+
+#ifndef REASONER_ASSIGNMENT_H
+#define REASONER_ASSIGNMENT_H
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "pgmlink/feature.h"
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_snapshot.h"
+#include "pgmlink/reasoner.h"
+
+namespace pgmlink {
+class Traxel;
+
+/**
+ * @brief Tracking by minimum cost bipartite matching between consecutive timesteps.
+ *
+ * Every pair of timesteps is matched independently: arcs of at most
+ * max_move_distance are candidates, and each connected component of the
+ * candidate graph is solved with the Hungarian method (maximum number of
+ * moves, minimal total arc_distance among those). Components larger than
+ * max_component_size are matched greedily by increasing distance instead
+ * to bound the running time in dense crowds.
+ *
+ * A matched ancestor whose divProb exceeds division_threshold may take an
+ * unmatched second child within max_division_distance; the child with the
+ * lowest division cost (e.g. GeometryDivision2) below max_division_cost is
+ * chosen. All detections are assumed to be real objects; unmatched ones
+ * appear or disappear.
+ *
+ * Arc lengths are read from the arc_distance property if the graph has
+ * it and computed from the traxel positions otherwise. conclude() writes
+ * node_active, arc_active and division_active, so events() and
+ * prune_inactive() apply as for the other reasoners.
+ */
+class AssignmentTracking : public Reasoner {
+    public:
+    typedef boost::function<double (const Traxel&, const Traxel&, const Traxel&)> division_cost_function;
+
+    AssignmentTracking(double max_move_distance = 10,
+                       double max_division_distance = 30,
+                       double division_threshold = 0.5,
+                       division_cost_function division = GeometryDivision2(0, 0),
+                       double max_division_cost = 1e12,
+                       size_t max_component_size = 1000)
+        : max_move_distance_(max_move_distance),
+          max_division_distance_(max_division_distance),
+          division_threshold_(division_threshold),
+          division_(division),
+          max_division_cost_(max_division_cost),
+          max_component_size_(max_component_size)
+    { };
+
+    virtual void formulate( const HypothesesGraph& );
+    virtual void infer();
+    virtual void conclude( HypothesesGraph& );
+
+    private:
+    typedef HypothesesGraphSnapshot::index_type index_type;
+
+    bool is_candidate( index_type arc, int t, double max_distance ) const;
+    void match_timestep( int t );
+    void match_component( int t, const std::vector<index_type>& sources, const std::vector<index_type>& targets );
+    void add_divisions( int t, const std::vector<index_type>& sources );
+
+    double max_move_distance_;
+    double max_division_distance_;
+    double division_threshold_;
+    division_cost_function division_;
+    double max_division_cost_;
+    size_t max_component_size_;
+
+    boost::shared_ptr<const HypothesesGraphSnapshot> snapshot_;
+    std::vector<double> distance_;      // by snapshot arc index
+    std::vector<bool> active_arcs_;     // by snapshot arc index
+    std::vector<int> timestep_;         // by snapshot node index
+    std::vector<bool> divisions_;       // by snapshot node index
+    std::vector<bool> has_parent_;      // by snapshot node index
+    std::vector<index_type> component_; // scratch: position in its component by snapshot node index
+};
+
+} /* namespace pgmlink */
+#endif /* REASONER_ASSIGNMENT_H */
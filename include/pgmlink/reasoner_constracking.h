@@ -1,27 +1,100 @@
 #ifndef CONSTRACKING_REASONER_H
 #define CONSTRACKING_REASONER_H
 
+#include <cassert>
+#include <cstddef>
 #include <map>
+#include <string>
+#include <vector>
 #include <boost/function.hpp>
 #include <opengm/inference/inference.hxx>
 
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
 #include <opengm/inference/lpgurobi.hxx>
 #else
 #include <opengm/inference/lpcplex.hxx>
 #endif
+#endif
 
 #include "pgmlink/pgm.h"
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_snapshot.h"
+#include "pgmlink/lp_formulation.h"
+#include "pgmlink/lp_solver.h"
 #include "pgmlink/reasoner.h"
 #include "pgmlink/feature.h"
 
 namespace pgmlink {
 class Traxel;
 
+/**
+ * @brief Solver variable ids of graph items, stored densely by lemon id.
+ *
+ * Lookups index a vector instead of searching a tree; iterating over the
+ * ids visits the items in id order, i.e. in the order of a
+ * std::map<Item, size_t>.
+ */
+template <typename Item>
+class VariableIdMap {
+ public:
+  static const size_t invalid = static_cast<size_t>(-1);
+
+  VariableIdMap() : size_(0) {}
+
+  void set(const Item& item, size_t variable) {
+    const size_t id = HypothesesGraph::id(item);
+    if (id >= variables_.size()) {
+      variables_.resize(id + 1, invalid);
+      items_.resize(id + 1);
+    }
+    if (variables_[id] == invalid) {
+      ++size_;
+    }
+    variables_[id] = variable;
+    items_[id] = item;
+  }
+
+  size_t operator[](const Item& item) const {
+    assert(count(item) > 0);
+    return variables_[HypothesesGraph::id(item)];
+  }
+
+  size_t count(const Item& item) const {
+    const size_t id = HypothesesGraph::id(item);
+    return id < variables_.size() && variables_[id] != invalid ? 1 : 0;
+  }
+
+  size_t size() const { return size_; }
+
+  void clear() {
+    variables_.clear();
+    items_.clear();
+    size_ = 0;
+  }
+
+  /** ids are in [0, id_bound()); variable(id) is invalid for ids without item */
+  size_t id_bound() const { return variables_.size(); }
+  size_t variable(size_t id) const { return variables_[id]; }
+  const Item& item(size_t id) const { return items_[id]; }
+
+ private:
+  std::vector<size_t> variables_;
+  std::vector<Item> items_;
+  size_t size_;
+};
+
+template <typename Item>
+const size_t VariableIdMap<Item>::invalid;
+
 
 class ConservationTracking : public Reasoner {
     public:
+    /** The energy functors are called from a single thread, so they need not
+     * be thread safe. Only the stock NegLnDetection, NegLnTransition,
+     * NegLnDivision and SpatialBorderAwareWeight are recognized and evaluated
+     * in parallel batches.
+     */
 	ConservationTracking(
                              unsigned int max_number_objects,
                              boost::function<double (const Traxel&, const size_t)> detection,
@@ -38,14 +111,19 @@ class ConservationTracking : public Reasoner {
                              bool with_disappearance = true,
                              double transition_parameter = 5,
                              bool with_constraints = true,
-                             double cplex_timeout = 1e75
+                             double cplex_timeout = 1e75,
+                             const std::string& solver_backend = "",
+                             const lp::SolverSettings& solver_settings = lp::SolverSettings(),
+                             bool with_relaxation = false
                              )
         : max_number_objects_(max_number_objects),
           detection_(detection),
           division_(division),
           transition_(transition),
           forbidden_cost_(forbidden_cost),
+#ifdef WITH_OPENGM_LP
           optimizer_(NULL),
+#endif
           ep_gap_(ep_gap),
           with_tracklets_(with_tracklets),
           with_divisions_(with_divisions),
@@ -60,7 +138,10 @@ class ConservationTracking : public Reasoner {
           with_disappearance_(with_disappearance),
           transition_parameter_(transition_parameter),
           with_constraints_(with_constraints),
-          cplex_timeout_(cplex_timeout)
+          cplex_timeout_(cplex_timeout),
+          solver_backend_(solver_backend),
+          solver_settings_(solver_settings),
+          with_relaxation_(with_relaxation)
     { };
     ~ConservationTracking();
 
@@ -71,6 +152,54 @@ class ConservationTracking : public Reasoner {
     double forbidden_cost() const;
     bool with_constraints() const;
 
+    /** Name of the lp::Solver backend used with the direct formulation
+     *
+     * If empty (and without with_relaxation()), the model is built as an
+     * opengm graphical model and solved with opengm's LPCplex/LPGurobi. Otherwise variables, objective and
+     * constraints are written straight into an lp::DiscreteFormulation.
+     * Builds without CPLEX and Gurobi always use the direct formulation; an
+     * empty name then selects the first of lp::available_solvers().
+     */
+    const std::string& solver_backend() const { return solver_backend_; }
+
+    /** Threads, memory limit, node files, emphasis and presolve of the solver
+     *
+     * opengm's LPCplex/LPGurobi only take the thread count and the memory
+     * limit; the direct formulation passes all settings to the backend.
+     */
+    const lp::SolverSettings& solver_settings() const { return solver_settings_; }
+
+    /** Fast approximate mode
+     *
+     * infer() solves only the LP relaxation of the direct formulation and
+     * rounds the arc flows to the nearest integers. A greedy pass then
+     * lowers flows until every node satisfies the conservation, division
+     * and appearance/disappearance constraints again. If the repaired
+     * labeling still violates a constraint (e.g. because appearance or
+     * disappearance is forbidden), the integer program is solved instead.
+     */
+    bool with_relaxation() const { return with_relaxation_; }
+
+    /** Solution of the direct formulation after infer()
+     *
+     * With the relaxation, bound is the LP optimum and gap() the relative
+     * optimality gap of the rounded labeling.
+     */
+    const lp::Solution& lp_solution() const { return lp_solution_; }
+
+    /** Anytime search
+     *
+     * The callback receives every improved incumbent with its gap and the
+     * elapsed time. Stopping rules (e.g. lp::WallClock, lp::GapPlateau) end
+     * the search early; infer() then keeps the best incumbent instead of
+     * failing, and conclude() writes it to the graph. Both require the
+     * direct formulation, which they select. Without them, a search cut
+     * short by cplex_timeout also keeps its best incumbent, with either
+     * formulation.
+     */
+    void set_incumbent_callback(const lp::IncumbentCallback& callback) { incumbent_callback_ = callback; }
+    void add_stopping_rule(const lp::StoppingRule& rule) { stopping_rules_.push_back(rule); }
+
     /** Return current state of graphical model
      *
      * The returned pointer may be NULL before formulate() is called
@@ -88,7 +217,7 @@ class ConservationTracking : public Reasoner {
      *
      * The map is populated after the first call to formulate().
      */
-    const std::map<HypothesesGraph::Arc, size_t>& get_arc_map() const;
+    const VariableIdMap<HypothesesGraph::Arc>& get_arc_map() const;
     
 
     private:
@@ -97,16 +226,24 @@ class ConservationTracking : public Reasoner {
     ConservationTracking& operator=(const ConservationTracking&) { return *this;};
 
     void reset();
-    void add_constraints( const HypothesesGraph& );
+    void add_constraints( const HypothesesGraphSnapshot& );
     void add_detection_nodes( const HypothesesGraph& );
     void add_appearance_nodes( const HypothesesGraph& );
     void add_disappearance_nodes( const HypothesesGraph& );
     void add_transition_nodes( const HypothesesGraph& );
-    void add_division_nodes(const HypothesesGraph& );
-    void add_finite_factors( const HypothesesGraph& );
+    void add_division_nodes(const HypothesesGraphSnapshot& );
+    void add_finite_factors( const HypothesesGraphSnapshot& );
+    bool round_relaxation( const lp::Solution& relaxed );
 
     // helper
+    bool direct_formulation() const;
     size_t cplex_id(size_t opengm_id, size_t state);
+    size_t add_variable(size_t number_of_labels);
+    void add_factor(const pgm::OpengmExplicitFactor<double>& table);
+    void add_factor(const pgm::OpengmSparseFactor<double>& table);
+    template <typename ITER, typename COEFF_ITER>
+    void add_constraint(ITER first_idx, ITER last_idx, COEFF_ITER first_coeff,
+                        double lower, double upper, const std::string& name);
 
 
     unsigned int max_number_objects_;
@@ -119,16 +256,18 @@ class ConservationTracking : public Reasoner {
     double forbidden_cost_;
     
     shared_ptr<pgm::OpengmModelDeprecated> pgm_;
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
     opengm::LPGurobi<pgm::OpengmModelDeprecated::ogmGraphicalModel, pgm::OpengmModelDeprecated::ogmAccumulator>* optimizer_;
 #else
     opengm::LPCplex<pgm::OpengmModelDeprecated::ogmGraphicalModel, pgm::OpengmModelDeprecated::ogmAccumulator>* optimizer_;
+#endif
 #endif
 
-    std::map<HypothesesGraph::Node, size_t> div_node_map_;
-    std::map<HypothesesGraph::Node, size_t> app_node_map_;
-    std::map<HypothesesGraph::Node, size_t> dis_node_map_;
-    std::map<HypothesesGraph::Arc, size_t> arc_map_;
+    VariableIdMap<HypothesesGraph::Node> div_node_map_;
+    VariableIdMap<HypothesesGraph::Node> app_node_map_;
+    VariableIdMap<HypothesesGraph::Node> dis_node_map_;
+    VariableIdMap<HypothesesGraph::Arc> arc_map_;
 
     double ep_gap_;    
 
@@ -150,6 +289,16 @@ class ConservationTracking : public Reasoner {
 
     double cplex_timeout_;
 
+    // direct formulation; see direct_formulation()
+    std::string solver_backend_;
+    lp::SolverSettings solver_settings_;
+    boost::shared_ptr<lp::DiscreteFormulation> formulation_;
+    lp::Solution lp_solution_;
+    bool with_relaxation_;
+    boost::shared_ptr<const HypothesesGraphSnapshot> snapshot_;
+    lp::IncumbentCallback incumbent_callback_;
+    std::vector<lp::StoppingRule> stopping_rules_;
+
     HypothesesGraph tracklet_graph_;
     std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> > tracklet2traxel_node_map_;
 };
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <iterator>
 #include <map>
+#include <string>
 #include <vector>
 #include <utility>
 #include <boost/function.hpp>
@@ -17,26 +18,32 @@
 #include <boost/bimap.hpp>
 #include <opengm/inference/inference.hxx>
 
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
 #include <opengm/inference/lpgurobi.hxx>
 #else
 #include <opengm/inference/lpcplex.hxx>
 #endif
+#endif
 
 #include "pgmlink/event.h"
 #include "pgmlink/feature.h"
 #include "pgmlink/pgm.h"
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/lp_formulation.h"
+#include "pgmlink/lp_solver.h"
 #include "pgmlink/reasoner.h"
 #include "pgmlink/pgm_chaingraph.h"
 
 namespace pgmlink {
   class Traxel;
   namespace pgm {
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
   typedef opengm::LPGurobi<OpengmModel, opengm::Minimizer> OpengmLPCplex;
 #else
   typedef opengm::LPCplex<OpengmModel, opengm::Minimizer> OpengmLPCplex;
+#endif
 #endif
   } /* namespace pgm */
 
@@ -48,13 +55,20 @@ namespace pgmlink {
     Chaingraph(bool with_constraints = true,
 	       double ep_gap = 0.01,
 	       bool fixed_detections = false,
-	       double cplex_timeout = 1e+75
+	       double cplex_timeout = 1e+75,
+	       const std::string& solver_backend = "",
+	       const lp::SolverSettings& solver_settings = lp::SolverSettings()
 	       )
-      : optimizer_(NULL),
+      :
+#ifdef WITH_OPENGM_LP
+      optimizer_(NULL),
+#endif
       with_constraints_(with_constraints),
       fixed_detections_(fixed_detections),
       ep_gap_(ep_gap),
       cplex_timeout_(cplex_timeout),
+      solver_backend_(solver_backend),
+      solver_settings_(solver_settings),
       builder_(NULL)
 	{ builder_ = new pgm::chaingraph::ECCV12ModelBuilder(); (*builder_).with_detection_vars().with_divisions(); }
     
@@ -63,13 +77,20 @@ namespace pgmlink {
 	     bool with_constraints = true,
 	     double ep_gap = 0.01,
 	     bool fixed_detections = false,
-	     double cplex_timeout = 1e+75
+	     double cplex_timeout = 1e+75,
+	     const std::string& solver_backend = "",
+	     const lp::SolverSettings& solver_settings = lp::SolverSettings()
     ) 
-    : optimizer_(NULL),
+    :
+#ifdef WITH_OPENGM_LP
+    optimizer_(NULL),
+#endif
     with_constraints_(with_constraints),
     fixed_detections_(fixed_detections),
     ep_gap_(ep_gap),
     cplex_timeout_(cplex_timeout),
+    solver_backend_(solver_backend),
+    solver_settings_(solver_settings),
     builder_(builder.clone())
     {};
     ~Chaingraph();
@@ -84,6 +105,24 @@ namespace pgmlink {
     void builder(const pgm::chaingraph::ModelBuilder& builder) {
       if(builder_) delete builder_; builder_ = builder.clone(); }
 
+    /** Name of the lp::Solver backend used with the direct formulation
+     *
+     * If empty, the graphical model is solved with opengm's
+     * LPCplex/LPGurobi. Otherwise its factors and the hard constraints are
+     * copied into an lp::DiscreteFormulation and solved by the named
+     * backend. Builds without CPLEX and Gurobi always use the direct
+     * formulation; an empty name then selects the first of
+     * lp::available_solvers().
+     */
+    const std::string& solver_backend() const { return solver_backend_; }
+
+    /** Threads, memory limit, node files, emphasis and presolve of the solver
+     *
+     * opengm's LPCplex/LPGurobi only take the thread count and the memory
+     * limit; the direct formulation passes all settings to the backend.
+     */
+    const lp::SolverSettings& solver_settings() const { return solver_settings_; }
+
     /** Return current state of graphical model
      *
      * The returned pointer may be NULL before formulate() is called
@@ -109,8 +148,11 @@ namespace pgmlink {
     Chaingraph(const Chaingraph&) {};
     Chaingraph& operator=(const Chaingraph&) { return *this;};
     void reset();
+    bool direct_formulation() const;
     
+#ifdef WITH_OPENGM_LP
     pgm::OpengmLPCplex* optimizer_;
+#endif
     shared_ptr<pgm::chaingraph::Model> linking_model_;
 
     bool with_constraints_;
@@ -118,6 +160,13 @@ namespace pgmlink {
 
     double ep_gap_;
     double cplex_timeout_;
+
+    // direct formulation; see direct_formulation()
+    std::string solver_backend_;
+    lp::SolverSettings solver_settings_;
+    shared_ptr<lp::DiscreteFormulation> formulation_;
+    lp::Solution lp_solution_;
+
     pgm::chaingraph::ModelBuilder* builder_;
 };
 
@@ -0,0 +1,162 @@
+/**
+   @file
+   @ingroup tracking
+   @brief spatial indices for neighbor queries on 3d points
+*/
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "pgmlink/pgmlink_export.h"
+
+namespace pgmlink {
+
+enum SpatialIndexType {
+  index_auto,     // chosen by prefer_grid_index()
+  index_kd_tree,  // KdTree
+  index_grid      // SpatialHashGrid
+};
+
+/**
+ * @brief Static index of 3d points with an id each for fixed-radius neighbor queries.
+ *
+ * Indices are built once and never modified, so all queries are const,
+ * re-entrant and may run concurrently from several threads. Queries do
+ * not allocate: results are written to buffers provided by the caller.
+ */
+class SpatialIndex {
+ public:
+  /** (point id, squared distance) */
+  typedef std::pair<unsigned int, double> Neighbor;
+
+  virtual ~SpatialIndex() {}
+
+  virtual size_t size() const = 0;
+
+  /**
+   * The (at most) k nearest points within radius of query[0..2].
+   *
+   * neighbors must hold k entries; they are filled sorted by increasing
+   * squared distance (ties by id). Points at exactly the radius count as
+   * in range.
+   * @return number of neighbors written
+   */
+  virtual size_t knn_in_range(const double query[3], double radius, size_t k, Neighbor* neighbors) const = 0;
+
+  /**
+   * knn_in_range() for n queries given as interleaved coordinates.
+   * The neighbors of query i are written to neighbors[i*k, i*k + counts[i]).
+   */
+  PGMLINK_EXPORT void knn_in_range(const double* queries, size_t n, double radius, size_t k,
+                                   Neighbor* neighbors, size_t* counts) const;
+
+  /** number of points within radius of query[0..2] */
+  virtual size_t count_in_range(const double query[3], double radius) const = 0;
+};
+
+/**
+ * @brief Static kd-tree with median splits on the widest dimension.
+ */
+class KdTree : public SpatialIndex {
+ public:
+  PGMLINK_EXPORT KdTree();
+
+  /**
+   * @param coordinates x, y and z of every point, interleaved
+   * @param ids one id per point
+   */
+  PGMLINK_EXPORT KdTree(const std::vector<double>& coordinates, const std::vector<unsigned int>& ids);
+
+  PGMLINK_EXPORT virtual size_t size() const { return ids_.size(); }
+  using SpatialIndex::knn_in_range;
+  PGMLINK_EXPORT virtual size_t knn_in_range(const double query[3], double radius, size_t k, Neighbor* neighbors) const;
+  PGMLINK_EXPORT virtual size_t count_in_range(const double query[3], double radius) const;
+
+ private:
+  struct Node {
+    size_t begin, end;  // range of points below this node
+    int split_dim;      // -1 for leaves
+    double split;
+    size_t left, right;
+  };
+
+  size_t build(size_t begin, size_t end, std::vector<size_t>& order, const std::vector<double>& coordinates);
+  void search(size_t node, const double query[3], double sq_radius, size_t k,
+              Neighbor* neighbors, size_t& found) const;
+  size_t count(size_t node, const double query[3], double sq_radius) const;
+
+  std::vector<Node> nodes_;
+  std::vector<double> points_;      // interleaved coordinates in tree order
+  std::vector<unsigned int> ids_;   // in tree order
+};
+
+/**
+ * @brief Uniform grid of cubic cells stored in a hash table.
+ *
+ * Building takes linear time (a counting sort of the points by cell).
+ * With the cell size equal to the search radius a query visits the 27
+ * cells around the query point, so its cost depends on the local point
+ * density only. Larger radii visit correspondingly more cells.
+ */
+class SpatialHashGrid : public SpatialIndex {
+ public:
+  /**
+   * @param coordinates x, y and z of every point, interleaved
+   * @param ids one id per point
+   * @param cell_size edge length of the cells, usually the search radius
+   */
+  PGMLINK_EXPORT SpatialHashGrid(const std::vector<double>& coordinates, const std::vector<unsigned int>& ids,
+                                 double cell_size);
+
+  PGMLINK_EXPORT virtual size_t size() const { return ids_.size(); }
+  using SpatialIndex::knn_in_range;
+  PGMLINK_EXPORT virtual size_t knn_in_range(const double query[3], double radius, size_t k, Neighbor* neighbors) const;
+  PGMLINK_EXPORT virtual size_t count_in_range(const double query[3], double radius) const;
+
+ private:
+  struct Cell {
+    long x, y, z;
+    bool operator==(const Cell& other) const { return x == other.x && y == other.y && z == other.z; }
+  };
+
+  Cell cell_of(const double point[3]) const;
+  size_t bucket_of(const Cell& cell) const;
+  // calls visitor(i) for every point i in the cells within radius of query
+  template <typename Visitor>
+  void visit(const double query[3], double radius, Visitor& visitor) const;
+
+  double cell_size_;
+  size_t bucket_mask_;                // number of buckets - 1, a power of two minus one
+  std::vector<size_t> bucket_begin_;  // points of bucket b: [bucket_begin_[b], bucket_begin_[b + 1])
+  std::vector<Cell> cells_;           // in bucket order, to skip points of colliding cells
+  std::vector<double> points_;        // interleaved coordinates in bucket order
+  std::vector<unsigned int> ids_;     // in bucket order
+};
+
+/**
+ * Heuristic choice between SpatialHashGrid and KdTree for radius queries.
+ *
+ * The grid pays off if the points are dense relative to the radius,
+ * i.e. if the bounding box of the points does not hold many more cells
+ * of the radius than points, and if there are enough points at all.
+ */
+PGMLINK_EXPORT bool prefer_grid_index(const std::vector<double>& coordinates, double radius);
+
+/**
+ * Build the index of the given type over the points (see KdTree); the
+ * grid uses the radius as cell size.
+ */
+PGMLINK_EXPORT boost::shared_ptr<const SpatialIndex> make_spatial_index(const std::vector<double>& coordinates,
+                                                                       const std::vector<unsigned int>& ids,
+                                                                       double radius,
+                                                                       SpatialIndexType type = index_auto);
+
+} /* namespace pgmlink */
+
+#endif /* SPATIAL_INDEX_H */
@@ -13,6 +13,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include "pgmlink/event.h"
+#include "pgmlink/lp_solver.h"
 #include "pgmlink/pgmlink_export.h"
 #include "pgmlink/traxels.h"
 #include "pgmlink/field_of_view.h"
@@ -61,6 +62,9 @@ namespace pgmlink {
      */
     PGMLINK_EXPORT void set_with_divisions(bool);
     PGMLINK_EXPORT void set_cplex_timeout(double);
+    /** lp::Solver backend by name; empty: opengm with CPLEX/Gurobi if available (see Chaingraph) */
+    PGMLINK_EXPORT void set_solver_backend(const std::string&);
+    PGMLINK_EXPORT void set_solver_settings(const lp::SolverSettings&);
 
   private:
     double app_, dis_, det_, mis_;
@@ -76,9 +80,20 @@ namespace pgmlink {
     bool with_divisions_;
     double cplex_timeout_;
     bool alternative_builder_;
+    std::string solver_backend_;
+    lp::SolverSettings solver_settings_;
     shared_ptr<std::vector< std::map<unsigned int, bool> > > last_detections_;
   };
 
+  /**
+   * Solver free tracking: nearest neighbor hypotheses matched frame to
+   * frame by AssignmentTracking. Moves are at most movDist long, second
+   * children of divisions (divProb > divisionThreshold) at most divDist.
+   * Distances are taken between the given features (Euclidean over their
+   * concatenation) or between the traxel positions if none are given.
+   * Splitter and merger handling are not implemented; the flags and
+   * maxTraxelIdAt are ignored.
+   */
   class NNTracking 
   {
    public:
@@ -112,6 +127,9 @@ namespace pgmlink {
   };
 
 
+  /**
+   * As NNTracking with a single distance limit for moves and divisions.
+   */
   class NNTrackletsTracking
   {
     public:
@@ -167,7 +185,9 @@ namespace pgmlink {
       means_(std::vector<double>()),
       sigmas_(std::vector<double>()),
       fov_(fov),
-      event_vector_dump_filename_(event_vector_dump_filename)
+      event_vector_dump_filename_(event_vector_dump_filename),
+      with_relaxation_(false),
+      traxels_by_reference_(false)
       {}
 
 
@@ -225,6 +245,38 @@ namespace pgmlink {
        */
       PGMLINK_EXPORT std::vector< std::map<unsigned int, bool> > detections();
 
+      /**
+       * Solver used by track() and resolve_mergers().
+       *
+       * The backend is selected by name (see lp::available_solvers()); an
+       * empty name uses opengm with CPLEX/Gurobi if available. The settings
+       * bound threads and memory per job.
+       */
+      PGMLINK_EXPORT void set_solver_backend(const std::string&);
+      PGMLINK_EXPORT void set_solver_settings(const lp::SolverSettings&);
+
+      /**
+       * Let track() solve the LP relaxation and round it instead of the
+       * integer program (see ConservationTracking::with_relaxation()).
+       * Meant for previews; merger resolution is always solved exactly.
+       */
+      PGMLINK_EXPORT void set_with_relaxation(bool);
+
+      /**
+       * Let the nodes of the hypotheses graph refer to the traxels of the
+       * TraxelStore given to build_hypo_graph() instead of copying them (see
+       * NodeTraxels). The store then has to outlive the graph.
+       */
+      PGMLINK_EXPORT void set_traxels_by_reference(bool);
+
+      /**
+       * Anytime search in track(): report improved incumbents and stop on
+       * the given rules with the best tracking found so far (see
+       * ConservationTracking::add_stopping_rule()).
+       */
+      PGMLINK_EXPORT void set_incumbent_callback(const lp::IncumbentCallback&);
+      PGMLINK_EXPORT void add_stopping_rule(const lp::StoppingRule&);
+
     private:
       int max_number_objects_;
       double max_dist_;
@@ -238,6 +290,12 @@ namespace pgmlink {
       shared_ptr<std::vector< std::map<unsigned int, bool> > > last_detections_;
       FieldOfView fov_;
       std::string event_vector_dump_filename_;
+      std::string solver_backend_;
+      lp::SolverSettings solver_settings_;
+      bool with_relaxation_;
+      bool traxels_by_reference_;
+      lp::IncumbentCallback incumbent_callback_;
+      std::vector<lp::StoppingRule> stopping_rules_;
 
       TraxelStore* traxel_store_;
 
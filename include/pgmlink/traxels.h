@@ -130,6 +130,20 @@ class IntmaxposLocator
 //
 // Traxel datatype
 //
+/**
+ * Detection of an object at one timestep with its features.
+ *
+ * The position is resolved from the features by the locator. Adding the
+ * traxel to a TraxelStore (or deserializing it) resolves it once and
+ * caches the coordinates inline, so that X(), Y(), Z(), the _corr
+ * variants and the geometric relations neither look up features nor
+ * call the locator afterwards; set_locator() refreshes the cache.
+ * Traxels without cached coordinates resolve them on every call. Write
+ * position features ("com", "com_corrected", ...) through set_feature(),
+ * which refreshes the cache, or call update_coordinates() after changing
+ * them in features directly or after changing the locator scales of a
+ * traxel that has cached coordinates (e.g. a copy of a traxel from a store).
+ */
 class Traxel 
 {
  public:
@@ -137,7 +151,7 @@ class Traxel
    //takes ownership of locator pointer
   PGMLINK_EXPORT Traxel(unsigned int id = 0, int timestep = 0, FeatureMap fmap = FeatureMap(), Locator* l = new ComLocator(),
 		                ComCorrLocator* lc = new ComCorrLocator()) 
-  : Id(id), Timestep(timestep), features(fmap), locator_(l), corr_locator_(lc) 
+  : Id(id), Timestep(timestep), features(fmap), locator_(l), corr_locator_(lc), has_coordinates_(false)
   {}
 
   PGMLINK_EXPORT Traxel(const Traxel& other);
@@ -145,6 +159,13 @@ class Traxel
   PGMLINK_EXPORT ~Traxel() { delete locator_; }
   PGMLINK_EXPORT Traxel& set_locator(Locator*);
   PGMLINK_EXPORT Locator* locator() {return locator_;}
+
+  /** resolve and cache the coordinates; without position features the cache is dropped */
+  PGMLINK_EXPORT void update_coordinates();
+  PGMLINK_EXPORT bool has_cached_coordinates() const { return has_coordinates_; }
+
+  /** set a feature and refresh the cached coordinates */
+  PGMLINK_EXPORT Traxel& set_feature(const std::string& name, const feature_array& value);
    
    // fields
    unsigned int Id; // id of connected component (aka "label")
@@ -152,13 +173,14 @@ class Traxel
    FeatureMap features;
    
    // position according to locator
-   PGMLINK_EXPORT double X() const;
-   PGMLINK_EXPORT double Y() const;
-   PGMLINK_EXPORT double Z() const;
+   PGMLINK_EXPORT double X() const { return has_coordinates_ ? coordinates_[0] : locator_->X(features); }
+   PGMLINK_EXPORT double Y() const { return has_coordinates_ ? coordinates_[1] : locator_->Y(features); }
+   PGMLINK_EXPORT double Z() const { return has_coordinates_ ? coordinates_[2] : locator_->Z(features); }
     
-   PGMLINK_EXPORT double X_corr() const;
-   PGMLINK_EXPORT double Y_corr() const;
-   PGMLINK_EXPORT double Z_corr() const;
+   // position according to com_corrected if present, else as above
+   PGMLINK_EXPORT double X_corr() const { return has_coordinates_ ? corr_coordinates_[0] : corr_coordinate(0); }
+   PGMLINK_EXPORT double Y_corr() const { return has_coordinates_ ? corr_coordinates_[1] : corr_coordinate(1); }
+   PGMLINK_EXPORT double Z_corr() const { return has_coordinates_ ? corr_coordinates_[2] : corr_coordinate(2); }
 
    // relation to other traxels
    PGMLINK_EXPORT double distance_to(const Traxel& other) const;
@@ -172,9 +194,16 @@ class Traxel
    template< typename Archive >
      void serialize( Archive&, const unsigned int /*version*/ );
 
+   double corr_coordinate(size_t dim) const;
+
    Locator* locator_;
 
    ComCorrLocator* corr_locator_;
+
+   // resolved positions, valid if has_coordinates_
+   bool has_coordinates_;
+   double coordinates_[3];
+   double corr_coordinates_[3];
  };
 
  // compare by (time,id) (Traxels can be used as keys (for instance in a std::map) )
@@ -241,6 +270,7 @@ class Traxel
    latest_timestep(const TraxelStore&);
 
  // io
+ /** adds a copy of the traxel with cached coordinates (see Traxel) */
  PGMLINK_EXPORT TraxelStore& add(TraxelStore&, const Traxel&);
 
  template<typename InputIt>
@@ -256,6 +286,14 @@ class Traxel
  class FieldOfView;
  PGMLINK_EXPORT size_t filter_by_fov( const TraxelStore& in, TraxelStore& out, const FieldOfView& );
 
+ /**
+  * Filter by field of view without copying.
+  * The Traxels are tested in parallel.
+  * @return the Traxels of in that are contained in the field of view, in the order of in;
+  *         the pointers stay valid as long as the Traxels are not erased from in
+  */
+ PGMLINK_EXPORT std::vector<const Traxel*> filter_by_fov( const TraxelStore& in, const FieldOfView& );
+
 
 
 /**/
@@ -287,6 +325,9 @@ void Traxel::serialize( Archive& ar, const unsigned int /*version*/ ) {
   ar & Timestep;
   ar & features;
   ar & locator_;
+  if (Archive::is_loading::value) {
+    update_coordinates();
+  }
 }
 
 template<typename InputIterator>
@@ -300,7 +341,9 @@ Traxels traxel_map_from_traxel_sequence(InputIterator begin, InputIterator end)
 
 template<typename InputIt>
   TraxelStore& add(TraxelStore& ts, InputIt begin, InputIt end) {
-  ts.get<by_timestep>().insert(begin, end);
+  for(; begin != end; ++begin) {
+    add(ts, *begin);
+  }
   return ts;
 }
 
@@ -1,10 +1,11 @@
 #define PY_ARRAY_UNIQUE_SYMBOL pgmlink_pyarray
 #define NO_IMPORT_ARRAY
 
+#include <cctype>
 #include <string>
 #include <sstream>
+#include <vector>
 
-#include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/python.hpp>
 #include <boost/python/iterator.hpp>
@@ -23,24 +24,39 @@ typedef property_map<node_traxel, HypothesesGraph::base_graph>::type node_traxel
 
 node_traxel_m& addNodeTraxelMap(HypothesesGraph* g) {
   g->add(node_traxel());
+  copy_referenced_traxels(*g);
   return g->get(node_traxel());
 }
 node_traxel_m& getNodeTraxelMap(HypothesesGraph* g) {
+  // python reads and writes node_traxel directly
+  copy_referenced_traxels(*g);
   return g->get(node_traxel());
 }
+std::vector<std::vector<Event> > activeEvents(const ActiveSubgraph& view) {
+  return *events(view);
+}
 
+// Pickles are binary archives (see write_binary()): they are compact and fast, but
+// can only be loaded on platforms with the same byte order and type sizes. Text
+// pickles of earlier versions are still loaded.
 struct HypothesesGraph_pickle_suite : pickle_suite {
   static std::string getstate( const HypothesesGraph& g ) {
-    std::stringstream ss;
-    boost::archive::text_oarchive oa(ss);
-    oa & g;
+    std::stringstream ss(std::ios::out | std::ios::binary);
+    write_binary(g, ss);
     return ss.str();
   }
 
   static void setstate( HypothesesGraph& g, const std::string& state ) {
-    std::stringstream ss(state);
-    boost::archive::text_iarchive ia(ss);
-    ia & g;
+    // pickles of earlier versions are text archives; they start with the length
+    // of the archive signature in decimal, binary archives with its raw bytes
+    if( !state.empty() && std::isdigit(static_cast<unsigned char>(state[0])) ) {
+      std::stringstream ss(state);
+      boost::archive::text_iarchive ia(ss);
+      ia & g;
+      return;
+    }
+    std::stringstream ss(state, std::ios::in | std::ios::binary);
+    read_binary(g, ss);
   }
 };
 
@@ -120,7 +136,9 @@ void export_hypotheses() {
   HypothesesGraph::Node (HypothesesGraph::*runningNode2)(const HypothesesGraph::OutArcIt&) const =
     &HypothesesGraph::runningNode;
 
-  class_<HypothesesGraph,shared_ptr<HypothesesGraph>, boost::noncopyable>("HypothesesGraph")
+  class_<HypothesesGraph,shared_ptr<HypothesesGraph>, boost::noncopyable>("HypothesesGraph",
+      "Pickles are binary and only portable between platforms with the same byte order and "
+      "type sizes; text pickles of earlier versions can still be loaded.")
     .def("addNode", addnode1)
     .def("addNode", addnode2)
     //.def("timesteps", &HypothesesGraph::timesteps, 
@@ -158,12 +176,23 @@ void export_hypotheses() {
     .def_pickle(HypothesesGraph_pickle_suite())
     ;
 
+  // active hypotheses without pruning; keeps the graph alive
+  class_<ActiveSubgraph, boost::noncopyable>("ActiveSubgraph",
+      init<const HypothesesGraph&>(args("hypotheses_graph"))[with_custodian_and_ward<1,2>()])
+    .def("graph", &ActiveSubgraph::graph, return_internal_reference<>())
+    ;
+  def("events", &activeEvents, args("active_subgraph"));
+
   //
   // lemon
   //
   int (*countNodes)(const HypothesesGraph&) = lemon::countNodes;
   def("countNodes", countNodes);
+  int (*countActiveNodes)(const ActiveSubgraph&) = lemon::countNodes;
+  def("countNodes", countActiveNodes);
 
   int (*countArcs)(const HypothesesGraph&) = lemon::countArcs;
   def("countArcs", countArcs);
+  int (*countActiveArcs)(const ActiveSubgraph&) = lemon::countArcs;
+  def("countArcs", countActiveArcs);
 }
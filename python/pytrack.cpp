@@ -6,6 +6,7 @@
 
 #include "../include/pgmlink/tracking.h"
 #include "../include/pgmlink/field_of_view.h"
+#include "../include/pgmlink/lp_solver.h"
 #include <boost/utility.hpp>
 #include <boost/python/suite/indexing/map_indexing_suite.hpp>
 #include <boost/python/suite/indexing/vector_indexing_suite.hpp>
@@ -31,6 +32,29 @@ vector<vector<Event> > pythonChaingraphTracking(ChaingraphTracking& tr, TraxelSt
 	return result;
 }
 
+vector<vector<Event> > pythonNNTracking(NNTracking& tr, TraxelStore& ts) {
+	vector<vector<Event> > result = std::vector<std::vector<Event> >(0);
+	// release the GIL
+	Py_BEGIN_ALLOW_THREADS
+	try {
+	  result = tr(ts);
+	} catch (std::exception& e) {
+		Py_BLOCK_THREADS
+		throw;
+	}
+	Py_END_ALLOW_THREADS
+	return result;
+}
+
+// the solver runs without the GIL: only the built-in stopping rules are exposed
+void addWallClockRule(ConsTracking& tr, double seconds) {
+	tr.add_stopping_rule(lp::WallClock(seconds));
+}
+
+void addGapPlateauRule(ConsTracking& tr, double min_improvement, double seconds) {
+	tr.add_stopping_rule(lp::GapPlateau(min_improvement, seconds));
+}
+
 vector<vector<Event> > pythonConsTracking(ConsTracking& tr, TraxelStore& ts, TimestepIdCoordinateMapPtr& coordinates,
 					  double forbidden_cost,
 					  double ep_gap,
@@ -89,6 +113,28 @@ void export_track() {
       .def(vector_indexing_suite<vector<map<unsigned int, bool> > >())
     ;
 
+    enum_<lp::MipEmphasis>("MipEmphasis")
+	.value("Balanced", lp::emphasis_balanced)
+	.value("Feasibility", lp::emphasis_feasibility)
+	.value("Optimality", lp::emphasis_optimality)
+	.value("Bound", lp::emphasis_bound)
+    ;
+
+    enum_<lp::PresolveLevel>("PresolveLevel")
+	.value("Auto", lp::presolve_auto)
+	.value("Off", lp::presolve_off)
+	.value("Conservative", lp::presolve_conservative)
+	.value("Aggressive", lp::presolve_aggressive)
+    ;
+
+    class_<lp::SolverSettings>("SolverSettings")
+      .def_readwrite("threads", &lp::SolverSettings::threads)
+      .def_readwrite("memory_limit", &lp::SolverSettings::memory_limit)
+      .def_readwrite("node_file_dir", &lp::SolverSettings::node_file_dir)
+      .def_readwrite("emphasis", &lp::SolverSettings::emphasis)
+      .def_readwrite("presolve", &lp::SolverSettings::presolve)
+    ;
+
     class_<ChaingraphTracking>("ChaingraphTracking", 
 			       init<string,double,double,double,double,
 			       	   bool,double,double,bool,
@@ -101,6 +147,14 @@ void export_track() {
       .def("detections", &ChaingraphTracking::detections)
       .def("set_with_divisions", &ChaingraphTracking::set_with_divisions)
       .def("set_cplex_timeout", &ChaingraphTracking::set_cplex_timeout)
+      .def("set_solver_backend", &ChaingraphTracking::set_solver_backend)
+      .def("set_solver_settings", &ChaingraphTracking::set_solver_settings)
+    ;
+
+    class_<NNTracking>("NNTracking",
+		       init<double,double>(args("div_dist", "mov_dist")))
+      .def("__call__", &pythonNNTracking)
+      .def("detections", &NNTracking::detections)
     ;
 
     class_<ConsTracking>("ConsTracking",
@@ -111,6 +165,12 @@ void export_track() {
           .def("track", &ConsTracking::track)
           .def("resolve_mergers", &ConsTracking::resolve_mergers)
 	  .def("detections", &ConsTracking::detections)
+	  .def("set_solver_backend", &ConsTracking::set_solver_backend)
+	  .def("set_solver_settings", &ConsTracking::set_solver_settings)
+	  .def("set_with_relaxation", &ConsTracking::set_with_relaxation)
+	  .def("set_traxels_by_reference", &ConsTracking::set_traxels_by_reference)
+	  .def("add_wall_clock_rule", &addWallClockRule, args("seconds"))
+	  .def("add_gap_plateau_rule", &addGapPlateauRule, args("min_improvement", "seconds"))
 	;
 
     enum_<Event::EventType>("EventType")
@@ -25,6 +25,12 @@ namespace pgmlink {
   using namespace vigra;
 
   // extending Traxel
+  void refresh_coordinates(Traxel& t) {
+    if(t.has_cached_coordinates()) {
+      t.update_coordinates();
+    }
+  }
+
   void set_intmaxpos_locator(Traxel& t) {
     Locator* l = new IntmaxposLocator();
     t.set_locator(l); // takes ownership of pointer
@@ -32,16 +38,24 @@ namespace pgmlink {
 
   void set_x_scale(Traxel& t, double s) {
     t.locator()->x_scale = s;
+    refresh_coordinates(t);
   }
   void set_y_scale(Traxel& t, double s) {
     t.locator()->y_scale = s;
+    refresh_coordinates(t);
   }
   void set_z_scale(Traxel& t, double s) {
     t.locator()->z_scale = s;
+    refresh_coordinates(t);
   }
 
   void add_feature_array(Traxel& t, string key, size_t size) {
-    t.features[key] = feature_array(size, 0);
+    t.set_feature(key, feature_array(size, 0));
+  }
+
+  void set_features(Traxel& t, const FeatureMap& features) {
+    t.features = features;
+    refresh_coordinates(t);
   }
 
   float get_feature_value(Traxel& t, string key, MultiArrayIndex i) {
@@ -65,6 +79,7 @@ namespace pgmlink {
       throw std::runtime_error("index out of range");
     }
     it->second[i] = value;
+    refresh_coordinates(t);
   }
 
   // extending Traxels
@@ -133,7 +148,8 @@ void export_traxels() {
         .def("X", &Traxel::X)
         .def("Y", &Traxel::Y)
         .def("Z", &Traxel::Z)
-	.def_readwrite("features", &Traxel::features)
+	.add_property("features", make_getter(&Traxel::features, return_value_policy<return_by_value>()), &set_features,
+		      "Copy of the feature map; changing it does not change the traxel. Assign the whole map or use set_feature_value(), both refresh the cached coordinates.")
         .def("add_feature_array", &add_feature_array, args("self","name", "size"), "Add a new feature array to the features map; initialize with zeros. If the name is already present, the old feature array will be replaced.")
 	.def("get_feature_value", &get_feature_value, args("self", "name", "index"))
 	.def("set_feature_value", &set_feature_value, args("self", "name", "index", "value"))
@@ -0,0 +1,92 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pgmlink/arc_features.h"
+#include "pgmlink/log.h"
+
+using namespace std;
+
+namespace pgmlink {
+
+void compute_arc_features(HypothesesGraph& g,
+                          bool with_optical_correction,
+                          const vector<boost::shared_ptr<feature_extraction::FeatureExtractor> >& extractors) {
+  LOG(logDEBUG) << "compute_arc_features(): entered";
+  g.add(arc_distance());
+  property_map<arc_distance, HypothesesGraph::base_graph>::type& distances = g.get(arc_distance());
+  const NodeTraxels traxels(g);
+  if (g.has_property(arc_features())) {
+    // distances are overwritten below
+    g.get(arc_features()).computed_.clear();
+  }
+
+  vector<HypothesesGraph::Arc> arcs;
+  for (HypothesesGraph::ArcIt a(g); a != lemon::INVALID; ++a) {
+    arcs.push_back(a);
+  }
+
+  // exceptions must not leave the parallel region
+  bool failed = false;
+  string error;
+  const int n = static_cast<int>(arcs.size());
+#   pragma omp parallel for
+  for (int i = 0; i < n; ++i) {
+    try {
+      const Traxel& from = traxels[g.source(arcs[i])];
+      const Traxel& to = traxels[g.target(arcs[i])];
+      distances[arcs[i]] = with_optical_correction ? from.distance_to_corr(to) : from.distance_to(to);
+    } catch (const std::exception& e) {
+#     pragma omp critical(compute_arc_features)
+      {
+        failed = true;
+        error = e.what();
+      }
+    }
+  }
+  if (failed) {
+    throw runtime_error("compute_arc_features(): " + error);
+  }
+
+  vector<size_t> offsets(extractors.size() + 1, 0);
+  vector<string> names;
+  vector<double> values;
+  if (!extractors.empty()) {
+    feature_extraction::PairwiseFeatureExtraction extraction(extractors);
+    // the first arc determines the size of the features
+    if (!arcs.empty()) {
+      extraction.set_layout(traxels[g.source(arcs[0])], traxels[g.target(arcs[0])]);
+      offsets = extraction.offsets();
+    }
+    names = extraction.names();
+
+    // one row per arc id; ids without an arc keep NULL traxels
+    vector<feature_extraction::PairwiseFeatureExtraction::TraxelPair> pairs(
+        g.maxArcId() + 1, feature_extraction::PairwiseFeatureExtraction::TraxelPair(NULL, NULL));
+    for (size_t i = 0; i < arcs.size(); ++i) {
+      pairs[HypothesesGraph::id(arcs[i])] = make_pair(&traxels[g.source(arcs[i])], &traxels[g.target(arcs[i])]);
+    }
+    values.assign(pairs.size() * offsets.back(), 0.);
+    if (offsets.back() > 0) {
+      extraction(&pairs[0], pairs.size(), &values[0]);
+    }
+  }
+
+  // the table is also created without extractors: it records which arcs have
+  // a precomputed distance
+  g.add(arc_features());
+  ArcFeatureTable& table = g.get(arc_features());
+  table.dimension_ = offsets.back();
+  table.names_.swap(names);
+  table.offsets_.swap(offsets);
+  table.values_.swap(values);
+  table.optical_correction_ = with_optical_correction;
+  table.computed_.assign(g.maxArcId() + 1, false);
+  for (size_t i = 0; i < arcs.size(); ++i) {
+    table.computed_[HypothesesGraph::id(arcs[i])] = true;
+  }
+  LOG(logDEBUG) << "compute_arc_features(): computed features of " << n << " arcs";
+}
+
+} /* namespace pgmlink */
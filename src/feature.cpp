@@ -1,5 +1,6 @@
 #include "pgmlink/feature.h"
 #include "pgmlink/log.h"
+#include <algorithm>
 #include <cmath>
 #include <string>
 
@@ -76,6 +77,14 @@ namespace pgmlink {
 	  return div_prob;
   }
 
+  // energies[i] = -weight * ln(max(args[i], 1e-10))
+  void neg_ln(const double* args, size_t n, double weight, double* energies) {
+#   pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+      energies[i] = -weight * log(std::max(args[i], 0.0000000001));
+    }
+  }
+
   }
 
 
@@ -108,6 +117,10 @@ double NegLnDetection::operator ()(const Traxel& tr, size_t state) const {
 	return w_*-1*log(arg);
 }
 
+void NegLnDetection::operator ()(const double* det_probs, size_t n, double* energies) const {
+	neg_ln(det_probs, n, w_, energies);
+}
+
 
 ////
 //// class NegLnDivision
@@ -121,6 +134,19 @@ double NegLnDivision::operator ()(const Traxel& tr, size_t state) const {
 	return w_*-1*log(arg);
 }
 
+void NegLnDivision::operator ()(const double* div_probs, size_t n, size_t state, double* energies) const {
+	if (state == 0) {
+		std::vector<double> args(n);
+#		pragma omp simd
+		for (size_t i = 0; i < n; ++i) {
+			args[i] = 1 - div_probs[i];
+		}
+		neg_ln(n ? &args[0] : NULL, n, w_, energies);
+	} else {
+		neg_ln(div_probs, n, w_, energies);
+	}
+}
+
 
 ////
 //// class NegLnTransition
@@ -131,6 +157,21 @@ double NegLnTransition::operator ()(const double dist_prob) const {
 	return w_*-1*log(arg);
 }
 
+void NegLnTransition::operator ()(const double* dist_probs, size_t n, double* energies) const {
+	neg_ln(dist_probs, n, w_, energies);
+}
+
+void NegLnTransition::operator ()(const double* distances, size_t n, double alpha, size_t state, double* energies) const {
+	std::vector<double> probs(n);
+	const double sign = state == 0 ? -1. : 1.;
+	const double offset = state == 0 ? 1. : 0.;
+#	pragma omp simd
+	for (size_t i = 0; i < n; ++i) {
+		probs[i] = offset + sign * exp(-distances[i] / alpha);
+	}
+	neg_ln(n ? &probs[0] : NULL, n, w_, energies);
+}
+
 
 ////
 //// class NegLnConstant
@@ -392,5 +433,14 @@ double NegLnConstant::operator ()(size_t state) const {
 	}
   }
 
+ void SpatialBorderAwareWeight::operator()( const double* /*t*/, const double* x, const double* y, const double* z,
+                                           size_t n, double* energies ) const {
+	fov_.spatial_distance_to_border(x, y, z, n, relative_, energies);
+#	pragma omp simd
+	for (size_t i = 0; i < n; ++i) {
+		energies[i] = energies[i] < margin_ ? (energies[i] / margin_) * cost_ : cost_;
+	}
+  }
+
 
 } /* namespace pgmlink */
@@ -1,3 +1,6 @@
+// stl
+#include <algorithm>
+
 // pgmlink
 #include "pgmlink/feature.h"
 #include "pgmlink/feature_calculator/base.h"
@@ -29,6 +32,12 @@ feature_array FeatureCalculator::calculate(const feature_array& /* f1 */, const
 }
 
 
+void FeatureCalculator::calculate_into(const feature_type* f1, const feature_type* f2, size_t size, double* out) const {
+  const feature_array result = calculate(feature_array(f1, f1 + size), feature_array(f2, f2 + size));
+  std::copy(result.begin(), result.end(), out);
+}
+
+
 const std::string& FeatureCalculator::name() const {
   return name_;
 }
@@ -33,6 +33,15 @@ feature_array ElementWiseSquaredDistanceCalculator::calculate(const feature_arra
 }
 
 
+void ElementWiseSquaredDistanceCalculator::calculate_into(const feature_type* f1, const feature_type* f2, size_t size, double* out) const {
+#   pragma omp simd
+  for (size_t i = 0; i < size; ++i) {
+    const feature_type diff = f1[i] - f2[i];
+    out[i] = diff * diff;
+  }
+}
+
+
 const std::string& ElementWiseSquaredDistanceCalculator::name() const {
   return name_;
 }
@@ -28,6 +28,22 @@ feature_array SquaredDifferenceCalculator::calculate(const feature_array& f1, co
 }
 
 
+void SquaredDifferenceCalculator::calculate_into(const feature_type* f1, const feature_type* f2, size_t size, double* out) const {
+  // accumulate in feature_type to match calculate()
+  feature_type sum = 0.;
+  for (size_t i = 0; i < size; ++i) {
+    const feature_type diff = f1[i] - f2[i];
+    sum += diff * diff;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = 0.;
+  }
+  if (size > 0) {
+    out[0] = sum;
+  }
+}
+
+
 const std::string& SquaredDifferenceCalculator::name() const {
   return SquaredDifferenceCalculator::name_;
 }
@@ -1,7 +1,9 @@
 // stl
+#include <cstddef>
 #include <string>
 #include <stdexcept>
 #include <map>
+#include <vector>
 
 // boost
 #include <boost/shared_ptr.hpp>
@@ -77,6 +79,10 @@ boost::shared_ptr<FeatureCalculator> FeatureExtractor::calculator() const {
   return calculator_;
 }
 
+const std::string& FeatureExtractor::feature_name() const {
+  return feature_name_;
+}
+
 std::string FeatureExtractor::name() const {
   return calculator_->name() + "<" + feature_name_ + ">";
 }
@@ -137,6 +143,92 @@ MultipleFeatureExtraction::CombinedFeatureMap MultipleFeatureExtraction::operato
 
 
 
+////
+//// class PairwiseFeatureExtraction
+////
+PairwiseFeatureExtraction::PairwiseFeatureExtraction( const MultipleFeatureExtraction::FeatureList& features ) {
+  for ( MultipleFeatureExtraction::FeatureList::const_iterator outer_features = features.begin(); outer_features != features.end(); ++outer_features) {
+    boost::shared_ptr<FeatureCalculator> calc = helpers::CalculatorLookup::extract_calculator(outer_features->first );
+    for ( std::vector<std::string>::const_iterator inner_features = outer_features->second.begin();
+          inner_features != outer_features->second.end();
+          ++inner_features ) {
+      calculators_.push_back( calc );
+      feature_names_.push_back( *inner_features );
+      names_.push_back( FeatureExtractor( calc, *inner_features ).name() );
+    }
+  }
+}
+
+
+PairwiseFeatureExtraction::PairwiseFeatureExtraction( const std::vector<boost::shared_ptr<FeatureExtractor> >& extractors ) {
+  for ( std::vector<boost::shared_ptr<FeatureExtractor> >::const_iterator extractor = extractors.begin();
+        extractor != extractors.end();
+        ++extractor ) {
+    calculators_.push_back( (*extractor)->calculator() );
+    feature_names_.push_back( (*extractor)->feature_name() );
+    names_.push_back( (*extractor)->name() );
+  }
+}
+
+
+size_t PairwiseFeatureExtraction::set_layout( const Traxel& trax1, const Traxel& trax2 ) {
+  sizes_.clear();
+  offsets_.assign( 1, 0 );
+  for ( size_t i = 0; i < calculators_.size(); ++i ) {
+    // throws if the feature is missing
+    const size_t size = FeatureExtractor( calculators_[i], feature_names_[i] ).extract( trax1, trax2 ).size();
+    sizes_.push_back( trax1.features.find( feature_names_[i] )->second.size() );
+    offsets_.push_back( offsets_.back() + size );
+  }
+  return dimension();
+}
+
+
+void PairwiseFeatureExtraction::operator() ( const TraxelPair* pairs, size_t n, double* out ) const {
+  if ( offsets_.empty() && !calculators_.empty() ) {
+    throw std::runtime_error( "PairwiseFeatureExtraction: set_layout() has to be called first" );
+  }
+  const size_t dim = dimension();
+
+  // exceptions must not leave the parallel region
+  bool failed = false;
+  std::string error;
+  const int rows = static_cast<int>( n );
+#   pragma omp parallel for
+  for ( int row = 0; row < rows; ++row ) {
+    const Traxel* trax1 = pairs[row].first;
+    const Traxel* trax2 = pairs[row].second;
+    if ( trax1 == NULL || trax2 == NULL ) {
+      continue;
+    }
+    try {
+      for ( size_t i = 0; i < calculators_.size(); ++i ) {
+        FeatureMap::const_iterator f1 = trax1->features.find( feature_names_[i] );
+        FeatureMap::const_iterator f2 = trax2->features.find( feature_names_[i] );
+        if ( f1 == trax1->features.end() || f2 == trax2->features.end() ) {
+          throw std::runtime_error( "Feature " + feature_names_[i] + " not present in traxel." );
+        }
+        if ( f1->second.size() != sizes_[i] || f2->second.size() != sizes_[i] ) {
+          throw std::runtime_error( "Feature " + feature_names_[i] + " differs in size." );
+        }
+        const feature_type* values1 = sizes_[i] > 0 ? &f1->second[0] : NULL;
+        const feature_type* values2 = sizes_[i] > 0 ? &f2->second[0] : NULL;
+        calculators_[i]->calculate_into( values1, values2, sizes_[i], out + row * dim + offsets_[i] );
+      }
+    } catch ( const std::exception& e ) {
+#     pragma omp critical(pairwise_feature_extraction)
+      {
+        failed = true;
+        error = e.what();
+      }
+    }
+  }
+  if ( failed ) {
+    throw std::runtime_error( "PairwiseFeatureExtraction: " + error );
+  }
+}
+
+
 namespace helpers {
 
 
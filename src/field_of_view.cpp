@@ -32,9 +32,18 @@ namespace pgmlink {
     ub_.push_back(uy);
     ub_.push_back(uz);
 
+    update_faces();
     return *this;
   }
 
+  void FieldOfView::update_faces() {
+    with_z_faces_ = ub_[3] - lb_[3] > 0;
+    face_ub_z_ = with_z_faces_ ? ub_[3] : 1.0; // 2D case
+    extent_[0] = ub_[1] - lb_[1];
+    extent_[1] = ub_[2] - lb_[2];
+    extent_[2] = face_ub_z_ - lb_[3];
+  }
+
   bool FieldOfView::contains( double t, double x, double y, double z ) const {
 
     if(    lb_[0] <= t && t <= ub_[0]
@@ -133,49 +142,44 @@ namespace pgmlink {
     return *min_element(ds, ds+6);
   }
   
+  namespace {
+    // distance of (x, y, z) to the nearest of the axis aligned faces
+    //   x = lx, x = ux, y = ly, y = uy (, z = lz, z = uz)
+    // optionally relative to the extent of the cuboid along the face normal
+    inline double distance_to_faces( double x, double y, double z,
+				     double lx, double ly, double lz,
+				     double ux, double uy, double uz,
+				     const double extent[3], bool with_z, bool relative ) {
+      double dx = min(fabs(x - lx), fabs(x - ux));
+      double dy = min(fabs(y - ly), fabs(y - uy));
+      double dz = min(fabs(z - lz), fabs(z - uz));
+      if (relative) {
+	dx /= extent[0];
+	dy /= extent[1];
+	dz /= extent[2];
+      }
+      double d = min(dx, dy);
+      return with_z ? min(d, dz) : d;
+    }
+  }
+
   double FieldOfView::spatial_distance_to_border( double /*t*/, double x, double y, double z, bool relative ) const {
 	  //distance to 6 cuboid planes, in the 2D case where Z=0,
 	  //we take the planes with Z upper bound set to 1.0
 	  //and return the distances to the 4 corresponding planes
-	  double zub = 1.0;// 2D case
-	  int vlen = 4;
-
-	  if (ub_[3] - lb_[3] > 0 ){ //3D case
-		  zub = ub_[3];
-		  vlen = 6;
-	  }
-	// the eight corners of the fov cube
-	double c1[3], c2[3], c3[3], c4[3], c5[3], c6[3], /*c7[3],*/ c8[3];
-	c1[0] = lb_[1]; c1[1] = lb_[2]; c1[2] = lb_[3];
-	c2[0] = ub_[1]; c2[1] = lb_[2]; c2[2] = lb_[3];
-	c3[0] = ub_[1]; c3[1] = ub_[2]; c3[2] = lb_[3];
-	c4[0] = lb_[1]; c4[1] = ub_[2]; c4[2] = lb_[3];
-
-	c5[0] = lb_[1]; c5[1] = lb_[2]; c5[2] = zub;
-	c6[0] = ub_[1]; c6[1] = lb_[2]; c6[2] = zub;
-	//c7[0] = ub_[1]; c7[1] = ub_[2]; c7[2] = zub; // unused
-	c8[0] = lb_[1]; c8[1] = ub_[2]; c8[2] = zub;
-
-	// distances to the six faces of the cube
-	double ds[6];
-	double q[3] = {x, y, z};
-	ds[0] = abs_distance(c1, c2, c5, q);
-	ds[1] = abs_distance(c2, c3, c6, q);
-	ds[2] = abs_distance(c4, c3, c8, q);
-	ds[3] = abs_distance(c1, c4, c5, q);
-	ds[4] = abs_distance(c1, c2, c4, q);
-	ds[5] = abs_distance(c5, c6, c8, q);
-
-	if (relative) {
-		//normalize relative to radius of range
-		ds[0] /= ((ub_[2] - lb_[2])); // / 2);
-		ds[1] /= ((ub_[1] - lb_[1]));// / 2);
-		ds[2] /= ((ub_[2] - lb_[2])); // / 2);
-		ds[3] /= ((ub_[1] - lb_[1])); // / 2);
-		ds[4] /= ((zub - lb_[3])); // / 2);
-		ds[5] /= ((zub - lb_[3])); // / 2);
-	}
-	return *min_element(ds, ds+vlen);
+	  return distance_to_faces(x, y, z, lb_[1], lb_[2], lb_[3], ub_[1], ub_[2], face_ub_z_,
+				   extent_, with_z_faces_, relative);
+  }
+
+  void FieldOfView::spatial_distance_to_border( const double* x, const double* y, const double* z, size_t n,
+						bool relative, double* distances ) const {
+    const double lx = lb_[1], ly = lb_[2], lz = lb_[3];
+    const double ux = ub_[1], uy = ub_[2], uz = face_ub_z_;
+    const bool with_z = with_z_faces_;
+#   pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+      distances[i] = distance_to_faces(x[i], y[i], z[i], lx, ly, lz, ux, uy, uz, extent_, with_z, relative);
+    }
   }
 
 
@@ -6,12 +6,15 @@
 #include <vector>
 #include <algorithm>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <lemon/lgf_reader.h>
 #include <lemon/lgf_writer.h>
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_snapshot.h"
 #include "pgmlink/log.h"
 #include "pgmlink/nearest_neighbors.h"
 #include "pgmlink/traxels.h"
@@ -56,6 +59,60 @@ HypothesesGraph::node_timestep_map::Value HypothesesGraph::latest_timestep() con
 
 
 
+////
+//// class NodeTraxels
+////
+NodeTraxels::NodeTraxels(const HypothesesGraph& g)
+    : refs_(NULL), traxels_(&g.get(node_traxel())) {
+    if (g.has_property(node_traxel_ref())) {
+        refs_ = &g.get(node_traxel_ref());
+    }
+}
+
+void NodeTraxels::set(const Key& node, const Traxel& traxel) {
+    traxels_->set(node, traxel);
+    if (refs_ != NULL) {
+        refs_->set(node, NULL);
+    }
+}
+
+void copy_referenced_traxels(HypothesesGraph& g) {
+    if (!g.has_property(node_traxel_ref())) {
+        return;
+    }
+    property_map<node_traxel_ref, HypothesesGraph::base_graph>::type& refs = g.get(node_traxel_ref());
+    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxels = g.get(node_traxel());
+    for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
+        if (refs[n] != NULL) {
+            traxels.set(n, *refs[n]);
+            refs.set(n, NULL);
+        }
+    }
+}
+
+ActiveNodeFilter::ActiveNodeFilter(const HypothesesGraph& g)
+    : active_(NULL), active2_(NULL) {
+    if (g.has_property(node_active())) {
+        active_ = &g.get(node_active());
+    } else {
+        active2_ = &g.get(node_active2());
+    }
+}
+
+ActiveSubgraph::ActiveSubgraph(const HypothesesGraph& g)
+    : boost::base_from_member<ActiveNodeFilter>(ActiveNodeFilter(g)),
+      base_view(g, member, g.get(arc_active())),
+      graph_(&g) {
+}
+
+ActiveSubgraph::ActiveSubgraph(const ActiveSubgraph& other)
+    : boost::base_from_member<ActiveNodeFilter>(other.member),
+      base_view(*other.graph_, member, other.graph_->get(arc_active())),
+      graph_(other.graph_) {
+}
+
+
+
 HypothesesGraph& prune_inactive(HypothesesGraph& g) {
     LOG(logDEBUG) << "prune_inactive(): entered";
     property_map<arc_active, HypothesesGraph::base_graph>::type& active_arcs = g.get(arc_active());
@@ -63,10 +120,10 @@ HypothesesGraph& prune_inactive(HypothesesGraph& g) {
     property_map<node_active, HypothesesGraph::base_graph>::type* active_nodes = 0;
     property_map<node_active2, HypothesesGraph::base_graph>::type* active2_nodes = 0;
     bool active2_used = false;
-    if (g.getProperties().count("node_active") > 0) {
+    if (g.has_property(node_active())) {
         active_nodes = &g.get(node_active());
     } else {
-        assert(g.getProperties().count("node_active2") > 0);
+        assert(g.has_property(node_active2()));
         active2_nodes = &g.get(node_active2());
         active2_used = true;
     }
@@ -119,10 +176,18 @@ HypothesesGraph& prune_inactive(HypothesesGraph& g) {
         }
     }
 
-    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+    const NodeTraxels traxel_map(g);
+    property_map<node_traxel_ref, HypothesesGraph::base_graph>::type* traxel_refs = NULL;
+    if (g.has_property(node_traxel_ref())) {
+        traxel_refs = &g.get(node_traxel_ref());
+    }
     // prune inactive nodes
     for(vector<HypothesesGraph::Node>::const_iterator it = nodes_to_prune.begin(); it!= nodes_to_prune.end(); ++it) {
         LOG(logDEBUG3) << "prune_inactive: prune node: " << g.id(*it) << ", Traxel = " << traxel_map[*it];
+        if (traxel_refs != NULL) {
+            // the id may be reused by a new node
+            traxel_refs->set(*it, NULL);
+        }
         for(HypothesesGraph::OutArcIt arcit(g,*it); arcit != lemon::INVALID; ++arcit) {
             assert(active_arcs[arcit] == false && "arc may not be active");
         }
@@ -139,22 +204,29 @@ HypothesesGraph& prune_inactive(HypothesesGraph& g) {
 
 
 boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGraph& g) {
+    return events(*freeze(g));
+}
+
+boost::shared_ptr<std::vector< std::vector<Event> > > events(const ActiveSubgraph& view) {
+    return events(*freeze(view));
+}
+
+boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGraphSnapshot& s) {
     LOG(logDEBUG) << "events(): entered";
+    typedef HypothesesGraphSnapshot::index_iterator index_iterator;
+    const HypothesesGraph& g = s.graph();
     boost::shared_ptr<std::vector< std::vector<Event> > > ret(new vector< vector<Event> >);
-    typedef property_map<node_timestep, HypothesesGraph::base_graph>::type node_timestep_map_t;
-    node_timestep_map_t& node_timestep_map = g.get(node_timestep());
-    typedef property_map<node_traxel, HypothesesGraph::base_graph>::type node_traxel_map_t;
-    node_traxel_map_t& node_traxel_map = g.get(node_traxel());
+    const NodeTraxels node_traxel_map(g);
     property_map<division_active, HypothesesGraph::base_graph>::type* division_node_map;
     
     bool with_division_detection = false;
-    if (g.getProperties().count("division_active") > 0) {
+    if (g.has_property(division_active())) {
         division_node_map = &g.get(division_active());
         with_division_detection = true;
     }
     property_map<node_active2, HypothesesGraph::base_graph>::type* node_number_of_objects;
     bool with_mergers = false;
-    if (g.getProperties().count("node_active2") > 0) {
+    if (g.has_property(node_active2())) {
         node_number_of_objects = &g.get(node_active2());
         with_mergers = true;
         LOG(logDEBUG1) << "events(): with_mergers = true";
@@ -162,20 +234,20 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
 
     bool with_origin = false;
     property_map<node_originated_from, HypothesesGraph::base_graph>::type* origin_map;
-    if (g.getProperties().count("node_originated_from") > 0) {
+    if (g.has_property(node_originated_from())) {
         origin_map = &g.get(node_originated_from());
         with_origin = true;
         LOG(logDEBUG1) << "events(): with_origin enabeld";
     }
 
     // for every timestep
-    LOG(logDEBUG1) << "events(): earliest_timestep: " << g.earliest_timestep();
-    LOG(logDEBUG1) << "events(): latest_timestep: " << g.latest_timestep();
+    LOG(logDEBUG1) << "events(): earliest_timestep: " << s.earliest_timestep();
+    LOG(logDEBUG1) << "events(): latest_timestep: " << s.latest_timestep();
 
     // add an empty first timestep
     ret->push_back(vector<Event>());
 
-    for(int t = g.earliest_timestep(); t < g.latest_timestep(); ++t) {
+    for(int t = s.earliest_timestep(); t < s.latest_timestep(); ++t) {
         LOG(logDEBUG2) << "events(): processing timestep: " << t;
         ret->push_back(vector<Event>());
 
@@ -183,7 +255,8 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
 
         // for every node: destiny
         LOG(logDEBUG2) << "events(): for every node: destiny";
-        for(node_timestep_map_t::ItemIt node_at(node_timestep_map, t); node_at!=lemon::INVALID; ++node_at) {
+        for(index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+            const HypothesesGraph::Node node_at = s.node(*n);
             assert(node_traxel_map[node_at].Timestep == t);
 
             if (with_origin && (*origin_map)[node_at].size() > 0) { // && t > g.earliest_timestep()) {
@@ -193,38 +266,23 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
                 resolver_map[origin_traxel_id].push_back(resolved_traxel_id);
             }
 
+            if (with_mergers) {
+                LOG(logDEBUG3) << "Number of detected objects: " << (*node_number_of_objects)[node_at];
+            }
 
-//            if (with_resolved && ((*resolved_map)[node_at]).size() > 0) {
-//                // property_map<merger_resolved_to, HypothesesGraph::base_graph>::type::ItemIt resolved_it;
-//                // resolved_it = std::find(resolved_it
-//                LOG(logINFO) << "events(): entered resolved_to event creation...";
-//                Event e;
-//                e.type = Event::ResolvedTo;
-//                e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-//                std::vector<unsigned int> ids = (*resolved_map)[node_at];
-//                for (std::vector<unsigned int>::iterator it = ids.begin(); it != ids.end(); ++it) {
-//                    e.traxel_ids.push_back(*it);
-//                }
-//                (*ret)[t-g.earliest_timestep()].push_back(e);
-//                LOG(logDEBUG3) << e;
-//            }
-
-            LOG(logDEBUG3) << "Number of detected objects: " << (*node_number_of_objects)[node_at];
-
-            // count outgoing arcs
-            size_t count = 0;
-            for(HypothesesGraph::base_graph::OutArcIt a(g, node_at); a!=lemon::INVALID; ++a) ++count;
+            const size_t count = s.out_degree(*n);
+            const index_iterator out = s.out_begin(*n);
             LOG(logDEBUG3) << "events(): counted outgoing arcs: " << count;
 
             // construct suitable Event object
             switch(count) {
                 // Disappearance
                 case 0: {
-                    if (t<g.latest_timestep()) {
+                    if (t<s.latest_timestep()) {
                         Event e;
                         e.type = Event::Disappearance;
                         e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                        (*ret)[t-g.earliest_timestep()+1].push_back(e);
+                        (*ret)[t-s.earliest_timestep()+1].push_back(e);
                         LOG(logDEBUG3) << e;
                     }
                     break;
@@ -234,9 +292,8 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
                     Event e;
                     e.type = Event::Move;
                     e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                    HypothesesGraph::base_graph::OutArcIt a(g, node_at);
-                    e.traxel_ids.push_back(node_traxel_map[g.target(a)].Id);
-                    (*ret)[t-g.earliest_timestep()+1].push_back(e);
+                    e.traxel_ids.push_back(node_traxel_map[s.node(s.target(out[0]))].Id);
+                    (*ret)[t-s.earliest_timestep()+1].push_back(e);
                     LOG(logDEBUG3) << e;
                     break;
                 }
@@ -247,19 +304,17 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
                         if (count == 2 && (*division_node_map)[node_at]) {
                             e.type = Event::Division;
                             e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                            HypothesesGraph::base_graph::OutArcIt a(g, node_at);
-                            e.traxel_ids.push_back(node_traxel_map[g.target(a)].Id);
-                            ++a;
-                            e.traxel_ids.push_back(node_traxel_map[g.target(a)].Id);
-                            (*ret)[t-g.earliest_timestep()+1].push_back(e);
+                            e.traxel_ids.push_back(node_traxel_map[s.node(s.target(out[0]))].Id);
+                            e.traxel_ids.push_back(node_traxel_map[s.node(s.target(out[1]))].Id);
+                            (*ret)[t-s.earliest_timestep()+1].push_back(e);
                             LOG(logDEBUG3) << e;
                         } else {
-                            for(HypothesesGraph::base_graph::OutArcIt a(g, node_at); a != lemon::INVALID; ++a) {
+                            for(index_iterator a = out; a != s.out_end(*n); ++a) {
                                 e.type = Event::Move;
                                 e.traxel_ids.clear();
                                 e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                                e.traxel_ids.push_back(node_traxel_map[g.target(a)].Id);
-                                (*ret)[t-g.earliest_timestep()+1].push_back(e);
+                                e.traxel_ids.push_back(node_traxel_map[s.node(s.target(*a))].Id);
+                                (*ret)[t-s.earliest_timestep()+1].push_back(e);
                                 LOG(logDEBUG3) << e;
                             }
                         }
@@ -269,11 +324,9 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
                         }
                         e.type = Event::Division;
                         e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                        HypothesesGraph::base_graph::OutArcIt a(g, node_at);
-                        e.traxel_ids.push_back(node_traxel_map[g.target(a)].Id);
-                        ++a;
-                        e.traxel_ids.push_back(node_traxel_map[g.target(a)].Id);
-                        (*ret)[t-g.earliest_timestep()+1].push_back(e);
+                        e.traxel_ids.push_back(node_traxel_map[s.node(s.target(out[0]))].Id);
+                        e.traxel_ids.push_back(node_traxel_map[s.node(s.target(out[1]))].Id);
+                        (*ret)[t-s.earliest_timestep()+1].push_back(e);
                         LOG(logDEBUG3) << e;
                     }
                     break;
@@ -287,57 +340,58 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
             for (std::vector<unsigned int>::iterator it = map_it->second.begin(); it != map_it->second.end(); ++it) {
                 e.traxel_ids.push_back(*it);
             }
-            (*ret)[t-g.earliest_timestep()].push_back(e);
+            (*ret)[t-s.earliest_timestep()].push_back(e);
             LOG(logDEBUG1) << e;
         }
 
 
         // appearances and mergers in next timestep
         LOG(logDEBUG2) << "events(): appearances in next timestep";
-        if (t+1 <= g.latest_timestep()) {
-            for(node_timestep_map_t::ItemIt node_at(node_timestep_map, t+1); node_at!=lemon::INVALID; ++node_at) {
-                // count incoming arcs
-                int count = 0;
-                for(HypothesesGraph::base_graph::InArcIt a(g, node_at); a!=lemon::INVALID; ++a) ++count;
-                LOG(logDEBUG3) << "events(): counted incoming arcs in next timestep: " << count;
+        if (t+1 <= s.latest_timestep()) {
+            for(index_iterator n = s.timestep_begin(t+1); n != s.timestep_end(t+1); ++n) {
+                LOG(logDEBUG3) << "events(): counted incoming arcs in next timestep: " << s.in_degree(*n);
 
                 // no incoming arcs => appearance
-                if(count == 0 && t + 1 > g.earliest_timestep()) {
+                if(s.in_degree(*n) == 0 && t + 1 > s.earliest_timestep()) {
                     Event e;
                     e.type = Event::Appearance;
-                    e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                    (*ret)[t-g.earliest_timestep()+1].push_back(e);
+                    e.traxel_ids.push_back(node_traxel_map[s.node(*n)].Id);
+                    (*ret)[t-s.earliest_timestep()+1].push_back(e);
                     LOG(logDEBUG3) << e;
                 }
             }
         }
-        for(node_timestep_map_t::ItemIt node_at(node_timestep_map, t); node_at!=lemon::INVALID; ++node_at) {
-            if(with_mergers && (*node_number_of_objects)[node_at] > 1) {
-                Event e;
-                e.type = Event::Merger;
-                e.traxel_ids.push_back(node_traxel_map[node_at].Id);
-                e.traxel_ids.push_back((*node_number_of_objects)[node_at]);
-                (*ret)[t-g.earliest_timestep()].push_back(e);
-                LOG(logDEBUG3) << e;
+        if (with_mergers) {
+            for(index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+                const HypothesesGraph::Node node_at = s.node(*n);
+                if((*node_number_of_objects)[node_at] > 1) {
+                    Event e;
+                    e.type = Event::Merger;
+                    e.traxel_ids.push_back(node_traxel_map[node_at].Id);
+                    e.traxel_ids.push_back((*node_number_of_objects)[node_at]);
+                    (*ret)[t-s.earliest_timestep()].push_back(e);
+                    LOG(logDEBUG3) << e;
+                }
             }
         }
 
     }
 
-    LOG(logDEBUG2) << "events(): last timestep: " << g.latest_timestep();
+    LOG(logDEBUG2) << "events(): last timestep: " << s.latest_timestep();
     map<unsigned int, vector<unsigned int> > resolver_map;
-    int t = g.latest_timestep();
-    for(node_timestep_map_t::ItemIt node_at(node_timestep_map, g.latest_timestep()); node_at!=lemon::INVALID; ++node_at) {
+    int t = s.latest_timestep();
+    for(index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+        const HypothesesGraph::Node node_at = s.node(*n);
         if(with_mergers && (*node_number_of_objects)[node_at] > 1) {
             Event e;
             e.type = Event::Merger;
             e.traxel_ids.push_back(node_traxel_map[node_at].Id);
             e.traxel_ids.push_back((*node_number_of_objects)[node_at]);
-            (*ret)[g.latest_timestep()-g.earliest_timestep()].push_back(e);
+            (*ret)[s.latest_timestep()-s.earliest_timestep()].push_back(e);
             LOG(logDEBUG3) << e;
         }
 
-        if (with_origin && (*origin_map)[node_at].size() > 0 && t > g.earliest_timestep()) {
+        if (with_origin && (*origin_map)[node_at].size() > 0 && t > s.earliest_timestep()) {
             const unsigned int& origin_traxel_id = (*origin_map)[node_at][0];
             const unsigned int& resolved_traxel_id = node_traxel_map[node_at].Id;
 
@@ -353,7 +407,7 @@ boost::shared_ptr<std::vector< std::vector<Event> > > events(const HypothesesGra
         for (std::vector<unsigned int>::iterator it = map_it->second.begin(); it != map_it->second.end(); ++it) {
             e.traxel_ids.push_back(*it);
         }
-        (*ret)[t-g.earliest_timestep()].push_back(e);
+        (*ret)[t-s.earliest_timestep()].push_back(e);
         LOG(logDEBUG1) << e;
     }
     LOG(logDEBUG2) << "events(): done.";
@@ -366,8 +420,7 @@ boost::shared_ptr<std::vector< std::vector<Event> > > multi_frame_move_events(co
     boost::shared_ptr<std::vector< std::vector<Event> > > ret(new vector< vector<Event> >);
     typedef property_map<node_timestep, HypothesesGraph::base_graph>::type node_timestep_map_t;
     node_timestep_map_t& node_timestep_map = g.get(node_timestep());
-    typedef property_map<node_traxel, HypothesesGraph::base_graph>::type node_traxel_map_t;
-    node_traxel_map_t& node_traxel_map = g.get(node_traxel());
+    const NodeTraxels node_traxel_map(g);
     typedef property_map<node_originated_from, HypothesesGraph::base_graph>::type origin_map_t;
     origin_map_t& origin_map = g.get(node_originated_from());
 
@@ -389,8 +442,7 @@ boost::shared_ptr<std::vector< std::vector<Event> > > multi_frame_move_events(co
                     }
                     Event e;
                     e.type = Event::MultiFrameMove;
-                    Traxel trax = node_traxel_map[src_node];
-                    e.traxel_ids.push_back(trax.Id);
+                    e.traxel_ids.push_back(node_traxel_map[src_node].Id);
                     int t_local = t+1;
                     HypothesesGraph::Node n = node_at;
                     while (t_local <= g.latest_timestep()) {
@@ -401,9 +453,8 @@ boost::shared_ptr<std::vector< std::vector<Event> > > multi_frame_move_events(co
                         n = g.target(merge_it);
                         assert(t_local == node_timestep_map[n]);
                         if (!origin_map[n].size()) {
-                            trax = node_traxel_map[n];
-                            assert(t_local == trax.Timestep);
-                            e.traxel_ids.push_back(trax.Id);
+                            assert(t_local == node_traxel_map[n].Timestep);
+                            e.traxel_ids.push_back(node_traxel_map[n].Id);
                             e.traxel_ids.push_back(t-1-g.earliest_timestep());
                             multi_frame_move_map[t_local-g.earliest_timestep()].push_back(e);
                             break;
@@ -449,11 +500,11 @@ void generateTrackletGraph(const HypothesesGraph& traxel_graph, HypothesesGraph&
     // go through the traxels graph, add each node which doesn't have an active incoming arc, and
     // follow the active outgoing path to add those nodes to the tracklet
     property_map<arc_active, HypothesesGraph::base_graph>::type& active_arcs = traxel_graph.get(arc_active());
-    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = traxel_graph.get(node_traxel());
+    const NodeTraxels traxel_map(traxel_graph);
 
     property_map<node_tracklet, HypothesesGraph::base_graph>::type* traxels_tracklet_map;
     bool traxel_nodes_are_tracklets = false;
-    if (traxel_graph.getProperties().count("node_tracklet") > 0) {
+    if (traxel_graph.has_property(node_tracklet())) {
         traxel_nodes_are_tracklets = true;
         traxels_tracklet_map = &traxel_graph.get(node_tracklet());
     }
@@ -579,18 +630,11 @@ void generateTrackletGraph(const HypothesesGraph& traxel_graph, HypothesesGraph&
 }
 
 namespace {
-std::vector<HypothesesGraph::Arc> getOutgoingArcs(const HypothesesGraph& graph, const HypothesesGraph::Node& n) {
-    std::vector<HypothesesGraph::Arc> result;
-    for(HypothesesGraph::OutArcIt a(graph, n); a != lemon::INVALID; ++a) {
-        result.push_back(a);
-    }
-    return result;
-}
-
-std::vector<HypothesesGraph::Arc> getIncomingArcs(const HypothesesGraph& graph, const HypothesesGraph::Node& n) {
+std::vector<HypothesesGraph::Arc> getIncomingArcs(const HypothesesGraphSnapshot& s, HypothesesGraphSnapshot::index_type n) {
     std::vector<HypothesesGraph::Arc> result;
-    for(HypothesesGraph::InArcIt a(graph, n); a != lemon::INVALID; ++a) {
-        result.push_back(a);
+    result.reserve(s.in_degree(n));
+    for(HypothesesGraphSnapshot::index_iterator a = s.in_begin(n); a != s.in_end(n); ++a) {
+        result.push_back(s.arc(*a));
     }
     return result;
 }
@@ -599,7 +643,7 @@ void addNodeToTracklet(const HypothesesGraph& traxel_graph, HypothesesGraph& tra
                        const HypothesesGraph::Node& traxel_node, const HypothesesGraph::Node& ancestor_traxel_node,
                        std::map<HypothesesGraph::Node, HypothesesGraph::Node>& traxel2tracklet, double traxel_arc_dist,
                        std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> >& tracklet2traxel, const int arc_id) {
-    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = traxel_graph.get(node_traxel());
+    const NodeTraxels traxel_map(traxel_graph);
     property_map<node_tracklet, HypothesesGraph::base_graph>::type& tracklet_map = tracklet_graph.get(node_tracklet());
     property_map<tracklet_intern_dist, HypothesesGraph::base_graph>::type& tracklet_arc_dist_map = tracklet_graph.get(tracklet_intern_dist());
     property_map<tracklet_intern_arc_ids, HypothesesGraph::base_graph>::type& tracklet_arc_id_map = tracklet_graph.get(tracklet_intern_arc_ids());
@@ -608,10 +652,7 @@ void addNodeToTracklet(const HypothesesGraph& traxel_graph, HypothesesGraph& tra
 
     assert(traxel2tracklet.find(ancestor_traxel_node) != traxel2tracklet.end());
     HypothesesGraph::Node tracklet_node = traxel2tracklet[ancestor_traxel_node];
-    std::vector<Traxel> tracklet = tracklet_map[tracklet_node];
-    Traxel tr = traxel_map[traxel_node];
-    tracklet.push_back(tr);
-    tracklet_map.set(tracklet_node, tracklet);
+    tracklet_map[tracklet_node].push_back(traxel_map[traxel_node]);
     traxel2tracklet[traxel_node] = tracklet_node;
     //	size_t timestep = tr.Timestep;
     //	timestep_map[tracklet_node].add(timestep);
@@ -633,16 +674,14 @@ void addNodeToTracklet(const HypothesesGraph& traxel_graph, HypothesesGraph& tra
 void addNodeToGraph(const HypothesesGraph& traxel_graph, HypothesesGraph& tracklet_graph,
                     const HypothesesGraph::Node& traxel_node, std::map<HypothesesGraph::Node, HypothesesGraph::Node>& traxel2tracklet,
                     std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> >& tracklet2traxel) {
-    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = traxel_graph.get(node_traxel());
+    const NodeTraxels traxel_map(traxel_graph);
     property_map<node_tracklet, HypothesesGraph::base_graph>::type& tracklet_map = tracklet_graph.get(node_tracklet());
     property_map<tracklet_intern_dist, HypothesesGraph::base_graph>::type& tracklet_intern_dist_map = tracklet_graph.get(tracklet_intern_dist());
-    std::vector<Traxel> tracklet;
-    Traxel tr = traxel_map[traxel_node];
-    tracklet.push_back(tr);
+    const Traxel& tr = traxel_map[traxel_node];
     size_t timestep = tr.Timestep;
     HypothesesGraph::Node tracklet_node = tracklet_graph.add_node(timestep);
     LOG(logDEBUG4) << "added tracklet node " << tracklet_graph.id(tracklet_node);
-    tracklet_map.set(tracklet_node, tracklet);
+    tracklet_map[tracklet_node].assign(1, tr);
     traxel2tracklet[traxel_node] = tracklet_node;
     std::vector<double> arc_dists;
     tracklet_intern_dist_map.set(tracklet_node, arc_dists);
@@ -676,8 +715,8 @@ void addArcsToGraph(const HypothesesGraph& traxel_graph, HypothesesGraph& trackl
 std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> > generateTrackletGraph2(const HypothesesGraph& traxel_graph, HypothesesGraph& tracklet_graph) {
     property_map<arc_distance, HypothesesGraph::base_graph>::type& traxel_arc_dist_map = traxel_graph.get(arc_distance());
 
-    typedef property_map<node_timestep, HypothesesGraph::base_graph>::type node_timestep_map_t;
-    node_timestep_map_t& node_timestep_map = traxel_graph.get(node_timestep());
+    const boost::shared_ptr<const HypothesesGraphSnapshot> snapshot = freeze(traxel_graph);
+    const HypothesesGraphSnapshot& s = *snapshot;
 
     // add empty traxel_map to the tracklet graph in order to make the tracklet graph equivalent to traxelgraphs
     tracklet_graph.add(node_traxel()).add(arc_distance());
@@ -688,29 +727,29 @@ std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> > generateTra
     // maps traxel_nodes to tracklet_nodes
     std::map<HypothesesGraph::Node, HypothesesGraph::Node > traxel_node_to_tracklet_node;
 
-    for(int t = traxel_graph.earliest_timestep(); t <= traxel_graph.latest_timestep(); ++t) {
-        for(node_timestep_map_t::ItemIt traxel_node(node_timestep_map, t); traxel_node!=lemon::INVALID; ++traxel_node) {
+    for(int t = s.earliest_timestep(); t <= s.latest_timestep(); ++t) {
+        for(HypothesesGraphSnapshot::index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+            const HypothesesGraph::Node traxel_node = s.node(*n);
             LOG(logDEBUG4) << "traxel_node = " << traxel_graph.id(traxel_node);
-            vector<HypothesesGraph::Arc> incoming_arcs = getIncomingArcs(traxel_graph, traxel_node);
-            if(incoming_arcs.size() != 1) {
+            if(s.in_degree(*n) != 1) {
                 addNodeToGraph(traxel_graph, tracklet_graph, traxel_node, traxel_node_to_tracklet_node, tracklet_node_to_traxel_nodes);
-                addArcsToGraph(traxel_graph, tracklet_graph, incoming_arcs, traxel_node_to_tracklet_node);
+                addArcsToGraph(traxel_graph, tracklet_graph, getIncomingArcs(s, *n), traxel_node_to_tracklet_node);
                 LOG(logDEBUG4) << "traxel2tracklet.size(): " << traxel_node_to_tracklet_node.size();
                 continue;
             }
 
-            HypothesesGraph::Node ancestor = traxel_graph.source(incoming_arcs[0]);
-            if(getOutgoingArcs(traxel_graph, ancestor).size() > 1) {
+            const HypothesesGraphSnapshot::index_type incoming_arc = *s.in_begin(*n);
+            const HypothesesGraphSnapshot::index_type ancestor = s.source(incoming_arc);
+            if(s.out_degree(ancestor) > 1) {
                 addNodeToGraph(traxel_graph, tracklet_graph, traxel_node, traxel_node_to_tracklet_node, tracklet_node_to_traxel_nodes);
-                assert(incoming_arcs.size() == 1);
-                addArcsToGraph(traxel_graph, tracklet_graph, incoming_arcs, traxel_node_to_tracklet_node);
+                addArcsToGraph(traxel_graph, tracklet_graph, getIncomingArcs(s, *n), traxel_node_to_tracklet_node);
                 LOG(logDEBUG4) << "traxel2tracklet.size(): " << traxel_node_to_tracklet_node.size();
                 continue;
             }
 
-            double dist = traxel_arc_dist_map[incoming_arcs[0]];
-            int arc_id = traxel_graph.id(incoming_arcs[0]);
-            addNodeToTracklet(traxel_graph, tracklet_graph, traxel_node, ancestor, traxel_node_to_tracklet_node, dist,
+            double dist = traxel_arc_dist_map[s.arc(incoming_arc)];
+            int arc_id = traxel_graph.id(s.arc(incoming_arc));
+            addNodeToTracklet(traxel_graph, tracklet_graph, traxel_node, s.node(ancestor), traxel_node_to_tracklet_node, dist,
                               tracklet_node_to_traxel_nodes, arc_id);
         }
     }
@@ -725,28 +764,36 @@ std::map<HypothesesGraph::Node, std::vector<HypothesesGraph::Node> > generateTra
 // state_of_nodes()
 //
 boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(const HypothesesGraph& g) {
+    return state_of_nodes(*freeze(g));
+}
+
+boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(const ActiveSubgraph& view) {
+    return state_of_nodes(*freeze(view));
+}
+
+boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(const HypothesesGraphSnapshot& s) {
     LOG(logDEBUG) << "detections(): entered";
+    const HypothesesGraph& g = s.graph();
     boost::shared_ptr<vector< map<unsigned int, bool> > > ret(new vector< map<unsigned int, bool> >);
 
     // required node properties: timestep, traxel, active
-    typedef property_map<node_timestep, HypothesesGraph::base_graph>::type node_timestep_map_t;
-    node_timestep_map_t& node_timestep_map = g.get(node_timestep());
-    typedef property_map<node_traxel, HypothesesGraph::base_graph>::type node_traxel_map_t;
-    node_traxel_map_t& node_traxel_map = g.get(node_traxel());
+    const NodeTraxels node_traxel_map(g);
     property_map<node_active, HypothesesGraph::base_graph>::type* node_active_map;
     property_map<node_active2, HypothesesGraph::base_graph>::type* node_active2_map;
     bool active2_used = false;
-    if (g.getProperties().count("node_active") > 0) {
+    if (g.has_property(node_active())) {
         node_active_map = &g.get(node_active());
-    } else if (g.getProperties().count("node_active2") > 0) {
+    } else if (g.has_property(node_active2())) {
         node_active2_map = &g.get(node_active2());
         active2_used = true;
     }
 
     // for every timestep
-    for(int t = g.earliest_timestep(); t <= g.latest_timestep(); ++t) {
+    for(int t = s.earliest_timestep(); t <= s.latest_timestep(); ++t) {
         ret->push_back(map<unsigned int, bool>());
-        for(node_timestep_map_t::ItemIt node_at(node_timestep_map, t); node_at!=lemon::INVALID; ++node_at) {
+        map<unsigned int, bool>& states = ret->back();
+        for(HypothesesGraphSnapshot::index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+            const HypothesesGraph::Node node_at = s.node(*n);
             assert(node_traxel_map[node_at].Timestep == t);
             unsigned int id = node_traxel_map[node_at].Id;
             bool active = false;
@@ -755,7 +802,7 @@ boost::shared_ptr<std::vector< std::map<unsigned int, bool> > > state_of_nodes(c
             } else {
                 active = (*node_active_map)[node_at];
             }
-            (*ret)[t-g.earliest_timestep()][id] = active;
+            states[id] = active;
         }
     }
 
@@ -783,8 +830,9 @@ void write_lgf( const HypothesesGraph& g, std::ostream& os, bool with_n_traxel )
             nodeMap("timestep", g.get(node_timestep())).
             arcMap("from_timestep", g.get(arc_from_timestep())).
             arcMap("to_timestep", g.get(arc_to_timestep()));
+    const NodeTraxels traxels(g);
     if(with_n_traxel) {
-        writer.nodeMap("traxel", g.get(node_traxel()), TraxelToStrConverter());
+        writer.nodeMap("traxel", traxels, TraxelToStrConverter());
     }
     writer.run();
 }
@@ -821,6 +869,21 @@ void read_lgf( HypothesesGraph& g, std::istream& is, bool with_n_traxel ) {
 
 
 
+//
+// write_binary() / read_binary()
+//
+void write_binary( const HypothesesGraph& g, std::ostream& os, bool traxels_by_reference ) {
+    boost::archive::binary_oarchive oa(os);
+    g.save_contents(oa, traxels_by_reference);
+}
+
+void read_binary( HypothesesGraph& g, std::istream& is, const TraxelStore* ts ) {
+    boost::archive::binary_iarchive ia(is);
+    g.load_contents(ia, ts);
+}
+
+
+
 ////
 //// class HypothesesBuilder
 ////
@@ -854,13 +917,25 @@ HypothesesGraph* SingleTimestepTraxel_HypothesesBuilder::construct() const {
     HypothesesGraph* graph = new HypothesesGraph();
     // store traxels inside the graph data structure
     graph->add(node_traxel());
+    if (options_.traxels_by_reference) {
+        // ... or only refer to them
+        graph->add(node_traxel_ref());
+    }
     return graph;
 }
 
 HypothesesGraph* SingleTimestepTraxel_HypothesesBuilder::add_nodes(HypothesesGraph* graph) const {
     LOG(logDEBUG) << "SingleTimestepTraxel_HypothesesBuilder::add_nodes(): entered";
-    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_m = graph->get(node_traxel());
+    if (options_.traxels_by_reference) {
+        property_map<node_traxel_ref, HypothesesGraph::base_graph>::type& traxel_ref_m = graph->get(node_traxel_ref());
+        for(TraxelStoreByTimestep::const_iterator it = ts_->begin(); it!= ts_->end(); ++it) {
+            HypothesesGraph::Node node = graph->add_node(it->Timestep);
+            traxel_ref_m.set(node, &*it);
+        }
+        return graph;
+    }
 
+    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_m = graph->get(node_traxel());
     for(TraxelStoreByTimestep::const_iterator it = ts_->begin(); it!= ts_->end(); ++it) {
         HypothesesGraph::Node node = graph->add_node(it->Timestep);
         traxel_m.set(node, *it);
@@ -897,9 +972,7 @@ HypothesesGraph* SingleTimestepTraxel_HypothesesBuilder::add_edges_at(Hypotheses
                                                                       int timestep, bool reverse) const {
     const HypothesesGraph::node_timestep_map& timemap = graph->get(
                 node_timestep());
-    typedef property_map<node_traxel, HypothesesGraph::base_graph>::type traxelmap_t;
-    const traxelmap_t& traxelmap = graph->get(node_traxel());
-    const TraxelStoreByTimeid& traxels_by_timeid = ts_->get<by_timeid>();
+    const NodeTraxels traxelmap(*graph);
     const TraxelStoreByTimestep& traxels_by_timestep = ts_->get<by_timestep>();
 
     int to_timestep = timestep + 1;
@@ -908,6 +981,12 @@ HypothesesGraph* SingleTimestepTraxel_HypothesesBuilder::add_edges_at(Hypotheses
         to_timestep = timestep - 1;
     }
 
+    // nodes of the next timestep by traxel id
+    map<unsigned int, HypothesesGraph::Node> nodes_by_id;
+    for (HypothesesGraph::node_timestep_map::ItemIt node(timemap, to_timestep); node != lemon::INVALID; ++node) {
+        nodes_by_id[traxelmap[node].Id] = node;
+    }
+
     //// find k nearest neighbors in next timestep
     // init nearest neighbor search
     pair<TraxelStoreByTimestep::const_iterator,
@@ -919,7 +998,9 @@ HypothesesGraph* SingleTimestepTraxel_HypothesesBuilder::add_edges_at(Hypotheses
         assert(it->Timestep == to_timestep);
     }
 
-    NearestNeighborSearch nns(traxels_at.first, traxels_at.second, reverse);
+    NearestNeighborSearch nns(traxels_at.first, traxels_at.second, reverse,
+                              options_.neighbor_index, options_.distance_threshold);
+    vector<NearestNeighborSearch::Neighbor> nearest_neighbors(max(options_.max_nearest_neighbors, 2u));
 
 
     // establish transition edges between a current node and appropriate nodes in next timestep
@@ -939,22 +1020,20 @@ HypothesesGraph* SingleTimestepTraxel_HypothesesBuilder::add_edges_at(Hypotheses
             }
         }
 
-        // search
-        map<unsigned int, double> nearest_neighbors = nns.knn_in_range(
+        // search; the neighbors are connected in the order of their ids
+        const size_t found = nns.knn_in_range(
                     traxelmap[curr_node], options_.distance_threshold,
-                    max_nn, reverse);
+                    max_nn, &nearest_neighbors[0], reverse);
+        sort(nearest_neighbors.begin(), nearest_neighbors.begin() + found);
 
         //// connect current node with k nearest neighbor nodes
-        for (map<unsigned int, double>::const_iterator neighbor =
-             nearest_neighbors.begin(); neighbor != nearest_neighbors.end();
+        for (vector<NearestNeighborSearch::Neighbor>::const_iterator neighbor =
+             nearest_neighbors.begin(); neighbor != nearest_neighbors.begin() + found;
              ++neighbor) {
             // connect with one of the neighbor nodes
-            TraxelStoreByTimeid::iterator neighbor_traxel =
-                    traxels_by_timeid.find(
-                        boost::make_tuple(to_timestep, neighbor->first));
-            assert(neighbor_traxel->Timestep == to_timestep);
-            assert(neighbor_traxel->Timestep != traxelmap[curr_node].Timestep);
-            traxelmap_t::ItemIt neighbor_node(traxelmap, *neighbor_traxel);
+            assert(nodes_by_id.count(neighbor->first) == 1);
+            const HypothesesGraph::Node neighbor_node = nodes_by_id.find(neighbor->first)->second;
+            assert(traxelmap[neighbor_node].Timestep == to_timestep);
             assert(curr_node != neighbor_node);
             if (!reverse) {
                 // if we go through the graph forward in time, add an arc from curr_node to neighbor_node
@@ -1103,7 +1182,23 @@ void PropertyGraph<lemon::ListDigraph>::copy(PropertyGraph<lemon::ListDigraph>&
         graph_copy.nodeMap(src.get(node_traxel()), dest.get(node_traxel()));
     }
 
+    if(src.has_property(node_traxel_ref()))
+    {
+        dest.add(node_traxel_ref());
+        graph_copy.nodeMap(src.get(node_traxel_ref()), dest.get(node_traxel_ref()));
+    }
+
+    // arc_features is indexed by arc id: its rows are remapped to the copied arcs
+    lemon::ListDigraph::ArcMap<lemon::ListDigraph::Arc> arc_ref(src);
+    graph_copy.arcRef(arc_ref);
+
     graph_copy.run();
+
+    if(src.has_property(arc_features()))
+    {
+        dest.add(arc_features());
+        dest.get(arc_features()).assign(src.get(arc_features()), src, dest, arc_ref);
+    }
 }
 
 void HypothesesGraph::copy(HypothesesGraph &src, HypothesesGraph &dest)
@@ -0,0 +1,52 @@
+// stl
+#include <vector>
+
+// pgmlink
+#include "pgmlink/hypotheses_overlay.h"
+#include "pgmlink/log.h"
+
+namespace pgmlink {
+
+////
+//// class HypothesesGraphOverlay
+////
+HypothesesGraphOverlay::HypothesesGraphOverlay(HypothesesGraph& g)
+  : graph_(&g), added_nodes_(g), added_arcs_(g) {
+}
+
+HypothesesGraphOverlay::~HypothesesGraphOverlay() {
+  revert();
+}
+
+void HypothesesGraphOverlay::set_traxel(const Node& node, const Traxel& traxel) {
+  record(graph_->get(node_traxel()), node);
+  if (graph_->has_property(node_traxel_ref())) {
+    record(graph_->get(node_traxel_ref()), node);
+  }
+  NodeTraxels(*graph_).set(node, traxel);
+}
+
+void HypothesesGraphOverlay::revert() {
+  LOG(logDEBUG) << "HypothesesGraphOverlay::revert(): erasing " << added_nodes_.items().size() << " nodes and "
+                << added_arcs_.items().size() << " arcs, restoring " << changes_.size() << " values";
+  for (std::vector<boost::shared_ptr<Change> >::reverse_iterator it = changes_.rbegin(); it != changes_.rend(); ++it) {
+    (*it)->undo();
+  }
+  changes_.clear();
+  recorded_.clear();
+
+  // erasing updates the recorded items, so erase copies
+  const std::vector<Arc> arcs(added_arcs_.items().begin(), added_arcs_.items().end());
+  for (std::vector<Arc>::const_iterator it = arcs.begin(); it != arcs.end(); ++it) {
+    graph_->erase(*it);
+  }
+  reset_added_nodes(node_traxel_ref(), NULL);
+  reset_added_nodes(node_originated_from(), std::vector<unsigned int>());
+  reset_added_nodes(merger_resolved_to(), std::vector<unsigned int>());
+  const std::vector<Node> nodes(added_nodes_.items().begin(), added_nodes_.items().end());
+  for (std::vector<Node>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+    graph_->erase(*it);
+  }
+}
+
+} /* namespace pgmlink */
@@ -0,0 +1,124 @@
+// stl
+#include <limits>
+#include <vector>
+
+// pgmlink
+#include "pgmlink/hypotheses_snapshot.h"
+#include "pgmlink/log.h"
+
+namespace pgmlink {
+
+////
+//// class HypothesesGraphSnapshot
+////
+const HypothesesGraphSnapshot::index_type HypothesesGraphSnapshot::invalid_index =
+    std::numeric_limits<HypothesesGraphSnapshot::index_type>::max();
+
+HypothesesGraphSnapshot::HypothesesGraphSnapshot(const HypothesesGraph& g)
+  : graph_(&g), earliest_timestep_(0), latest_timestep_(-1) {
+  init(g);
+}
+
+HypothesesGraphSnapshot::HypothesesGraphSnapshot(const ActiveSubgraph& view)
+  : graph_(&view.graph()), earliest_timestep_(0), latest_timestep_(-1) {
+  init(view);
+}
+
+template <typename Digraph>
+void HypothesesGraphSnapshot::init(const Digraph& view) {
+  const HypothesesGraph& g = *graph_;
+  // nodes and arcs in lemon iteration order
+  node_index_.assign(view.maxNodeId() + 1, invalid_index);
+  for (typename Digraph::NodeIt n(view); n != lemon::INVALID; ++n) {
+    node_index_[view.id(n)] = nodes_.size();
+    nodes_.push_back(n);
+  }
+  arc_index_.assign(view.maxArcId() + 1, invalid_index);
+  for (typename Digraph::ArcIt a(view); a != lemon::INVALID; ++a) {
+    arc_index_[view.id(a)] = arcs_.size();
+    arcs_.push_back(a);
+    arc_source_.push_back(node_index_[view.id(view.source(a))]);
+    arc_target_.push_back(node_index_[view.id(view.target(a))]);
+  }
+
+  // adjacency
+  out_offsets_.reserve(nodes_.size() + 1);
+  in_offsets_.reserve(nodes_.size() + 1);
+  out_arcs_.reserve(arcs_.size());
+  in_arcs_.reserve(arcs_.size());
+  for (std::vector<Node>::const_iterator n = nodes_.begin(); n != nodes_.end(); ++n) {
+    out_offsets_.push_back(out_arcs_.size());
+    for (typename Digraph::OutArcIt a(view, *n); a != lemon::INVALID; ++a) {
+      out_arcs_.push_back(arc_index_[view.id(a)]);
+    }
+    in_offsets_.push_back(in_arcs_.size());
+    for (typename Digraph::InArcIt a(view, *n); a != lemon::INVALID; ++a) {
+      in_arcs_.push_back(arc_index_[view.id(a)]);
+    }
+  }
+  out_offsets_.push_back(out_arcs_.size());
+  in_offsets_.push_back(in_arcs_.size());
+
+  // per timestep node ranges; nodes outside of the view are skipped
+  if (!g.timesteps().empty()) {
+    typedef property_map<node_timestep, HypothesesGraph::base_graph>::type node_timestep_map_t;
+    node_timestep_map_t& node_timestep_map = g.get(node_timestep());
+    earliest_timestep_ = g.earliest_timestep();
+    latest_timestep_ = g.latest_timestep();
+    timestep_offsets_.reserve(latest_timestep_ - earliest_timestep_ + 2);
+    timestep_nodes_.reserve(nodes_.size());
+    for (int t = earliest_timestep_; t <= latest_timestep_; ++t) {
+      timestep_offsets_.push_back(timestep_nodes_.size());
+      for (node_timestep_map_t::ItemIt n(node_timestep_map, t); n != lemon::INVALID; ++n) {
+        if (node_index_[g.id(n)] != invalid_index) {
+          timestep_nodes_.push_back(node_index_[g.id(n)]);
+        }
+      }
+    }
+    timestep_offsets_.push_back(timestep_nodes_.size());
+  }
+
+  LOG(logDEBUG1) << "HypothesesGraphSnapshot: froze " << nodes_.size() << " nodes and "
+                 << arcs_.size() << " arcs";
+}
+
+HypothesesGraphSnapshot::index_type HypothesesGraphSnapshot::node_index(const Node& n) const {
+  const int id = graph_->id(n);
+  if (id < 0 || static_cast<std::size_t>(id) >= node_index_.size()) {
+    return invalid_index;
+  }
+  return node_index_[id];
+}
+
+HypothesesGraphSnapshot::index_type HypothesesGraphSnapshot::arc_index(const Arc& a) const {
+  const int id = graph_->id(a);
+  if (id < 0 || static_cast<std::size_t>(id) >= arc_index_.size()) {
+    return invalid_index;
+  }
+  return arc_index_[id];
+}
+
+HypothesesGraphSnapshot::index_iterator HypothesesGraphSnapshot::timestep_begin(int t) const {
+  if (timestep_offsets_.empty() || t < earliest_timestep_ || t > latest_timestep_) {
+    return timestep_nodes_.end();
+  }
+  return timestep_nodes_.begin() + timestep_offsets_[t - earliest_timestep_];
+}
+
+HypothesesGraphSnapshot::index_iterator HypothesesGraphSnapshot::timestep_end(int t) const {
+  if (timestep_offsets_.empty() || t < earliest_timestep_ || t > latest_timestep_) {
+    return timestep_nodes_.end();
+  }
+  return timestep_nodes_.begin() + timestep_offsets_[t - earliest_timestep_ + 1];
+}
+
+
+boost::shared_ptr<const HypothesesGraphSnapshot> freeze(const HypothesesGraph& g) {
+  return boost::shared_ptr<const HypothesesGraphSnapshot>(new HypothesesGraphSnapshot(g));
+}
+
+boost::shared_ptr<const HypothesesGraphSnapshot> freeze(const ActiveSubgraph& view) {
+  return boost::shared_ptr<const HypothesesGraphSnapshot>(new HypothesesGraphSnapshot(view));
+}
+
+} /* namespace pgmlink */
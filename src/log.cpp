@@ -0,0 +1,346 @@
+// stl
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !(defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+#include <pthread.h>
+#define PGMLINK_LOG_WITH_PTHREADS
+#endif
+
+// pgmlink
+#include "pgmlink/log.h"
+
+namespace pgmlink {
+
+#ifdef PGMLINK_LOG_WITH_PTHREADS
+namespace {
+////
+//// thread local logging state
+////
+// messages of one thread waiting for the background writer; the writer is the
+// only other thread locking the buffer
+struct ThreadBuffer {
+  ThreadBuffer() : registered(false) {
+    pthread_mutex_init(&mutex, NULL);
+  }
+  ~ThreadBuffer() {
+    pthread_mutex_destroy(&mutex);
+  }
+
+  pthread_mutex_t mutex;
+  std::vector<std::string> pending;
+  bool registered; // only accessed by the owning thread
+};
+
+struct ThreadLog {
+  std::ostringstream stream;
+  ThreadBuffer buffer;
+};
+
+pthread_key_t log_key;
+pthread_once_t log_key_once = PTHREAD_ONCE_INIT;
+
+void delete_thread_log(void* log);
+
+// the key destructor only runs for threads that exit, not for the main thread
+void delete_main_thread_log() {
+  void* log = pthread_getspecific(log_key);
+  pthread_setspecific(log_key, NULL);
+  delete_thread_log(log);
+}
+
+void create_log_key() {
+  pthread_key_create(&log_key, delete_thread_log);
+  std::atexit(&delete_main_thread_log);
+}
+
+ThreadLog* thread_log() {
+  pthread_once(&log_key_once, create_log_key);
+  ThreadLog* log = static_cast<ThreadLog*>(pthread_getspecific(log_key));
+  if (!log) {
+    log = new ThreadLog;
+    pthread_setspecific(log_key, log);
+  }
+  return log;
+}
+
+
+////
+//// class AsyncWriter
+////
+/**
+ * Background thread writing queued messages to Output2FILE::getRedirect().
+ *
+ * Every producer thread appends finished messages to its own ThreadBuffer, so
+ * producers never wait for each other. The writer swaps the buffers out in
+ * passes and writes them without holding any lock. Messages of one thread stay
+ * in order; messages of different threads are only ordered by their pass.
+ *
+ * Producers take the writer's mutex only to register their buffer and to wake
+ * the writer when their buffer was empty, i.e. at most once per pass. Whether
+ * the writer is running is read without a lock, so synchronous output does
+ * not touch the mutex at all.
+ */
+class AsyncWriter {
+ public:
+  // never destroyed: exiting threads and exit handlers may still use it
+  static AsyncWriter& instance() {
+    static AsyncWriter* writer = new AsyncWriter;
+    return *writer;
+  }
+
+  bool active() const {
+    return __atomic_load_n(&active_, __ATOMIC_ACQUIRE) != 0;
+  }
+
+  bool start() {
+    pthread_mutex_lock(&mutex_);
+    if (!running_) {
+      stop_ = false;
+      running_ = pthread_create(&thread_, NULL, &AsyncWriter::run, this) == 0;
+      if (running_) {
+        __atomic_store_n(&active_, 1, __ATOMIC_RELEASE);
+        if (!exit_handler_registered_) {
+          exit_handler_registered_ = std::atexit(&AsyncWriter::at_exit) == 0;
+        }
+      }
+    }
+    bool running = running_;
+    pthread_mutex_unlock(&mutex_);
+    return running;
+  }
+
+  void stop() {
+    pthread_mutex_lock(&mutex_);
+    if (!running_) {
+      pthread_mutex_unlock(&mutex_);
+      return;
+    }
+    // the final pass locks every buffer after this store, so each message is
+    // either collected or rejected by enqueue()
+    __atomic_store_n(&active_, 0, __ATOMIC_RELEASE);
+    stop_ = true;
+    pthread_cond_signal(&wakeup_);
+    pthread_mutex_unlock(&mutex_);
+    pthread_join(thread_, NULL);
+    pthread_mutex_lock(&mutex_);
+    running_ = false;
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  bool enqueue(ThreadBuffer& buffer, const std::string& msg) {
+    if (!active()) {
+      return false;
+    }
+    if (!buffer.registered) {
+      buffer.registered = add_buffer(buffer);
+      if (!buffer.registered) {
+        return false;
+      }
+    }
+    pthread_mutex_lock(&buffer.mutex);
+    const bool accepted = active();
+    const bool was_empty = buffer.pending.empty();
+    if (accepted) {
+      buffer.pending.push_back(msg);
+    }
+    pthread_mutex_unlock(&buffer.mutex);
+    if (accepted && was_empty) {
+      // under the mutex, so the writer cannot miss it between its last check and waiting
+      pthread_mutex_lock(&mutex_);
+      pthread_cond_signal(&wakeup_);
+      pthread_mutex_unlock(&mutex_);
+    }
+    return accepted;
+  }
+
+  // hand the messages of an exiting thread to the writer
+  void remove_buffer(ThreadBuffer& buffer) {
+    pthread_mutex_lock(&mutex_);
+    buffers_.erase(std::remove(buffers_.begin(), buffers_.end(), &buffer), buffers_.end());
+    pthread_mutex_lock(&buffer.mutex);
+    orphaned_.insert(orphaned_.end(), buffer.pending.begin(), buffer.pending.end());
+    buffer.pending.clear();
+    pthread_mutex_unlock(&buffer.mutex);
+    if (!orphaned_.empty()) {
+      pthread_cond_signal(&wakeup_);
+    }
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  void flush() {
+    pthread_mutex_lock(&mutex_);
+    // a pass in progress may have missed messages queued before this call,
+    // the pass after it has not
+    const unsigned long target = passes_ + 2;
+    while (running_ && passes_ < target) {
+      pthread_cond_signal(&wakeup_);
+      pthread_cond_wait(&written_cond_, &mutex_);
+    }
+    pthread_mutex_unlock(&mutex_);
+  }
+
+ private:
+  AsyncWriter()
+    : active_(0), running_(false), stop_(false), exit_handler_registered_(false), passes_(0) {
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&wakeup_, NULL);
+    pthread_cond_init(&written_cond_, NULL);
+  }
+
+  static void at_exit() {
+    instance().stop();
+  }
+
+  static void* run(void* self) {
+    static_cast<AsyncWriter*>(self)->loop();
+    return NULL;
+  }
+
+  bool add_buffer(ThreadBuffer& buffer) {
+    pthread_mutex_lock(&mutex_);
+    const bool added = running_ && !stop_;
+    if (added) {
+      buffers_.push_back(&buffer);
+    }
+    pthread_mutex_unlock(&mutex_);
+    return added;
+  }
+
+  // move all pending messages to batch; requires mutex_
+  void collect(std::vector<std::string>& batch) {
+    batch.swap(orphaned_);
+    for (std::vector<ThreadBuffer*>::const_iterator it = buffers_.begin(); it != buffers_.end(); ++it) {
+      pthread_mutex_lock(&(*it)->mutex);
+      if (batch.empty()) {
+        batch.swap((*it)->pending);
+      } else {
+        batch.insert(batch.end(), (*it)->pending.begin(), (*it)->pending.end());
+        (*it)->pending.clear();
+      }
+      pthread_mutex_unlock(&(*it)->mutex);
+    }
+  }
+
+  // requires mutex_
+  bool has_pending() {
+    bool pending = !orphaned_.empty();
+    for (std::vector<ThreadBuffer*>::const_iterator it = buffers_.begin(); !pending && it != buffers_.end(); ++it) {
+      pthread_mutex_lock(&(*it)->mutex);
+      pending = !(*it)->pending.empty();
+      pthread_mutex_unlock(&(*it)->mutex);
+    }
+    return pending;
+  }
+
+  void loop() {
+    std::vector<std::string> batch;
+    pthread_mutex_lock(&mutex_);
+    while (true) {
+      const bool stopping = stop_;
+      collect(batch);
+      if (!batch.empty()) {
+        pthread_mutex_unlock(&mutex_);
+        FILE* pStream = Output2FILE::getRedirect();
+        if (pStream) {
+          for (std::vector<std::string>::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+            fwrite(it->data(), 1, it->size(), pStream);
+          }
+          fflush(pStream);
+        }
+        batch.clear();
+        pthread_mutex_lock(&mutex_);
+      }
+      ++passes_;
+      pthread_cond_broadcast(&written_cond_);
+      if (stopping) {
+        break;
+      }
+      if (!stop_ && !has_pending()) {
+        pthread_cond_wait(&wakeup_, &mutex_);
+      }
+    }
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  int active_; // running and accepting messages; read without the mutex
+  pthread_mutex_t mutex_;
+  pthread_cond_t wakeup_;
+  pthread_cond_t written_cond_;
+  pthread_t thread_;
+  bool running_, stop_, exit_handler_registered_;
+  unsigned long passes_;
+  std::vector<ThreadBuffer*> buffers_;
+  std::vector<std::string> orphaned_;
+};
+
+void delete_thread_log(void* log) {
+  ThreadLog* thread_log = static_cast<ThreadLog*>(log);
+  if (thread_log && thread_log->buffer.registered) {
+    AsyncWriter::instance().remove_buffer(thread_log->buffer);
+  }
+  delete thread_log;
+}
+} // anonymous namespace
+#endif // PGMLINK_LOG_WITH_PTHREADS
+
+
+namespace detail {
+std::ostringstream* thread_log_stream() {
+#ifdef PGMLINK_LOG_WITH_PTHREADS
+  return &thread_log()->stream;
+#else
+  return NULL;
+#endif
+}
+
+bool enqueue_log_message(const std::string& msg) {
+#ifdef PGMLINK_LOG_WITH_PTHREADS
+  AsyncWriter& writer = AsyncWriter::instance();
+  return writer.active() && writer.enqueue(thread_log()->buffer, msg);
+#else
+  (void) msg;
+  return false;
+#endif
+}
+} /* namespace detail */
+
+
+////
+//// class Output2FILE
+////
+void Output2FILE::setAsynchronous(bool async) {
+#ifdef PGMLINK_LOG_WITH_PTHREADS
+  if (async) {
+    AsyncWriter::instance().start();
+  } else {
+    AsyncWriter::instance().stop();
+  }
+#else
+  (void) async;
+#endif
+}
+
+bool Output2FILE::isAsynchronous() {
+#ifdef PGMLINK_LOG_WITH_PTHREADS
+  return AsyncWriter::instance().active();
+#else
+  return false;
+#endif
+}
+
+void Output2FILE::flush() {
+#ifdef PGMLINK_LOG_WITH_PTHREADS
+  AsyncWriter::instance().flush();
+#endif
+  FILE* pStream = getRedirect();
+  if (pStream) {
+    fflush(pStream);
+  }
+}
+
+} /* namespace pgmlink */
@@ -0,0 +1,181 @@
+// stl
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// pgmlink
+#include "pgmlink/lp_formulation.h"
+
+namespace pgmlink {
+namespace lp {
+
+////
+//// class LinearProgram
+////
+LinearProgram::LinearProgram()
+  : integer_count_(0), objective_offset_(0.), keep_row_names_(false) {
+  row_offsets_.push_back(0);
+}
+
+LinearProgram::index_type LinearProgram::add_column(double lower, double upper, double objective, bool integer) {
+  if (lower > upper) {
+    throw std::invalid_argument("LinearProgram::add_column(): lower bound exceeds upper bound");
+  }
+  column_lower_.push_back(lower);
+  column_upper_.push_back(upper);
+  objective_.push_back(objective);
+  integer_.push_back(integer);
+  if (integer) {
+    ++integer_count_;
+  }
+  return objective_.size() - 1;
+}
+
+std::string LinearProgram::row_name(index_type r) const {
+  if (r >= row_names_.size()) {
+    return std::string();
+  }
+  return row_names_[r];
+}
+
+double LinearProgram::evaluate(const std::vector<double>& x) const {
+  if (x.size() != column_count()) {
+    throw std::invalid_argument("LinearProgram::evaluate(): solution size differs from number of columns");
+  }
+  double value = objective_offset_;
+  for (index_type j = 0; j < column_count(); ++j) {
+    value += objective_[j] * x[j];
+  }
+  return value;
+}
+
+bool LinearProgram::is_feasible(const std::vector<double>& x, double tolerance) const {
+  if (x.size() != column_count()) {
+    return false;
+  }
+  for (index_type j = 0; j < column_count(); ++j) {
+    if (x[j] < column_lower_[j] - tolerance || x[j] > column_upper_[j] + tolerance) {
+      return false;
+    }
+    if (integer_[j] && std::fabs(x[j] - std::floor(x[j] + 0.5)) > tolerance) {
+      return false;
+    }
+  }
+  for (index_type r = 0; r < row_count(); ++r) {
+    double activity = 0.;
+    for (index_type k = row_offsets_[r]; k < row_offsets_[r + 1]; ++k) {
+      activity += coefficients_[k] * x[columns_[k]];
+    }
+    if (activity < row_lower_[r] - tolerance || activity > row_upper_[r] + tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+
+////
+//// class DiscreteFormulation
+////
+DiscreteFormulation::DiscreteFormulation() {
+  term_offsets_.push_back(0);
+}
+
+DiscreteFormulation::index_type DiscreteFormulation::add_variable(std::size_t number_of_labels) {
+  if (number_of_labels == 0) {
+    throw std::invalid_argument("DiscreteFormulation::add_variable(): variable without labels");
+  }
+  const index_type first = program_.column_count();
+  std::vector<index_type> columns;
+  for (std::size_t state = 0; state < number_of_labels; ++state) {
+    columns.push_back(program_.add_column(0., 1., 0., true));
+  }
+  // exactly one label per variable
+  const std::vector<double> ones(number_of_labels, 1.);
+  program_.add_row(columns.begin(), columns.end(), ones.begin(), 1., 1.);
+
+  first_column_.push_back(first);
+  number_of_labels_.push_back(number_of_labels);
+  return first_column_.size() - 1;
+}
+
+void DiscreteFormulation::add_term(const std::vector<index_type>& vars,
+                                   const std::vector<std::size_t>& labelings,
+                                   const std::vector<double>& values,
+                                   double default_value) {
+  const std::size_t order = vars.size();
+  if (order == 0 || labelings.size() != order * values.size()) {
+    throw std::invalid_argument("DiscreteFormulation::add_term(): labelings do not match variables and values");
+  }
+  program_.add_objective_offset(default_value);
+
+  std::vector<index_type> columns(order + 1);
+  std::vector<double> coeffs(order + 1);
+  for (std::size_t e = 0; e < values.size(); ++e) {
+    const double cost = values[e] - default_value;
+    if (cost == 0.) {
+      continue;
+    }
+    const index_type z = program_.add_column(0., 1., cost, false);
+    for (std::size_t i = 0; i < order; ++i) {
+      columns[i] = column(vars[i], labelings[e * order + i]);
+    }
+    columns[order] = z;
+    term_columns_.push_back(z);
+    term_indicators_.insert(term_indicators_.end(), columns.begin(), columns.begin() + order);
+    term_offsets_.push_back(term_indicators_.size());
+    if (cost < 0.) {
+      // the minimization pushes z up: z <= x[var_i, label_i] for all i
+      const double coeff[] = {1., -1.};
+      for (std::size_t i = 0; i < order; ++i) {
+        const index_type pair[] = {z, columns[i]};
+        program_.add_row(pair, pair + 2, coeff, -infinity, 0.);
+      }
+    } else {
+      // the minimization pushes z down: z >= sum_i x[var_i, label_i] - (order - 1)
+      std::fill(coeffs.begin(), coeffs.end(), -1.);
+      coeffs[order] = 1.;
+      program_.add_row(columns.begin(), columns.end(), coeffs.begin(),
+                       1. - static_cast<double>(order), infinity);
+    }
+  }
+}
+
+void DiscreteFormulation::labeling(const std::vector<double>& x, std::vector<std::size_t>& labels) const {
+  if (x.size() != program_.column_count()) {
+    throw std::invalid_argument("DiscreteFormulation::labeling(): solution size differs from number of columns");
+  }
+  labels.resize(number_of_variables());
+  for (index_type var = 0; var < number_of_variables(); ++var) {
+    std::size_t best = 0;
+    for (std::size_t state = 1; state < number_of_labels_[var]; ++state) {
+      if (x[first_column_[var] + state] > x[first_column_[var] + best]) {
+        best = state;
+      }
+    }
+    labels[var] = best;
+  }
+}
+
+void DiscreteFormulation::columns(const std::vector<std::size_t>& labels, std::vector<double>& x) const {
+  if (labels.size() != number_of_variables()) {
+    throw std::invalid_argument("DiscreteFormulation::columns(): number of labels differs from number of variables");
+  }
+  x.assign(program_.column_count(), 0.);
+  for (index_type var = 0; var < number_of_variables(); ++var) {
+    x[column(var, labels[var])] = 1.;
+  }
+  for (index_type t = 0; t < term_columns_.size(); ++t) {
+    double product = 1.;
+    for (index_type k = term_offsets_[t]; k < term_offsets_[t + 1]; ++k) {
+      product *= x[term_indicators_[k]];
+    }
+    x[term_columns_[t]] = product;
+  }
+}
+
+} /* namespace lp */
+} /* namespace pgmlink */
@@ -0,0 +1,627 @@
+// stl
+#include <sys/time.h>
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// solver libraries
+#ifdef WITH_CPLEX
+#include <ilcplex/ilocplex.h>
+#endif
+#ifdef WITH_GUROBI
+#include <gurobi_c++.h>
+#endif
+#ifdef WITH_GLPK
+#include <glpk.h>
+#endif
+
+// pgmlink
+#include "pgmlink/log.h"
+#include "pgmlink/lp_solver.h"
+
+namespace pgmlink {
+namespace lp {
+
+namespace {
+////
+//// class ProgressMonitor
+////
+// Turns the progress reported by a solver callback into Progress, passes
+// improved incumbents on and polls the stopping rules.
+class ProgressMonitor {
+ public:
+  ProgressMonitor(const SolverParameters& param, double objective_offset)
+    : on_incumbent_(param.on_incumbent), rules_(param.stopping_rules),
+      offset_(objective_offset), best_(infinity), start_(now()) {}
+
+  bool enabled() const { return !on_incumbent_.empty() || !rules_.empty(); }
+
+  // objective and bound without offset; returns true if the search should stop
+  bool report(double objective, double bound) {
+    Progress progress;
+    progress.elapsed = now() - start_;
+    progress.bound = bound > -infinity ? bound + offset_ : -infinity;
+    if (objective < infinity) {
+      progress.objective = objective + offset_;
+      progress.gap = std::fabs(progress.objective - progress.bound) / (1e-10 + std::fabs(progress.objective));
+    }
+    if (progress.objective < best_) {
+      best_ = progress.objective;
+      LOG(logDEBUG) << "ProgressMonitor: incumbent " << progress.objective << ", gap " << progress.gap
+                    << " after " << progress.elapsed << "s";
+      if (!on_incumbent_.empty()) {
+        on_incumbent_(progress);
+      }
+    }
+    for (std::vector<StoppingRule>::iterator rule = rules_.begin(); rule != rules_.end(); ++rule) {
+      if ((*rule)(progress)) {
+        LOG(logINFO) << "ProgressMonitor: stopping rule met after " << progress.elapsed << "s, gap " << progress.gap;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static double now() {
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+  }
+
+  IncumbentCallback on_incumbent_;
+  std::vector<StoppingRule> rules_;
+  double offset_;
+  double best_;
+  double start_;
+};
+
+#ifdef WITH_CPLEX
+////
+//// class CplexSolver
+////
+class CplexSolver : public Solver {
+ private:
+  class ProgressCallback : public IloCplex::MIPInfoCallbackI {
+   public:
+    ProgressCallback(IloEnv env, ProgressMonitor& monitor)
+      : IloCplex::MIPInfoCallbackI(env), monitor_(monitor) {}
+   protected:
+    void main() {
+      const double objective = hasIncumbent() ? getIncumbentObjValue() : infinity;
+      const double bound = getBestObjValue();
+      bool stop;
+      // with several threads CPLEX calls this concurrently, but the monitor and
+      // the user's callbacks are not thread safe
+#     pragma omp critical(lp_progress_monitor)
+      stop = monitor_.report(objective, bound);
+      if (stop) {
+        abort();
+      }
+    }
+    IloCplex::CallbackI* duplicateCallback() const {
+      return new (getEnv()) ProgressCallback(*this);
+    }
+   private:
+    ProgressMonitor& monitor_;
+  };
+
+ public:
+  std::string name() const { return "cplex"; }
+
+  Solution solve(const LinearProgram& program, const SolverParameters& param) {
+    Solution solution;
+    IloEnv env;
+    try {
+      IloModel model(env);
+      IloNumVarArray x(env);
+      for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+        x.add(IloNumVar(env, bound(program.column_lower(j)), bound(program.column_upper(j)),
+                        program.is_integer(j) && !param.relaxation ? ILOINT : ILOFLOAT));
+      }
+
+      IloExpr objective(env);
+      for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+        if (program.objective(j) != 0.) {
+          objective += program.objective(j) * x[j];
+        }
+      }
+      model.add(IloMinimize(env, objective));
+      objective.end();
+
+      IloRangeArray rows(env);
+      const std::vector<LinearProgram::index_type>& columns = program.row_columns();
+      const std::vector<double>& coefficients = program.row_coefficients();
+      for (LinearProgram::index_type r = 0; r < program.row_count(); ++r) {
+        IloExpr row(env);
+        for (LinearProgram::index_type k = program.row_begin(r); k < program.row_end(r); ++k) {
+          row += coefficients[k] * x[columns[k]];
+        }
+        const std::string row_name = program.row_name(r);
+        rows.add(IloRange(env, bound(program.row_lower(r)), row, bound(program.row_upper(r)),
+                          row_name.empty() ? NULL : row_name.c_str()));
+        row.end();
+      }
+      model.add(rows);
+
+      IloCplex cplex(model);
+      if (!param.verbose) {
+        cplex.setOut(env.getNullStream());
+        cplex.setWarning(env.getNullStream());
+      }
+      cplex.setParam(IloCplex::EpGap, param.ep_gap);
+      cplex.setParam(IloCplex::TiLim, param.time_limit);
+      apply(cplex, param);
+      ProgressMonitor monitor(param, program.objective_offset());
+      if (monitor.enabled() && program.has_integers() && !param.relaxation) {
+        cplex.use(IloCplex::Callback(new (env) ProgressCallback(env, monitor)));
+      }
+
+      const bool found = cplex.solve();
+      const IloAlgorithm::Status status = cplex.getStatus();
+      LOG(logDEBUG) << "CplexSolver::solve: status " << status;
+      if (status == IloAlgorithm::Optimal) {
+        solution.status = optimal;
+      } else if (found) {
+        solution.status = feasible;
+      } else if (status == IloAlgorithm::Infeasible) {
+        solution.status = infeasible;
+      }
+
+      if (found) {
+        IloNumArray values(env);
+        cplex.getValues(values, x);
+        solution.values.resize(program.column_count());
+        for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+          solution.values[j] = values[j];
+        }
+        solution.objective = cplex.getObjValue() + program.objective_offset();
+        solution.bound = program.has_integers() && !param.relaxation
+            ? cplex.getBestObjValue() + program.objective_offset()
+            : solution.objective;
+      }
+    } catch (IloException& e) {
+      std::ostringstream msg;
+      msg << "CplexSolver::solve(): " << e.getMessage();
+      env.end();
+      throw std::runtime_error(msg.str());
+    }
+    env.end();
+    return solution;
+  }
+
+ private:
+  static double bound(double b) {
+    if (b >= infinity) return IloInfinity;
+    if (b <= -infinity) return -IloInfinity;
+    return b;
+  }
+
+  static void apply(IloCplex& cplex, const SolverSettings& settings) {
+    if (settings.threads > 0) {
+      cplex.setParam(IloCplex::Threads, settings.threads);
+    }
+    if (settings.memory_limit > 0.) {
+      cplex.setParam(IloCplex::WorkMem, settings.memory_limit);
+      if (settings.node_file_dir.empty()) {
+        // stop with the incumbent instead of running out of memory
+        cplex.setParam(IloCplex::TreLim, settings.memory_limit);
+      }
+    }
+    if (!settings.node_file_dir.empty()) {
+      cplex.setParam(IloCplex::NodeFileInd, 3); // compressed node files on disk
+      cplex.setParam(IloCplex::WorkDir, settings.node_file_dir.c_str());
+    }
+    cplex.setParam(IloCplex::MIPEmphasis, static_cast<int>(settings.emphasis));
+    switch (settings.presolve) {
+      case presolve_off:
+        cplex.setParam(IloCplex::PreInd, false);
+        break;
+      case presolve_conservative:
+        cplex.setParam(IloCplex::PrePass, 1);
+        break;
+      case presolve_aggressive:
+        cplex.setParam(IloCplex::PreslvNd, 1); // presolve at the nodes, too
+        break;
+      case presolve_auto:
+        break;
+    }
+  }
+};
+#endif // WITH_CPLEX
+
+#ifdef WITH_GUROBI
+////
+//// class GurobiSolver
+////
+class GurobiSolver : public Solver {
+ private:
+  class ProgressCallback : public GRBCallback {
+   public:
+    explicit ProgressCallback(ProgressMonitor& monitor) : monitor_(monitor) {}
+   protected:
+    void callback() {
+      double objective, bound;
+      if (where == GRB_CB_MIP) {
+        objective = getDoubleInfo(GRB_CB_MIP_OBJBST);
+        bound = getDoubleInfo(GRB_CB_MIP_OBJBND);
+      } else if (where == GRB_CB_MIPSOL) {
+        objective = getDoubleInfo(GRB_CB_MIPSOL_OBJBST);
+        bound = getDoubleInfo(GRB_CB_MIPSOL_OBJBND);
+      } else {
+        return;
+      }
+      if (monitor_.report(objective >= GRB_INFINITY ? infinity : objective,
+                          bound <= -GRB_INFINITY ? -infinity : bound)) {
+        abort();
+      }
+    }
+   private:
+    ProgressMonitor& monitor_;
+  };
+
+ public:
+  std::string name() const { return "gurobi"; }
+
+  Solution solve(const LinearProgram& program, const SolverParameters& param) {
+    Solution solution;
+    try {
+      GRBEnv env;
+      env.set(GRB_IntParam_OutputFlag, param.verbose ? 1 : 0);
+      env.set(GRB_DoubleParam_MIPGap, param.ep_gap);
+      env.set(GRB_DoubleParam_TimeLimit, param.time_limit);
+      apply(env, param);
+      GRBModel model(env);
+
+      std::vector<GRBVar> x;
+      x.reserve(program.column_count());
+      for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+        x.push_back(model.addVar(bound(program.column_lower(j)), bound(program.column_upper(j)),
+                                 program.objective(j),
+                                 program.is_integer(j) && !param.relaxation ? GRB_INTEGER : GRB_CONTINUOUS));
+      }
+      model.update();
+
+      const std::vector<LinearProgram::index_type>& columns = program.row_columns();
+      const std::vector<double>& coefficients = program.row_coefficients();
+      std::vector<GRBVar> row_vars;
+      for (LinearProgram::index_type r = 0; r < program.row_count(); ++r) {
+        row_vars.clear();
+        for (LinearProgram::index_type k = program.row_begin(r); k < program.row_end(r); ++k) {
+          row_vars.push_back(x[columns[k]]);
+        }
+        GRBLinExpr row;
+        if (!row_vars.empty()) {
+          row.addTerms(&coefficients[program.row_begin(r)], &row_vars[0], row_vars.size());
+        }
+        const double lower = program.row_lower(r);
+        const double upper = program.row_upper(r);
+        const std::string row_name = program.row_name(r);
+        if (lower == upper) {
+          model.addConstr(row, GRB_EQUAL, lower, row_name);
+        } else if (lower <= -infinity) {
+          model.addConstr(row, GRB_LESS_EQUAL, upper, row_name);
+        } else if (upper >= infinity) {
+          model.addConstr(row, GRB_GREATER_EQUAL, lower, row_name);
+        } else {
+          model.addRange(row, lower, upper, row_name);
+        }
+      }
+
+      ProgressMonitor monitor(param, program.objective_offset());
+      ProgressCallback callback(monitor);
+      if (monitor.enabled() && program.has_integers() && !param.relaxation) {
+        model.setCallback(&callback);
+      }
+      model.optimize();
+      const int status = model.get(GRB_IntAttr_Status);
+      const bool found = model.get(GRB_IntAttr_SolCount) > 0;
+      LOG(logDEBUG) << "GurobiSolver::solve: status " << status;
+      if (status == GRB_OPTIMAL) {
+        solution.status = optimal;
+      } else if (found) {
+        solution.status = feasible;
+      } else if (status == GRB_INFEASIBLE) {
+        solution.status = infeasible;
+      }
+
+      if (found) {
+        solution.values.resize(program.column_count());
+        for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+          solution.values[j] = x[j].get(GRB_DoubleAttr_X);
+        }
+        solution.objective = model.get(GRB_DoubleAttr_ObjVal) + program.objective_offset();
+        solution.bound = program.has_integers() && !param.relaxation
+            ? model.get(GRB_DoubleAttr_ObjBound) + program.objective_offset()
+            : solution.objective;
+      }
+    } catch (GRBException& e) {
+      std::ostringstream msg;
+      msg << "GurobiSolver::solve(): " << e.getMessage() << " (error code " << e.getErrorCode() << ")";
+      throw std::runtime_error(msg.str());
+    }
+    return solution;
+  }
+
+ private:
+  static double bound(double b) {
+    if (b >= infinity) return GRB_INFINITY;
+    if (b <= -infinity) return -GRB_INFINITY;
+    return b;
+  }
+
+  static void apply(GRBEnv& env, const SolverSettings& settings) {
+    if (settings.threads > 0) {
+      env.set(GRB_IntParam_Threads, settings.threads);
+    }
+    if (settings.memory_limit > 0.) {
+      // swap search tree nodes to disk beyond the limit (in GB)
+      env.set(GRB_DoubleParam_NodefileStart, settings.memory_limit / 1024.);
+    }
+    if (!settings.node_file_dir.empty()) {
+      env.set(GRB_StringParam_NodefileDir, settings.node_file_dir);
+    }
+    env.set(GRB_IntParam_MIPFocus, static_cast<int>(settings.emphasis));
+    switch (settings.presolve) {
+      case presolve_off:
+        env.set(GRB_IntParam_Presolve, 0);
+        break;
+      case presolve_conservative:
+        env.set(GRB_IntParam_Presolve, 1);
+        break;
+      case presolve_aggressive:
+        env.set(GRB_IntParam_Presolve, 2);
+        break;
+      case presolve_auto:
+        break;
+    }
+  }
+};
+#endif // WITH_GUROBI
+
+#ifdef WITH_GLPK
+////
+//// class GlpkSolver
+////
+class GlpkSolver : public Solver {
+ public:
+  std::string name() const { return "glpk"; }
+
+  Solution solve(const LinearProgram& program, const SolverParameters& param) {
+    Solution solution;
+    Problem problem;
+    glp_prob* lp = problem.lp;
+    glp_set_obj_dir(lp, GLP_MIN);
+
+    // glpk indices are 1-based
+    if (program.column_count() > 0) {
+      glp_add_cols(lp, static_cast<int>(program.column_count()));
+    }
+    for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+      const int col = static_cast<int>(j) + 1;
+      glp_set_col_bnds(lp, col, bound_type(program.column_lower(j), program.column_upper(j)),
+                       program.column_lower(j), program.column_upper(j));
+      glp_set_obj_coef(lp, col, program.objective(j));
+      if (program.is_integer(j) && !param.relaxation) {
+        glp_set_col_kind(lp, col, GLP_IV);
+      }
+    }
+
+    if (program.row_count() > 0) {
+      glp_add_rows(lp, static_cast<int>(program.row_count()));
+    }
+    const std::vector<LinearProgram::index_type>& columns = program.row_columns();
+    const std::vector<double>& coefficients = program.row_coefficients();
+    std::vector<int> ind(1);
+    std::vector<double> val(1);
+    for (LinearProgram::index_type r = 0; r < program.row_count(); ++r) {
+      const int row = static_cast<int>(r) + 1;
+      ind.resize(1);
+      val.resize(1);
+      for (LinearProgram::index_type k = program.row_begin(r); k < program.row_end(r); ++k) {
+        ind.push_back(static_cast<int>(columns[k]) + 1);
+        val.push_back(coefficients[k]);
+      }
+      glp_set_row_bnds(lp, row, bound_type(program.row_lower(r), program.row_upper(r)),
+                       program.row_lower(r), program.row_upper(r));
+      glp_set_mat_row(lp, row, static_cast<int>(ind.size()) - 1, &ind[0], &val[0]);
+      const std::string row_name = program.row_name(r);
+      if (!row_name.empty()) {
+        glp_set_row_name(lp, row, row_name.c_str());
+      }
+    }
+
+    const int time_limit = param.time_limit * 1000. < INT_MAX
+        ? static_cast<int>(param.time_limit * 1000.) : INT_MAX;
+    const int presolve = param.presolve == presolve_off ? GLP_OFF : GLP_ON;
+    // glp_mem_limit() is process wide and glpk aborts the process when the limit is exceeded
+    if (param.threads > 1 || !param.node_file_dir.empty() || param.memory_limit > 0.) {
+      LOG(logDEBUG) << "GlpkSolver::solve: threads, node files and memory limits are not supported; ignored";
+    }
+    bool found = false;
+    if (program.has_integers() && !param.relaxation) {
+      if (presolve == GLP_OFF) {
+        // without the integer presolver glp_intopt starts from an optimal basis of the relaxation
+        glp_smcp relaxation;
+        glp_init_smcp(&relaxation);
+        relaxation.tm_lim = time_limit;
+        relaxation.msg_lev = param.verbose ? GLP_MSG_ON : GLP_MSG_ERR;
+        glp_simplex(lp, &relaxation);
+      }
+      glp_iocp parm;
+      glp_init_iocp(&parm);
+      parm.presolve = presolve;
+      parm.mip_gap = param.ep_gap;
+      parm.tm_lim = time_limit;
+      parm.msg_lev = param.verbose ? GLP_MSG_ON : GLP_MSG_ERR;
+      ProgressMonitor monitor(param, program.objective_offset());
+      if (monitor.enabled()) {
+        parm.cb_func = &progress;
+        parm.cb_info = &monitor;
+      }
+      switch (param.emphasis) {
+        case emphasis_feasibility:
+          parm.fp_heur = GLP_ON;
+          parm.bt_tech = GLP_BT_DFS;
+          break;
+        case emphasis_optimality:
+          parm.bt_tech = GLP_BT_BPH;
+          break;
+        case emphasis_bound:
+          parm.bt_tech = GLP_BT_BLB;
+          break;
+        case emphasis_balanced:
+          break;
+      }
+      const int ret = glp_intopt(lp, &parm);
+      const int status = glp_mip_status(lp);
+      LOG(logDEBUG) << "GlpkSolver::solve: glp_intopt returned " << ret << ", status " << status;
+      found = status == GLP_OPT || status == GLP_FEAS;
+      if (status == GLP_OPT || (status == GLP_FEAS && ret == GLP_EMIPGAP)) {
+        solution.status = optimal;
+      } else if (found) {
+        solution.status = feasible;
+      } else if (status == GLP_NOFEAS || ret == GLP_ENOPFS) {
+        solution.status = infeasible;
+      }
+      if (found) {
+        solution.values.resize(program.column_count());
+        for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+          solution.values[j] = glp_mip_col_val(lp, static_cast<int>(j) + 1);
+        }
+        solution.objective = glp_mip_obj_val(lp) + program.objective_offset();
+        // glpk does not report the final bound; an optimal solution is within ep_gap of it
+        solution.bound = solution.status == optimal
+            ? solution.objective - param.ep_gap * std::fabs(solution.objective)
+            : -infinity;
+      }
+    } else {
+      glp_smcp parm;
+      glp_init_smcp(&parm);
+      parm.presolve = presolve;
+      parm.tm_lim = time_limit;
+      parm.msg_lev = param.verbose ? GLP_MSG_ON : GLP_MSG_ERR;
+      const int ret = glp_simplex(lp, &parm);
+      const int status = glp_get_status(lp);
+      LOG(logDEBUG) << "GlpkSolver::solve: glp_simplex returned " << ret << ", status " << status;
+      found = status == GLP_OPT;
+      if (found) {
+        solution.status = optimal;
+        solution.values.resize(program.column_count());
+        for (LinearProgram::index_type j = 0; j < program.column_count(); ++j) {
+          solution.values[j] = glp_get_col_prim(lp, static_cast<int>(j) + 1);
+        }
+        solution.objective = glp_get_obj_val(lp) + program.objective_offset();
+        solution.bound = solution.objective;
+      } else if (status == GLP_NOFEAS || ret == GLP_ENOPFS) {
+        solution.status = infeasible;
+      }
+    }
+    return solution;
+  }
+
+ private:
+  // owns the glpk problem object
+  struct Problem {
+    Problem() : lp(glp_create_prob()) {}
+    ~Problem() { glp_delete_prob(lp); }
+    glp_prob* lp;
+   private:
+    Problem(const Problem&);
+    Problem& operator=(const Problem&);
+  };
+
+  // glp_intopt callback; the problem of the tree holds the incumbent
+  static void progress(glp_tree* tree, void* info) {
+    const int reason = glp_ios_reason(tree);
+    if (reason != GLP_IBINGO && reason != GLP_ISELECT) {
+      return;
+    }
+    glp_prob* lp = glp_ios_get_prob(tree);
+    const double objective = glp_mip_status(lp) == GLP_FEAS ? glp_mip_obj_val(lp) : infinity;
+    const int node = glp_ios_best_node(tree);
+    const double bound = node != 0 ? glp_ios_node_bound(tree, node) : -infinity;
+    if (static_cast<ProgressMonitor*>(info)->report(objective, bound)) {
+      glp_ios_terminate(tree);
+    }
+  }
+
+  static int bound_type(double lower, double upper) {
+    const bool has_lower = lower > -infinity;
+    const bool has_upper = upper < infinity;
+    if (has_lower && has_upper) {
+      return lower == upper ? GLP_FX : GLP_DB;
+    }
+    if (has_lower) return GLP_LO;
+    if (has_upper) return GLP_UP;
+    return GLP_FR;
+  }
+};
+#endif // WITH_GLPK
+} // anonymous namespace
+
+
+
+bool WallClock::operator()(const Progress& progress) const {
+  return progress.objective < infinity && progress.elapsed >= seconds_;
+}
+
+bool GapPlateau::operator()(const Progress& progress) {
+  if (progress.objective >= infinity) {
+    return false;
+  }
+  if (reference_gap_ >= infinity || progress.gap <= reference_gap_ - min_improvement_) {
+    reference_gap_ = progress.gap;
+    reference_time_ = progress.elapsed;
+    return false;
+  }
+  return progress.elapsed - reference_time_ >= seconds_;
+}
+
+
+std::vector<std::string> available_solvers() {
+  std::vector<std::string> names;
+#ifdef WITH_CPLEX
+  names.push_back("cplex");
+#endif
+#ifdef WITH_GUROBI
+  names.push_back("gurobi");
+#endif
+#ifdef WITH_GLPK
+  names.push_back("glpk");
+#endif
+  return names;
+}
+
+boost::shared_ptr<Solver> create_solver(const std::string& name) {
+  std::string selected = name;
+  if (selected.empty()) {
+    const std::vector<std::string> names = available_solvers();
+    if (names.empty()) {
+      throw std::runtime_error("lp::create_solver(): no solver backend compiled in");
+    }
+    selected = names.front();
+  }
+#ifdef WITH_CPLEX
+  if (selected == "cplex") {
+    return boost::shared_ptr<Solver>(new CplexSolver());
+  }
+#endif
+#ifdef WITH_GUROBI
+  if (selected == "gurobi") {
+    return boost::shared_ptr<Solver>(new GurobiSolver());
+  }
+#endif
+#ifdef WITH_GLPK
+  if (selected == "glpk") {
+    return boost::shared_ptr<Solver>(new GlpkSolver());
+  }
+#endif
+  throw std::runtime_error("lp::create_solver(): solver backend '" + selected + "' is not available");
+}
+
+} /* namespace lp */
+} /* namespace pgmlink */
@@ -258,7 +258,7 @@ std::vector<Traxel> FeatureExtractorMCOMsFromPCOMs::operator()(
     res.push_back(trax);
     Traxel& new_trax = res.back();
     new_trax.Id = start_id;
-    new_trax.features["com"] = feature_array(range.begin()+(3*n), range.begin()+(3*(n+1)));
+    new_trax.set_feature("com", feature_array(range.begin()+(3*n), range.begin()+(3*(n+1))));
     LOG(logINFO) << "FeatureExtractorMCOMsFromPCOMs::operator()(): Appended traxel with com (" << new_trax.features["com"][0] << "," << new_trax.features["com"][1] << "," << new_trax.features["com"][2] << ") and id " << new_trax.Id;
   }
   return res;
@@ -283,7 +283,7 @@ std::vector<Traxel> FeatureExtractorMCOMsFromMCOMs::operator()(
     // copy such that we won't modify the original traxel
     Traxel new_trax = trax;
     new_trax.Id = start_id;
-    new_trax.features["com"] = feature_array(it->second.begin()+(3*n), it->second.begin()+(3*(n+1)));
+    new_trax.set_feature("com", feature_array(it->second.begin()+(3*n), it->second.begin()+(3*(n+1))));
     res.push_back(new_trax);
     LOG(logDEBUG3) << "FeatureExtractorMCOMsFromMCOMs::operator()(): Appended traxel with com (" << new_trax.features["com"][0] << "," << new_trax.features["com"][1] << "," << new_trax.features["com"][2] << ") and id " << new_trax.Id;
   }
@@ -360,7 +360,7 @@ void FeatureHandlerBase::add_arcs_for_replacement_node(HypothesesGraph& g,
   property_map<arc_active, HypothesesGraph::base_graph>::type& arc_active_map = g.get(arc_active());
   property_map<arc_resolution_candidate, HypothesesGraph::base_graph>::type& arc_resolution_map = g.get(arc_resolution_candidate());
 
-  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+  const NodeTraxels traxel_map(g);
 
   std::vector<int> arc_ids;
   // add incoming arcs
@@ -411,7 +411,7 @@ void FeatureHandlerFromTraxels::operator()(
   
   // property maps
   property_map<node_active2, HypothesesGraph::base_graph>::type& active_map = g.get(node_active2());
-  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+  NodeTraxels traxel_map(g);
   property_map<node_timestep, HypothesesGraph::base_graph>::type& time_map = g.get(node_timestep());
   property_map<node_originated_from, HypothesesGraph::base_graph>::type& origin_map = g.get(node_originated_from());
   property_map<node_resolution_candidate, HypothesesGraph::base_graph>::type& node_resolution_map = g.get(node_resolution_candidate());
@@ -450,7 +450,7 @@ void FeatureHandlerFromTraxels::operator()(
 //// DistanceFromCOMs
 ////
 double DistanceFromCOMs::operator()(const HypothesesGraph& g, HypothesesGraph::Node from, HypothesesGraph::Node to) {
-  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+  const NodeTraxels traxel_map(g);
   return traxel_map[from].distance_to(traxel_map[to]);
 }
 
@@ -471,12 +471,10 @@ void MergerResolver::deactivate_arcs(std::vector<HypothesesGraph::base_graph::Ar
   // Deactivate Arcs provided by arcs.
   // Useful to deactivate arcs of merger node.
 
-  property_map<arc_active, HypothesesGraph::base_graph>::type& arc_active_map = g_->get(arc_active());
-  property_map<arc_resolution_candidate, HypothesesGraph::base_graph>::type& arc_resolution_map = g_->get(arc_resolution_candidate());
   for (std::vector<HypothesesGraph::base_graph::Arc>::iterator it = arcs.begin(); it != arcs.end(); ++it) {
-    LOG(logDEBUG3) << "MergerResolver::deactivate_arcs(): setting arc " << g_->id(*it)  << " (" << g_->get(node_traxel())[g_->source((*it))].Id << "," << g_->get(node_traxel())[g_->target((*it))].Id << ") property arc_active to false";
-    arc_active_map.set(*it, false);
-    arc_resolution_map.set(*it, false);
+    LOG(logDEBUG3) << "MergerResolver::deactivate_arcs(): setting arc " << g_->id(*it)  << " (" << NodeTraxels(*g_)[g_->source((*it))].Id << "," << NodeTraxels(*g_)[g_->target((*it))].Id << ") property arc_active to false";
+    set(arc_active(), *it, false);
+    set(arc_resolution_candidate(), *it, false);
   }
 }
 
@@ -484,20 +482,19 @@ void MergerResolver::deactivate_nodes(std::vector<HypothesesGraph::Node> nodes)
   // Deactivate Nodes provided by nodes.
   // Needed to set all resolved merger nodes inactive.
   std::vector<HypothesesGraph::Node>::iterator it = nodes.begin();
-  property_map<node_active2, HypothesesGraph::base_graph>::type& node_active_map = g_->get(node_active2());
-  property_map<node_resolution_candidate, HypothesesGraph::base_graph>::type& node_resolution_map = g_->get(node_resolution_candidate());
   for (; it != nodes.end(); ++it) {
     LOG(logDEBUG3) << "MergerResolver::deactivate_nodes(): setting Node " << g_->id(*it) << " property node_active2 to 0";
-    node_active_map.set(*it, 0);
-    node_resolution_map.set(*it, 0);
+    set(node_active2(), *it, 0);
+    set(node_resolution_candidate(), *it, false);
   }
 }
 
 unsigned int MergerResolver::get_max_id(int ts) {
-  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g_->get(node_traxel());
+  const NodeTraxels traxel_map(*g_);
   property_map<node_timestep, HypothesesGraph::base_graph>::type& time_map = g_->get(node_timestep());
   property_map<node_timestep, HypothesesGraph::base_graph>::type::ItemIt timeIt(time_map, ts);
   unsigned int max_id = 0;
+  // inactive hypotheses are included, so new ids are unique in the whole graph
   for (; timeIt != lemon::INVALID; ++timeIt) {
     if (traxel_map[timeIt].Id > max_id) {
       max_id = traxel_map[timeIt].Id;
@@ -511,7 +508,6 @@ void MergerResolver::refine_node(HypothesesGraph::Node node,
                                  FeatureHandlerBase& handler) {
   LOG(logDEBUG4) << "MergerResolver::refine_node() -- entered";
   property_map<node_timestep, HypothesesGraph::base_graph>::type& time_map = g_->get(node_timestep());
-  property_map<merger_resolved_to, HypothesesGraph::base_graph>::type& resolved_map = g_->get(merger_resolved_to());
     
   int timestep = time_map[node];
   unsigned int max_id = get_max_id(timestep)+1;
@@ -536,15 +532,18 @@ void MergerResolver::refine_node(HypothesesGraph::Node node,
   deactivate_arcs(sources);
   deactivate_arcs(targets);
   // save information on new ids in property map
-  resolved_map.set(node, new_ids);
+  set(merger_resolved_to(), node, new_ids);
 }
 
 
-void calculate_gmm_beforehand(HypothesesGraph& g, int n_trials, int n_dimensions) {
-  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+namespace {
+// the traxels of the mergers are changed through the overlay, if given
+void calculate_gmm_beforehand(HypothesesGraph& g, HypothesesGraphOverlay* overlay, int n_trials, int n_dimensions) {
+  NodeTraxels traxel_map(g);
   HypothesesGraph::node_timestep_map& timestep_map = g.get(node_timestep());
   HypothesesGraph::node_timestep_map::ValueIt timestep_it = timestep_map.beginValue();
   property_map<node_active2, HypothesesGraph::base_graph>::type& active_map = g.get(node_active2());
+  property_map<arc_active, HypothesesGraph::base_graph>::type& arc_active_map = g.get(arc_active());
   
   for (; timestep_it != timestep_map.endValue(); ++timestep_it) {
     HypothesesGraph::node_timestep_map::ItemIt node_it(timestep_map, *timestep_it);
@@ -557,6 +556,9 @@ void calculate_gmm_beforehand(HypothesesGraph& g, int n_trials, int n_dimensions
         arma::vec initial_weights(count);
         int curr_idx = 0;
         for (HypothesesGraph::InArcIt arc_it(g, node_it); arc_it != lemon::INVALID; ++arc_it) {
+          if (!arc_active_map[arc_it]) {
+            continue;
+          }
           int count_src = active_map[g.source(arc_it)];
           if (count_src == 1) {
             const feature_array& com = traxel_map[g.source(arc_it)].features.find("com")->second;
@@ -582,12 +584,25 @@ void calculate_gmm_beforehand(HypothesesGraph& g, int n_trials, int n_dimensions
         feature_array possible_coms = gmm();
         trax.features["mergerCOMs"].resize(possible_coms.size());
         std::copy(possible_coms.begin(), possible_coms.end(), trax.features["mergerCOMs"].begin());
-        traxel_map.set(node_it, trax);
+        if (overlay) {
+          overlay->set_traxel(node_it, trax);
+        } else {
+          traxel_map.set(node_it, trax);
+        }
       }
     }
   }
   LOG(logINFO) << "calculate_gmm_beforehand: done";
 }
+}
+
+void calculate_gmm_beforehand(HypothesesGraph& g, int n_trials, int n_dimensions) {
+  calculate_gmm_beforehand(g, NULL, n_trials, n_dimensions);
+}
+
+void calculate_gmm_beforehand(HypothesesGraphOverlay& overlay, int n_trials, int n_dimensions) {
+  calculate_gmm_beforehand(overlay.graph(), &overlay, n_trials, n_dimensions);
+}
 
 HypothesesGraph* MergerResolver::resolve_mergers(FeatureHandlerBase& handler) {
   // extract property maps and iterators from graph
@@ -661,7 +676,9 @@ void resolve_graph(HypothesesGraph& src,
                    double ep_gap,
                    bool with_tracklets, 
                    const double transition_parameter,
-                   const bool with_constraints) {
+                   const bool with_constraints,
+                   const std::string& solver_backend,
+                   const lp::SolverSettings& solver_settings) {
 
   // Optimize the graph built by the class MergerResolver.
   // Up to here everything is only graph (nodes, arcs) based
@@ -721,6 +738,10 @@ void resolve_graph(HypothesesGraph& src,
   // boost::function<double(const double)> transition = NegLnTransition(1); // weight 1
   boost::function<double(const Traxel&, const size_t)> detection = boost::bind<double>(NegLnConstant(1,prob), _2);
   translate_property_value_map<node_traxel, HypothesesGraph::Node>(src, dest, nr);
+  if (src.has_property(node_traxel_ref())) {
+    dest.add(node_traxel_ref());
+    translate_property_value_map<node_traxel_ref, HypothesesGraph::Node>(src, dest, nr);
+  }
   translate_property_value_map<arc_distance, HypothesesGraph::Arc>(src, dest, ar);
   translate_property_value_map<node_originated_from, HypothesesGraph::Node>(src, dest, nr);
   translate_property_bool_map<division_active, HypothesesGraph::Node>(src, dest, nr);
@@ -756,7 +777,10 @@ void resolve_graph(HypothesesGraph& src,
       false, // with appearance
       false, // with disappearance
       transition_parameter,
-      with_constraints
+      with_constraints,
+      1e75, // cplex_timeout
+      solver_backend,
+      solver_settings
                            );
 
   pgm.formulate(dest);
@@ -827,14 +851,13 @@ void duplicate_division_nodes(HypothesesGraph& graph,
 
   LOG(logDEBUG) << "duplicate_division_nodes(): enter";
   typedef property_map<division_active, HypothesesGraph::base_graph>::type DivisionMap;
-  typedef property_map<node_traxel, HypothesesGraph::base_graph>::type TraxelMap;
   typedef property_map<arc_active, HypothesesGraph::base_graph>::type ArcMap;
   typedef property_map<arc_distance, HypothesesGraph::base_graph>::type DistanceMap;
   typedef property_map<node_active2, HypothesesGraph::base_graph>::type NodeMap;
   typedef property_map<node_originated_from, HypothesesGraph::base_graph>::type OriginMap;
 
   DivisionMap& division_map = graph.get(division_active());
-  TraxelMap& traxel_map = graph.get(node_traxel());
+  NodeTraxels traxel_map(graph);
   ArcMap& arc_map = graph.get(arc_active());
   DistanceMap& distance_map = graph.get(arc_distance());
   NodeMap& node_map = graph.get(node_active2());
@@ -851,9 +874,8 @@ void duplicate_division_nodes(HypothesesGraph& graph,
     }
 
       
-    const Traxel& trax = traxel_map[division_it];
-    const HypothesesGraph::Node& node = graph.add_node(trax.Timestep);
-    traxel_map.set(node, trax);
+    const HypothesesGraph::Node& node = graph.add_node(traxel_map[division_it].Timestep);
+    traxel_map.set(node, traxel_map[division_it]);
     node_map.set(node, 1);
 
     // Do not duplicate incoming arcs:
@@ -142,6 +142,19 @@ namespace pgmlink {
       return *this;
     }
 
+    double ModelBuilder::move_energy( const HypothesesGraph& hypotheses, const HypothesesGraph::Arc& a ) const {
+      // SquaredDistance is Traxel::distance_to(): read it from arc_distance if that was
+      // computed for the arc and without optical correction
+      if( move_.target<SquaredDistance>() != NULL && hypotheses.has_property(arc_features()) ) {
+	const ArcFeatureTable& table = hypotheses.get(arc_features());
+	if( table.contains(a) && !table.optical_correction() ) {
+	  return hypotheses.get(arc_distance())[a];
+	}
+      }
+      const NodeTraxels traxel_map(hypotheses);
+      return move_(traxel_map[hypotheses.source(a)], traxel_map[hypotheses.target(a)]);
+    }
+
     ModelBuilder& ModelBuilder::with_detection_vars( function<double (const Traxel&)> detection,
 									 function<double (const Traxel&)> non_detection) {
       if(!(detection && non_detection)) {
@@ -180,71 +193,127 @@ namespace pgmlink {
 	inline size_t cplex_id(size_t opengm_id) {
 	  return 2*opengm_id + 1;
 	}
-      }
-      void ModelBuilder::add_hard_constraints( const Model& m, const HypothesesGraph& hypotheses, OpengmLPCplex& cplex ) {
-	LOG(logDEBUG) << "Chaingraph::add_constraints: entered";
-	////
-	//// outgoing transitions
-	////
-	LOG(logDEBUG) << "Chaingraph::add_constraints: outgoing transitions";
-	for(HypothesesGraph::NodeIt n(hypotheses); n!=lemon::INVALID; ++n) {
-	  // couple detection and transitions
-	  if(has_detection_vars()) {
-	    for(HypothesesGraph::OutArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
-	      couple(m, n, a, cplex);
+
+	// lp column of the indicator "opengm variable is on"
+#ifdef WITH_OPENGM_LP
+	inline size_t on_column(const OpengmLPCplex&, size_t opengm_id) {
+	  return cplex_id(opengm_id);
+	}
+#endif
+	inline size_t on_column(const lp::DiscreteFormulation& f, size_t opengm_id) {
+	  return f.column(opengm_id, 1);
+	}
+
+	// lower <= sum_k coeffs[k]*column[k] <= upper
+#ifdef WITH_OPENGM_LP
+	inline void add_constraint(OpengmLPCplex& cplex, const vector<size_t>& cplex_idxs, const vector<int>& coeffs, double lower, double upper) {
+	  cplex.addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), lower, upper);
+	}
+#endif
+	inline void add_constraint(lp::DiscreteFormulation& f, const vector<size_t>& cplex_idxs, const vector<int>& coeffs, double lower, double upper) {
+	  f.program().add_row(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), lower, upper);
+	}
+
+	template <typename LP>
+	void couple(const Model& m, const HypothesesGraph::Node& n, const HypothesesGraph::Arc& a, LP& lp ) {
+	  vector<size_t> cplex_idxs; 
+	  cplex_idxs.push_back(on_column(lp, m.var_of_node(n)));
+	  cplex_idxs.push_back(on_column(lp, m.var_of_arc(a)));
+	  vector<int> coeffs;
+	  coeffs.push_back(1);
+	  coeffs.push_back(-1);
+	  // 0 <= 1*detection - 1*transition <= 1
+	  add_constraint(lp, cplex_idxs, coeffs, 0, 1);
+	}
+
+	template <typename LP>
+	void add_hard_constraints( const ModelBuilder& builder, const Model& m, const HypothesesGraph& hypotheses, LP& lp ) {
+	  LOG(logDEBUG) << "Chaingraph::add_constraints: entered";
+	  ////
+	  //// outgoing transitions
+	  ////
+	  LOG(logDEBUG) << "Chaingraph::add_constraints: outgoing transitions";
+	  for(HypothesesGraph::NodeIt n(hypotheses); n!=lemon::INVALID; ++n) {
+	    // couple detection and transitions
+	    if(builder.has_detection_vars()) {
+	      for(HypothesesGraph::OutArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
+		couple(m, n, a, lp);
+	      }
 	    }
-	  }
 	
-	  // couple assignments
-	  vector<size_t> cplex_idxs;
-	  for(HypothesesGraph::OutArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
-	    cplex_idxs.push_back(cplex_id(m.var_of_arc(a)));
-	  }
-	  if( cplex_idxs.size() > 0 ) {
-	    vector<int> coeffs(cplex_idxs.size(), 1);
-	    // 0 <= 1*transition + ... + 1*transition <= 2 [div] or 1 [no div]
-	    const size_t max_on = has_divisions() ? 2 : 1;
-	    cplex.addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, max_on);
+	    // couple assignments
+	    vector<size_t> cplex_idxs;
+	    for(HypothesesGraph::OutArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
+	      cplex_idxs.push_back(on_column(lp, m.var_of_arc(a)));
+	    }
+	    if( cplex_idxs.size() > 0 ) {
+	      vector<int> coeffs(cplex_idxs.size(), 1);
+	      // 0 <= 1*transition + ... + 1*transition <= 2 [div] or 1 [no div]
+	      const size_t max_on = builder.has_divisions() ? 2 : 1;
+	      add_constraint(lp, cplex_idxs, coeffs, 0, max_on);
+	    }
 	  }
-	}
       
-	////
-	//// incoming transitions
-	////
-	LOG(logDEBUG) << "Chaingraph::add_constraints: incoming transitions";
-	for(HypothesesGraph::NodeIt n(hypotheses); n!=lemon::INVALID; ++n) {
-	  // couple detection and transitions
-	  if(has_detection_vars()) {
-	    for(HypothesesGraph::InArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
-	      couple(m, n, a, cplex);
+	  ////
+	  //// incoming transitions
+	  ////
+	  LOG(logDEBUG) << "Chaingraph::add_constraints: incoming transitions";
+	  for(HypothesesGraph::NodeIt n(hypotheses); n!=lemon::INVALID; ++n) {
+	    // couple detection and transitions
+	    if(builder.has_detection_vars()) {
+	      for(HypothesesGraph::InArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
+		couple(m, n, a, lp);
+	      }
 	    }
-	  }
 	    
-	  // couple transitions
-	  vector<size_t> cplex_idxs;
-	  for(HypothesesGraph::InArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
-	    cplex_idxs.push_back(cplex_id(m.var_of_arc(a)));
+	    // couple transitions
+	    vector<size_t> cplex_idxs;
+	    for(HypothesesGraph::InArcIt a(hypotheses, n); a!=lemon::INVALID; ++a) {
+	      cplex_idxs.push_back(on_column(lp, m.var_of_arc(a)));
+	    }
+	    if(cplex_idxs.size() > 0) {
+	      vector<int> coeffs(cplex_idxs.size(), 1);
+	      // 0 <= 1*transition + ... + 1*transition <= 1
+	      add_constraint(lp, cplex_idxs, coeffs, 0, 1);
+	    }
 	  }
-	  if(cplex_idxs.size() > 0) {
-	    vector<int> coeffs(cplex_idxs.size(), 1);
-	    // 0 <= 1*transition + ... + 1*transition <= 1
-	    cplex.addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 1);
+	}
+
+	template <typename LP>
+	void fix_detections( const Model& m, const HypothesesGraph& g, LP& lp ) {
+	  for(HypothesesGraph::NodeIt n(g); n!=lemon::INVALID; ++n) {
+	    vector<size_t> cplex_idxs; 
+	    cplex_idxs.push_back(on_column(lp, m.var_of_node(n)));
+	    vector<int> coeffs;
+	    coeffs.push_back(1);
+	    // 1 <= 1*detection <= 1
+	    add_constraint(lp, cplex_idxs, coeffs, 1, 1);
 	  }
 	}
+      } /* anonymous namespace */
+
+#ifdef WITH_OPENGM_LP
+      void ModelBuilder::add_hard_constraints( const Model& m, const HypothesesGraph& hypotheses, OpengmLPCplex& cplex ) {
+	chaingraph::add_hard_constraints(*this, m, hypotheses, cplex);
       }
 
       void ModelBuilder::fix_detections( const Model& m, const HypothesesGraph& g, OpengmLPCplex& cplex ) {
 	if(!has_detection_vars()) {
 	  throw std::runtime_error("chaingraph::ModelBuilder::fix_detections(): called without has_detection_vars()");
 	}
-	for(HypothesesGraph::NodeIt n(g); n!=lemon::INVALID; ++n) {
-	  vector<size_t> cplex_idxs; 
-	  cplex_idxs.push_back(cplex_id(m.var_of_node(n)));
-	  vector<int> coeffs;
-	  coeffs.push_back(1);
-	  // 1 <= 1*detection <= 1
-	  cplex.addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin() , 1, 1);
+	chaingraph::fix_detections(m, g, cplex);
+      }
+#endif
+
+      void ModelBuilder::add_hard_constraints( const Model& m, const HypothesesGraph& hypotheses, lp::DiscreteFormulation& f ) {
+	chaingraph::add_hard_constraints(*this, m, hypotheses, f);
+      }
+
+      void ModelBuilder::fix_detections( const Model& m, const HypothesesGraph& g, lp::DiscreteFormulation& f ) {
+	if(!has_detection_vars()) {
+	  throw std::runtime_error("chaingraph::ModelBuilder::fix_detections(): called without has_detection_vars()");
 	}
+	chaingraph::fix_detections(m, g, f);
       }
 
       inline void ModelBuilder::add_detection_vars( const HypothesesGraph& hypotheses, Model& m ) const {
@@ -292,19 +361,6 @@ namespace pgmlink {
 	return vi;
       }
 
-      void ModelBuilder::couple(const Model& m, const HypothesesGraph::Node& n, const HypothesesGraph::Arc& a, OpengmLPCplex& cplex ) {
-	vector<size_t> cplex_idxs; 
-	cplex_idxs.push_back(cplex_id(m.var_of_node(n)));
-	cplex_idxs.push_back(cplex_id(m.var_of_arc(a)));
-	vector<int> coeffs;
-	coeffs.push_back(1);
-	coeffs.push_back(-1);
-	// 0 <= 1*detection - 1*transition <= 1
-	cplex.addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin() , 0, 1);
-      }
-
-
-
     ////
     //// class TrainableChaingraphModelBuilder
     ////
@@ -354,7 +410,7 @@ namespace pgmlink {
     }
 
     void TrainableModelBuilder::add_detection_factor( const HypothesesGraph& hypotheses, Model& m, const HypothesesGraph::Node& n ) const {
-      property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = hypotheses.get(node_traxel());
+      const NodeTraxels traxel_map(hypotheses);
       std::vector<size_t> var_indices;
       var_indices.push_back(m.var_of_node(n));
       size_t shape[] = {2};
@@ -368,38 +424,11 @@ namespace pgmlink {
       	.add_as_feature_to( *(m.opengm_model), m.weight_map[Model::det_weight].front() );
     }
 
-    namespace {
-      std::vector<size_t> DecToBin(size_t number)
-      {
-	if ( number == 0 ) return std::vector<size_t>(1,0);
-	if ( number == 1 ) return std::vector<size_t>(1,1);
-	
-	if ( number % 2 == 0 ) {
-	  std::vector<size_t> ret = DecToBin(number / 2);
-	  ret.push_back(0);
-	  return ret;
-	}
-	else {
-	  std::vector<size_t> ret = DecToBin(number / 2);
-	  ret.push_back(1);
-	  return ret;
-	}
-      }
-
-      int BinToDec(std::vector<size_t> number)
-      {
-	int result = 0, pow = 1;
-	for ( int i = number.size() - 1; i >= 0; --i, pow <<= 1 )
-	  result += number[i] * pow;
-	return result;
-      }
-    }
-
     inline void TrainableModelBuilder::add_outgoing_factor( const HypothesesGraph& hypotheses,
 							    Model& m, 
 							    const HypothesesGraph::Node& n) const {
       using namespace std;
-      property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = hypotheses.get(node_traxel());
+      const NodeTraxels traxel_map(hypotheses);
 
       LOG(logDEBUG) << "TrainableModelBuilder::add_outgoing_factor(): entered";
       // setup node and arc var indices
@@ -422,17 +451,13 @@ namespace pgmlink {
       const std::vector<size_t> shape(table_dim, 2);
       std::vector<size_t> coords;
 
-      std::set<size_t > entries;
-      for(size_t i = 0; i < static_cast<size_t>(std::pow(2., static_cast<int>(table_dim))); ++i) {
-	entries.insert( entries.end(), i );
-      }
+      // every labeling not explicitly allowed below is forbidden
+      OpengmSparseFactor<OpengmModel::ValueType> forbidden( vi, forbidden_cost() );
 	
       // opportunity configuration; only in case of detection vars
       if(has_detection_vars()) {
 	coords = std::vector<size_t>(table_dim, 0); // (0,0,...,0)
-	size_t check = entries.erase(BinToDec(coords));
-	assert(check == 1);
-   _unused(check); // for build in release mode
+	forbidden.set_value( coords, 0 );
 	OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), opportunity_cost() )
 	  .add_as_feature_to( *(m.opengm_model), m.weight_map[Model::opp_weight].front() );
       }
@@ -443,9 +468,7 @@ namespace pgmlink {
 	if(has_detection_vars()){
 	  coords[0] = 1; // (1,0,...,0)
 	}
-	size_t check = entries.erase(BinToDec(coords));
-	assert(check == 1);
-   _unused(check); // for build in release mode
+	forbidden.set_value( coords, 0 );
 	OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), disappearance()(traxel_map[n]) )
 	  .add_as_feature_to( *(m.opengm_model), m.weight_map[Model::dis_weight].front() );
       }
@@ -461,10 +484,8 @@ namespace pgmlink {
 	// (1  ,0,0,0,1,0,0)
 	for(size_t i = assignment_begin; i < table_dim; ++i) {
 	  coords[i] = 1; 
-	  size_t check = entries.erase(BinToDec(coords));
-	  assert(check == 1);
-     _unused(check); // for build in release mode
-	  OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), move()(traxel_map[n], traxel_map[hypotheses.target(arcs[i-assignment_begin])]) )
+	  forbidden.set_value( coords, 0 );
+	  OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), move_energy(hypotheses, arcs[i-assignment_begin]) )
 	    .add_as_feature_to( *(m.opengm_model), m.weight_map[Model::mov_weight].front() );
 	  coords[i] = 0; // reset coords
 	}
@@ -484,9 +505,7 @@ namespace pgmlink {
 	  for(unsigned int j = i+1; j < table_dim; ++j) {
 	    coords[i] = 1;
 	    coords[j] = 1;
-	    size_t check = entries.erase(BinToDec(coords));
-	    assert(check == 1);
-       _unused(check); // for build in release mode
+	    forbidden.set_value( coords, 0 );
 	    OpengmModel::ValueType value = division()(traxel_map[n],
 							traxel_map[hypotheses.target(arcs[i-assignment_begin])],
 							traxel_map[hypotheses.target(arcs[j-assignment_begin])]);
@@ -500,18 +519,7 @@ namespace pgmlink {
       }
 
       // forbidden configurations
-      {
-	for(std::set<size_t>::iterator it = entries.begin(); it != entries.end(); ++it) {
-	  coords = DecToBin(*it);
-	  // pad with zeros up to coordinate size
-	  if(coords.size() < table_dim ) {
-	    coords.insert(coords.begin(), table_dim-coords.size(), 0);
-	  }
-	  assert( coords.size() == table_dim );
-	  OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), forbidden_cost())
-	    .add_to( *(m.opengm_model) );
-	}
-      }
+      forbidden.add_to( *(m.opengm_model) );
 
       LOG(logDEBUG) << "TrainableChaingraphModelBuilder::add_outgoing_factor(): leaving";
     }
@@ -520,7 +528,7 @@ namespace pgmlink {
 								      Model& m,
 								      const HypothesesGraph::Node& n ) const {
       using namespace std;
-      property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = hypotheses.get(node_traxel());
+      const NodeTraxels traxel_map(hypotheses);
 
       LOG(logDEBUG) << "TrainableModelBuilder::add_incoming_factor(): entered";
       // collect and count incoming arcs
@@ -536,18 +544,14 @@ namespace pgmlink {
       const std::vector<size_t> shape(table_dim, 2);
       std::vector<size_t> coords;
       
-      std::set<size_t > entries;
-      for(size_t i = 0; i < static_cast<size_t>(std::pow(2., static_cast<int>(table_dim))); ++i) {
-	entries.insert( entries.end(), i );
-      }
+      // every labeling not explicitly allowed below is forbidden
+      OpengmSparseFactor<OpengmModel::ValueType> forbidden( vi, forbidden_cost() );
 
       // allow opportunity configuration
       // (0,0,...,0)
       if(has_detection_vars()) {
 	coords = std::vector<size_t>(table_dim, 0);
-	size_t check = entries.erase(BinToDec(coords));
-	assert(check == 1);
-   _unused(check); // for build in release mode
+	forbidden.set_value( coords, 0 );
       }
 
       // appearance configuration
@@ -555,9 +559,7 @@ namespace pgmlink {
       if(has_detection_vars()) {
 	coords[0] = 1; // (1,0,...,0)
       }
-      size_t check = entries.erase(BinToDec(coords));
-      assert(check == 1);
-      _unused(check); // for build in release mode
+      forbidden.set_value( coords, 0 );
       OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), appearance()(traxel_map[n]) )
 	.add_as_feature_to( *(m.opengm_model), m.weight_map[Model::app_weight].front() );
 
@@ -571,23 +573,12 @@ namespace pgmlink {
       }
       for(size_t i = assignment_begin; i < table_dim; ++i) {
 	coords[i] = 1; 
-	size_t check = entries.erase(BinToDec(coords));
-	assert(check == 1);
-   _unused(check); // for build in release mode
+	forbidden.set_value( coords, 0 );
 	coords[i] = 0; // reset coords
       }
 
       // forbidden configurations
-      for(std::set<size_t>::iterator it = entries.begin(); it != entries.end(); ++it) {
-	coords = DecToBin(*it);
-	// zero padding up to table dim
-	if(coords.size() < table_dim ) {
-	  coords.insert(coords.begin(), table_dim-coords.size(), 0);
-	}
-	assert( coords.size() == table_dim );
-	OpengmWeightedFeature<OpengmModel::ValueType>(vi, shape.begin(), shape.end(), coords.begin(), forbidden_cost())
-	  .add_to( *(m.opengm_model) );
-      }
+      forbidden.add_to( *(m.opengm_model) );
       
       LOG(logDEBUG) << "TrainableModelBuilder::add_incoming_factor(): leaving";
     }
@@ -636,7 +627,7 @@ namespace pgmlink {
     }
 
     void ECCV12ModelBuilder::add_detection_factor( const HypothesesGraph& hypotheses, Model& m, const HypothesesGraph::Node& n) const {
-      property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = hypotheses.get(node_traxel());
+      const NodeTraxels traxel_map(hypotheses);
 
       size_t vi[] = {m.var_of_node(n)};
       vector<size_t> coords(1,0);
@@ -656,7 +647,7 @@ namespace pgmlink {
 								   const HypothesesGraph::Node& n
 								   ) const {
       using namespace std;
-      property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = hypotheses.get(node_traxel());
+      const NodeTraxels traxel_map(hypotheses);
 
       LOG(logDEBUG) << "ECCV12ModelBuilder::add_outgoing_factor(): entered";
       // collect and count outgoing arcs
@@ -692,7 +683,7 @@ namespace pgmlink {
 	// no division possible
 	size_t table_dim = 2; 		// detection var + 1 * transition var
 	std::vector<size_t> coords;
-	OpengmExplicitFactor<double> table( vi, forbidden_cost() );
+	OpengmSparseFactor<double> table( vi, forbidden_cost() );
 
 	// opportunity configuration
 	coords = std::vector<size_t>(table_dim, 0); // (0,0)
@@ -706,7 +697,7 @@ namespace pgmlink {
 	// move configurations
 	coords = std::vector<size_t>(table_dim, 1);
 	// (1,1)
-	table.set_value( coords, move()(traxel_map[n], traxel_map[hypotheses.target(arcs[0])]) );
+	table.set_value( coords, move_energy(hypotheses, arcs[0]) );
 
 	table.add_to( *m.opengm_model );
 
@@ -714,7 +705,7 @@ namespace pgmlink {
 	// build value table
 	size_t table_dim = count + 1; 		// detection var + n * transition var
 	std::vector<size_t> coords;
-	OpengmExplicitFactor<double> table( vi, forbidden_cost() );
+	OpengmSparseFactor<double> table( vi, forbidden_cost() );
 
 	// opportunity configuration
 	coords = std::vector<size_t>(table_dim, 0); // (0,0,...,0)
@@ -731,7 +722,7 @@ namespace pgmlink {
 	// (1,0,0,0,1,0,0)
 	for(size_t i = 1; i < table_dim; ++i) {
 	  coords[i] = 1; 
-	  table.set_value( coords, move()(traxel_map[n], traxel_map[hypotheses.target(arcs[i-1])]) );
+	  table.set_value( coords, move_energy(hypotheses, arcs[i-1]) );
 	  coords[i] = 0; // reset coords
 	}
       
@@ -766,7 +757,7 @@ namespace pgmlink {
 								   Model& m,
 								   const HypothesesGraph::Node& n) const {
       using namespace std;
-      property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = hypotheses.get(node_traxel());
+      const NodeTraxels traxel_map(hypotheses);
 
       LOG(logDEBUG) << "ECCV12ModelBuilder::add_incoming_factor(): entered";
       // collect and count incoming arcs
@@ -782,7 +773,7 @@ namespace pgmlink {
       //// construct factor
       // build value table
       size_t table_dim = count + 1; // detection var + n * transition var
-      OpengmExplicitFactor<double> table( vi, forbidden_cost() );
+      OpengmSparseFactor<double> table( vi, forbidden_cost() );
       std::vector<size_t> coords;
 
       // allow opportunity configuration
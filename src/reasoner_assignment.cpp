@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_snapshot.h"
+#include "pgmlink/log.h"
+#include "pgmlink/reasoner_assignment.h"
+#include "pgmlink/traxels.h"
+
+using namespace std;
+
+namespace pgmlink {
+namespace {
+/**
+ * Minimum cost assignment of every row to a distinct column (rows <= cols)
+ * by the Hungarian method with potentials in O(rows^2 cols). cost is
+ * stored row by row.
+ */
+void hungarian(const vector<double>& cost, size_t rows, size_t cols, vector<size_t>& column_of_row) {
+    assert(rows <= cols);
+    const double inf = numeric_limits<double>::infinity();
+    // 1-based; column 0 is the virtual start of each augmenting path
+    vector<double> u(rows + 1, 0.), v(cols + 1, 0.);
+    vector<size_t> row_of(cols + 1, 0), way(cols + 1, 0);
+    vector<double> min_slack(cols + 1);
+    vector<bool> used(cols + 1);
+    for (size_t i = 1; i <= rows; ++i) {
+        row_of[0] = i;
+        size_t j0 = 0;
+        fill(min_slack.begin(), min_slack.end(), inf);
+        fill(used.begin(), used.end(), false);
+        do {
+            used[j0] = true;
+            const size_t i0 = row_of[j0];
+            double delta = inf;
+            size_t j1 = 0;
+            for (size_t j = 1; j <= cols; ++j) {
+                if (used[j]) {
+                    continue;
+                }
+                const double slack = cost[(i0 - 1) * cols + (j - 1)] - u[i0] - v[j];
+                if (slack < min_slack[j]) {
+                    min_slack[j] = slack;
+                    way[j] = j0;
+                }
+                if (min_slack[j] < delta) {
+                    delta = min_slack[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= cols; ++j) {
+                if (used[j]) {
+                    u[row_of[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_slack[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (row_of[j0] != 0);
+        // augment along the path
+        do {
+            const size_t j1 = way[j0];
+            row_of[j0] = row_of[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+    column_of_row.assign(rows, 0);
+    for (size_t j = 1; j <= cols; ++j) {
+        if (row_of[j] != 0) {
+            column_of_row[row_of[j] - 1] = j - 1;
+        }
+    }
+}
+
+bool by_distance(const pair<double, size_t>& a, const pair<double, size_t>& b) {
+    return a.first < b.first;
+}
+
+bool by_division_probability(const pair<double, size_t>& a, const pair<double, size_t>& b) {
+    return a.first > b.first;
+}
+}
+
+void AssignmentTracking::formulate(const HypothesesGraph& g) {
+    LOG(logDEBUG) << "AssignmentTracking::formulate: entered";
+    snapshot_ = freeze(g);
+    const HypothesesGraphSnapshot& s = *snapshot_;
+
+    distance_.resize(s.arc_count());
+    if (g.has_property(arc_distance())) {
+        property_map<arc_distance, HypothesesGraph::base_graph>::type& arc_distances = g.get(arc_distance());
+        for (index_type k = 0; k < s.arc_count(); ++k) {
+            distance_[k] = arc_distances[s.arc(k)];
+        }
+    } else {
+        const NodeTraxels traxel_map(g);
+        for (index_type k = 0; k < s.arc_count(); ++k) {
+            distance_[k] = traxel_map[s.node(s.source(k))].distance_to(traxel_map[s.node(s.target(k))]);
+        }
+    }
+
+    timestep_.assign(s.node_count(), 0);
+    for (int t = s.earliest_timestep(); t <= s.latest_timestep(); ++t) {
+        for (HypothesesGraphSnapshot::index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+            timestep_[*n] = t;
+        }
+    }
+    active_arcs_.assign(s.arc_count(), false);
+    divisions_.assign(s.node_count(), false);
+    has_parent_.assign(s.node_count(), false);
+    component_.assign(s.node_count(), HypothesesGraphSnapshot::invalid_index);
+}
+
+void AssignmentTracking::infer() {
+    if (!snapshot_) {
+        throw runtime_error("AssignmentTracking::infer(): formulate() has to be called first");
+    }
+    for (int t = snapshot_->earliest_timestep(); t < snapshot_->latest_timestep(); ++t) {
+        match_timestep(t);
+    }
+}
+
+void AssignmentTracking::conclude(HypothesesGraph& g) {
+    const HypothesesGraphSnapshot& s = *snapshot_;
+    g.add(node_active()).add(arc_active()).add(division_active());
+    property_map<node_active, HypothesesGraph::base_graph>::type& active_nodes = g.get(node_active());
+    property_map<arc_active, HypothesesGraph::base_graph>::type& active_arcs = g.get(arc_active());
+    property_map<division_active, HypothesesGraph::base_graph>::type& division_nodes = g.get(division_active());
+
+    // every detection is taken to be an object
+    for (index_type i = 0; i < s.node_count(); ++i) {
+        active_nodes.set(s.node(i), true);
+        division_nodes.set(s.node(i), divisions_[i]);
+    }
+    for (index_type k = 0; k < s.arc_count(); ++k) {
+        active_arcs.set(s.arc(k), active_arcs_[k]);
+    }
+}
+
+bool AssignmentTracking::is_candidate(index_type arc, int t, double max_distance) const {
+    return timestep_[snapshot_->target(arc)] == t + 1 && distance_[arc] <= max_distance;
+}
+
+void AssignmentTracking::match_timestep(int t) {
+    const HypothesesGraphSnapshot& s = *snapshot_;
+    typedef HypothesesGraphSnapshot::index_iterator index_iterator;
+    const index_type unvisited = HypothesesGraphSnapshot::invalid_index;
+
+    // connected components of the candidate arcs between t and t+1
+    vector<index_type> sources, targets, queue;
+    size_t components = 0;
+    for (index_iterator n = s.timestep_begin(t); n != s.timestep_end(t); ++n) {
+        if (component_[*n] != unvisited) {
+            continue;
+        }
+        sources.clear();
+        targets.clear();
+        queue.assign(1, *n);
+        component_[*n] = 0;
+        while (!queue.empty()) {
+            const index_type i = queue.back();
+            queue.pop_back();
+            if (timestep_[i] == t) {
+                component_[i] = sources.size();
+                sources.push_back(i);
+                for (index_iterator a = s.out_begin(i); a != s.out_end(i); ++a) {
+                    const index_type j = s.target(*a);
+                    if (is_candidate(*a, t, max_move_distance_) && component_[j] == unvisited) {
+                        component_[j] = 0;
+                        queue.push_back(j);
+                    }
+                }
+            } else {
+                component_[i] = targets.size();
+                targets.push_back(i);
+                for (index_iterator a = s.in_begin(i); a != s.in_end(i); ++a) {
+                    const index_type j = s.source(*a);
+                    if (timestep_[j] == t && is_candidate(*a, t, max_move_distance_) && component_[j] == unvisited) {
+                        component_[j] = 0;
+                        queue.push_back(j);
+                    }
+                }
+            }
+        }
+        if (!targets.empty()) {
+            match_component(t, sources, targets);
+            ++components;
+        }
+        // the targets are the sources of the next timestep
+        for (vector<index_type>::const_iterator j = targets.begin(); j != targets.end(); ++j) {
+            component_[*j] = unvisited;
+        }
+    }
+    LOG(logDEBUG1) << "AssignmentTracking::match_timestep: " << components << " components at t = " << t;
+
+    vector<index_type> all_sources(s.timestep_begin(t), s.timestep_end(t));
+    add_divisions(t, all_sources);
+}
+
+void AssignmentTracking::match_component(int t,
+                                         const vector<index_type>& sources,
+                                         const vector<index_type>& targets) {
+    const HypothesesGraphSnapshot& s = *snapshot_;
+    typedef HypothesesGraphSnapshot::index_iterator index_iterator;
+    const index_type no_arc = HypothesesGraphSnapshot::invalid_index;
+
+    if (max(sources.size(), targets.size()) > max_component_size_) {
+        // greedy by increasing distance
+        vector<pair<double, size_t> > arcs;
+        for (vector<index_type>::const_iterator i = sources.begin(); i != sources.end(); ++i) {
+            for (index_iterator a = s.out_begin(*i); a != s.out_end(*i); ++a) {
+                if (is_candidate(*a, t, max_move_distance_)) {
+                    arcs.push_back(make_pair(distance_[*a], *a));
+                }
+            }
+        }
+        sort(arcs.begin(), arcs.end(), by_distance);
+        vector<bool> matched(sources.size(), false);
+        for (vector<pair<double, size_t> >::const_iterator a = arcs.begin(); a != arcs.end(); ++a) {
+            const index_type i = s.source(a->second);
+            const index_type j = s.target(a->second);
+            if (!matched[component_[i]] && !has_parent_[j]) {
+                matched[component_[i]] = true;
+                has_parent_[j] = true;
+                active_arcs_[a->second] = true;
+            }
+        }
+        return;
+    }
+
+    // rows are the smaller side; forbidden pairs cost more than any set of real moves
+    const bool rows_are_sources = sources.size() <= targets.size();
+    const size_t rows = rows_are_sources ? sources.size() : targets.size();
+    const size_t cols = rows_are_sources ? targets.size() : sources.size();
+    const double forbidden = (max_move_distance_ + 1.) * (rows + 1);
+    vector<double> cost(rows * cols, forbidden);
+    vector<index_type> arc(rows * cols, no_arc);
+    for (vector<index_type>::const_iterator i = sources.begin(); i != sources.end(); ++i) {
+        for (index_iterator a = s.out_begin(*i); a != s.out_end(*i); ++a) {
+            if (!is_candidate(*a, t, max_move_distance_)) {
+                continue;
+            }
+            const index_type source = component_[*i];
+            const index_type target = component_[s.target(*a)];
+            const size_t cell = rows_are_sources ? source * cols + target : target * cols + source;
+            if (distance_[*a] < cost[cell]) {
+                cost[cell] = distance_[*a];
+                arc[cell] = *a;
+            }
+        }
+    }
+
+    vector<size_t> column_of_row;
+    hungarian(cost, rows, cols, column_of_row);
+    for (size_t r = 0; r < rows; ++r) {
+        const index_type a = arc[r * cols + column_of_row[r]];
+        if (a != no_arc) {
+            active_arcs_[a] = true;
+            has_parent_[s.target(a)] = true;
+        }
+    }
+}
+
+void AssignmentTracking::add_divisions(int t, const vector<index_type>& sources) {
+    const HypothesesGraphSnapshot& s = *snapshot_;
+    typedef HypothesesGraphSnapshot::index_iterator index_iterator;
+    const index_type no_arc = HypothesesGraphSnapshot::invalid_index;
+    const NodeTraxels traxel_map(s.graph());
+
+    // likely divisions choose their second child first
+    vector<pair<double, size_t> > candidates;
+    for (vector<index_type>::const_iterator i = sources.begin(); i != sources.end(); ++i) {
+        const Traxel& tr = traxel_map[s.node(*i)];
+        FeatureMap::const_iterator div_prob = tr.features.find("divProb");
+        if (div_prob != tr.features.end() && div_prob->second[0] > division_threshold_) {
+            candidates.push_back(make_pair(static_cast<double>(div_prob->second[0]), *i));
+        }
+    }
+    sort(candidates.begin(), candidates.end(), by_division_probability);
+
+    size_t count = 0;
+    for (vector<pair<double, size_t> >::const_iterator c = candidates.begin(); c != candidates.end(); ++c) {
+        const index_type i = c->second;
+        index_type first = no_arc;
+        for (index_iterator a = s.out_begin(i); a != s.out_end(i); ++a) {
+            if (active_arcs_[*a]) {
+                first = *a;
+                break;
+            }
+        }
+        if (first == no_arc || distance_[first] > max_division_distance_) {
+            continue;
+        }
+        const Traxel& ancestor = traxel_map[s.node(i)];
+        const Traxel& child1 = traxel_map[s.node(s.target(first))];
+        index_type second = no_arc;
+        double best = max_division_cost_;
+        for (index_iterator a = s.out_begin(i); a != s.out_end(i); ++a) {
+            if (!is_candidate(*a, t, max_division_distance_) || has_parent_[s.target(*a)]) {
+                continue;
+            }
+            const double cost = division_(ancestor, child1, traxel_map[s.node(s.target(*a))]);
+            if (cost < best) {
+                best = cost;
+                second = *a;
+            }
+        }
+        if (second != no_arc) {
+            active_arcs_[second] = true;
+            has_parent_[s.target(second)] = true;
+            divisions_[i] = true;
+            ++count;
+        }
+    }
+    LOG(logDEBUG1) << "AssignmentTracking::add_divisions: " << count << " divisions at t = " << t;
+}
+
+} /* namespace pgmlink */
@@ -5,9 +5,12 @@
 #include <memory.h>
 #include <opengm/datastructures/marray/marray.hxx>
 #include <opengm/graphicalmodel/graphicalmodel_hdf5.hxx>
+#include <boost/shared_ptr.hpp>
 
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_snapshot.h"
 #include "pgmlink/log.h"
+#include "pgmlink/lp_solver.h"
 #include "pgmlink/reasoner_constracking.h"
 #include "pgmlink/traxels.h"
 
@@ -32,7 +35,12 @@ double ConservationTracking::forbidden_cost() const {
 void ConservationTracking::formulate(const HypothesesGraph& hypotheses) {
     LOG(logDEBUG) << "ConservationTracking::formulate: entered";
     reset();
-    pgm_ = boost::shared_ptr < pgm::OpengmModelDeprecated > (new pgm::OpengmModelDeprecated());
+    if (direct_formulation()) {
+        LOG(logDEBUG) << "ConservationTracking::formulate: direct formulation for '" << solver_backend_ << "'";
+        formulation_ = boost::shared_ptr<lp::DiscreteFormulation>(new lp::DiscreteFormulation());
+    } else {
+        pgm_ = boost::shared_ptr < pgm::OpengmModelDeprecated > (new pgm::OpengmModelDeprecated());
+    }
 
     HypothesesGraph const *graph;
     if (with_tracklets_) {
@@ -42,6 +50,11 @@ void ConservationTracking::formulate(const HypothesesGraph& hypotheses) {
     } else {
         graph = &hypotheses;
     }
+    // the graph is not modified until conclude(): iterate a frozen copy of its topology
+    const boost::shared_ptr<const HypothesesGraphSnapshot> snapshot = freeze(*graph);
+    if (formulation_) {
+        snapshot_ = snapshot;
+    }
 
     LOG(logDEBUG) << "ConservationTracking::formulate: add_transition_nodes";
     add_transition_nodes(*graph);
@@ -52,59 +65,130 @@ void ConservationTracking::formulate(const HypothesesGraph& hypotheses) {
 
     LOG(logDEBUG) << "ConservationTracking::formulate: add_division_nodes";
     if (with_divisions_) {
-        add_division_nodes(*graph);
+        add_division_nodes(*snapshot);
     }
-    pgm::OpengmModelDeprecated::ogmGraphicalModel* model = pgm_->Model();
 
     LOG(logDEBUG) << "ConservationTracking::formulate: add_finite_factors";
-    add_finite_factors(*graph);
+    add_finite_factors(*snapshot);
     LOG(logDEBUG) << "ConservationTracking::formulate: finished add_finite_factors";
 
+#ifdef WITH_OPENGM_LP
+    if (!formulation_) {
+        pgm::OpengmModelDeprecated::ogmGraphicalModel* model = pgm_->Model();
 #ifdef WITH_GUROBI
-    typedef opengm::LPGurobi<pgm::OpengmModelDeprecated::ogmGraphicalModel,
-            pgm::OpengmModelDeprecated::ogmAccumulator> cplex_optimizer;
+        typedef opengm::LPGurobi<pgm::OpengmModelDeprecated::ogmGraphicalModel,
+                pgm::OpengmModelDeprecated::ogmAccumulator> cplex_optimizer;
 #else
-    typedef opengm::LPCplex<pgm::OpengmModelDeprecated::ogmGraphicalModel,
-            pgm::OpengmModelDeprecated::ogmAccumulator> cplex_optimizer;
+        typedef opengm::LPCplex<pgm::OpengmModelDeprecated::ogmGraphicalModel,
+                pgm::OpengmModelDeprecated::ogmAccumulator> cplex_optimizer;
 #endif
-    cplex_optimizer::Parameter param;
-    param.verbose_ = true;
-    param.integerConstraint_ = true;
-    param.epGap_ = ep_gap_;
-    param.timeLimit_ = cplex_timeout_;
-    LOG(logDEBUG) << "ConservationTracking::formulate ep_gap = " << param.epGap_;
+        cplex_optimizer::Parameter param;
+        param.verbose_ = true;
+        param.integerConstraint_ = true;
+        param.epGap_ = ep_gap_;
+        param.timeLimit_ = cplex_timeout_;
+        param.numberOfThreads_ = solver_settings_.threads;
+        if (solver_settings_.memory_limit > 0.) {
+            param.workMem_ = solver_settings_.memory_limit;
+            param.treeMemoryLimit_ = solver_settings_.memory_limit;
+        }
+        LOG(logDEBUG) << "ConservationTracking::formulate ep_gap = " << param.epGap_;
 
-    optimizer_ = new cplex_optimizer(*model, param);
+        optimizer_ = new cplex_optimizer(*model, param);
+    }
+#endif
 
     LOG(logDEBUG) << "ConservationTracking::formulate: add_constraints";
     if (with_constraints_) {
-        add_constraints(*graph);
+        add_constraints(*snapshot);
     }
 
     LOG(logINFO) << "number_of_transition_nodes_ = " << number_of_transition_nodes_;
     LOG(logINFO) << "number_of_appearance_nodes_ = " << number_of_appearance_nodes_;
     LOG(logINFO) << "number_of_disappearance_nodes_ = " << number_of_disappearance_nodes_;
     LOG(logINFO) << "number_of_division_nodes_ = " << number_of_division_nodes_;
-
+    if (formulation_) {
+        LOG(logINFO) << "direct formulation: " << formulation_->program().column_count() << " columns, "
+                     << formulation_->program().row_count() << " rows, "
+                     << formulation_->program().nonzero_count() << " nonzeros";
+    }
 }
 
 void ConservationTracking::infer() {
+    if (formulation_) {
+        if (!with_constraints_) {
+            throw std::runtime_error("GraphicalModel::infer(): inference with soft constraints is not implemented yet");
+        }
+        lp::SolverParameters param(solver_settings_);
+        param.verbose = true;
+        param.ep_gap = ep_gap_;
+        param.time_limit = cplex_timeout_;
+        param.on_incumbent = incumbent_callback_;
+        param.stopping_rules = stopping_rules_;
+        boost::shared_ptr<lp::Solver> solver = lp::create_solver(solver_backend_);
+        if (with_relaxation_) {
+            param.relaxation = true;
+            const lp::Solution relaxed = solver->solve(formulation_->program(), param);
+            if (relaxed.status != lp::optimal) {
+                throw std::runtime_error("GraphicalModel::infer(): optimizer terminated abnormally");
+            }
+            if (round_relaxation(relaxed)) {
+                LOG(logINFO) << "ConservationTracking::infer: rounded LP relaxation: objective = "
+                             << lp_solution_.objective << ", bound = " << lp_solution_.bound
+                             << ", gap = " << lp_solution_.gap();
+                return;
+            }
+            LOG(logWARNING) << "ConservationTracking::infer: rounded LP relaxation is infeasible, "
+                            << "solving the integer program";
+            param.relaxation = false;
+        }
+        lp_solution_ = solver->solve(formulation_->program(), param);
+        if (!lp_solution_.has_values()) {
+            throw std::runtime_error("GraphicalModel::infer(): optimizer terminated abnormally");
+        }
+        if (lp_solution_.status != lp::optimal) {
+            // time limit or stopping rule: conclude() uses the best incumbent
+            LOG(logWARNING) << "ConservationTracking::infer: search stopped early: objective = "
+                            << lp_solution_.objective << ", bound = " << lp_solution_.bound
+                            << ", gap = " << lp_solution_.gap();
+        }
+        return;
+    }
+#ifdef WITH_OPENGM_LP
 	if (!with_constraints_) {
 		opengm::hdf5::save(optimizer_->graphicalModel(), "./conservationTracking.h5", "conservationTracking");
 		throw std::runtime_error("GraphicalModel::infer(): inference with soft constraints is not implemented yet. The conservation tracking factor graph has been saved to file");
 	}
     opengm::InferenceTermination status = optimizer_->infer();
     if (status != opengm::NORMAL) {
-        throw std::runtime_error("GraphicalModel::infer(): optimizer terminated abnormally");
+        // time limit: conclude() uses the best incumbent, if there is one
+        vector<pgm::OpengmModelDeprecated::ogmInference::LabelType> incumbent;
+        if (optimizer_->arg(incumbent) != opengm::NORMAL) {
+            throw std::runtime_error("GraphicalModel::infer(): optimizer terminated abnormally");
+        }
+        LOG(logWARNING) << "ConservationTracking::infer: search stopped early with status " << status
+                        << ", using the best incumbent: energy = "
+                        << optimizer_->graphicalModel().evaluate(incumbent.begin());
     }
+#endif
 }
 
 void ConservationTracking::conclude(HypothesesGraph& g) {
     // extract solution from optimizer
     vector<pgm::OpengmModelDeprecated::ogmInference::LabelType> solution;
-    opengm::InferenceTermination status = optimizer_->arg(solution);
-    if (status != opengm::NORMAL) {
-        throw runtime_error("GraphicalModel::infer(): solution extraction terminated abnormally");
+#ifdef WITH_OPENGM_LP
+    if (!formulation_) {
+        opengm::InferenceTermination status = optimizer_->arg(solution);
+        if (status != opengm::NORMAL) {
+            throw runtime_error("GraphicalModel::infer(): solution extraction terminated abnormally");
+        }
+    }
+#endif
+    if (formulation_) {
+        if (!lp_solution_.has_values()) {
+            throw runtime_error("GraphicalModel::infer(): solution extraction terminated abnormally");
+        }
+        formulation_->labeling(lp_solution_.values, solution);
     }
 
     // add 'active' properties to graph
@@ -129,126 +213,137 @@ void ConservationTracking::conclude(HypothesesGraph& g) {
 
     // write state after inference into 'active'-property maps
     // the node is also active if its appearance node is active
-    for (std::map<HypothesesGraph::Node, size_t>::const_iterator it = app_node_map_.begin();
-            it != app_node_map_.end(); ++it) {
+    for (size_t id = 0; id < app_node_map_.id_bound(); ++id) {
+        const size_t var = app_node_map_.variable(id);
+        if (var == VariableIdMap<HypothesesGraph::Node>::invalid) {
+            continue;
+        }
+        const HypothesesGraph::Node& node = app_node_map_.item(id);
         if (with_tracklets_) {
             // set state of tracklet nodes
-            std::vector<HypothesesGraph::Node> traxel_nodes = tracklet2traxel_node_map_[it->first];
+            std::vector<HypothesesGraph::Node> traxel_nodes = tracklet2traxel_node_map_[node];
             for (std::vector<HypothesesGraph::Node>::const_iterator tr_n_it = traxel_nodes.begin();
                     tr_n_it != traxel_nodes.end(); ++tr_n_it) {
                 HypothesesGraph::Node n = *tr_n_it;
-                active_nodes.set(n, solution[it->second]);
+                active_nodes.set(n, solution[var]);
             }
             // set state of tracklet internal arcs
-            std::vector<int> arc_ids = tracklet_arc_id_map[it->first];
+            std::vector<int> arc_ids = tracklet_arc_id_map[node];
             for (std::vector<int>::const_iterator arc_id_it = arc_ids.begin();
                     arc_id_it != arc_ids.end(); ++arc_id_it) {
                 HypothesesGraph::Arc a = g.arcFromId(*arc_id_it);
                 assert(active_arcs[a] == false);
-                if (solution[it->second] > 0) {
+                if (solution[var] > 0) {
                     active_arcs.set(a, true);
-                    assert(active_nodes[g.source(a)] == solution[it->second]
+                    assert(active_nodes[g.source(a)] == solution[var]
                             && "tracklet internal arcs must have the same flow as their connected nodes");
-                    assert(active_nodes[g.target(a)] == solution[it->second]
+                    assert(active_nodes[g.target(a)] == solution[var]
                             && "tracklet internal arcs must have the same flow as their connected nodes");
                 }
             }
         } else {
-            active_nodes.set(it->first, solution[it->second]);
+            active_nodes.set(node, solution[var]);
         }
     }
 
     // the node is also active if its disappearance node is active
-    for (std::map<HypothesesGraph::Node, size_t>::const_iterator it = dis_node_map_.begin();
-            it != dis_node_map_.end(); ++it) {
-
-        if (solution[it->second] > 0) {
+    for (size_t id = 0; id < dis_node_map_.id_bound(); ++id) {
+        const size_t var = dis_node_map_.variable(id);
+        if (var == VariableIdMap<HypothesesGraph::Node>::invalid) {
+            continue;
+        }
+        const HypothesesGraph::Node& node = dis_node_map_.item(id);
+        if (solution[var] > 0) {
             if (with_tracklets_) {
                 // set state of tracklet nodes
-                std::vector<HypothesesGraph::Node> traxel_nodes = tracklet2traxel_node_map_[it->first];
+                std::vector<HypothesesGraph::Node> traxel_nodes = tracklet2traxel_node_map_[node];
                 for (std::vector<HypothesesGraph::Node>::const_iterator tr_n_it =
                         traxel_nodes.begin(); tr_n_it != traxel_nodes.end(); ++tr_n_it) {
                     HypothesesGraph::Node n = *tr_n_it;
                     if (active_nodes[n] == 0) {
-                        active_nodes.set(n, solution[it->second]);
+                        active_nodes.set(n, solution[var]);
                     } else {
-                        assert(active_nodes[n] == solution[it->second]);
+                        assert(active_nodes[n] == solution[var]);
                     }
                 }
                 // set state of tracklet internal arcs
-                std::vector<int> arc_ids = tracklet_arc_id_map[it->first];
+                std::vector<int> arc_ids = tracklet_arc_id_map[node];
                 for (std::vector<int>::const_iterator arc_id_it = arc_ids.begin();
                         arc_id_it != arc_ids.end(); ++arc_id_it) {
                     HypothesesGraph::Arc a = g.arcFromId(*arc_id_it);
-                    if (solution[it->second] > 0) {
+                    if (solution[var] > 0) {
                         active_arcs.set(a, true);
-                        assert(active_nodes[g.source(a)] == solution[it->second]
+                        assert(active_nodes[g.source(a)] == solution[var]
                                 && "tracklet internal arcs must have the same flow as their connected nodes");
-                        assert(active_nodes[g.target(a)] == solution[it->second]
+                        assert(active_nodes[g.target(a)] == solution[var]
                                 && "tracklet internal arcs must have the same flow as their connected nodes");
                     }
                 }
             } else {
-                if (active_nodes[it->first] == 0) {
-                    active_nodes.set(it->first, solution[it->second]);
+                if (active_nodes[node] == 0) {
+                    active_nodes.set(node, solution[var]);
                 } else {
-                    assert(active_nodes[it->first] == solution[it->second]);
+                    assert(active_nodes[node] == solution[var]);
                 }
             }
         }
     }
 
-    for (std::map<HypothesesGraph::Arc, size_t>::const_iterator it = arc_map_.begin();
-            it != arc_map_.end(); ++it) {
-        if (solution[it->second] >= 1) {
+    for (size_t id = 0; id < arc_map_.id_bound(); ++id) {
+        const size_t var = arc_map_.variable(id);
+        if (var != VariableIdMap<HypothesesGraph::Arc>::invalid && solution[var] >= 1) {
             if (with_tracklets_) {
-                active_arcs.set(g.arcFromId((traxel_arc_id_map[it->first])), true);
+                active_arcs.set(g.arcFromId((traxel_arc_id_map[arc_map_.item(id)])), true);
             } else {
-                active_arcs.set(it->first, true);
+                active_arcs.set(arc_map_.item(id), true);
             }
         }
     }
     // initialize division node map
     if (with_divisions_) {
-        for (std::map<HypothesesGraph::Node, size_t>::const_iterator it = div_node_map_.begin();
-                it != div_node_map_.end(); ++it) {
-            division_nodes.set(it->first, false);
+        for (size_t id = 0; id < div_node_map_.id_bound(); ++id) {
+            if (div_node_map_.variable(id) != VariableIdMap<HypothesesGraph::Node>::invalid) {
+                division_nodes.set(div_node_map_.item(id), false);
+            }
         }
-        for (std::map<HypothesesGraph::Node, size_t>::const_iterator it = div_node_map_.begin();
-                it != div_node_map_.end(); ++it) {
-            if (solution[it->second] >= 1) {
+        for (size_t id = 0; id < div_node_map_.id_bound(); ++id) {
+            const size_t var = div_node_map_.variable(id);
+            if (var != VariableIdMap<HypothesesGraph::Node>::invalid && solution[var] >= 1) {
                 if (with_tracklets_) {
                     // set division property for the last node in the tracklet
-                    division_nodes.set(tracklet2traxel_node_map_[it->first].back(), true);
+                    division_nodes.set(tracklet2traxel_node_map_[div_node_map_.item(id)].back(), true);
                 } else {
-                    division_nodes.set(it->first, true);
+                    division_nodes.set(div_node_map_.item(id), true);
                 }
             }
         }
     }
 }
 
-const std::map<HypothesesGraph::Arc, size_t>& ConservationTracking::get_arc_map() const {
+const VariableIdMap<HypothesesGraph::Arc>& ConservationTracking::get_arc_map() const {
     return arc_map_;
 }
 
 void ConservationTracking::reset() {
+#ifdef WITH_OPENGM_LP
     if (optimizer_ != NULL) {
         delete optimizer_;
         optimizer_ = NULL;
     }
+#endif
     arc_map_.clear();
     div_node_map_.clear();
     app_node_map_.clear();
     dis_node_map_.clear();
+    formulation_.reset();
+    lp_solution_ = lp::Solution();
+    snapshot_.reset();
 }
 
 void ConservationTracking::add_appearance_nodes(const HypothesesGraph& g) {
     size_t count = 0;
     for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
-        pgm_->Model()->addVariable(max_number_objects_ + 1);
-        app_node_map_[n] = pgm_->Model()->numberOfVariables() - 1;
-        assert(pgm_->Model()->numberOfLabels(app_node_map_[n]) == max_number_objects_ + 1);
+        app_node_map_.set(n, add_variable(max_number_objects_ + 1));
         ++count;
     }
     number_of_appearance_nodes_ = count;
@@ -257,9 +352,7 @@ void ConservationTracking::add_appearance_nodes(const HypothesesGraph& g) {
 void ConservationTracking::add_disappearance_nodes(const HypothesesGraph& g) {
     size_t count = 0;
     for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
-        pgm_->Model()->addVariable(max_number_objects_ + 1);
-        dis_node_map_[n] = pgm_->Model()->numberOfVariables() - 1;
-        assert(pgm_->Model()->numberOfLabels(dis_node_map_[n]) == max_number_objects_ + 1);
+        dis_node_map_.set(n, add_variable(max_number_objects_ + 1));
         ++count;
     }
     number_of_disappearance_nodes_ = count;
@@ -268,25 +361,18 @@ void ConservationTracking::add_disappearance_nodes(const HypothesesGraph& g) {
 void ConservationTracking::add_transition_nodes(const HypothesesGraph& g) {
     size_t count = 0;
     for (HypothesesGraph::ArcIt a(g); a != lemon::INVALID; ++a) {
-        pgm_->Model()->addVariable(max_number_objects_ + 1);
-        arc_map_[a] = pgm_->Model()->numberOfVariables() - 1;
-        assert(pgm_->Model()->numberOfLabels(arc_map_[a]) == max_number_objects_ + 1);
+        arc_map_.set(a, add_variable(max_number_objects_ + 1));
         ++count;
     }
     number_of_transition_nodes_ = count;
 }
 
-void ConservationTracking::add_division_nodes(const HypothesesGraph& g) {
+void ConservationTracking::add_division_nodes(const HypothesesGraphSnapshot& s) {
     size_t count = 0;
-    for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
-        size_t number_of_outarcs = 0;
-        for (HypothesesGraph::OutArcIt a(g, n); a != lemon::INVALID; ++a) {
-            ++number_of_outarcs;
-        }
-        if (number_of_outarcs > 1) {
-            pgm_->Model()->addVariable(2);
-            div_node_map_[n] = pgm_->Model()->numberOfVariables() - 1;
-            assert(pgm_->Model()->numberOfLabels(div_node_map_[n]) == 2);
+    for (HypothesesGraphSnapshot::index_type i = 0; i < s.node_count(); ++i) {
+        if (s.out_degree(i) > 1) {
+            const HypothesesGraph::Node n = s.node(i);
+            div_node_map_.set(n, add_variable(2));
             ++count;
         }
     }
@@ -301,174 +387,375 @@ double get_transition_prob(double distance, size_t state, double alpha) {
     }
     return prob;
 }
+
+// the named feature of a traxel with at least size entries
+const feature_array& get_feature(const Traxel& tr, const string& name, size_t size) {
+    FeatureMap::const_iterator it = tr.features.find(name);
+    if (it == tr.features.end() || it->second.size() < size) {
+        throw runtime_error("ConservationTracking: " + name + " feature not in traxel");
+    }
+    return it->second;
+}
+
+// exceptions must not leave a parallel region: the first one is kept and
+// rethrown after the loop
+class ParallelError {
+ public:
+    ParallelError() : failed_(false) {}
+    void capture(const std::exception& e) {
+#       pragma omp critical(constracking_parallel_error)
+        {
+            if (!failed_) {
+                failed_ = true;
+                what_ = e.what();
+            }
+        }
+    }
+    void rethrow() const {
+        if (failed_) {
+            throw runtime_error(what_);
+        }
+    }
+ private:
+    bool failed_;
+    string what_;
+};
+
+// costs[i] = cost(*traxels[i]) for all non-null traxels, and 0 otherwise;
+// SpatialBorderAwareWeight is evaluated in a single batch, other functors
+// are called serially
+void evaluate_costs(const boost::function<double (const Traxel&)>& cost,
+                    const vector<const Traxel*>& traxels,
+                    vector<double>& costs) {
+    costs.assign(traxels.size(), 0.);
+    const SpatialBorderAwareWeight* batch = cost.target<SpatialBorderAwareWeight>();
+    if (batch == NULL) {
+        for (size_t i = 0; i < traxels.size(); ++i) {
+            if (traxels[i] != NULL) {
+                costs[i] = cost(*traxels[i]);
+            }
+        }
+        return;
+    }
+
+    vector<size_t> index;
+    vector<double> t, x, y, z;
+    for (size_t i = 0; i < traxels.size(); ++i) {
+        if (traxels[i] != NULL) {
+            index.push_back(i);
+            t.push_back(traxels[i]->Timestep);
+            x.push_back(traxels[i]->X());
+            y.push_back(traxels[i]->Y());
+            z.push_back(traxels[i]->Z());
+        }
+    }
+    if (index.empty()) {
+        return;
+    }
+    vector<double> energies(index.size());
+    (*batch)(&t[0], &x[0], &y[0], &z[0], index.size(), &energies[0]);
+    for (size_t k = 0; k < index.size(); ++k) {
+        costs[index[k]] = energies[k];
+    }
+}
 }
 
-void ConservationTracking::add_finite_factors(const HypothesesGraph& g) {
+void ConservationTracking::add_finite_factors(const HypothesesGraphSnapshot& s) {
     LOG(logDEBUG) << "ConservationTracking::add_finite_factors: entered";
-    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+    const HypothesesGraph& g = s.graph();
+    const NodeTraxels traxel_map(g);
     property_map<node_tracklet, HypothesesGraph::base_graph>::type& tracklet_map =
             g.get(node_tracklet());
     property_map<tracklet_intern_dist, HypothesesGraph::base_graph>::type& tracklet_intern_dist_map =
             g.get(tracklet_intern_dist());
+    property_map<arc_distance, HypothesesGraph::base_graph>::type& arc_distances = g.get(
+            arc_distance());
 
-    ////
-    //// add detection factors
-    ////
-    LOG(logDEBUG) << "ConservationTracking::add_finite_factors: add detection factors";
-    for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
-        size_t num_vars = 0;
-        vector<size_t> vi;
-        vector<double> cost;
-
-        int node_begin_time = -1;
-        int node_end_time = -1;
-        if (with_tracklets_) {
-            node_begin_time = tracklet_map[n].front().Timestep;
-            node_end_time = tracklet_map[n].back().Timestep;
-        } else {
-            node_begin_time = traxel_map[n].Timestep;
-            node_end_time = traxel_map[n].Timestep;
-        }
-
-        if (app_node_map_.count(n) > 0) {
-            vi.push_back(app_node_map_[n]);
-            if (node_begin_time <= g.earliest_timestep()) {  // "<" holds if there are only tracklets in the first frame
-                // pay no appearance costs in the first timestep
-                cost.push_back(0.);
-            } else {
-                if (with_tracklets_) {
-                    cost.push_back(appearance_cost_(tracklet_map[n].front()));
-                    LOG(logDEBUG4) << "App-costs 1: " << appearance_cost_(tracklet_map[n].front()) << ", " << tracklet_map[n].front();
-                } else {
-                    cost.push_back(appearance_cost_(traxel_map[n]));
-                    LOG(logDEBUG4) << "App-costs 2: " << appearance_cost_(traxel_map[n]) << ", " << traxel_map[n];
+    // The formulation has two phases: all energies and factor tables are
+    // computed into preallocated buffers, then the tables are registered one
+    // after the other in node and arc order, so that the model does not
+    // depend on the number of threads.
+    //
+    // Energies are stored state major (energy[state * count + index]).
+    // The stock energy functors are recognized and evaluated in batches; any
+    // other functor is supplied by the caller and is called serially, once
+    // per state and node or arc. Only feature gathering and the factor tables
+    // are computed in parallel.
+    const size_t num_states = max_number_objects_ + 1;
+    const size_t num_nodes = s.node_count();
+    const size_t num_arcs = s.arc_count();
+    ParallelError error;
+
+    LOG(logDEBUG) << "ConservationTracking::add_finite_factors: evaluate energies";
+    vector<double> detection_energy(num_states * num_nodes, 0.);
+    const NegLnDetection* batch_detection = detection_.target<NegLnDetection>();
+    if (batch_detection != NULL && !with_tracklets_) {
+        vector<double> det_probs(detection_energy.size());
+#       pragma omp parallel for
+        for (int i = 0; i < static_cast<int>(num_nodes); ++i) {
+            try {
+                const feature_array& det_prob = get_feature(traxel_map[s.node(i)], "detProb", num_states);
+                for (size_t state = 0; state < num_states; ++state) {
+                    det_probs[state * num_nodes + i] = det_prob[state];
                 }
+            } catch (const std::exception& e) {
+                error.capture(e);
             }
-            ++num_vars;
         }
-        if (dis_node_map_.count(n) > 0) {
-            vi.push_back(dis_node_map_[n]);
-            double c = 0;
-            if (node_end_time < g.latest_timestep()) { // "<" holds if there are only tracklets in the last frame
+        error.rethrow();
+        if (!det_probs.empty()) {
+            (*batch_detection)(&det_probs[0], det_probs.size(), &detection_energy[0]);
+        }
+    } else {
+        for (HypothesesGraphSnapshot::index_type i = 0; i < num_nodes; ++i) {
+            const HypothesesGraph::Node n = s.node(i);
+            for (size_t state = 0; state < num_states; ++state) {
+                double energy = 0;
                 if (with_tracklets_) {
-                    c += disappearance_cost_(tracklet_map[n].back());
-                    LOG(logDEBUG4) << "Disapp-costs 1: " << disappearance_cost_(tracklet_map[n].back()) << ", " << tracklet_map[n].back();
+                    // add all detection factors of the internal nodes
+                    for (std::vector<Traxel>::const_iterator trax_it = tracklet_map[n].begin();
+                            trax_it != tracklet_map[n].end(); ++trax_it) {
+                        energy += detection_(*trax_it, state);
+                    }
+                    // add all transition factors of the internal arcs
+                    for (std::vector<double>::const_iterator intern_dist_it =
+                            tracklet_intern_dist_map[n].begin();
+                            intern_dist_it != tracklet_intern_dist_map[n].end(); ++intern_dist_it) {
+                        energy += transition_(
+                                get_transition_prob(*intern_dist_it, state, transition_parameter_));
+                    }
                 } else {
-                    c += disappearance_cost_(traxel_map[n]);
-                    LOG(logDEBUG4) << "Disapp-costs 2: " << disappearance_cost_(traxel_map[n]) << ", " << traxel_map[n];
+                    energy = detection_(traxel_map[n], state);
                 }
+                detection_energy[state * num_nodes + i] = energy;
             }
-            cost.push_back(c);
-            ++num_vars;
         }
+    }
 
-        // convert vector to array
-        vector<size_t> coords(num_vars, 0); // number of variables
-        // ITER first_ogm_idx, ITER last_ogm_idx, VALUE init, size_t states_per_var
-        pgm::OpengmExplicitFactor<double> table(vi.begin(), vi.end(), forbidden_cost_, (max_number_objects_ + 1));
-        for (size_t state = 0; state <= max_number_objects_; ++state) {
-            double energy = 0;
-            if (with_tracklets_) {
-                // add all detection factors of the internal nodes
-                for (std::vector<Traxel>::const_iterator trax_it = tracklet_map[n].begin();
-                        trax_it != tracklet_map[n].end(); ++trax_it) {
-                    energy += detection_(*trax_it, state);
+    // no appearance costs in the first and no disappearance costs in the last timestep;
+    // "<" holds if there are only tracklets in the first or last frame
+    vector<const Traxel*> appearing(num_nodes, NULL), disappearing(num_nodes, NULL);
+    for (HypothesesGraphSnapshot::index_type i = 0; i < num_nodes; ++i) {
+        const HypothesesGraph::Node n = s.node(i);
+        const Traxel& first = with_tracklets_ ? tracklet_map[n].front() : traxel_map[n];
+        const Traxel& last = with_tracklets_ ? tracklet_map[n].back() : traxel_map[n];
+        if (app_node_map_.count(n) > 0 && first.Timestep > g.earliest_timestep()) {
+            appearing[i] = &first;
+        }
+        if (dis_node_map_.count(n) > 0 && last.Timestep < g.latest_timestep()) {
+            disappearing[i] = &last;
+        }
+    }
+    vector<double> appearance_energy, disappearance_energy;
+    evaluate_costs(appearance_cost_, appearing, appearance_energy);
+    evaluate_costs(disappearance_cost_, disappearing, disappearance_energy);
+
+    vector<double> transition_energy(num_states * num_arcs, 0.);
+    const NegLnTransition* batch_transition = transition_.target<NegLnTransition>();
+    if (batch_transition != NULL) {
+        vector<double> distances(num_arcs);
+        for (HypothesesGraphSnapshot::index_type i = 0; i < num_arcs; ++i) {
+            distances[i] = arc_distances[s.arc(i)];
+        }
+        if (num_arcs > 0) {
+            for (size_t state = 0; state < num_states; ++state) {
+                (*batch_transition)(&distances[0], num_arcs, transition_parameter_, state,
+                                    &transition_energy[state * num_arcs]);
+            }
+        }
+    } else {
+        for (HypothesesGraphSnapshot::index_type i = 0; i < num_arcs; ++i) {
+            for (size_t state = 0; state < num_states; ++state) {
+                transition_energy[state * num_arcs + i] =
+                        transition_(get_transition_prob(arc_distances[s.arc(i)], state, transition_parameter_));
+            }
+        }
+    }
+
+    vector<double> division_energy(2 * num_nodes, 0.);
+    if (with_divisions_) {
+        vector<HypothesesGraphSnapshot::index_type> dividing;
+        for (HypothesesGraphSnapshot::index_type i = 0; i < num_nodes; ++i) {
+            if (div_node_map_.count(s.node(i)) > 0) {
+                dividing.push_back(i);
+            }
+        }
+        const NegLnDivision* batch_division = division_.target<NegLnDivision>();
+        if (batch_division != NULL && !dividing.empty()) {
+            vector<double> div_probs(dividing.size()), energies(dividing.size());
+#           pragma omp parallel for
+            for (int k = 0; k < static_cast<int>(dividing.size()); ++k) {
+                try {
+                    const HypothesesGraph::Node n = s.node(dividing[k]);
+                    const Traxel& tr = with_tracklets_ ? tracklet_map[n].back() : traxel_map[n];
+                    div_probs[k] = get_feature(tr, "divProb", 1)[0];
+                } catch (const std::exception& e) {
+                    error.capture(e);
                 }
-                // add all transition factors of the internal arcs
-                for (std::vector<double>::const_iterator intern_dist_it =
-                        tracklet_intern_dist_map[n].begin();
-                        intern_dist_it != tracklet_intern_dist_map[n].end(); ++intern_dist_it) {
-                    energy += transition_(
-                            get_transition_prob(*intern_dist_it, state, transition_parameter_));
+            }
+            error.rethrow();
+            for (size_t state = 0; state <= 1; ++state) {
+                (*batch_division)(&div_probs[0], div_probs.size(), state, &energies[0]);
+                for (size_t k = 0; k < dividing.size(); ++k) {
+                    division_energy[state * num_nodes + dividing[k]] = energies[k];
+                }
+            }
+        } else {
+            for (size_t k = 0; k < dividing.size(); ++k) {
+                const HypothesesGraph::Node n = s.node(dividing[k]);
+                const Traxel& tr = with_tracklets_ ? tracklet_map[n].back() : traxel_map[n];
+                for (size_t state = 0; state <= 1; ++state) {
+                    division_energy[state * num_nodes + dividing[k]] = division_(tr, state);
                 }
-            } else {
-                energy = detection_(traxel_map[n], state);
-            }
-            LOG(logDEBUG2) << "ConservationTracking::add_finite_factors: detection[" << state
-                    << "] = " << energy;
-            for (size_t var_idx = 0; var_idx < num_vars; ++var_idx) {
-                coords[var_idx] = state;
-                // if only one of the variables is > 0, then it is an appearance in this time frame
-                // or a disappearance in the next timeframe. Hence, add the cost of appearance/disappearance
-                // to the detection cost
-                table.set_value(coords, energy + state * cost[var_idx]);
-                coords[var_idx] = 0;
-                LOG(logDEBUG4) << "ConservationTracking::add_finite_factors: var_idx "
-                        << var_idx << " = " << energy;
-            }
-            // also this energy if both variables have the same state
-            if (num_vars == 2) {
-                coords[0] = state;
-                coords[1] = state;
-                // only pay detection energy if both variables are on
-                table.set_value(coords, energy);
-                coords[0] = 0;
-                coords[1] = 0;
-
-                LOG(logDEBUG4) << "ConservationTracking::add_finite_factors: var_idxs 0 and var_idx 1 = "
-                        << energy;
             }
         }
+    }
 
-        LOG(logDEBUG3) << "ConservationTracking::add_finite_factors: adding table to pgm";
-        table.add_to(*(pgm_->Model()));
+    ////
+    //// add detection factors
+    ////
+    LOG(logDEBUG) << "ConservationTracking::add_finite_factors: add detection factors";
+    vector<boost::shared_ptr<pgm::OpengmSparseFactor<double> > > detection_tables(num_nodes);
+#   pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(num_nodes); ++i) {
+        try {
+            const HypothesesGraph::Node n = s.node(i);
+            size_t num_vars = 0;
+            vector<size_t> vi;
+            vector<double> cost;
+
+            if (app_node_map_.count(n) > 0) {
+                vi.push_back(app_node_map_[n]);
+                cost.push_back(appearance_energy[i]);
+                LOG(logDEBUG4) << "App-costs: " << appearance_energy[i];
+                ++num_vars;
+            }
+            if (dis_node_map_.count(n) > 0) {
+                vi.push_back(dis_node_map_[n]);
+                cost.push_back(disappearance_energy[i]);
+                LOG(logDEBUG4) << "Disapp-costs: " << disappearance_energy[i];
+                ++num_vars;
+            }
+
+            // convert vector to array
+            vector<size_t> coords(num_vars, 0); // number of variables
+            // only the diagonal and the axes are allowed; all other labelings keep the forbidden cost
+            // ITER first_ogm_idx, ITER last_ogm_idx, VALUE default, size_t states_per_var
+            detection_tables[i].reset(
+                    new pgm::OpengmSparseFactor<double>(vi.begin(), vi.end(), forbidden_cost_, num_states));
+            pgm::OpengmSparseFactor<double>& table = *detection_tables[i];
+            for (size_t state = 0; state < num_states; ++state) {
+                double energy = detection_energy[state * num_nodes + i];
+                LOG(logDEBUG2) << "ConservationTracking::add_finite_factors: detection[" << state
+                        << "] = " << energy;
+                for (size_t var_idx = 0; var_idx < num_vars; ++var_idx) {
+                    coords[var_idx] = state;
+                    // if only one of the variables is > 0, then it is an appearance in this time frame
+                    // or a disappearance in the next timeframe. Hence, add the cost of appearance/disappearance
+                    // to the detection cost
+                    table.set_value(coords, energy + state * cost[var_idx]);
+                    coords[var_idx] = 0;
+                    LOG(logDEBUG4) << "ConservationTracking::add_finite_factors: var_idx "
+                            << var_idx << " = " << energy;
+                }
+                // also this energy if both variables have the same state
+                if (num_vars == 2) {
+                    coords[0] = state;
+                    coords[1] = state;
+                    // only pay detection energy if both variables are on
+                    table.set_value(coords, energy);
+                    coords[0] = 0;
+                    coords[1] = 0;
+
+                    LOG(logDEBUG4) << "ConservationTracking::add_finite_factors: var_idxs 0 and var_idx 1 = "
+                            << energy;
+                }
+            }
+        } catch (const std::exception& e) {
+            error.capture(e);
+        }
     }
+    error.rethrow();
+    LOG(logDEBUG3) << "ConservationTracking::add_finite_factors: adding detection tables to pgm";
+    for (size_t i = 0; i < num_nodes; ++i) {
+        add_factor(*detection_tables[i]);
+    }
+    detection_tables.clear();
 
     ////
     //// add transition factors
     ////
     LOG(logDEBUG) << "ConservationTracking::add_finite_factors: add transition factors";
-    property_map<arc_distance, HypothesesGraph::base_graph>::type& arc_distances = g.get(
-            arc_distance());
-    for (HypothesesGraph::ArcIt a(g); a != lemon::INVALID; ++a) {
-        size_t vi[] = { arc_map_[a] };
-        vector<size_t> coords(1, 0); // number of variables
-        // ITER first_ogm_idx, ITER last_ogm_idx, VALUE init, size_t states_per_var
-        pgm::OpengmExplicitFactor<double> table(vi, vi + 1, forbidden_cost_, (max_number_objects_ + 1));
-        for (size_t state = 0; state <= max_number_objects_; ++state) {
-            double energy = transition_(get_transition_prob(arc_distances[a], state, transition_parameter_));
-            LOG(logDEBUG2) << "ConservationTracking::add_finite_factors: transition[" << state
-                    << "] = " << energy;
-            coords[0] = state;
-            table.set_value(coords, energy);
-            coords[0] = 0;
+    vector<boost::shared_ptr<pgm::OpengmExplicitFactor<double> > > transition_tables(num_arcs);
+#   pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(num_arcs); ++i) {
+        try {
+            const HypothesesGraph::Arc a = s.arc(i);
+            size_t vi[] = { arc_map_[a] };
+            vector<size_t> coords(1, 0); // number of variables
+            // ITER first_ogm_idx, ITER last_ogm_idx, VALUE init, size_t states_per_var
+            transition_tables[i].reset(
+                    new pgm::OpengmExplicitFactor<double>(vi, vi + 1, forbidden_cost_, num_states));
+            for (size_t state = 0; state < num_states; ++state) {
+                double energy = transition_energy[state * num_arcs + i];
+                LOG(logDEBUG2) << "ConservationTracking::add_finite_factors: transition[" << state
+                        << "] = " << energy;
+                coords[0] = state;
+                transition_tables[i]->set_value(coords, energy);
+                coords[0] = 0;
+            }
+        } catch (const std::exception& e) {
+            error.capture(e);
         }
-        table.add_to(*(pgm_->Model()));
     }
+    error.rethrow();
+    for (size_t i = 0; i < num_arcs; ++i) {
+        add_factor(*transition_tables[i]);
+    }
+    transition_tables.clear();
 
     ////
     //// add division factors
     ////
     if (with_divisions_) {
         LOG(logDEBUG) << "ConservationTracking::add_finite_factors: add division factors";
-        for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
-            if (div_node_map_.count(n) == 0) {
-                continue;
-            }
-            size_t vi[] = { div_node_map_[n] };
-            vector<size_t> coords(1, 0); // number of variables
-            // ITER first_ogm_idx, ITER last_ogm_idx, VALUE init, size_t states_per_var
-            pgm::OpengmExplicitFactor<double> table(vi, vi + 1, forbidden_cost_, 2);
-            for (size_t state = 0; state <= 1; ++state) {
-                double energy = 0;
-                if (with_tracklets_) {
-                    energy = division_(tracklet_map[n].back(), state);
-                } else {
-                    energy = division_(traxel_map[n], state);
+        // NULL for nodes without division variable
+        vector<boost::shared_ptr<pgm::OpengmExplicitFactor<double> > > division_tables(num_nodes);
+#       pragma omp parallel for
+        for (int i = 0; i < static_cast<int>(num_nodes); ++i) {
+            try {
+                const HypothesesGraph::Node n = s.node(i);
+                if (div_node_map_.count(n) == 0) {
+                    continue;
                 }
-                LOG(logDEBUG2) << "ConservationTracking::add_finite_factors: division[" << state
-                        << "] = " << energy;
-                coords[0] = state;
-                table.set_value(coords, energy);
-                coords[0] = 0;
+                size_t vi[] = { div_node_map_[n] };
+                vector<size_t> coords(1, 0); // number of variables
+                // ITER first_ogm_idx, ITER last_ogm_idx, VALUE init, size_t states_per_var
+                division_tables[i].reset(new pgm::OpengmExplicitFactor<double>(vi, vi + 1, forbidden_cost_, 2));
+                for (size_t state = 0; state <= 1; ++state) {
+                    double energy = division_energy[state * num_nodes + i];
+                    LOG(logDEBUG2) << "ConservationTracking::add_finite_factors: division[" << state
+                            << "] = " << energy;
+                    coords[0] = state;
+                    division_tables[i]->set_value(coords, energy);
+                    coords[0] = 0;
+                }
+            } catch (const std::exception& e) {
+                error.capture(e);
+            }
+        }
+        error.rethrow();
+        for (size_t i = 0; i < num_nodes; ++i) {
+            if (division_tables[i]) {
+                add_factor(*division_tables[i]);
             }
-            table.add_to(*(pgm_->Model()));
         }
     }
 
 
     if (!with_constraints_) {
-    	for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
+    	for (HypothesesGraphSnapshot::index_type i = 0; i < s.node_count(); ++i) {
+    		const HypothesesGraph::Node n = s.node(i);
 			LOG(logDEBUG) << "ConservationTracking::add_finite_factors: add soft-constraints for outgoing";
 
 			// collect and count outgoing arcs
@@ -486,9 +773,9 @@ void ConservationTracking::add_finite_factors(const HypothesesGraph& g) {
 
 			  int count = 0;
 			  //int trans_idx = vi.size();
-			  for(HypothesesGraph::OutArcIt a(g, n); a != lemon::INVALID; ++a) {
-				  arcs.push_back(a);
-				  vi.push_back(arc_map_[a]);
+			  for(HypothesesGraphSnapshot::index_iterator a = s.out_begin(i); a != s.out_end(i); ++a) {
+				  arcs.push_back(s.arc(*a));
+				  vi.push_back(arc_map_[s.arc(*a)]);
 				  states_vars.push_back(max_number_objects_+1);
 				  ++count;
 			  }
@@ -510,7 +797,7 @@ void ConservationTracking::add_finite_factors(const HypothesesGraph& g) {
                     // TODO
               }
               
-				  table.add_to(*(pgm_->Model()));
+				  add_factor(table);
 			  }
 
 
@@ -524,9 +811,9 @@ void ConservationTracking::add_finite_factors(const HypothesesGraph& g) {
 			  vi.push_back(dis_node_map_[n]); // first detection node, remaining will be transition nodes
 
 			  count = 0;
-			  for(HypothesesGraph::InArcIt a(g, n); a != lemon::INVALID; ++a) {
-				  arcs.push_back(a);
-				  vi.push_back(arc_map_[a]);
+			  for(HypothesesGraphSnapshot::index_iterator a = s.in_begin(i); a != s.in_end(i); ++a) {
+				  arcs.push_back(s.arc(*a));
+				  vi.push_back(arc_map_[s.arc(*a)]);
 				  states_vars.push_back(max_number_objects_+1);
 				  ++count;
 			  }
@@ -544,18 +831,269 @@ void ConservationTracking::add_finite_factors(const HypothesesGraph& g) {
 				  //// TODO: set the forbidden configurations to infinity or the allowed to zero
 				  /////
 
-				  table.add_to(*(pgm_->Model()));
+				  add_factor(table);
 			  }
     	}
 
     }
 }
 
+namespace {
+typedef HypothesesGraphSnapshot::index_type index_type;
+typedef HypothesesGraphSnapshot::index_iterator index_iterator;
+
+// label of a discrete variable in expectation under the relaxed indicators
+double expected_state(const lp::DiscreteFormulation& f, size_t var, const vector<double>& x) {
+    double value = 0.;
+    for (size_t state = 1; state < f.number_of_labels(var); ++state) {
+        value += state * x[f.column(var, state)];
+    }
+    return value;
+}
+
+size_t inflow(const HypothesesGraphSnapshot& s, const vector<size_t>& flow, index_type i) {
+    size_t sum = 0;
+    for (index_iterator a = s.in_begin(i); a != s.in_end(i); ++a) {
+        sum += flow[*a];
+    }
+    return sum;
+}
+
+size_t outflow(const HypothesesGraphSnapshot& s, const vector<size_t>& flow, index_type i) {
+    size_t sum = 0;
+    for (index_iterator a = s.out_begin(i); a != s.out_end(i); ++a) {
+        sum += flow[*a];
+    }
+    return sum;
+}
+
+// one object in, two out along distinct arcs
+bool is_division(const HypothesesGraphSnapshot& s, const vector<size_t>& flow, index_type i) {
+    if (inflow(s, flow, i) > 1 || outflow(s, flow, i) != 2) {
+        return false;
+    }
+    for (index_iterator a = s.out_begin(i); a != s.out_end(i); ++a) {
+        if (flow[*a] > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+bool ConservationTracking::round_relaxation(const lp::Solution& relaxed) {
+    const HypothesesGraphSnapshot& s = *snapshot_;
+    const size_t m = max_number_objects_;
+
+    vector<bool> divides(s.node_count(), false);
+    if (with_divisions_) {
+        for (index_type i = 0; i < s.node_count(); ++i) {
+            divides[i] = div_node_map_.count(s.node(i)) > 0;
+        }
+    }
+
+    // round the arc flows to the nearest integer
+    vector<double> lp_flow(s.arc_count());
+    vector<size_t> flow(s.arc_count());
+    for (index_type k = 0; k < s.arc_count(); ++k) {
+        lp_flow[k] = expected_state(*formulation_, arc_map_[s.arc(k)], relaxed.values);
+        flow[k] = std::min(m, static_cast<size_t>(lp_flow[k] + 0.5));
+    }
+
+    // repair: lower flows until every node conserves them (or divides); only ever decreasing
+    // the flow guarantees termination
+    vector<index_type> worklist;
+    vector<bool> queued(s.node_count(), true);
+    for (index_type i = s.node_count(); i > 0; --i) {
+        worklist.push_back(i - 1);
+    }
+    size_t repairs = 0;
+    while (!worklist.empty()) {
+        const index_type i = worklist.back();
+        worklist.pop_back();
+        queued[i] = false;
+        while (true) {
+            const size_t in = inflow(s, flow, i);
+            const size_t out = outflow(s, flow, i);
+            if (divides[i] && is_division(s, flow, i)) {
+                break;
+            }
+            if (in <= m && out <= m && (in == 0 || out == 0 || in == out)) {
+                break;
+            }
+            const bool lower_out = out > m || (in <= m && out > in);
+            index_iterator first = lower_out ? s.out_begin(i) : s.in_begin(i);
+            index_iterator last = lower_out ? s.out_end(i) : s.in_end(i);
+            // take the unit away from the arc the relaxation trusts least
+            index_type weakest = HypothesesGraphSnapshot::invalid_index;
+            for (; first != last; ++first) {
+                if (flow[*first] > 0 && (weakest == HypothesesGraphSnapshot::invalid_index
+                                         || lp_flow[*first] < lp_flow[weakest])) {
+                    weakest = *first;
+                }
+            }
+            assert(weakest != HypothesesGraphSnapshot::invalid_index);
+            --flow[weakest];
+            ++repairs;
+            const index_type other = lower_out ? s.target(weakest) : s.source(weakest);
+            if (!queued[other]) {
+                queued[other] = true;
+                worklist.push_back(other);
+            }
+        }
+    }
+    LOG(logDEBUG) << "ConservationTracking::round_relaxation: " << repairs << " units of flow removed";
+
+    // derive the node labels from the flows
+    vector<size_t> labels(formulation_->number_of_variables(), 0);
+    for (index_type k = 0; k < s.arc_count(); ++k) {
+        labels[arc_map_[s.arc(k)]] = flow[k];
+    }
+    for (index_type i = 0; i < s.node_count(); ++i) {
+        const HypothesesGraph::Node n = s.node(i);
+        size_t app = outflow(s, flow, i);
+        size_t dis = inflow(s, flow, i);
+        size_t division = 0;
+        if (divides[i] && is_division(s, flow, i)) {
+            // without incoming objects, two outgoing ones may also be an appearing merger
+            if (dis == 1 || app > m || expected_state(*formulation_, div_node_map_[n], relaxed.values) >= 0.5) {
+                division = 1;
+                app = 1;
+            }
+            labels[div_node_map_[n]] = division;
+        }
+        // a side without arcs is unconstrained: match the other side to avoid paying
+        // for an appearance or disappearance
+        if (s.in_degree(i) == 0 && s.out_degree(i) == 0) {
+            app = std::min(m, static_cast<size_t>(
+                expected_state(*formulation_, app_node_map_[n], relaxed.values) + 0.5));
+            dis = app;
+        } else if (s.in_degree(i) == 0) {
+            dis = app;
+        } else if (s.out_degree(i) == 0) {
+            app = dis;
+        }
+        labels[app_node_map_[n]] = app;
+        labels[dis_node_map_[n]] = dis;
+    }
+
+    vector<double> x;
+    formulation_->columns(labels, x);
+    if (!formulation_->program().is_feasible(x)) {
+        return false;
+    }
+    lp_solution_ = lp::Solution();
+    lp_solution_.values.swap(x);
+    lp_solution_.objective = formulation_->program().evaluate(lp_solution_.values);
+    lp_solution_.bound = relaxed.objective;
+    lp_solution_.status = lp_solution_.gap() <= ep_gap_ ? lp::optimal : lp::feasible;
+    return true;
+}
+
+bool ConservationTracking::direct_formulation() const {
+#ifdef WITH_OPENGM_LP
+    return with_relaxation_ || !incumbent_callback_.empty() || !stopping_rules_.empty()
+            || !solver_backend_.empty();
+#else
+    return true;
+#endif
+}
+
 size_t ConservationTracking::cplex_id(size_t opengm_id, size_t state) {
-    return optimizer_->lpNodeVi(opengm_id, state);
+#ifdef WITH_OPENGM_LP
+    if (!formulation_) {
+        return optimizer_->lpNodeVi(opengm_id, state);
+    }
+#endif
+    return formulation_->column(opengm_id, state);
 }
 
-void ConservationTracking::add_constraints(const HypothesesGraph& g) {
+size_t ConservationTracking::add_variable(size_t number_of_labels) {
+    if (formulation_) {
+        return formulation_->add_variable(number_of_labels);
+    }
+    pgm_->Model()->addVariable(number_of_labels);
+    assert(pgm_->Model()->numberOfLabels(pgm_->Model()->numberOfVariables() - 1) == number_of_labels);
+    return pgm_->Model()->numberOfVariables() - 1;
+}
+
+void ConservationTracking::add_factor(const pgm::OpengmExplicitFactor<double>& table) {
+    if (!formulation_) {
+        table.add_to(*(pgm_->Model()));
+        return;
+    }
+    const vector<size_t>& vi = table.var_indices();
+    vector<size_t> coords(vi.size(), 0);
+    if (vi.size() == 1) {
+        vector<double> values(formulation_->number_of_labels(vi[0]));
+        for (size_t state = 0; state < values.size(); ++state) {
+            coords[0] = state;
+            values[state] = table.get_value(coords);
+        }
+        formulation_->add_unary(vi[0], values.begin());
+        return;
+    }
+
+    // dense table: every labeling is an entry
+    vector<size_t> labelings;
+    vector<double> values;
+    while (true) {
+        labelings.insert(labelings.end(), coords.begin(), coords.end());
+        values.push_back(table.get_value(coords));
+        size_t i = 0;
+        for (; i < coords.size(); ++i) {
+            if (++coords[i] < formulation_->number_of_labels(vi[i])) {
+                break;
+            }
+            coords[i] = 0;
+        }
+        if (i == coords.size()) {
+            break;
+        }
+    }
+    formulation_->add_term(vi, labelings, values, 0.);
+}
+
+void ConservationTracking::add_factor(const pgm::OpengmSparseFactor<double>& table) {
+    if (!formulation_) {
+        table.add_to(*(pgm_->Model()));
+        return;
+    }
+    // the function stores its entries in sorted variable order
+    vector<size_t> vi(table.var_indices());
+    indexsorter::reorder(vi, table.var_order());
+
+    typedef pgm::OpengmSparseFactor<double>::FunctionType function_t;
+    const function_t& f = table.function();
+    vector<size_t> labelings;
+    vector<double> values;
+    labelings.reserve(f.numberOfEntries() * vi.size());
+    values.reserve(f.numberOfEntries());
+    for (function_t::EntryMap::const_iterator it = f.entries().begin(); it != f.entries().end(); ++it) {
+        const size_t offset = labelings.size();
+        labelings.resize(offset + vi.size(), 0);
+        for (function_t::KeyType::const_iterator k = it->first.begin(); k != it->first.end(); ++k) {
+            labelings[offset + k->first] = k->second;
+        }
+        values.push_back(it->second);
+    }
+    formulation_->add_term(vi, labelings, values, f.default_value());
+}
+
+template <typename ITER, typename COEFF_ITER>
+void ConservationTracking::add_constraint(ITER first_idx, ITER last_idx, COEFF_ITER first_coeff,
+                                          double lower, double upper, const std::string& name) {
+#ifdef WITH_OPENGM_LP
+    if (!formulation_) {
+        optimizer_->addConstraint(first_idx, last_idx, first_coeff, lower, upper, name.c_str());
+        return;
+    }
+#endif
+    formulation_->program().add_row(first_idx, last_idx, first_coeff, lower, upper, name);
+}
+
+void ConservationTracking::add_constraints(const HypothesesGraphSnapshot& s) {
+    const HypothesesGraph& g = s.graph();
     size_t counter = 0;
     LOG(logDEBUG) << "ConservationTracking::add_constraints: entered";
     //typedef opengm::LPCplex<pgm::OpengmModelDeprecated::ogmGraphicalModel,
@@ -567,7 +1105,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
     std::stringstream constraint_name;
 
     LOG(logDEBUG) << "ConservationTracking::add_constraints: transitions";
-    for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
+    for (HypothesesGraphSnapshot::index_type i = 0; i < s.node_count(); ++i) {
+        const HypothesesGraph::Node n = s.node(i);
         std::stringstream traxel_names_ss;
         for (std::vector<Traxel>::const_iterator trax_it = tracklet_map[n].begin();
                 trax_it != tracklet_map[n].end(); ++trax_it) {
@@ -581,9 +1120,10 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
         ////
         //// outgoing transitions
         ////
-        size_t num_outarcs = 0;
+        const size_t num_outarcs = s.out_degree(i);
         // couple detection and transitions: Y_ij <= App_i
-        for (HypothesesGraph::OutArcIt a(g, n); a != lemon::INVALID; ++a) {
+        for (HypothesesGraphSnapshot::index_iterator ai = s.out_begin(i); ai != s.out_end(i); ++ai) {
+            const HypothesesGraph::Arc a = s.arc(*ai);
             assert(app_node_map_.count(n) > 0
                     && "this node should be contained in app_node_map_ since it has outgoing arcs");
             for (size_t nu = 0; nu < max_number_objects_; ++nu) {
@@ -599,12 +1139,11 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
                     constraint_name << "outgoing: 0 <= App_i[" << nu << "] + Y_ij[" << mu << "] <= 1; ";
                     constraint_name << "g.id(n) = " << g.id(n) << ", g.id(a) = " << g.id(a) << ", Traxel " << traxel_names;
                     constraint_name << ", cid = " << ++counter;
-                    optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(),
-                            0, 1, constraint_name.str().c_str());
+                    add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(),
+                            0, 1, constraint_name.str());
                     LOG(logDEBUG3) << constraint_name.str();
                 }
             }
-            ++num_outarcs;
         }
 
         int div_cplex_id = -1;
@@ -618,7 +1157,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             // couple transitions: sum(Y_ij) = D_i + App_i
             cplex_idxs.clear();
             coeffs.clear();
-            for (HypothesesGraph::OutArcIt a(g, n); a != lemon::INVALID; ++a) {
+            for (HypothesesGraphSnapshot::index_iterator ai = s.out_begin(i); ai != s.out_end(i); ++ai) {
+                const HypothesesGraph::Arc a = s.arc(*ai);
                 for (size_t nu = 1; nu <= max_number_objects_; ++nu) {
                     coeffs.push_back(nu);
                     cplex_idxs.push_back(cplex_id(arc_map_[a], nu));
@@ -639,8 +1179,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name << " sum(Y_ij) = D_i + App_i added for Traxel " << traxel_names << ", "
                     << "n = " << app_node_map_[n];
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 0,
-                    constraint_name.str().c_str());
+            add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 0,
+                    constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
 
         }
@@ -664,8 +1204,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name << " D_i=1 => App_i =1 added for Traxel " << traxel_names << ", " << "n = "
                     << app_node_map_[n] << ", d = " << div_node_map_[n];
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), -1, 0,
-                    constraint_name.str().c_str());
+            add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), -1, 0,
+                    constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
 
             // couple divsion and transition: D_1 = 1 => sum_k(Y_ik) = 2
@@ -674,7 +1214,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             cplex_idxs2.push_back(div_cplex_id);
             coeffs2.push_back(2);
 
-            for (HypothesesGraph::OutArcIt a(g, n); a != lemon::INVALID; ++a) {
+            for (HypothesesGraphSnapshot::index_iterator ai = s.out_begin(i); ai != s.out_end(i); ++ai) {
+                const HypothesesGraph::Arc a = s.arc(*ai);
                 for (size_t nu = 2; nu <= max_number_objects_; ++nu) {
                     // D_i[1] = 1 => Y_ij[nu] = 0 forall nu > 1
                     cplex_idxs.clear();
@@ -692,8 +1233,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
                             << nu;
                     constraint_name << ", cid = " << ++counter;
 
-                    optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(),
-                            0, 1, constraint_name.str().c_str());
+                    add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(),
+                            0, 1, constraint_name.str());
                     LOG(logDEBUG3) << constraint_name.str();
 
                 }
@@ -708,8 +1249,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name  << " D_i = 1 => sum_k(Y_ik) = 2 added for Traxel " << traxel_names << ", "
                     << "d = " << div_node_map_[n];
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs2.begin(), cplex_idxs2.end(), coeffs2.begin(),
-                    -int(max_number_objects_), 0, constraint_name.str().c_str());
+            add_constraint(cplex_idxs2.begin(), cplex_idxs2.end(), coeffs2.begin(),
+                    -int(max_number_objects_), 0, constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
         }
 
@@ -720,13 +1261,13 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
         cplex_idxs.clear();
         coeffs.clear();
 
-        size_t num_inarcs = 0;
-        for (HypothesesGraph::InArcIt a(g, n); a != lemon::INVALID; ++a) {
+        const size_t num_inarcs = s.in_degree(i);
+        for (HypothesesGraphSnapshot::index_iterator ai = s.in_begin(i); ai != s.in_end(i); ++ai) {
+            const HypothesesGraph::Arc a = s.arc(*ai);
             for (size_t nu = 1; nu <= max_number_objects_; ++nu) {
                 cplex_idxs.push_back(cplex_id(arc_map_[a], nu));
                 coeffs.push_back(nu);
             }
-            ++num_inarcs;
         }
 
         if (num_inarcs > 0) {
@@ -743,8 +1284,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name << " sum_k(Y_kj) = Dis_j added for Traxel " << traxel_names << ", " << "n = "
                     << dis_node_map_[n];
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 0,
-                    constraint_name.str().c_str());
+            add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 0,
+                    constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
         }
 
@@ -772,8 +1313,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
                 constraint_name << " A_i[nu] = 1 => V_i[nu] = 1 v V_i[0] = 1 added for Traxel "
                         << traxel_names << ", " << "n = " << app_node_map_[n];
                 constraint_name << ", cid = " << ++counter;
-                optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), -1,
-                        0, constraint_name.str().c_str());
+                add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), -1,
+                        0, constraint_name.str());
                 LOG(logDEBUG3) << constraint_name.str();
             }
 
@@ -797,8 +1338,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
                 constraint_name << " V_i[nu] = 1 => A_i[nu] = 1 v A_i[0] = 1 added for Traxel "
                         << traxel_names << ", " << "n = " << app_node_map_[n];
                 constraint_name << ", cid = " << ++counter;
-                optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), -1,
-                        0, constraint_name.str().c_str());
+                add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), -1,
+                        0, constraint_name.str());
                 LOG(logDEBUG3) << constraint_name.str();
             }
         }
@@ -823,8 +1364,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name << "disappearance/appearance coupling: ";
             constraint_name << " A_i[0] + V_i[0] = 0 added for Traxel " << traxel_names;
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 0,
-                    constraint_name.str().c_str());
+            add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0, 0,
+                    constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
         }
 
@@ -840,8 +1381,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name << " V_i[0] = 0 added for Traxel " << traxel_names << ", " << "n = "
                     << dis_node_map_[n];
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0,
-                    0, constraint_name.str().c_str());
+            add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0,
+                    0, constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
         }
 
@@ -857,8 +1398,8 @@ void ConservationTracking::add_constraints(const HypothesesGraph& g) {
             constraint_name << " A_i[0] = 0 added for Traxel " << traxel_names << ", " << "n = "
                     << app_node_map_[n];
             constraint_name << ", cid = " << ++counter;
-            optimizer_->addConstraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0,
-                    0, constraint_name.str().c_str());
+            add_constraint(cplex_idxs.begin(), cplex_idxs.end(), coeffs.begin(), 0,
+                    0, constraint_name.str());
             LOG(logDEBUG3) << constraint_name.str();
         }
     }
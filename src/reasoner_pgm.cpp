@@ -8,17 +8,22 @@
 #include <string.h>
 #include <memory.h>
 
+#ifdef WITH_OPENGM_LP
 #ifdef WITH_GUROBI
 #include <opengm/inference/lpgurobi.hxx>
 #else
 #include <opengm/inference/lpcplex.hxx>
 #endif
+#endif
 
 #include <opengm/datastructures/marray/marray.hxx>
+#include <opengm/utilities/metaprogramming.hxx>
 
 #include "pgmlink/pgm.h"
 #include "pgmlink/hypotheses.h"
 #include "pgmlink/log.h"
+#include "pgmlink/lp_formulation.h"
+#include "pgmlink/lp_solver.h"
 #include "pgmlink/reasoner_pgm.h"
 #include "pgmlink/pgm_chaingraph.h"
 #include "pgmlink/traxels.h"
@@ -28,15 +33,81 @@
 using namespace std;
 
 namespace pgmlink {
+  namespace {
+    // copy variables and factors of the graphical model into the direct formulation
+    void add_to_formulation( const pgm::OpengmModel& gm, lp::DiscreteFormulation& f ) {
+      typedef pgm::OpengmModel::FactorType factor_t;
+      const size_t sparse_type = opengm::meta::GetIndexInTypeList<pgm::OpengmModel::FunctionTypeList,
+                                                                 pgm::SparseFunction>::value;
+      for(size_t var = 0; var < gm.numberOfVariables(); ++var) {
+        f.add_variable(gm.numberOfLabels(var));
+      }
+
+      vector<lp::DiscreteFormulation::index_type> vi;
+      vector<size_t> coords;
+      vector<size_t> labelings;
+      vector<double> values;
+      for(size_t i = 0; i < gm.numberOfFactors(); ++i) {
+        const factor_t& factor = gm[i];
+        vi.assign(factor.variableIndicesBegin(), factor.variableIndicesEnd());
+        coords.assign(vi.size(), 0);
+        labelings.clear();
+        values.clear();
+
+        if(vi.size() == 1) {
+          for(coords[0] = 0; coords[0] < factor.numberOfLabels(0); ++coords[0]) {
+            values.push_back(factor(coords.begin()));
+          }
+          f.add_unary(vi[0], values.begin());
+          continue;
+        }
+
+        if(factor.functionType() == sparse_type) {
+          // only the entries that differ from the default
+          const pgm::SparseFunction& sparse = factor.function<sparse_type>();
+          for(pgm::SparseFunction::EntryMap::const_iterator it = sparse.entries().begin(); it != sparse.entries().end(); ++it) {
+            const size_t offset = labelings.size();
+            labelings.resize(offset + vi.size(), 0);
+            for(pgm::SparseFunction::KeyType::const_iterator k = it->first.begin(); k != it->first.end(); ++k) {
+              labelings[offset + k->first] = k->second;
+            }
+            values.push_back(it->second);
+          }
+          f.add_term(vi, labelings, values, sparse.default_value());
+          continue;
+        }
+
+        // dense factor: every labeling is an entry
+        while(true) {
+          labelings.insert(labelings.end(), coords.begin(), coords.end());
+          values.push_back(factor(coords.begin()));
+          size_t d = 0;
+          for(; d < coords.size(); ++d) {
+            if(++coords[d] < factor.numberOfLabels(d)) {
+              break;
+            }
+            coords[d] = 0;
+          }
+          if(d == coords.size()) {
+            break;
+          }
+        }
+        f.add_term(vi, labelings, values, 0.);
+      }
+    }
+  } /* anonymous namespace */
+
   ////
   //// class Chaingraph
   ////
 
   Chaingraph::~Chaingraph() {
+#ifdef WITH_OPENGM_LP
     if(optimizer_ != NULL) {
 	delete optimizer_;
 	optimizer_ = NULL;
     }
+#endif
 
     delete builder_;
     builder_ = NULL;
@@ -50,6 +121,14 @@ bool Chaingraph::with_constraints() const {
   return with_constraints_;
 }
 
+bool Chaingraph::direct_formulation() const {
+#ifdef WITH_OPENGM_LP
+  return !solver_backend_.empty();
+#else
+  return true;
+#endif
+}
+
 void Chaingraph::formulate( const HypothesesGraph& hypotheses ) {
     LOG(logDEBUG) << "Chaingraph::formulate: entered";
     reset();
@@ -57,12 +136,33 @@ void Chaingraph::formulate( const HypothesesGraph& hypotheses ) {
     // build the model
     linking_model_ = boost::shared_ptr<pgm::chaingraph::Model>(builder_->build(hypotheses));
 
+    if (direct_formulation()) {
+      LOG(logDEBUG) << "Chaingraph::formulate: direct formulation for '" << solver_backend_ << "'";
+      formulation_ = boost::shared_ptr<lp::DiscreteFormulation>(new lp::DiscreteFormulation());
+      add_to_formulation(*(linking_model_->opengm_model), *formulation_);
+      if (with_constraints_) {
+        LOG(logDEBUG) << "Chaingraph::formulate: add_constraints";
+        builder_->add_hard_constraints( *linking_model_ , hypotheses, *formulation_ );
+      }
+      if (fixed_detections_) {
+        LOG(logDEBUG) << "Chaingraph::formulate: fix_detections";
+        builder_->fix_detections( *linking_model_, hypotheses, *formulation_ );
+      }
+      return;
+    }
+
+#ifdef WITH_OPENGM_LP
     // refine the model with hard constraints
     pgm::OpengmLPCplex::Parameter param;
     param.verbose_ = true;
     param.integerConstraint_ = true;
     param.epGap_ = ep_gap_;
     param.timeLimit_ = cplex_timeout_;
+    param.numberOfThreads_ = solver_settings_.threads;
+    if (solver_settings_.memory_limit > 0.) {
+      param.workMem_ = solver_settings_.memory_limit;
+      param.treeMemoryLimit_ = solver_settings_.memory_limit;
+    }
     LOG(logDEBUG) << "Chaingraph::formulate ep_gap = " << param.epGap_;
     pgm::OpengmLPCplex* cplex = new pgm::OpengmLPCplex(*(linking_model_->opengm_model), param);
     optimizer_ = cplex; // opengm::Inference optimizer_
@@ -76,24 +176,50 @@ void Chaingraph::formulate( const HypothesesGraph& hypotheses ) {
       LOG(logDEBUG) << "Chaingraph::formulate: fix_detections";
       builder_->fix_detections( *linking_model_, hypotheses, *cplex );
     }
+#endif
 }
 
 
 
 void Chaingraph::infer() {
+    if(formulation_) {
+        lp::SolverParameters param(solver_settings_);
+        param.verbose = true;
+        param.ep_gap = ep_gap_;
+        param.time_limit = cplex_timeout_;
+        lp_solution_ = lp::create_solver(solver_backend_)->solve(formulation_->program(), param);
+        if(lp_solution_.status != lp::optimal) {
+            throw std::runtime_error("GraphicalModel::infer(): optimizer terminated unnormally");
+        }
+        return;
+    }
+#ifdef WITH_OPENGM_LP
     opengm::InferenceTermination status = optimizer_->infer();
     if(status != opengm::NORMAL) {
         throw std::runtime_error("GraphicalModel::infer(): optimizer terminated unnormally");
     }
+#endif
 }
 
 
 void Chaingraph::conclude( HypothesesGraph& g ) {
     // extract solution from optimizer
-  vector<pgm::OpengmLPCplex::LabelType> solution;
-    opengm::InferenceTermination status = optimizer_->arg(solution);
-    if(status != opengm::NORMAL) {
+  vector<pgm::OpengmModel::LabelType> solution;
+#ifdef WITH_OPENGM_LP
+    if(!formulation_) {
+      opengm::InferenceTermination status = optimizer_->arg(solution);
+      if(status != opengm::NORMAL) {
 	throw runtime_error("GraphicalModel::infer(): solution extraction terminated unnormally");
+      }
+    }
+#endif
+    if(formulation_) {
+      if(!lp_solution_.has_values()) {
+	throw runtime_error("GraphicalModel::infer(): solution extraction terminated unnormally");
+      }
+      vector<size_t> labels;
+      formulation_->labeling(lp_solution_.values, labels);
+      solution.assign(labels.begin(), labels.end());
     }
 
     // add 'active' properties to graph
@@ -132,10 +258,14 @@ void Chaingraph::conclude( HypothesesGraph& g ) {
   }
 
 void Chaingraph::reset() {
+#ifdef WITH_OPENGM_LP
     if(optimizer_ != NULL) {
 	delete optimizer_;
 	optimizer_ = NULL;
     }
+#endif
+    formulation_.reset();
+    lp_solution_ = lp::Solution();
 }
 
 } /* namespace pgmlink */ 
@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "pgmlink/spatial_index.h"
+
+using namespace std;
+
+namespace pgmlink {
+
+namespace {
+const size_t leaf_size = 8;
+
+// orders point indices by one coordinate
+class ByCoordinate {
+ public:
+  ByCoordinate(const vector<double>& coordinates, int dim) : coordinates_(coordinates), dim_(dim) {}
+  bool operator()(size_t a, size_t b) const {
+    return coordinates_[3 * a + dim_] < coordinates_[3 * b + dim_];
+  }
+ private:
+  const vector<double>& coordinates_;
+  int dim_;
+};
+
+inline double squared_distance(const double* a, const double* b) {
+  const double dx = a[0] - b[0];
+  const double dy = a[1] - b[1];
+  const double dz = a[2] - b[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+typedef SpatialIndex::Neighbor Neighbor;
+
+inline bool closer(const Neighbor& a, const Neighbor& b) {
+  return a.second < b.second || (a.second == b.second && a.first < b.first);
+}
+
+// insertion into the buffer of the found k nearest neighbors sorted by distance;
+// the farthest one is dropped if the buffer is full
+inline void insert(const Neighbor& candidate, size_t k, Neighbor* neighbors, size_t& found) {
+  if (found == k && !closer(candidate, neighbors[k - 1])) {
+    return;
+  }
+  size_t pos = found < k ? found++ : k - 1;
+  while (pos > 0 && closer(candidate, neighbors[pos - 1])) {
+    neighbors[pos] = neighbors[pos - 1];
+    --pos;
+  }
+  neighbors[pos] = candidate;
+}
+}
+
+////
+//// class SpatialIndex
+////
+void SpatialIndex::knn_in_range(const double* queries, size_t n, double radius, size_t k,
+                                Neighbor* neighbors, size_t* counts) const {
+  for (size_t i = 0; i < n; ++i) {
+    counts[i] = knn_in_range(queries + 3 * i, radius, k, neighbors + i * k);
+  }
+}
+
+////
+//// class KdTree
+////
+KdTree::KdTree() {}
+
+KdTree::KdTree(const vector<double>& coordinates, const vector<unsigned int>& ids) {
+  if (coordinates.size() != 3 * ids.size()) {
+    throw invalid_argument("KdTree: expected three coordinates per id");
+  }
+  if (ids.empty()) {
+    return;
+  }
+
+  vector<size_t> order(ids.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  nodes_.reserve(2 * (ids.size() / leaf_size + 1));
+  build(0, ids.size(), order, coordinates);
+
+  points_.resize(coordinates.size());
+  ids_.resize(ids.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    copy(&coordinates[3 * order[i]], &coordinates[3 * order[i]] + 3, &points_[3 * i]);
+    ids_[i] = ids[order[i]];
+  }
+}
+
+size_t KdTree::build(size_t begin, size_t end, vector<size_t>& order, const vector<double>& coordinates) {
+  const size_t index = nodes_.size();
+  Node node;
+  node.begin = begin;
+  node.end = end;
+  node.split_dim = -1;
+  node.split = 0.;
+  node.left = node.right = 0;
+  nodes_.push_back(node);
+  if (end - begin <= leaf_size) {
+    return index;
+  }
+
+  // split at the median of the dimension with the largest spread
+  double lower[3], upper[3];
+  for (int d = 0; d < 3; ++d) {
+    lower[d] = upper[d] = coordinates[3 * order[begin] + d];
+  }
+  for (size_t i = begin + 1; i < end; ++i) {
+    for (int d = 0; d < 3; ++d) {
+      lower[d] = min(lower[d], coordinates[3 * order[i] + d]);
+      upper[d] = max(upper[d], coordinates[3 * order[i] + d]);
+    }
+  }
+  int dim = 0;
+  for (int d = 1; d < 3; ++d) {
+    if (upper[d] - lower[d] > upper[dim] - lower[dim]) {
+      dim = d;
+    }
+  }
+  if (upper[dim] == lower[dim]) {
+    return index; // all points coincide
+  }
+
+  const size_t mid = begin + (end - begin) / 2;
+  nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, ByCoordinate(coordinates, dim));
+  nodes_[index].split_dim = dim;
+  nodes_[index].split = coordinates[3 * order[mid] + dim];
+  const size_t left = build(begin, mid, order, coordinates);
+  const size_t right = build(mid, end, order, coordinates);
+  nodes_[index].left = left;
+  nodes_[index].right = right;
+  return index;
+}
+
+size_t KdTree::knn_in_range(const double query[3], double radius, size_t k, Neighbor* neighbors) const {
+  if (radius < 0) {
+    throw invalid_argument("KdTree::knn_in_range: radius has to be non-negative");
+  }
+  size_t found = 0;
+  if (k > 0 && !nodes_.empty()) {
+    search(0, query, radius * radius, k, neighbors, found);
+  }
+  return found;
+}
+
+size_t KdTree::count_in_range(const double query[3], double radius) const {
+  if (radius < 0) {
+    throw invalid_argument("KdTree::count_in_range: radius has to be non-negative");
+  }
+  if (nodes_.empty()) {
+    return 0;
+  }
+  return count(0, query, radius * radius);
+}
+
+void KdTree::search(size_t index, const double query[3], double sq_radius, size_t k,
+                    Neighbor* neighbors, size_t& found) const {
+  const Node& node = nodes_[index];
+  if (node.split_dim < 0) {
+    for (size_t i = node.begin; i < node.end; ++i) {
+      const double d = squared_distance(query, &points_[3 * i]);
+      if (d <= sq_radius) {
+        insert(Neighbor(ids_[i], d), k, neighbors, found);
+      }
+    }
+    return;
+  }
+
+  const double diff = query[node.split_dim] - node.split;
+  const size_t near = diff < 0 ? node.left : node.right;
+  const size_t far = diff < 0 ? node.right : node.left;
+  search(near, query, sq_radius, k, neighbors, found);
+  const double bound = found == k ? neighbors[k - 1].second : sq_radius;
+  if (diff * diff <= bound) {
+    search(far, query, sq_radius, k, neighbors, found);
+  }
+}
+
+size_t KdTree::count(size_t index, const double query[3], double sq_radius) const {
+  const Node& node = nodes_[index];
+  if (node.split_dim < 0) {
+    size_t n = 0;
+    for (size_t i = node.begin; i < node.end; ++i) {
+      if (squared_distance(query, &points_[3 * i]) <= sq_radius) {
+        ++n;
+      }
+    }
+    return n;
+  }
+  const double diff = query[node.split_dim] - node.split;
+  const size_t near = diff < 0 ? node.left : node.right;
+  const size_t far = diff < 0 ? node.right : node.left;
+  size_t n = count(near, query, sq_radius);
+  if (diff * diff <= sq_radius) {
+    n += count(far, query, sq_radius);
+  }
+  return n;
+}
+
+
+
+////
+//// class SpatialHashGrid
+////
+SpatialHashGrid::SpatialHashGrid(const vector<double>& coordinates, const vector<unsigned int>& ids, double cell_size)
+  : cell_size_(cell_size) {
+  if (coordinates.size() != 3 * ids.size()) {
+    throw invalid_argument("SpatialHashGrid: expected three coordinates per id");
+  }
+  if (!(cell_size > 0)) {
+    throw invalid_argument("SpatialHashGrid: cell size has to be positive");
+  }
+
+  // at least two buckets per point keeps collisions rare
+  size_t buckets = 1;
+  while (buckets < 2 * ids.size()) {
+    buckets *= 2;
+  }
+  bucket_mask_ = buckets - 1;
+
+  // counting sort of the points by bucket
+  const size_t n = ids.size();
+  vector<Cell> cells(n);
+  vector<size_t> bucket(n);
+  bucket_begin_.assign(buckets + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    cells[i] = cell_of(&coordinates[3 * i]);
+    bucket[i] = bucket_of(cells[i]);
+    ++bucket_begin_[bucket[i] + 1];
+  }
+  for (size_t b = 0; b < buckets; ++b) {
+    bucket_begin_[b + 1] += bucket_begin_[b];
+  }
+  vector<size_t> next(bucket_begin_.begin(), bucket_begin_.end() - 1);
+  cells_.resize(n);
+  points_.resize(3 * n);
+  ids_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    const size_t pos = next[bucket[i]]++;
+    cells_[pos] = cells[i];
+    copy(&coordinates[3 * i], &coordinates[3 * i] + 3, &points_[3 * pos]);
+    ids_[pos] = ids[i];
+  }
+}
+
+SpatialHashGrid::Cell SpatialHashGrid::cell_of(const double point[3]) const {
+  Cell cell;
+  cell.x = static_cast<long>(floor(point[0] / cell_size_));
+  cell.y = static_cast<long>(floor(point[1] / cell_size_));
+  cell.z = static_cast<long>(floor(point[2] / cell_size_));
+  return cell;
+}
+
+size_t SpatialHashGrid::bucket_of(const Cell& cell) const {
+  // the spatial hash of Teschner et al.
+  const size_t h = (static_cast<size_t>(cell.x) * 73856093u)
+                 ^ (static_cast<size_t>(cell.y) * 19349663u)
+                 ^ (static_cast<size_t>(cell.z) * 83492791u);
+  return h & bucket_mask_;
+}
+
+template <typename Visitor>
+void SpatialHashGrid::visit(const double query[3], double radius, Visitor& visitor) const {
+  const double lower_corner[3] = { query[0] - radius, query[1] - radius, query[2] - radius };
+  const double upper_corner[3] = { query[0] + radius, query[1] + radius, query[2] + radius };
+  const Cell lower = cell_of(lower_corner);
+  const Cell upper = cell_of(upper_corner);
+  Cell cell;
+  for (cell.x = lower.x; cell.x <= upper.x; ++cell.x) {
+    for (cell.y = lower.y; cell.y <= upper.y; ++cell.y) {
+      for (cell.z = lower.z; cell.z <= upper.z; ++cell.z) {
+        const size_t b = bucket_of(cell);
+        for (size_t i = bucket_begin_[b]; i < bucket_begin_[b + 1]; ++i) {
+          if (cells_[i] == cell) {
+            visitor(i);
+          }
+        }
+      }
+    }
+  }
+}
+
+namespace {
+class CollectNearest {
+ public:
+  CollectNearest(const double* query, double sq_radius, size_t k, Neighbor* neighbors,
+                 const vector<double>& points, const vector<unsigned int>& ids)
+    : found(0), query_(query), sq_radius_(sq_radius), k_(k), neighbors_(neighbors), points_(points), ids_(ids) {}
+  void operator()(size_t i) {
+    const double d = squared_distance(query_, &points_[3 * i]);
+    if (d <= sq_radius_) {
+      insert(Neighbor(ids_[i], d), k_, neighbors_, found);
+    }
+  }
+  size_t found;
+ private:
+  const double* query_;
+  double sq_radius_;
+  size_t k_;
+  Neighbor* neighbors_;
+  const vector<double>& points_;
+  const vector<unsigned int>& ids_;
+};
+
+class CountInRange {
+ public:
+  CountInRange(const double* query, double sq_radius, const vector<double>& points)
+    : count(0), query_(query), sq_radius_(sq_radius), points_(points) {}
+  void operator()(size_t i) {
+    if (squared_distance(query_, &points_[3 * i]) <= sq_radius_) {
+      ++count;
+    }
+  }
+  size_t count;
+ private:
+  const double* query_;
+  double sq_radius_;
+  const vector<double>& points_;
+};
+}
+
+size_t SpatialHashGrid::knn_in_range(const double query[3], double radius, size_t k, Neighbor* neighbors) const {
+  if (radius < 0) {
+    throw invalid_argument("SpatialHashGrid::knn_in_range: radius has to be non-negative");
+  }
+  if (k == 0 || ids_.empty()) {
+    return 0;
+  }
+  CollectNearest collect(query, radius * radius, k, neighbors, points_, ids_);
+  visit(query, radius, collect);
+  return collect.found;
+}
+
+size_t SpatialHashGrid::count_in_range(const double query[3], double radius) const {
+  if (radius < 0) {
+    throw invalid_argument("SpatialHashGrid::count_in_range: radius has to be non-negative");
+  }
+  if (ids_.empty()) {
+    return 0;
+  }
+  CountInRange counter(query, radius * radius, points_);
+  visit(query, radius, counter);
+  return counter.count;
+}
+
+
+
+bool prefer_grid_index(const vector<double>& coordinates, double radius) {
+  const size_t n = coordinates.size() / 3;
+  if (n < 64 || !(radius > 0)) {
+    return false;
+  }
+  double lower[3], upper[3];
+  for (int d = 0; d < 3; ++d) {
+    lower[d] = upper[d] = coordinates[d];
+  }
+  for (size_t i = 1; i < n; ++i) {
+    for (int d = 0; d < 3; ++d) {
+      lower[d] = min(lower[d], coordinates[3 * i + d]);
+      upper[d] = max(upper[d], coordinates[3 * i + d]);
+    }
+  }
+  // number of cells of the bounding box; flat dimensions (2d data) span one cell
+  double cells = 1.;
+  for (int d = 0; d < 3; ++d) {
+    cells *= floor((upper[d] - lower[d]) / radius) + 1.;
+  }
+  return cells <= 4. * n;
+}
+
+boost::shared_ptr<const SpatialIndex> make_spatial_index(const vector<double>& coordinates,
+                                                        const vector<unsigned int>& ids,
+                                                        double radius,
+                                                        SpatialIndexType type) {
+  if (type == index_auto) {
+    type = prefer_grid_index(coordinates, radius) ? index_grid : index_kd_tree;
+  }
+  if (type == index_grid && radius > 0) {
+    return boost::shared_ptr<const SpatialIndex>(new SpatialHashGrid(coordinates, ids, radius));
+  }
+  return boost::shared_ptr<const SpatialIndex>(new KdTree(coordinates, ids));
+}
+
+} /* namespace pgmlink */
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <memory>
 #include <set>
 #include <string>
@@ -10,10 +12,13 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 
+#include "pgmlink/arc_features.h"
 #include "pgmlink/feature.h"
 #include "pgmlink/pgm.h"
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_overlay.h"
 #include "pgmlink/log.h"
+#include "pgmlink/reasoner_assignment.h"
 #include "pgmlink/reasoner_pgm.h"
 #include "pgmlink/tracking.h"
 #include "pgmlink/reasoner_constracking.h"
@@ -37,6 +42,14 @@ void ChaingraphTracking::set_cplex_timeout(double seconds) {
 	cplex_timeout_ = seconds;
 }
 
+void ChaingraphTracking::set_solver_backend(const std::string& name) {
+	solver_backend_ = name;
+}
+
+void ChaingraphTracking::set_solver_settings(const lp::SolverSettings& settings) {
+	solver_settings_ = settings;
+}
+
 vector<vector<Event> > ChaingraphTracking::operator()(TraxelStore& ts) {
   LOG(logINFO) << "Calling chaingraph tracking with the following parameters:\n"
 	       << "\trandom forest filename: " << rf_fn_ << "\n"
@@ -55,7 +68,10 @@ vector<vector<Event> > ChaingraphTracking::operator()(TraxelStore& ts) {
     	       << "\tn neighbors: " <<  n_neighbors_ << "\n"
    	       << "\twith divisions: " << with_divisions_  << "\n"
    	       << "\tcplex timeout: " << cplex_timeout_ << "\n"
-   	       << "\talternative builder: " << alternative_builder_;
+   	       << "\talternative builder: " << alternative_builder_ << "\n"
+   	       << "\tsolver backend: " << solver_backend_ << "\n"
+   	       << "\tsolver threads: " << solver_settings_.threads << "\n"
+   	       << "\tsolver memory limit: " << solver_settings_.memory_limit;
 
   
   
@@ -109,8 +125,11 @@ vector<vector<Event> > ChaingraphTracking::operator()(TraxelStore& ts) {
 
 	cout << "-> building hypotheses" << endl;
 	SingleTimestepTraxel_HypothesesBuilder::Options builder_opts(n_neighbors_, 50);
+	// the graph does not outlive ts
+	builder_opts.traxels_by_reference = true;
 	SingleTimestepTraxel_HypothesesBuilder hyp_builder(&ts, builder_opts);
 	boost::shared_ptr<HypothesesGraph> graph = boost::shared_ptr<HypothesesGraph>(hyp_builder.build());
+	compute_arc_features(*graph);
 
 	cout << "-> init MRF reasoner" << endl;
 	std::auto_ptr<Chaingraph> mrf;
@@ -127,7 +146,8 @@ vector<vector<Event> > ChaingraphTracking::operator()(TraxelStore& ts) {
 	  }
 
 	  b.with_detection_vars(detection, misdetection);
-	  mrf = std::auto_ptr<Chaingraph>(new Chaingraph(b, with_constraints_, ep_gap_, fixed_detections_, cplex_timeout_));
+	  mrf = std::auto_ptr<Chaingraph>(new Chaingraph(b, with_constraints_, ep_gap_, fixed_detections_, cplex_timeout_,
+							 solver_backend_, solver_settings_));
 	} else {
 	  pgm::chaingraph::ECCV12ModelBuilder b(appearance,
 					      disappearance,
@@ -140,7 +160,8 @@ vector<vector<Event> > ChaingraphTracking::operator()(TraxelStore& ts) {
 	  }
 
 	  b.with_detection_vars(detection, misdetection);
-	  mrf = std::auto_ptr<Chaingraph>(new Chaingraph(b, with_constraints_, ep_gap_, fixed_detections_, cplex_timeout_));
+	  mrf = std::auto_ptr<Chaingraph>(new Chaingraph(b, with_constraints_, ep_gap_, fixed_detections_, cplex_timeout_,
+							 solver_backend_, solver_settings_));
 	}
 
 	cout << "-> formulate MRF model" << endl;
@@ -155,12 +176,9 @@ vector<vector<Event> > ChaingraphTracking::operator()(TraxelStore& ts) {
 	cout << "-> storing state of detection vars" << endl;
 	last_detections_ = state_of_nodes(*graph);
 
-	cout << "-> pruning inactive hypotheses" << endl;
-	prune_inactive(*graph);
-
 	cout << "-> constructing events" << endl;
 
-	return *events(*graph);
+	return *events(ActiveSubgraph(*graph));
 }
 
 vector<map<unsigned int, bool> > ChaingraphTracking::detections() {
@@ -175,6 +193,104 @@ vector<map<unsigned int, bool> > ChaingraphTracking::detections() {
 
 
 
+////
+//// class NNTracking, NNTrackletsTracking
+////
+namespace {
+double feature_distance(const Traxel& from, const Traxel& to, const vector<string>& features) {
+	double sum = 0;
+	for (vector<string>::const_iterator f = features.begin(); f != features.end(); ++f) {
+		const feature_array& a = from.features.find(*f)->second;
+		const feature_array& b = to.features.find(*f)->second;
+		if (a.size() != b.size()) {
+			throw runtime_error("feature_distance(): feature " + *f + " differs in size");
+		}
+		for (size_t i = 0; i < a.size(); ++i) {
+			sum += (a[i] - b[i]) * (a[i] - b[i]);
+		}
+	}
+	return sqrt(sum);
+}
+
+vector<vector<Event> > assignment_tracking(TraxelStore& ts,
+					   double move_distance,
+					   double division_distance,
+					   const vector<string>& distance_features,
+					   double division_threshold,
+					   shared_ptr<vector<map<unsigned int, bool> > >& last_detections) {
+	for (vector<string>::const_iterator f = distance_features.begin(); f != distance_features.end(); ++f) {
+		for (TraxelStore::const_iterator it = ts.begin(); it != ts.end(); ++it) {
+			if (it->features.find(*f) == it->features.end()) {
+				throw runtime_error("assignment_tracking(): distance feature " + *f + " missing in traxel");
+			}
+		}
+	}
+
+	cout << "-> building hypotheses" << endl;
+	SingleTimestepTraxel_HypothesesBuilder::Options builder_opts(6, max(move_distance, division_distance));
+	// the graph does not outlive ts
+	builder_opts.traxels_by_reference = true;
+	SingleTimestepTraxel_HypothesesBuilder hyp_builder(&ts, builder_opts);
+	boost::shared_ptr<HypothesesGraph> graph = boost::shared_ptr<HypothesesGraph>(hyp_builder.build());
+
+	if (!distance_features.empty()) {
+		graph->add(arc_distance());
+		property_map<arc_distance, HypothesesGraph::base_graph>::type& arc_distances = graph->get(arc_distance());
+		const NodeTraxels traxel_map(*graph);
+		for (HypothesesGraph::ArcIt a(*graph); a != lemon::INVALID; ++a) {
+			arc_distances.set(a, feature_distance(traxel_map[graph->source(a)], traxel_map[graph->target(a)],
+							      distance_features));
+		}
+	}
+
+	cout << "-> assignment" << endl;
+	AssignmentTracking reasoner(move_distance, division_distance, division_threshold);
+	reasoner.formulate(*graph);
+	reasoner.infer();
+	reasoner.conclude(*graph);
+
+	last_detections = state_of_nodes(*graph);
+
+	cout << "-> constructing events" << endl;
+	return *events(ActiveSubgraph(*graph));
+}
+}
+
+vector<vector<Event> > NNTracking::operator()(TraxelStore& ts) {
+	LOG(logINFO) << "Calling nearest neighbor tracking with the following parameters:\n"
+		     << "\tdivision distance: " << divDist_ << "\n"
+		     << "\tmovement distance: " << movDist_ << "\n"
+		     << "\tdivision threshold: " << divisionThreshold_;
+	return assignment_tracking(ts, movDist_, divDist_, distanceFeatures_, divisionThreshold_, last_detections_);
+}
+
+vector<map<unsigned int, bool> > NNTracking::detections() {
+	if (last_detections_) {
+		return *last_detections_;
+	} else {
+		throw std::runtime_error(
+				"NNTracking::detections(): previous tracking result required");
+	}
+}
+
+vector<vector<Event> > NNTrackletsTracking::operator()(TraxelStore& ts) {
+	LOG(logINFO) << "Calling nearest neighbor tracklets tracking with the following parameters:\n"
+		     << "\tmaximal distance: " << maxDist_ << "\n"
+		     << "\tdivision threshold: " << divisionThreshold_;
+	return assignment_tracking(ts, maxDist_, maxDist_, distanceFeatures_, divisionThreshold_, last_detections_);
+}
+
+vector<map<unsigned int, bool> > NNTrackletsTracking::detections() {
+	if (last_detections_) {
+		return *last_detections_;
+	} else {
+		throw std::runtime_error(
+				"NNTrackletsTracking::detections(): previous tracking result required");
+	}
+}
+
+
+
 namespace {
 std::vector<double> computeDetProb(double vol, vector<double> means, vector<double> s2) {
 	std::vector<double> result;
@@ -354,32 +470,19 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 				with_divisions_, // consider_divisions
 				division_threshold_
 				);
+	builder_opts.traxels_by_reference = traxels_by_reference_;
 	SingleTimestepTraxel_HypothesesBuilder hyp_builder(traxel_store_, builder_opts);
 	hypotheses_graph_ = boost::shared_ptr<HypothesesGraph>(hyp_builder.build());
 
 	hypotheses_graph_->add(arc_distance()).add(tracklet_intern_dist()).add(node_tracklet()).add(tracklet_intern_arc_ids()).add(traxel_arc_id());
  	
-	property_map<arc_distance, HypothesesGraph::base_graph>::type& arc_distances = (hypotheses_graph_)->get(arc_distance());
-	property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = (hypotheses_graph_)->get(node_traxel());
 	bool with_optical_correction = false;
-	Traxel some_traxel = (*traxel_map.beginValue());
+	const Traxel& some_traxel = *traxel_store_->begin();
 	if (some_traxel.features.find("com_corrected") != some_traxel.features.end()) {
 		LOG(logINFO) << "optical correction enabled";
 		with_optical_correction = true;
 	}
-
-	for(HypothesesGraph::ArcIt a(*hypotheses_graph_); a!=lemon::INVALID; ++a) {
-		HypothesesGraph::Node from = (hypotheses_graph_)->source(a);
-		HypothesesGraph::Node to = (hypotheses_graph_)->target(a);
-		Traxel from_tr = traxel_map[from];
-		Traxel to_tr = traxel_map[to];
-
-		if (with_optical_correction) {
-			arc_distances.set(a, from_tr.distance_to_corr(to_tr));
-		} else {
-			arc_distances.set(a, from_tr.distance_to(to_tr));
-		}
-	}
+	compute_arc_features(*hypotheses_graph_, with_optical_correction);
 
         if(event_vector_dump_filename_ != "none")
 	  {
@@ -421,6 +524,8 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
     LOG(logDEBUG1) <<"border_width\t"<<      border_width;
     LOG(logDEBUG1) <<"with_constraints\t"<<      with_constraints;
     LOG(logDEBUG1) <<"cplex_timeout\t"<<      cplex_timeout;
+    LOG(logDEBUG1) <<"solver_backend\t"<<      solver_backend_;
+    LOG(logDEBUG1) <<"with_relaxation\t"<<      with_relaxation_;
     
     
 
@@ -489,8 +594,16 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 			true, // with_disappearance
 			transition_parameter,
             with_constraints,
-            cplex_timeout
+            cplex_timeout,
+            solver_backend_,
+            solver_settings_,
+            with_relaxation_
 			);
+	pgm.set_incumbent_callback(incumbent_callback_);
+	for (std::vector<lp::StoppingRule>::const_iterator rule = stopping_rules_.begin();
+	     rule != stopping_rules_.end(); ++rule) {
+		pgm.add_stopping_rule(*rule);
+	}
 
 	cout << "-> formulate ConservationTracking model" << endl;
 	pgm.formulate(*hypotheses_graph_);
@@ -504,11 +617,9 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 	cout << "-> storing state of detection vars" << endl;
 	last_detections_ = state_of_nodes(*hypotheses_graph_);
 
-	cout << "-> pruning inactive hypotheses" << endl;
-	prune_inactive(*hypotheses_graph_);
-
+	// inactive hypotheses are kept in the graph and hidden by the view
 	cout << "-> constructing unresolved events" << endl;
-	boost::shared_ptr<std::vector< std::vector<Event> > > ev = events(*hypotheses_graph_);
+	boost::shared_ptr<std::vector< std::vector<Event> > > ev = events(ActiveSubgraph(*hypotheses_graph_));
 
 	if(event_vector_dump_filename_ != "none")
 	  {
@@ -547,17 +658,17 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 			LOG(logDEBUG) << "Nothing to resolve in ConstTracking::resolve_mergers:";
 			LOG(logDEBUG) << "max_number_objects = 1";
 		} else {
-            // create a copy of the hypotheses graph to perform merger resolution without destroying the old graph
-            HypothesesGraph resolved_graph;
-            HypothesesGraph::copy(*hypotheses_graph_, resolved_graph);
+            // resolve mergers in the hypotheses graph; the overlay undoes the changes when it goes out of scope
+            HypothesesGraphOverlay overlay(*hypotheses_graph_);
+            HypothesesGraph& resolved_graph = overlay.graph();
 
-            MergerResolver m(&resolved_graph);
+            MergerResolver m(&overlay);
 			FeatureExtractorBase* extractor;
 			DistanceFromCOMs distance;
 			if (coordinates) {
 				extractor = new FeatureExtractorArmadillo(coordinates);
 			} else {
-                calculate_gmm_beforehand(resolved_graph, 1, n_dim);
+                calculate_gmm_beforehand(overlay, 1, n_dim);
 				extractor = new FeatureExtractorMCOMsFromMCOMs;
 			}
 			FeatureHandlerFromTraxels handler(*extractor, distance);
@@ -565,7 +676,8 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 			m.resolve_mergers(handler);
 
 			HypothesesGraph g_res;
-            resolve_graph(resolved_graph, g_res, transition, ep_gap, with_tracklets, transition_parameter, with_constraints);
+            resolve_graph(resolved_graph, g_res, transition, ep_gap, with_tracklets, transition_parameter, with_constraints,
+                          solver_backend_, solver_settings_);
 			if (return_multi_frame_moves) {
 				cout << "-> constructing multi frame moves" << endl;
 				boost::shared_ptr<std::vector<std::vector<Event> > > multi_frame_moves
@@ -574,8 +686,7 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 				events_ptr = merge_event_vectors(*events_ptr, *multi_frame_moves);
 			} else {
 				cout << "-> get events of the resolved graph" << endl;
-				prune_inactive(resolved_graph);
-				events_ptr = events(resolved_graph);
+				events_ptr = events(ActiveSubgraph(resolved_graph));
 			}
 
 			// TODO The in serialized event vector written in the track() function
@@ -593,6 +704,30 @@ shared_ptr<HypothesesGraph> ConsTracking::build_hypo_graph(TraxelStore& ts) {
 
 
 
+void ConsTracking::set_solver_backend(const std::string& name) {
+	solver_backend_ = name;
+}
+
+void ConsTracking::set_solver_settings(const lp::SolverSettings& settings) {
+	solver_settings_ = settings;
+}
+
+void ConsTracking::set_with_relaxation(bool with_relaxation) {
+	with_relaxation_ = with_relaxation;
+}
+
+void ConsTracking::set_traxels_by_reference(bool traxels_by_reference) {
+	traxels_by_reference_ = traxels_by_reference;
+}
+
+void ConsTracking::set_incumbent_callback(const lp::IncumbentCallback& callback) {
+	incumbent_callback_ = callback;
+}
+
+void ConsTracking::add_stopping_rule(const lp::StoppingRule& rule) {
+	stopping_rules_.push_back(rule);
+}
+
 vector<map<unsigned int, bool> > ConsTracking::detections() {
 	vector<map<unsigned int, bool> > res;
 	if (last_detections_) {
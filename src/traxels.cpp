@@ -2,6 +2,7 @@
 #include <cmath>
 #include <stdexcept>
 #include <set>
+#include <string>
 #include <vector>
 #include "pgmlink/traxels.h"
 #include "pgmlink/field_of_view.h"
@@ -29,6 +30,9 @@ namespace pgmlink {
   Traxel::Traxel(const Traxel& other): Id(other.Id), Timestep(other.Timestep), features(other.features) {
     locator_ = other.locator_->clone();
     corr_locator_ = other.corr_locator_;
+    has_coordinates_ = other.has_coordinates_;
+    copy(other.coordinates_, other.coordinates_ + 3, coordinates_);
+    copy(other.corr_coordinates_, other.corr_coordinates_ + 3, corr_coordinates_);
   }
 
   Traxel& Traxel::operator=(const Traxel& other) {
@@ -40,49 +44,53 @@ namespace pgmlink {
     Locator* temp = other.locator_->clone();
     delete locator_;
     locator_ = temp;
+    has_coordinates_ = other.has_coordinates_;
+    copy(other.coordinates_, other.coordinates_ + 3, coordinates_);
+    copy(other.corr_coordinates_, other.corr_coordinates_ + 3, corr_coordinates_);
     return *this;
   }
 
   Traxel& Traxel::set_locator(Locator* l) {
     delete locator_;
     locator_ = l;
+    if (has_coordinates_) {
+      update_coordinates();
+    }
     return *this;
   }
 
-  double Traxel::X() const {
-    return locator_->X(features);
-  }
-
-  double Traxel::Y() const {
-    return locator_->Y(features);
-  }
-
-  double Traxel::Z() const {
-    return locator_->Z(features);
-  }
-
-  double Traxel::X_corr() const {
-	if (features.count("com_corrected") == 1) {
-		return corr_locator_->X(features);
-	} else {
-		return X();
-	}
+  Traxel& Traxel::set_feature(const std::string& name, const feature_array& value) {
+    features[name] = value;
+    if (has_coordinates_) {
+      update_coordinates();
+    }
+    return *this;
   }
 
-  double Traxel::Y_corr() const {
-	  if (features.count("com_corrected") == 1) {
-		return corr_locator_->Y(features);
-	} else {
-		return Y();
-	}
+  void Traxel::update_coordinates() {
+    has_coordinates_ = false;
+    if (!locator_->is_applicable(features)) {
+      return;
+    }
+    coordinates_[0] = locator_->X(features);
+    coordinates_[1] = locator_->Y(features);
+    coordinates_[2] = locator_->Z(features);
+    for (size_t dim = 0; dim < 3; ++dim) {
+      corr_coordinates_[dim] = corr_coordinate(dim);
+    }
+    has_coordinates_ = true;
   }
 
-  double Traxel::Z_corr() const {
-	  if (features.count("com_corrected") == 1) {
-		  return corr_locator_->Z(features);
-	  } else {
-		  return Z();
-	  }
+  double Traxel::corr_coordinate(size_t dim) const {
+    const Locator* locator = locator_;
+    if (features.count("com_corrected") == 1) {
+      locator = corr_locator_;
+    }
+    switch (dim) {
+    case 0: return locator->X(features);
+    case 1: return locator->Y(features);
+    default: return locator->Z(features);
+    }
   }
 
   namespace {
@@ -213,7 +221,9 @@ namespace pgmlink {
  }
   
   TraxelStore& add(TraxelStore& ts, const Traxel& t) {
-    ts.get<by_timestep>().insert(t);
+    Traxel traxel(t);
+    traxel.update_coordinates();
+    ts.get<by_timestep>().insert(traxel);
     return ts;
   }
 
@@ -234,14 +244,49 @@ namespace pgmlink {
   }
 
   size_t filter_by_fov( const TraxelStore& in, TraxelStore& out, const FieldOfView& fov ) {
-    size_t n = 0;
+    vector<const Traxel*> inside = filter_by_fov(in, fov);
+    for(vector<const Traxel*>::const_iterator it = inside.begin(); it != inside.end(); ++it) {
+      add(out, **it);
+    }
+    return inside.size();
+  }
+
+  std::vector<const Traxel*> filter_by_fov( const TraxelStore& in, const FieldOfView& fov ) {
+    vector<const Traxel*> traxels;
+    traxels.reserve(in.size());
     for(TraxelStore::iterator it = in.begin(); it != in.end(); ++it) {
-      if(fov.contains(it->Timestep, it->X(), it->Y(), it->Z())) {
-	  add(out, *it);
-	  ++n;
+      traxels.push_back(&*it);
+    }
+
+    // exceptions must not leave the parallel region
+    vector<char> inside(traxels.size(), 0);
+    bool failed = false;
+    string error;
+    const int n = static_cast<int>(traxels.size());
+#   pragma omp parallel for
+    for(int i = 0; i < n; ++i) {
+      try {
+	const Traxel& tr = *traxels[i];
+	inside[i] = fov.contains(tr.Timestep, tr.X(), tr.Y(), tr.Z());
+      } catch(const std::exception& e) {
+#       pragma omp critical(filter_by_fov)
+	{
+	  failed = true;
+	  error = e.what();
 	}
+      }
+    }
+    if(failed) {
+      throw runtime_error("filter_by_fov(): " + error);
+    }
+
+    vector<const Traxel*> ret;
+    for(size_t i = 0; i < traxels.size(); ++i) {
+      if(inside[i]) {
+	ret.push_back(traxels[i]);
+      }
     }
-    return n;
+    return ret;
   }
 } /* namespace pgmlink */
 
@@ -0,0 +1,120 @@
+#define BOOST_TEST_MODULE arc_features_test
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "pgmlink/arc_features.h"
+#include "pgmlink/feature_calculator.h"
+#include "pgmlink/feature_extraction.h"
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/traxels.h"
+
+using namespace pgmlink;
+using namespace std;
+
+namespace {
+Traxel make_traxel(unsigned int id, int timestep, double x, float count) {
+  Traxel tr(id, timestep);
+  feature_array com(3, 0.);
+  com[0] = x;
+  tr.features["com"] = com;
+  tr.features["count"] = feature_array(1, count);
+  return tr;
+}
+}
+
+BOOST_AUTO_TEST_CASE( compute_arc_features_distances_and_extractors ) {
+  //  t=0      1
+  //  1 ------ 2
+  //    `----- 3
+  HypothesesGraph g;
+  g.add(node_traxel());
+  HypothesesGraph::Node n1 = g.add_node(0);
+  HypothesesGraph::Node n2 = g.add_node(1);
+  HypothesesGraph::Node n3 = g.add_node(1);
+  NodeTraxels traxels(g);
+  traxels.set(n1, make_traxel(1, 0, 0., 10.));
+  traxels.set(n2, make_traxel(2, 1, 3., 12.));
+  traxels.set(n3, make_traxel(3, 1, 5., 7.));
+  HypothesesGraph::Arc a12 = g.addArc(n1, n2);
+  HypothesesGraph::Arc a13 = g.addArc(n1, n3);
+
+  vector<boost::shared_ptr<feature_extraction::FeatureExtractor> > extractors;
+  extractors.push_back(boost::shared_ptr<feature_extraction::FeatureExtractor>(
+      new feature_extraction::FeatureExtractor(
+          boost::shared_ptr<feature_extraction::FeatureCalculator>(
+              new feature_extraction::ElementWiseSquaredDistanceCalculator), "com")));
+  extractors.push_back(boost::shared_ptr<feature_extraction::FeatureExtractor>(
+      new feature_extraction::FeatureExtractor(
+          boost::shared_ptr<feature_extraction::FeatureCalculator>(
+              new feature_extraction::AbsoluteDifferenceCalculator), "count")));
+  compute_arc_features(g, false, extractors);
+
+  BOOST_CHECK_EQUAL(g.get(arc_distance())[a12], 3.);
+  BOOST_CHECK_EQUAL(g.get(arc_distance())[a13], 5.);
+
+  const ArcFeatureTable& table = g.get(arc_features());
+  BOOST_REQUIRE_EQUAL(table.dimension(), 4u);
+  BOOST_CHECK_EQUAL(table.names().size(), 2u);
+  BOOST_CHECK_EQUAL(table.offsets()[1], 3u);
+  BOOST_CHECK_EQUAL(table[a12][0], 9.);
+  BOOST_CHECK_EQUAL(table[a12][3], 2.);
+  BOOST_CHECK_EQUAL(table[a13][0], 25.);
+  BOOST_CHECK_EQUAL(table[a13][3], 3.);
+  BOOST_CHECK(table.contains(a12));
+  BOOST_CHECK(!table.optical_correction());
+
+  // the table is kept by copies and binary archives of the graph
+  HypothesesGraph copied;
+  HypothesesGraph::copy(g, copied);
+  std::stringstream ss;
+  write_binary(g, ss);
+  HypothesesGraph loaded;
+  read_binary(loaded, ss);
+  const HypothesesGraph* graphs[] = {&copied, &loaded};
+  for (size_t i = 0; i < 2; ++i) {
+    BOOST_REQUIRE(graphs[i]->has_property(arc_features()));
+    const ArcFeatureTable& other = graphs[i]->get(arc_features());
+    BOOST_REQUIRE_EQUAL(other.dimension(), 4u);
+    BOOST_CHECK_EQUAL(other.names().size(), 2u);
+    size_t arcs = 0;
+    for (HypothesesGraph::ArcIt a(*graphs[i]); a != lemon::INVALID; ++a, ++arcs) {
+      BOOST_REQUIRE(other.contains(a));
+      const double distance = graphs[i]->get(arc_distance())[a];
+      BOOST_CHECK_EQUAL(other[a][0], distance * distance);
+      BOOST_CHECK_EQUAL(other[a][3], distance == 3. ? 2. : 3.);
+    }
+    BOOST_CHECK_EQUAL(arcs, 2u);
+  }
+
+  // arcs added afterwards have no row, also if they reuse the id of an erased arc
+  const int id13 = g.id(a13);
+  g.erase(a13);
+  HypothesesGraph::Arc added = g.addArc(n1, n3);
+  BOOST_CHECK_EQUAL(g.id(added), id13);
+  HypothesesGraph::Arc beyond = g.addArc(n2, n3);
+  BOOST_CHECK(!table.contains(added));
+  BOOST_CHECK(table[added] == NULL);
+  BOOST_CHECK(!table.contains(beyond));
+  BOOST_CHECK(table[beyond] == NULL);
+  BOOST_CHECK(table.contains(a12));
+
+  // a feature missing in a traxel is reported, and no arc keeps a stale row
+  Traxel without_count = traxels[n3];
+  without_count.features.erase("count");
+  traxels.set(n3, without_count);
+  BOOST_CHECK_THROW(compute_arc_features(g, false, extractors), std::runtime_error);
+  BOOST_CHECK(!table.contains(a12));
+
+  // without extractors the table only records the distances
+  compute_arc_features(g, true);
+  BOOST_CHECK_EQUAL(table.dimension(), 0u);
+  BOOST_CHECK(table.optical_correction());
+  BOOST_CHECK(table.contains(beyond));
+}
+
+// EOF
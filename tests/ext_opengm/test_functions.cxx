@@ -1,6 +1,7 @@
 #include "opengm/functions/constant.hxx"
 #include "pgmlink/ext_opengm/decorator_weighted.hxx"
 #include "pgmlink/ext_opengm/indicator_function.hxx"
+#include "pgmlink/ext_opengm/sparse_table_function.hxx"
 
 #include <opengm/unittests/test.hxx>
 
@@ -50,6 +51,34 @@ struct FunctionsTest {
       OPENGM_TEST_EQUAL(f(arg2), 2);
   }
 
+  void testSparseTableFunction() {
+      std::cout << "  * SparseTableFunction" << std::endl;
+      size_t shape[]={2,2,2,2};
+      opengm::SparseTableFunction<T> f(shape, shape+4, 9);
+      OPENGM_TEST_EQUAL(f.dimension(), 4);
+      OPENGM_TEST_EQUAL(f.shape(3), 2);
+      OPENGM_TEST_EQUAL(f.size(), 16);
+      OPENGM_TEST_EQUAL(f.numberOfEntries(), 0);
+
+      size_t zero[]={0,0,0,0};
+      size_t one[]={1,0,0,0};
+      size_t two[]={1,0,1,0};
+      size_t other[]={0,1,1,1};
+      f.set(zero, 0);
+      f.set(one, 3);
+      f.set(two, 5);
+      OPENGM_TEST_EQUAL(f.numberOfEntries(), 3);
+      OPENGM_TEST_EQUAL(f(zero), 0);
+      OPENGM_TEST_EQUAL(f(one), 3);
+      OPENGM_TEST_EQUAL(f(two), 5);
+      OPENGM_TEST_EQUAL(f(other), 9);
+
+      f.set(two, 4);
+      OPENGM_TEST_EQUAL(f.numberOfEntries(), 3);
+      OPENGM_TEST_EQUAL(f(two), 4);
+      testProperties( f );
+  }
+
   void testFunctionDecoratorWeighted() {
     std::cout << "  * FunctionDecoratorWeighted" << std::endl;
     double constant = 3;
@@ -119,6 +148,7 @@ struct FunctionsTest {
 
    void run() {
       testIndicatorFunction();
+      testSparseTableFunction();
       testFunctionDecoratorWeighted();
    }
 };
@@ -135,3 +135,57 @@ BOOST_AUTO_TEST_CASE( MultipleFeatureExtraction ) {
   }
 }
 
+
+BOOST_AUTO_TEST_CASE( PairwiseFeatureExtraction ) {
+  fe::MultipleFeatureExtraction::FeatureList flist;
+  flist["ElementWiseSquaredDistance"].push_back( "feat" );
+  flist["Ratio"].push_back( "feat" );
+  flist["SquaredDifference"].push_back( "feat" );
+  flist["AbsoluteDifference"].push_back( "other" );
+
+  std::vector<pgmlink::Traxel> traxels( 4 );
+  for ( size_t i = 0; i < traxels.size(); ++i ) {
+    pgmlink::feature_array feat( 3 );
+    feat[0] = i;
+    feat[1] = 2. * i + 1.;
+    feat[2] = 0.;
+    traxels[i].features["feat"] = feat;
+    traxels[i].features["other"] = pgmlink::feature_array( 1, 10. - i );
+  }
+
+  fe::PairwiseFeatureExtraction extraction( flist );
+  BOOST_REQUIRE_EQUAL( extraction.set_layout( traxels[0], traxels[1] ), 10u );
+  BOOST_CHECK_EQUAL( extraction.names().size(), 4u );
+
+  std::vector<fe::PairwiseFeatureExtraction::TraxelPair> pairs;
+  pairs.push_back( std::make_pair( &traxels[0], &traxels[1] ) );
+  pairs.push_back( std::make_pair( &traxels[3], &traxels[1] ) );
+  pairs.push_back( std::make_pair( &traxels[2], static_cast<const pgmlink::Traxel*>( NULL ) ) );
+  pairs.push_back( std::make_pair( &traxels[2], &traxels[2] ) );
+  std::vector<double> out( pairs.size() * extraction.dimension(), -1. );
+  extraction( &pairs[0], pairs.size(), &out[0] );
+
+  // the same values as the pairwise extraction
+  fe::MultipleFeatureExtraction ex;
+  for ( size_t row = 0; row < pairs.size(); ++row ) {
+    if ( pairs[row].second == NULL ) {
+      for ( size_t col = 0; col < extraction.dimension(); ++col ) {
+        BOOST_CHECK_EQUAL( out[row * extraction.dimension() + col], -1. );
+      }
+      continue;
+    }
+    fe::MultipleFeatureExtraction::CombinedFeatureMap cmap = ex( flist, *pairs[row].first, *pairs[row].second );
+    std::vector<double> expected;
+    for ( fe::MultipleFeatureExtraction::CombinedFeatureMap::const_iterator res = cmap.begin(); res != cmap.end(); ++res ) {
+      expected.insert( expected.end(), res->second.begin(), res->second.end() );
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS( out.begin() + row * extraction.dimension(), out.begin() + ( row + 1 ) * extraction.dimension(),
+                                   expected.begin(), expected.end() );
+  }
+
+  // features differing from the layout are reported
+  traxels[3].features["feat"].push_back( 1. );
+  BOOST_CHECK_THROW( extraction( &pairs[0], pairs.size(), &out[0] ), std::runtime_error );
+  traxels[3].features.erase( "other" );
+  BOOST_CHECK_THROW( extraction( &pairs[0], pairs.size(), &out[0] ), std::runtime_error );
+}
@@ -118,4 +118,59 @@ BOOST_AUTO_TEST_CASE( SpatialDistanceToBorder )
 	BOOST_CHECK_EQUAL(cost_fn(t6), 25.);
 }
 
+BOOST_AUTO_TEST_CASE( Batch_energies_match_scalar )
+{
+    const size_t n = 5;
+    double probs[n] = { 0., 1e-12, 0.25, 0.5, 1. };
+    double distances[n] = { 0., 1., 2.5, 10., 100. };
+    double energies[n];
+
+    NegLnDetection detection(10);
+    NegLnDivision division(2);
+    NegLnTransition transition(3);
+
+    detection(probs, n, energies);
+    for (size_t i = 0; i < n; ++i) {
+        Traxel tr;
+        feature_array det(feature_array::difference_type(1));
+        det[0] = probs[i];
+        tr.features["detProb"] = det;
+        BOOST_CHECK_CLOSE(energies[i], detection(tr, 0), 1e-8);
+    }
+
+    for (size_t state = 0; state <= 1; ++state) {
+        division(probs, n, state, energies);
+        for (size_t i = 0; i < n; ++i) {
+            Traxel tr;
+            feature_array div(feature_array::difference_type(1));
+            div[0] = probs[i];
+            tr.features["divProb"] = div;
+            BOOST_CHECK_CLOSE(energies[i], division(tr, state), 1e-8);
+        }
+    }
+
+    transition(probs, n, energies);
+    for (size_t i = 0; i < n; ++i) {
+        BOOST_CHECK_CLOSE(energies[i], transition(probs[i]), 1e-8);
+    }
+    for (size_t state = 0; state <= 2; ++state) {
+        transition(distances, n, 5., state, energies);
+        for (size_t i = 0; i < n; ++i) {
+            double prob = exp(-distances[i] / 5.);
+            BOOST_CHECK_CLOSE(energies[i], transition(state == 0 ? 1 - prob : prob), 1e-8);
+        }
+    }
+
+    FieldOfView fov(0, 0, 0, 0, 1, 10, 10, 0);
+    SpatialBorderAwareWeight border(100, 2, false, fov);
+    double t[3] = { 0, 0, 0 };
+    double x[3] = { 1, 1, 0.5 };
+    double y[3] = { 1, 5, 7 };
+    double z[3] = { 0, 0, 0 };
+    border(t, x, y, z, 3, energies);
+    BOOST_CHECK_EQUAL(energies[0], 50.);
+    BOOST_CHECK_EQUAL(energies[1], 50.);
+    BOOST_CHECK_EQUAL(energies[2], 25.);
+}
+
 // EOF
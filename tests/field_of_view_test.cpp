@@ -70,3 +70,32 @@ BOOST_AUTO_TEST_CASE( FieldOfView_test ) {
   BOOST_CHECK_EQUAL(fov.temporal_margin( 0,0,0,0 ), 3);
   BOOST_CHECK_EQUAL(fov.temporal_margin( 3,2,2,7 ), 0);
 } 
+
+BOOST_AUTO_TEST_CASE( FieldOfView_batch_distance_to_border ) {
+  // 3d and 2d (lz == uz) field of view
+  FieldOfView fovs[] = { FieldOfView( 0,1,1,1, 5,10,12,6 ), FieldOfView( 0,0,0,0, 5,10,10,0 ) };
+  const size_t n = 6;
+  double x[n] = { 1, 5, 9, 0.5, 20, 3 };
+  double y[n] = { 1, 5, 11.5, 7, 5, 4 };
+  double z[n] = { 1, 2, 3, 0, 0, 5.5 };
+  double distances[n];
+
+  for (size_t f = 0; f < 2; ++f) {
+    for (size_t relative = 0; relative <= 1; ++relative) {
+      fovs[f].spatial_distance_to_border(x, y, z, n, relative, distances);
+      for (size_t i = 0; i < n; ++i) {
+        BOOST_CHECK_EQUAL(distances[i], fovs[f].spatial_distance_to_border(0, x[i], y[i], z[i], relative));
+      }
+    }
+  }
+
+  fovs[0].spatial_distance_to_border(x, y, z, n, false, distances);
+  BOOST_CHECK_EQUAL(distances[0], 0.);
+  BOOST_CHECK_EQUAL(distances[1], 1.);
+  BOOST_CHECK_EQUAL(distances[5], 0.5);
+  fovs[1].spatial_distance_to_border(x, y, z, n, false, distances);
+  BOOST_CHECK_EQUAL(distances[3], 0.5);
+  BOOST_CHECK_EQUAL(distances[4], 5.);
+}
+
+// EOF
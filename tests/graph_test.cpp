@@ -27,6 +27,18 @@ struct property_map<node_testprop, Graph> {
 };
 template <typename Graph>
 const std::string property_map<node_testprop,Graph>::name = "node_testprop";
+
+// dense graph property stored in a compile time slot
+struct node_slotprop {};
+template <typename Graph>
+struct property_map<node_slotprop, Graph> {
+  typedef typename Graph::template NodeMap<int> type;
+  static const std::string name;
+};
+template <typename Graph>
+const std::string property_map<node_slotprop,Graph>::name = "node_slotprop";
+template <>
+struct property_slot<node_slotprop> { static const int value = 3; };
 }
 
 BOOST_AUTO_TEST_CASE( PropertyGraph_add_get ) {
@@ -42,6 +54,26 @@ BOOST_AUTO_TEST_CASE( PropertyGraph_add_get ) {
   BOOST_CHECK_EQUAL(other_m[n], 72);
 }
 
+BOOST_AUTO_TEST_CASE( PropertyGraph_slot_add_get ) {
+  typedef PropertyGraph<lemon::ListDigraph> prop_graph;
+  prop_graph g;
+  prop_graph::base_graph::Node n = g.addNode();
+  BOOST_CHECK(!g.has_property(node_slotprop()));
+  BOOST_CHECK_THROW(g.get(node_slotprop()), std::runtime_error);
+
+  g.add(node_slotprop()).add(node_testprop());
+  BOOST_CHECK(g.has_property(node_slotprop()));
+  BOOST_CHECK_EQUAL(g.properties().count("node_slotprop"), 1);
+  property_map<node_slotprop,prop_graph::base_graph>::type& m 
+    = g.get(node_slotprop());
+  m.set(n, 42);
+
+  // adding an existing property keeps the old map
+  g.add(node_slotprop());
+  BOOST_CHECK_EQUAL(g.get(node_slotprop())[n], 42);
+  BOOST_CHECK_EQUAL(&g.get(node_slotprop()), &m);
+}
+
 BOOST_AUTO_TEST_CASE( PropertyGraph_addNode ) {
     PropertyGraph<lemon::ListDigraph> graph;
     graph.addNode();
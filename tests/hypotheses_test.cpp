@@ -14,6 +14,8 @@
 #include <lemon/maps.h>
 
 #include "pgmlink/hypotheses.h"
+#include "pgmlink/hypotheses_overlay.h"
+#include "pgmlink/hypotheses_snapshot.h"
 #include "pgmlink/traxels.h"
 
 using namespace pgmlink;
@@ -25,6 +27,142 @@ BOOST_AUTO_TEST_CASE( HypothesesGraph_add_node ) {
     graph.add_node(13);
 }
 
+BOOST_AUTO_TEST_CASE( HypothesesGraphSnapshot_freeze ) {
+  HypothesesGraph g;
+  HypothesesGraph::Node n00 = g.add_node(0);
+  HypothesesGraph::Node n01 = g.add_node(1);
+  HypothesesGraph::Node n11 = g.add_node(1);
+  HypothesesGraph::Node n03 = g.add_node(3);
+  HypothesesGraph::Arc a0 = g.addArc(n00, n01);
+  HypothesesGraph::Arc a1 = g.addArc(n00, n11);
+  HypothesesGraph::Arc a2 = g.addArc(n11, n03);
+
+  boost::shared_ptr<const HypothesesGraphSnapshot> s = freeze(g);
+  BOOST_CHECK_EQUAL(s->node_count(), 4);
+  BOOST_CHECK_EQUAL(s->arc_count(), 3);
+  BOOST_CHECK_EQUAL(s->earliest_timestep(), 0);
+  BOOST_CHECK_EQUAL(s->latest_timestep(), 3);
+
+  // adjacency agrees with the lemon graph
+  for (HypothesesGraph::NodeIt n(g); n != lemon::INVALID; ++n) {
+    HypothesesGraphSnapshot::index_type i = s->node_index(n);
+    BOOST_CHECK(s->node(i) == n);
+    BOOST_CHECK_EQUAL(s->out_degree(i), static_cast<size_t>(lemon::countOutArcs(g, n)));
+    BOOST_CHECK_EQUAL(s->in_degree(i), static_cast<size_t>(lemon::countInArcs(g, n)));
+    for (HypothesesGraphSnapshot::index_iterator a = s->out_begin(i); a != s->out_end(i); ++a) {
+      BOOST_CHECK(g.source(s->arc(*a)) == n);
+      BOOST_CHECK_EQUAL(s->source(*a), i);
+    }
+  }
+  BOOST_CHECK(s->node(s->target(s->arc_index(a0))) == n01);
+  BOOST_CHECK(s->node(s->target(s->arc_index(a1))) == n11);
+  BOOST_CHECK(s->node(s->source(s->arc_index(a2))) == n11);
+
+  // per timestep ranges
+  BOOST_CHECK_EQUAL(s->timestep_end(0) - s->timestep_begin(0), 1);
+  BOOST_CHECK_EQUAL(s->timestep_end(1) - s->timestep_begin(1), 2);
+  BOOST_CHECK(s->timestep_begin(2) == s->timestep_end(2));
+  BOOST_CHECK_EQUAL(s->timestep_end(3) - s->timestep_begin(3), 1);
+  BOOST_CHECK(s->node(*s->timestep_begin(3)) == n03);
+  BOOST_CHECK(s->timestep_begin(4) == s->timestep_end(4));
+}
+
+BOOST_AUTO_TEST_CASE( ActiveSubgraph_matches_prune_inactive ) {
+  // t=0    1      2
+  //  00 - 01 --- 02
+  //     ` 11 -´       (11 and its arcs inactive)
+  HypothesesGraph g;
+  g.add(node_traxel()).add(node_active2()).add(arc_active());
+  HypothesesGraph::Node n00 = g.add_node(0);
+  HypothesesGraph::Node n01 = g.add_node(1);
+  HypothesesGraph::Node n11 = g.add_node(1);
+  HypothesesGraph::Node n02 = g.add_node(2);
+  HypothesesGraph::Arc a1 = g.addArc(n00, n01);
+  HypothesesGraph::Arc a2 = g.addArc(n00, n11);
+  HypothesesGraph::Arc a3 = g.addArc(n01, n02);
+  HypothesesGraph::Arc a4 = g.addArc(n11, n02);
+
+  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+  property_map<node_active2, HypothesesGraph::base_graph>::type& active_map = g.get(node_active2());
+  property_map<arc_active, HypothesesGraph::base_graph>::type& arc_active_map = g.get(arc_active());
+  traxel_map.set(n00, Traxel(1, 0));
+  traxel_map.set(n01, Traxel(1, 1));
+  traxel_map.set(n11, Traxel(2, 1));
+  traxel_map.set(n02, Traxel(1, 2));
+  active_map.set(n00, 1);
+  active_map.set(n01, 1);
+  active_map.set(n11, 0);
+  active_map.set(n02, 1);
+  arc_active_map.set(a1, true);
+  arc_active_map.set(a2, false);
+  arc_active_map.set(a3, true);
+  arc_active_map.set(a4, false);
+
+  HypothesesGraph pruned;
+  HypothesesGraph::copy(g, pruned);
+  prune_inactive(pruned);
+
+  const ActiveSubgraph view(g);
+  BOOST_CHECK_EQUAL(lemon::countNodes(view), 3);
+  BOOST_CHECK_EQUAL(lemon::countArcs(view), 2);
+  BOOST_CHECK(*events(view) == *events(pruned));
+  BOOST_CHECK(*state_of_nodes(view) == *state_of_nodes(pruned));
+
+  // the graph keeps its hypotheses and the view follows the activity maps
+  BOOST_CHECK_EQUAL(lemon::countNodes(g), 4);
+  BOOST_CHECK_EQUAL(lemon::countArcs(g), 4);
+  active_map.set(n11, 1);
+  arc_active_map.set(a2, true);
+  BOOST_CHECK_EQUAL(lemon::countNodes(view), 4);
+  BOOST_CHECK_EQUAL(lemon::countArcs(view), 3);
+  BOOST_CHECK_EQUAL(lemon::countNodes(ActiveSubgraph(view)), 4);
+}
+
+BOOST_AUTO_TEST_CASE( HypothesesGraphOverlay_revert ) {
+  HypothesesGraph g;
+  g.add(node_traxel()).add(node_active2()).add(arc_active()).add(node_originated_from());
+  HypothesesGraph::Node n0 = g.add_node(0);
+  HypothesesGraph::Node n1 = g.add_node(1);
+  HypothesesGraph::Arc a01 = g.addArc(n0, n1);
+  g.get(node_traxel()).set(n1, Traxel(5, 1));
+  g.get(node_active2()).set(n1, 2);
+  g.get(arc_active()).set(a01, true);
+
+  {
+    HypothesesGraphOverlay overlay(g);
+    BOOST_CHECK_EQUAL(&overlay.graph(), &g);
+    HypothesesGraph::Node n2 = g.add_node(1);
+    HypothesesGraph::Arc a02 = g.addArc(n0, n2);
+    BOOST_CHECK(overlay.added(n2));
+    BOOST_CHECK(overlay.added(a02));
+    BOOST_CHECK(!overlay.added(n1));
+
+    overlay.set(node_active2(), n1, 0);
+    overlay.set(node_active2(), n1, 1);
+    overlay.set(arc_active(), a01, false);
+    overlay.set(arc_active(), a02, true);
+    overlay.set(node_originated_from(), n2, vector<unsigned int>(1, 5));
+    overlay.set_traxel(n1, Traxel(6, 1));
+    overlay.set_traxel(n2, Traxel(7, 1));
+    BOOST_CHECK_EQUAL(overlay.added_node_count(), 1u);
+    BOOST_CHECK_EQUAL(overlay.added_arc_count(), 1u);
+    // only the first change of an original item is recorded
+    BOOST_CHECK_EQUAL(overlay.changed_value_count(), 3u);
+    BOOST_CHECK_EQUAL(g.get(node_active2())[n1], 1u);
+    BOOST_CHECK_EQUAL(g.get(node_traxel())[n1].Id, 6u);
+    BOOST_CHECK_EQUAL(lemon::countNodes(g), 3);
+  }
+
+  BOOST_CHECK_EQUAL(lemon::countNodes(g), 2);
+  BOOST_CHECK_EQUAL(lemon::countArcs(g), 1);
+  BOOST_CHECK_EQUAL(g.get(node_active2())[n1], 2u);
+  BOOST_CHECK(g.get(arc_active())[a01]);
+  BOOST_CHECK_EQUAL(g.get(node_traxel())[n1].Id, 5u);
+  // a node reusing the id of an erased one does not inherit its properties
+  HypothesesGraph::Node n3 = g.add_node(1);
+  BOOST_CHECK(g.get(node_originated_from())[n3].empty());
+}
+
 BOOST_AUTO_TEST_CASE( HypothesesGraph_serialize ) {
   HypothesesGraph g;
   HypothesesGraph::Node n00 = g.add_node(0);
@@ -94,6 +232,72 @@ BOOST_AUTO_TEST_CASE( HypothesesGraph_serialize ) {
   
 }
 
+BOOST_AUTO_TEST_CASE( HypothesesGraph_binary_serialization ) {
+  HypothesesGraph g;
+  HypothesesGraph::Node n00 = g.add_node(0);
+  HypothesesGraph::Node gap = g.add_node(0);
+  HypothesesGraph::Node n01 = g.add_node(1);
+  HypothesesGraph::Node n11 = g.add_node(1);
+  HypothesesGraph::Arc a0 = g.addArc(n00, n01);
+  HypothesesGraph::Arc a_gap = g.addArc(n00, gap);
+  HypothesesGraph::Arc a1 = g.addArc(n00, n11);
+  g.erase(a_gap);
+  g.erase(gap);
+
+  TraxelStore ts;
+  Traxel tr00(5, 0), tr01(7, 1), tr11(9, 1);
+  tr00.features["com"] = feature_array(3, 1.);
+  add(ts, tr00);
+  add(ts, tr01);
+  add(ts, tr11);
+
+  g.add(node_traxel()).add(arc_distance()).add(node_active2());
+  g.get(node_traxel()).set(n00, tr00);
+  g.get(node_traxel()).set(n01, tr01);
+  g.get(node_traxel()).set(n11, tr11);
+  g.get(arc_distance()).set(a0, 1.5);
+  g.get(arc_distance()).set(a1, 2.5);
+  g.get(node_active2()).set(n00, 2);
+  g.get(node_active2()).set(n01, 1);
+  g.get(node_active2()).set(n11, 1);
+
+  for (int by_reference = 0; by_reference < 2; ++by_reference) {
+    stringstream ss(ios::in | ios::out | ios::binary);
+    write_binary(g, ss, by_reference);
+
+    // properties of the target graph that are not in the archive are dropped
+    HypothesesGraph loaded;
+    loaded.add(node_active()).add(node_traxel_ref());
+    read_binary(loaded, ss, &ts);
+
+    BOOST_CHECK_EQUAL(countNodes(loaded), 3);
+    BOOST_CHECK_EQUAL(countArcs(loaded), 2);
+    BOOST_CHECK(!loaded.valid(loaded.nodeFromId(g.id(gap))));
+    BOOST_CHECK(!loaded.valid(loaded.arcFromId(g.id(a_gap))));
+    HypothesesGraph::Arc l1 = loaded.arcFromId(g.id(a1));
+    BOOST_CHECK_EQUAL(loaded.id(loaded.source(l1)), g.id(n00));
+    BOOST_CHECK_EQUAL(loaded.id(loaded.target(l1)), g.id(n11));
+    BOOST_CHECK_EQUAL(loaded.get(arc_distance())[l1], 2.5);
+    BOOST_CHECK_EQUAL(loaded.get(node_timestep())[loaded.nodeFromId(g.id(n11))], 1);
+    BOOST_CHECK_EQUAL(loaded.get(node_active2())[loaded.nodeFromId(g.id(n00))], 2);
+    BOOST_CHECK(!loaded.has_property(node_active()));
+    const Traxel& loaded00 = NodeTraxels(loaded)[loaded.nodeFromId(g.id(n00))];
+    BOOST_CHECK_EQUAL(loaded00, tr00);
+    BOOST_CHECK_EQUAL(loaded00.features.find("com")->second[2], 1.);
+    // traxels saved by reference refer to the store again instead of being copied
+    BOOST_CHECK_EQUAL(loaded.has_property(node_traxel_ref()), by_reference == 1);
+    if (by_reference) {
+      BOOST_CHECK(&loaded00 == &*ts.get<by_timeid>().find(boost::make_tuple(0, 5u)));
+    }
+  }
+
+  // traxels stored by reference need a TraxelStore
+  stringstream ss(ios::in | ios::out | ios::binary);
+  write_binary(g, ss, true);
+  HypothesesGraph loaded;
+  BOOST_CHECK_THROW(read_binary(loaded, ss), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE( lgf_serialization ) {
   HypothesesGraph g;
   HypothesesGraph::Node n00 = g.add_node(0);
@@ -286,6 +490,64 @@ BOOST_AUTO_TEST_CASE( SingleTimestepTraxel_HypothesesBuilder_build_forward_backw
 }
 
 
+BOOST_AUTO_TEST_CASE( SingleTimestepTraxel_HypothesesBuilder_traxels_by_reference ) {
+    TraxelStore ts;
+    for (unsigned int i = 0; i < 3; ++i) {
+        for (int t = 0; t < 2; ++t) {
+            Traxel tr(i + 1, t);
+            tr.features["com"] = feature_array(3, 10. * i + t);
+            add(ts, tr);
+        }
+    }
+
+    SingleTimestepTraxel_HypothesesBuilder::Options copy_opts(2, 5);
+    SingleTimestepTraxel_HypothesesBuilder::Options ref_opts(copy_opts);
+    ref_opts.traxels_by_reference = true;
+    boost::shared_ptr<HypothesesGraph> copied(SingleTimestepTraxel_HypothesesBuilder(&ts, copy_opts).build());
+    boost::shared_ptr<HypothesesGraph> referring(SingleTimestepTraxel_HypothesesBuilder(&ts, ref_opts).build());
+    BOOST_CHECK(!copied->has_property(node_traxel_ref()));
+    BOOST_REQUIRE(referring->has_property(node_traxel_ref()));
+
+    // same topology, the traxels are not copied into node_traxel
+    BOOST_CHECK_EQUAL(countArcs(*referring), countArcs(*copied));
+    BOOST_CHECK_EQUAL(countArcs(*referring), 3);
+    NodeTraxels traxels(*referring);
+    for (HypothesesGraph::NodeIt n(*referring); n != lemon::INVALID; ++n) {
+        BOOST_CHECK(referring->get(node_traxel())[n].features.empty());
+        BOOST_CHECK_EQUAL(traxels[n].features.find("com")->second[0], 10. * (traxels[n].Id - 1) + traxels[n].Timestep);
+        BOOST_CHECK(&traxels[n] == &*ts.get<by_timeid>().find(boost::make_tuple(traxels[n].Timestep, traxels[n].Id)));
+    }
+    for (HypothesesGraph::ArcIt a(*referring); a != lemon::INVALID; ++a) {
+        BOOST_CHECK_EQUAL(traxels[referring->source(a)].Id, traxels[referring->target(a)].Id);
+    }
+
+    // modified traxels are stored in the graph
+    HypothesesGraph::Node n = HypothesesGraph::NodeIt(*referring);
+    Traxel modified = traxels[n];
+    modified.features["divProb"] = feature_array(1, 0.5);
+    traxels.set(n, modified);
+    BOOST_CHECK(referring->get(node_traxel_ref())[n] == NULL);
+    BOOST_CHECK_EQUAL(traxels[n].features.size(), 2u);
+    BOOST_CHECK_EQUAL(ts.get<by_timeid>().find(boost::make_tuple(modified.Timestep, modified.Id))->features.size(), 1u);
+
+    // traxels are resolved when serialized
+    stringstream ss(ios::in | ios::out | ios::binary);
+    write_binary(*referring, ss);
+    HypothesesGraph loaded;
+    read_binary(loaded, ss);
+    BOOST_CHECK(!loaded.has_property(node_traxel_ref()));
+    for (HypothesesGraph::NodeIt m(loaded); m != lemon::INVALID; ++m) {
+        BOOST_CHECK_EQUAL(loaded.get(node_traxel())[m], traxels[referring->nodeFromId(loaded.id(m))]);
+    }
+
+    copy_referenced_traxels(*referring);
+    for (HypothesesGraph::NodeIt m(*referring); m != lemon::INVALID; ++m) {
+        BOOST_CHECK(referring->get(node_traxel_ref())[m] == NULL);
+        BOOST_CHECK(!referring->get(node_traxel())[m].features.empty());
+    }
+}
+
+
 BOOST_AUTO_TEST_CASE( SingleTimestepTraxel_HypothesesBuilder_build_divisions ) {
     Traxel tr11, tr12, tr21, tr22, tr23;
     feature_array com11(3);
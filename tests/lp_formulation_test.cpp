@@ -0,0 +1,309 @@
+#define BOOST_TEST_MODULE lp_formulation_test
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include "pgmlink/lp_formulation.h"
+#include "pgmlink/lp_solver.h"
+
+using namespace pgmlink;
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( LinearProgram_rows ) {
+  lp::LinearProgram program;
+  BOOST_CHECK_EQUAL(program.column_count(), 0u);
+  BOOST_CHECK_EQUAL(program.row_count(), 0u);
+
+  BOOST_CHECK_EQUAL(program.add_column(0., 1., 2., true), 0u);
+  BOOST_CHECK_EQUAL(program.add_column(0., lp::infinity, -1., false), 1u);
+  BOOST_CHECK_EQUAL(program.add_column(-3., 3., 0., true), 2u);
+  BOOST_CHECK_THROW(program.add_column(1., 0., 0., false), std::invalid_argument);
+  BOOST_CHECK(program.has_integers());
+  program.add_objective(2, 0.5);
+  program.add_objective_offset(10.);
+
+  program.keep_row_names(true);
+  size_t idx0[] = {0, 1};
+  double coeff0[] = {1., 1.};
+  BOOST_CHECK_EQUAL(program.add_row(idx0, idx0 + 2, coeff0, 1., 1., "first"), 0u);
+  size_t idx1[] = {1, 2};
+  int coeff1[] = {2, -1};
+  BOOST_CHECK_EQUAL(program.add_row(idx1, idx1 + 2, coeff1, -lp::infinity, 0.), 1u);
+  size_t bad[] = {5};
+  BOOST_CHECK_THROW(program.add_row(bad, bad + 1, coeff0, 0., 0.), std::out_of_range);
+
+  BOOST_CHECK_EQUAL(program.row_count(), 2u);
+  BOOST_CHECK_EQUAL(program.nonzero_count(), 4u);
+  BOOST_CHECK_EQUAL(program.row_begin(1), 2u);
+  BOOST_CHECK_EQUAL(program.row_end(1), 4u);
+  BOOST_CHECK_EQUAL(program.row_columns()[3], 2u);
+  BOOST_CHECK_EQUAL(program.row_coefficients()[3], -1.);
+  BOOST_CHECK_EQUAL(program.row_name(0), "first");
+  BOOST_CHECK_EQUAL(program.row_name(1), "");
+
+  vector<double> x(3);
+  x[0] = 1.; x[1] = 0.; x[2] = 2.;
+  BOOST_CHECK(program.is_feasible(x));
+  BOOST_CHECK_CLOSE(program.evaluate(x), 2. + 1. + 10., 1e-9);
+  x[0] = 0.5; x[1] = 0.5;
+  BOOST_CHECK(!program.is_feasible(x)); // x[0] integer
+  x[0] = 0.; x[1] = 1.; x[2] = 1.;
+  BOOST_CHECK(!program.is_feasible(x)); // 2*x[1] - x[2] <= 0 violated
+}
+
+BOOST_AUTO_TEST_CASE( DiscreteFormulation_term_linearization ) {
+  lp::DiscreteFormulation f;
+  BOOST_CHECK_EQUAL(f.add_variable(3), 0u);
+  BOOST_CHECK_EQUAL(f.add_variable(3), 1u);
+  BOOST_CHECK_EQUAL(f.number_of_variables(), 2u);
+  BOOST_CHECK_EQUAL(f.column(1, 0), 3u);
+  BOOST_CHECK_THROW(f.column(1, 3), std::out_of_range);
+  BOOST_CHECK_EQUAL(f.program().row_count(), 2u); // one label per variable
+
+  double unary[] = {0., 1., 2.};
+  f.add_unary(0, unary);
+
+  // sparse term: diagonal and axes below, everything else at default 5
+  vector<lp::DiscreteFormulation::index_type> vars;
+  vars.push_back(0);
+  vars.push_back(1);
+  vector<size_t> labelings;
+  vector<double> values;
+  for (size_t s = 0; s < 3; ++s) {
+    labelings.push_back(s); labelings.push_back(s); values.push_back(-1. * s);
+    if (s > 0) {
+      labelings.push_back(s); labelings.push_back(0); values.push_back(7.);
+      labelings.push_back(0); labelings.push_back(s); values.push_back(5.); // equals default: no column
+    }
+  }
+  const size_t columns_before = f.program().column_count();
+  f.add_term(vars, labelings, values, 5.);
+  BOOST_CHECK_EQUAL(f.program().column_count(), columns_before + 5);
+
+  // every labeling of the two variables has a feasible completion with the intended objective
+  const lp::LinearProgram& p = f.program();
+  for (size_t a = 0; a < 3; ++a) {
+    for (size_t b = 0; b < 3; ++b) {
+      vector<double> x(p.column_count(), 0.);
+      x[f.column(0, a)] = 1.;
+      x[f.column(1, b)] = 1.;
+      // the optimal auxiliary columns are the products of their indicators
+      size_t z = columns_before;
+      double expected = unary[a] + 5.;
+      for (size_t e = 0; e < values.size(); ++e) {
+        if (values[e] == 5.) continue;
+        if (labelings[2 * e] == a && labelings[2 * e + 1] == b) {
+          x[z] = 1.;
+          expected = unary[a] + values[e];
+        }
+        ++z;
+      }
+      BOOST_CHECK(p.is_feasible(x));
+      BOOST_CHECK_CLOSE(p.evaluate(x) + 1., expected + 1., 1e-9);
+
+      vector<size_t> labels;
+      f.labeling(x, labels);
+      BOOST_CHECK_EQUAL(labels.size(), 2u);
+      BOOST_CHECK_EQUAL(labels[0], a);
+      BOOST_CHECK_EQUAL(labels[1], b);
+    }
+  }
+
+  // columns() is the inverse of labeling()
+  vector<size_t> labels(2);
+  labels[0] = 2; labels[1] = 0;
+  vector<double> y;
+  f.columns(labels, y);
+  BOOST_CHECK(p.is_feasible(y));
+  BOOST_CHECK_CLOSE(p.evaluate(y), unary[2] + 7., 1e-9);
+  vector<size_t> back;
+  f.labeling(y, back);
+  BOOST_CHECK(back == labels);
+  labels.push_back(0);
+  BOOST_CHECK_THROW(f.columns(labels, y), std::invalid_argument);
+
+  // a positive entry cannot be dodged by leaving its auxiliary column at zero
+  vector<double> x(p.column_count(), 0.);
+  x[f.column(0, 1)] = 1.;
+  x[f.column(1, 0)] = 1.;
+  BOOST_CHECK(!p.is_feasible(x));
+}
+
+BOOST_AUTO_TEST_CASE( create_solver_unknown_backend ) {
+  BOOST_CHECK_THROW(lp::create_solver("no such solver"), std::runtime_error);
+  const vector<string> names = lp::available_solvers();
+  for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    BOOST_CHECK_EQUAL(lp::create_solver(*it)->name(), *it);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Solver_small_milp ) {
+  // min 1 - x0 - 2*x1 - 0.5*y s.t. x0 + x1 <= 1.5, y <= x0, y <= 0.75, x binary
+  lp::LinearProgram p;
+  p.add_column(0., 1., -1., true);
+  p.add_column(0., 1., -2., true);
+  p.add_column(0., 0.75, -0.5, false);
+  p.add_objective_offset(1.);
+  size_t idx0[] = {0, 1};
+  double coeff0[] = {1., 1.};
+  p.add_row(idx0, idx0 + 2, coeff0, -lp::infinity, 1.5);
+  size_t idx1[] = {2, 0};
+  double coeff1[] = {1., -1.};
+  p.add_row(idx1, idx1 + 2, coeff1, -lp::infinity, 0.);
+
+  lp::SolverParameters param;
+  param.ep_gap = 0.;
+  const vector<string> names = lp::available_solvers();
+  for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    const lp::Solution solution = lp::create_solver(*it)->solve(p, param);
+    BOOST_CHECK_EQUAL(solution.status, lp::optimal);
+    BOOST_REQUIRE(solution.has_values());
+    BOOST_CHECK_CLOSE(solution.values[0], 0., 1e-6);
+    BOOST_CHECK_CLOSE(solution.values[1], 1., 1e-6);
+    BOOST_CHECK_CLOSE(solution.objective, -1., 1e-6);
+    BOOST_CHECK(solution.bound <= solution.objective + 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Solver_relaxation ) {
+  // min -x0 - x1 s.t. 2 x0 + 2 x1 <= 3, x binary: the relaxation splits the half unit
+  lp::LinearProgram p;
+  p.add_column(0., 1., -1., true);
+  p.add_column(0., 1., -1., true);
+  size_t idx[] = {0, 1};
+  double coeff[] = {2., 2.};
+  p.add_row(idx, idx + 2, coeff, -lp::infinity, 3.);
+
+  lp::SolverParameters param;
+  param.ep_gap = 0.;
+  const vector<string> names = lp::available_solvers();
+  for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    param.relaxation = true;
+    const lp::Solution relaxed = lp::create_solver(*it)->solve(p, param);
+    BOOST_CHECK_EQUAL(relaxed.status, lp::optimal);
+    BOOST_REQUIRE(relaxed.has_values());
+    BOOST_CHECK_CLOSE(relaxed.objective, -1.5, 1e-6);
+    // a vertex of the relaxation: one column at 1, the other at 0.5
+    BOOST_CHECK_CLOSE(relaxed.values[0] + relaxed.values[1], 1.5, 1e-6);
+    BOOST_CHECK_CLOSE(std::min(relaxed.values[0], relaxed.values[1]), 0.5, 1e-6);
+
+    param.relaxation = false;
+    lp::Solution exact = lp::create_solver(*it)->solve(p, param);
+    BOOST_CHECK_EQUAL(exact.status, lp::optimal);
+    BOOST_REQUIRE(exact.has_values());
+    BOOST_CHECK_CLOSE(exact.objective, -1., 1e-6);
+    BOOST_CHECK_CLOSE(exact.values[0] + exact.values[1], 1., 1e-6);
+
+    // gap of the integer solution with respect to the relaxation
+    exact.bound = relaxed.objective;
+    BOOST_CHECK_CLOSE(exact.gap(), 0.5, 1e-6);
+  }
+}
+
+namespace {
+struct IncumbentRecorder {
+  explicit IncumbentRecorder(vector<lp::Progress>* incumbents) : incumbents_(incumbents) {}
+  void operator()(const lp::Progress& progress) { incumbents_->push_back(progress); }
+  vector<lp::Progress>* incumbents_;
+};
+}
+
+BOOST_AUTO_TEST_CASE( StoppingRules ) {
+  lp::Progress progress;
+  BOOST_CHECK(progress.objective >= lp::infinity);
+  progress.elapsed = 10.;
+
+  lp::WallClock clock(5.);
+  BOOST_CHECK(!clock(progress)); // no incumbent yet
+  progress.objective = 2.;
+  progress.bound = 1.;
+  progress.gap = 0.5;
+  BOOST_CHECK(clock(progress));
+  progress.elapsed = 1.;
+  BOOST_CHECK(!clock(progress));
+
+  lp::GapPlateau plateau(0.1, 3.);
+  BOOST_CHECK(!plateau(progress));  // t = 1, gap 0.5: reference
+  progress.elapsed = 3.;
+  progress.gap = 0.45;
+  BOOST_CHECK(!plateau(progress));  // too little improvement, but only 2s
+  progress.elapsed = 3.5;
+  progress.gap = 0.3;
+  BOOST_CHECK(!plateau(progress));  // improved: new reference
+  progress.elapsed = 6.;
+  BOOST_CHECK(!plateau(progress));
+  progress.elapsed = 6.5;
+  BOOST_CHECK(plateau(progress));
+
+  // rules and callbacks leave a search that finishes in time untouched
+  lp::LinearProgram p;
+  p.add_column(0., 1., -1., true);
+  p.add_column(0., 1., -2., true);
+  size_t idx[] = {0, 1};
+  double coeff[] = {1., 1.};
+  p.add_row(idx, idx + 2, coeff, -lp::infinity, 1.);
+  lp::SolverParameters param;
+  param.ep_gap = 0.;
+  param.stopping_rules.push_back(lp::GapPlateau(0., 1e6));
+  const vector<string> names = lp::available_solvers();
+  for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    vector<lp::Progress> incumbents;
+    param.on_incumbent = IncumbentRecorder(&incumbents);
+    const lp::Solution solution = lp::create_solver(*it)->solve(p, param);
+    BOOST_CHECK_EQUAL(solution.status, lp::optimal);
+    BOOST_CHECK_CLOSE(solution.objective, -2., 1e-6);
+    for (size_t i = 1; i < incumbents.size(); ++i) {
+      BOOST_CHECK(incumbents[i].objective < incumbents[i - 1].objective);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( SolverParameters_settings ) {
+  lp::SolverSettings settings;
+  BOOST_CHECK_EQUAL(settings.threads, 0);
+  BOOST_CHECK_EQUAL(settings.memory_limit, 0.);
+  BOOST_CHECK(settings.node_file_dir.empty());
+  settings.threads = 1;
+  settings.memory_limit = 256.;
+  settings.emphasis = lp::emphasis_feasibility;
+  settings.presolve = lp::presolve_off;
+
+  lp::SolverParameters param(settings);
+  BOOST_CHECK_EQUAL(param.threads, 1);
+  BOOST_CHECK_EQUAL(param.memory_limit, 256.);
+  BOOST_CHECK_EQUAL(param.emphasis, lp::emphasis_feasibility);
+  BOOST_CHECK_EQUAL(param.presolve, lp::presolve_off);
+  BOOST_CHECK_EQUAL(param.ep_gap, 0.01);
+
+  // the settings change the search, not the optimum
+  lp::DiscreteFormulation f;
+  f.add_variable(3);
+  f.add_variable(2);
+  double unary0[] = {3., 1., 1.5};
+  double unary1[] = {0., -1.};
+  f.add_unary(0, unary0);
+  f.add_unary(1, unary1);
+  vector<lp::DiscreteFormulation::index_type> vars;
+  vars.push_back(0);
+  vars.push_back(1);
+  vector<size_t> labelings;
+  labelings.push_back(1); labelings.push_back(1);
+  vector<double> values(1, 10.);
+  f.add_term(vars, labelings, values, 0.);
+
+  param.ep_gap = 0.;
+  const vector<string> names = lp::available_solvers();
+  for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    const lp::Solution solution = lp::create_solver(*it)->solve(f.program(), param);
+    BOOST_REQUIRE(solution.has_values());
+    vector<size_t> labels;
+    f.labeling(solution.values, labels);
+    BOOST_CHECK_EQUAL(labels[0], 2u);
+    BOOST_CHECK_EQUAL(labels[1], 1u);
+    BOOST_CHECK_CLOSE(solution.objective, 0.5, 1e-6);
+  }
+}
@@ -807,6 +807,81 @@ BOOST_AUTO_TEST_CASE( MergerResolver_deactivate_nodes ) {
 }
 
 
+BOOST_AUTO_TEST_CASE( MergerResolver_resolve_mergers_overlay ) {
+  HypothesesGraph g;
+  g.add(node_traxel()).add(arc_distance()).add(arc_active()).add(node_active2());
+  //  t=1      2
+  //    o ----
+  //          |
+  //           O
+  //          |
+  //    o ----
+  feature_array com(3,0);
+  feature_array pCOM(6*3, 0);
+  pCOM[0]  = 3;
+  pCOM[3]  = 1;
+  pCOM[6]  = 6;
+  pCOM[9]  = 1;
+  pCOM[12] = 3;
+  pCOM[16] = 6;
+
+  Traxel t11;
+  t11.Timestep = 1;
+  t11.Id = 11;
+  com[0] = 1; t11.features["com"] = com;
+  Traxel t12 = t11;
+  t12.Id = 12;
+  t12.features["com"][0] = 6;
+  Traxel t21;
+  t21.Timestep = 2;
+  t21.Id = 21;
+  com[0] = 3; t21.features["com"] = com;
+  t21.features["possibleCOMs"] = pCOM;
+
+  HypothesesGraph::Node n11 = g.add_node(1);
+  HypothesesGraph::Node n12 = g.add_node(1);
+  HypothesesGraph::Node n21 = g.add_node(2);
+  HypothesesGraph::Arc a11_21 = g.addArc(n11, n21);
+  HypothesesGraph::Arc a12_21 = g.addArc(n12, n21);
+
+  property_map<node_traxel, HypothesesGraph::base_graph>::type& traxel_map = g.get(node_traxel());
+  traxel_map.set(n11, t11);
+  traxel_map.set(n12, t12);
+  traxel_map.set(n21, t21);
+  property_map<arc_active, HypothesesGraph::base_graph>::type& arc_map = g.get(arc_active());
+  arc_map.set(a11_21, true);
+  arc_map.set(a12_21, true);
+  property_map<node_active2, HypothesesGraph::base_graph>::type& active_map = g.get(node_active2());
+  active_map.set(n11, 1);
+  active_map.set(n12, 1);
+  active_map.set(n21, 2);
+
+  {
+    HypothesesGraphOverlay overlay(g);
+    MergerResolver m(&overlay);
+    FeatureExtractorMCOMsFromPCOMs extractor;
+    DistanceFromCOMs distance;
+    FeatureHandlerFromTraxels handler(extractor, distance);
+    m.resolve_mergers(handler);
+
+    // two replacement nodes with two arcs each
+    BOOST_CHECK_EQUAL(overlay.added_node_count(), 2u);
+    BOOST_CHECK_EQUAL(overlay.added_arc_count(), 4u);
+    BOOST_CHECK_EQUAL(active_map[n21], 0u);
+    BOOST_CHECK(!arc_map[a11_21]);
+    BOOST_CHECK_EQUAL(lemon::countNodes(ActiveSubgraph(g)), 4);
+  }
+
+  // the original hypotheses are restored
+  BOOST_CHECK_EQUAL(lemon::countNodes(g), 3);
+  BOOST_CHECK_EQUAL(lemon::countArcs(g), 2);
+  BOOST_CHECK_EQUAL(active_map[n21], 2u);
+  BOOST_CHECK(arc_map[a11_21]);
+  BOOST_CHECK(arc_map[a12_21]);
+  BOOST_CHECK(g.get(merger_resolved_to())[n21].empty());
+}
+
+
 BOOST_AUTO_TEST_CASE( MergerResolver_get_max_id ) {
   // get_max_id(int ts)
 
@@ -0,0 +1,99 @@
+#define BOOST_TEST_MODULE reasoner_assignment_test
+
+#include <vector>
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "pgmlink/hypotheses.h"
+#include "pgmlink/reasoner_assignment.h"
+#include "pgmlink/tracking.h"
+#include "pgmlink/traxels.h"
+
+using namespace pgmlink;
+using namespace std;
+
+namespace {
+void add_traxel(TraxelStore& ts, unsigned int id, int timestep, double x, double y, float div_prob) {
+	Traxel tr;
+	tr.Id = id;
+	tr.Timestep = timestep;
+	feature_array com(feature_array::difference_type(3));
+	com[0] = x; com[1] = y; com[2] = 0;
+	feature_array divProb(feature_array::difference_type(1));
+	divProb[0] = div_prob;
+	tr.features["com"] = com;
+	tr.features["divProb"] = divProb;
+	add(ts, tr);
+}
+}
+
+BOOST_AUTO_TEST_CASE( NNTracking_move_and_division ) {
+	//  t=1        2
+	//  1 ------- 10
+	//    `------ 12   (divProb of 1 is high)
+	//  2 ------- 11
+	TraxelStore ts;
+	add_traxel(ts, 1, 1, 0, 0, 0.9);
+	add_traxel(ts, 2, 1, 20, 0, 0.1);
+	add_traxel(ts, 10, 2, 1, 0, 0.1);
+	add_traxel(ts, 11, 2, 21, 0, 0.1);
+	add_traxel(ts, 12, 2, 0, 3, 0.1);
+
+	NNTracking tracking(10, // divDist
+			    10  // movDist
+			    );
+	vector<vector<Event> > events = tracking(ts);
+
+	BOOST_REQUIRE_EQUAL(events.size(), 2u);
+	size_t moves = 0, divisions = 0;
+	for (vector<Event>::const_iterator e = events[1].begin(); e != events[1].end(); ++e) {
+		if (e->type == Event::Move) {
+			++moves;
+			BOOST_CHECK_EQUAL(e->traxel_ids[0], 2u);
+			BOOST_CHECK_EQUAL(e->traxel_ids[1], 11u);
+		} else if (e->type == Event::Division) {
+			++divisions;
+			BOOST_CHECK_EQUAL(e->traxel_ids[0], 1u);
+			BOOST_CHECK((e->traxel_ids[1] == 10u && e->traxel_ids[2] == 12u) ||
+				    (e->traxel_ids[1] == 12u && e->traxel_ids[2] == 10u));
+		} else {
+			BOOST_ERROR("unexpected event " << *e);
+		}
+	}
+	BOOST_CHECK_EQUAL(moves, 1u);
+	BOOST_CHECK_EQUAL(divisions, 1u);
+
+	vector<map<unsigned int, bool> > detections = tracking.detections();
+	BOOST_CHECK_EQUAL(detections.size(), 2u);
+	BOOST_CHECK(detections[1][12]);
+}
+
+BOOST_AUTO_TEST_CASE( AssignmentTracking_minimal_total_distance ) {
+	// greedy would take the shortest arc 2 -> 10 first and then 1 -> 11
+	//  t=1: 1 at x=0, 2 at x=3;  t=2: 10 at x=2, 11 at x=5.5
+	TraxelStore ts;
+	add_traxel(ts, 1, 1, 0, 0, 0.);
+	add_traxel(ts, 2, 1, 3, 0, 0.);
+	add_traxel(ts, 10, 2, 2, 0, 0.);
+	add_traxel(ts, 11, 2, 5.5, 0, 0.);
+
+	SingleTimestepTraxel_HypothesesBuilder builder(&ts, SingleTimestepTraxel_HypothesesBuilder::Options(2, 10));
+	boost::shared_ptr<HypothesesGraph> graph(builder.build());
+
+	AssignmentTracking reasoner(10, 10, 1.);
+	reasoner.formulate(*graph);
+	reasoner.infer();
+	reasoner.conclude(*graph);
+	prune_inactive(*graph);
+	vector<vector<Event> > events = *pgmlink::events(*graph);
+
+	BOOST_REQUIRE_EQUAL(events.size(), 2u);
+	BOOST_CHECK_EQUAL(events[1].size(), 2u);
+	for (vector<Event>::const_iterator e = events[1].begin(); e != events[1].end(); ++e) {
+		BOOST_CHECK_EQUAL(e->type, Event::Move);
+		BOOST_CHECK((e->traxel_ids[0] == 1u && e->traxel_ids[1] == 10u) ||
+			    (e->traxel_ids[0] == 2u && e->traxel_ids[1] == 11u));
+	}
+}
@@ -291,6 +291,92 @@ BOOST_AUTO_TEST_CASE( Tracking_ConservationTracking_SimpleMove ) {
 }
 
 
+BOOST_AUTO_TEST_CASE( Tracking_ConservationTracking_Relaxation ) {
+	//  t=1      2
+	//  o ------ o
+	//         /
+	//  o ----
+	// The LP relaxation is fractional: it sends 1.11 to 1.33 objects along the
+	// upper arc and 1/3 along the lower one. Rounding yields the optimal
+	// tracking, whose energy is far above the relaxed bound.
+	TraxelStore ts;
+	Traxel n11, n12, n21;
+	feature_array com(feature_array::difference_type(3));
+	feature_array divProb(feature_array::difference_type(1));
+	feature_array detProb(feature_array::difference_type(3));
+	n11.Id = 1; n11.Timestep = 1; com[0] = 0; com[1] = 0; com[2] = 0; divProb[0] = 0.1;
+	detProb[0] = 0.1; detProb[1] = 0.5; detProb[2] = 0.4;
+	n11.features["com"] = com; n11.features["divProb"] = divProb; n11.features["detProb"] = detProb;
+	add(ts,n11);
+	n12.Id = 2; n12.Timestep = 1; com[0] = 6; com[1] = 0; com[2] = 0; divProb[0] = 0.5;
+	detProb[0] = 0.6; detProb[1] = 0.3; detProb[2] = 0.1;
+	n12.features["com"] = com; n12.features["divProb"] = divProb; n12.features["detProb"] = detProb;
+	add(ts,n12);
+	n21.Id = 10; n21.Timestep = 2; com[0] = 1; com[1] = 0; com[2] = 0; divProb[0] = 0.9;
+	detProb[0] = 0.6; detProb[1] = 0.3; detProb[2] = 0.1;
+	n21.features["com"] = com; n21.features["divProb"] = divProb; n21.features["detProb"] = detProb;
+	add(ts,n21);
+
+	FieldOfView fov(0, 0, 0, 0, 4, 10, 10, 10); // tlow, xlow, ylow, zlow, tup, xup, yup, zup
+	ConsTracking tracking = ConsTracking(
+					     2, // max_number_objects
+					     false, // detection_by_volume
+					     double(1.1), // avg_obj_size
+					     20, // max_neighbor_distance
+					     true, //with_divisions
+					     0.3, // division_threshold
+					     "none", // random_forest_filename
+					     fov
+				  );
+	shared_ptr<HypothesesGraph> graph = tracking.build_hypo_graph(ts);
+	BOOST_REQUIRE_EQUAL(lemon::countArcs(*graph), 2);
+
+	ConservationTracking pgm(
+			2, // max_number_objects
+			NegLnDetection(10), // detection
+			NegLnDivision(10), // division
+			NegLnTransition(10), // transition
+			0, // forbidden_cost
+			0.0, // ep_gap
+			false, // with_tracklets
+			true, // with_divisions
+			ConstantFeature(10.), // disappearance_cost
+			ConstantFeature(5.), // appearance_cost
+			true, // with_misdetections_allowed
+			true, // with_appearance
+			true, // with_disappearance
+			5, // transition_parameter
+			true, // with_constraints
+			1e75, // cplex_timeout
+			"", // solver_backend
+			lp::SolverSettings(),
+			true // with_relaxation
+			);
+	pgm.formulate(*graph);
+	pgm.infer();
+	pgm.conclude(*graph);
+
+	// the rounded labeling, not the integer program: its energy is only
+	// bounded by the relaxation
+	const lp::Solution& solution = pgm.lp_solution();
+	BOOST_CHECK_EQUAL(solution.status, lp::feasible);
+	BOOST_CHECK_CLOSE(solution.bound, 7.48896, 1e-3);
+	BOOST_CHECK_CLOSE(solution.objective, 30.66621, 1e-3);
+	BOOST_CHECK_CLOSE(solution.gap(), (30.66621 - 7.48896) / 30.66621, 1e-3);
+
+	// 1 -> 10 is kept, the fractional 2 -> 10 is rounded away
+	property_map<node_traxel, HypothesesGraph::base_graph>::type& traxels = graph->get(node_traxel());
+	property_map<node_active2, HypothesesGraph::base_graph>::type& active_nodes = graph->get(node_active2());
+	property_map<arc_active, HypothesesGraph::base_graph>::type& active_arcs = graph->get(arc_active());
+	for (HypothesesGraph::NodeIt n(*graph); n != lemon::INVALID; ++n) {
+		BOOST_CHECK_EQUAL(active_nodes[n], traxels[n].Id == 2 ? 0u : 1u);
+	}
+	for (HypothesesGraph::ArcIt a(*graph); a != lemon::INVALID; ++a) {
+		BOOST_CHECK_EQUAL(active_arcs[a], traxels[graph->source(a)].Id == 1);
+	}
+}
+
+
 BOOST_AUTO_TEST_CASE( Tracking_ConservationTracking_Merger_Volume ) {
 
 	std::cout << "Constructing HypothesesGraph" << std::endl;
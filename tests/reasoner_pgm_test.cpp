@@ -21,6 +21,7 @@
 #include "pgmlink/graph.h"
 #include "pgmlink/hypotheses.h"
 #include "pgmlink/feature.h"
+#include "pgmlink/lp_solver.h"
 #include "pgmlink/reasoner_pgm.h"
 #include "pgmlink/traxels.h"
 
@@ -134,17 +135,18 @@ BOOST_AUTO_TEST_CASE( HypothesesGraph_build_hyp2 ) {
   const pgm::OpengmModel::FactorType f = (*model)[model->factorOfVariable(det_var, 2)];
   BOOST_CHECK_EQUAL(f.numberOfVariables(), 3);
   BOOST_CHECK_EQUAL(f.size(), 8);
+  BOOST_CHECK_EQUAL(f.functionType(), 3); // sparse table
   BOOST_CHECK_EQUAL(f.shape(0), 2);
   BOOST_CHECK_EQUAL(f.shape(1), 2);
   BOOST_CHECK_EQUAL(f.shape(2), 2);
-  BOOST_CHECK_EQUAL(f.function<0>()(0,0,0), 0);
-  BOOST_CHECK_EQUAL(f.function<0>()(0,0,1), 8);
-  BOOST_CHECK_EQUAL(f.function<0>()(0,1,0), 8);
-  BOOST_CHECK_EQUAL(f.function<0>()(0,1,1), 8);
-  BOOST_CHECK_EQUAL(f.function<0>()(1,0,0), 3);
-  BOOST_CHECK_EQUAL(f.function<0>()(1,0,1), 0);
-  BOOST_CHECK_EQUAL(f.function<0>()(1,1,0), 0);
-  BOOST_CHECK_EQUAL(f.function<0>()(1,1,1), 8);
+  BOOST_CHECK_EQUAL(f.function<3>()(0,0,0), 0);
+  BOOST_CHECK_EQUAL(f.function<3>()(0,0,1), 8);
+  BOOST_CHECK_EQUAL(f.function<3>()(0,1,0), 8);
+  BOOST_CHECK_EQUAL(f.function<3>()(0,1,1), 8);
+  BOOST_CHECK_EQUAL(f.function<3>()(1,0,0), 3);
+  BOOST_CHECK_EQUAL(f.function<3>()(1,0,1), 0);
+  BOOST_CHECK_EQUAL(f.function<3>()(1,1,0), 0);
+  BOOST_CHECK_EQUAL(f.function<3>()(1,1,1), 8);
 
   // outgoing factor
   det_var = mrf.get_node_map().find(m4)->second;
@@ -152,17 +154,18 @@ BOOST_AUTO_TEST_CASE( HypothesesGraph_build_hyp2 ) {
   const pgm::OpengmModel::FactorType f2 = (*model)[model->factorOfVariable(det_var, 1)];
   BOOST_CHECK_EQUAL(f2.numberOfVariables(), 3);
   BOOST_CHECK_EQUAL(f2.size(), 8);
+  BOOST_CHECK_EQUAL(f2.functionType(), 3); // sparse table
   BOOST_CHECK_EQUAL(f2.shape(0), 2);
   BOOST_CHECK_EQUAL(f2.shape(1), 2);
   BOOST_CHECK_EQUAL(f2.shape(2), 2);
-  BOOST_CHECK_EQUAL(f2.function<0>()(0,0,0), 7);
-  BOOST_CHECK_EQUAL(f2.function<0>()(0,0,1), 8);
-  BOOST_CHECK_EQUAL(f2.function<0>()(0,1,0), 8);
-  BOOST_CHECK_EQUAL(f2.function<0>()(0,1,1), 8);
-  BOOST_CHECK_EQUAL(f2.function<0>()(1,0,0), 4);
-  BOOST_CHECK_EQUAL(f2.function<0>()(1,0,1), 5);
-  BOOST_CHECK_EQUAL(f2.function<0>()(1,1,0), 5);
-  BOOST_CHECK_EQUAL(f2.function<0>()(1,1,1), 6);
+  BOOST_CHECK_EQUAL(f2.function<3>()(0,0,0), 7);
+  BOOST_CHECK_EQUAL(f2.function<3>()(0,0,1), 8);
+  BOOST_CHECK_EQUAL(f2.function<3>()(0,1,0), 8);
+  BOOST_CHECK_EQUAL(f2.function<3>()(0,1,1), 8);
+  BOOST_CHECK_EQUAL(f2.function<3>()(1,0,0), 4);
+  BOOST_CHECK_EQUAL(f2.function<3>()(1,0,1), 5);
+  BOOST_CHECK_EQUAL(f2.function<3>()(1,1,0), 5);
+  BOOST_CHECK_EQUAL(f2.function<3>()(1,1,1), 6);
 
   // detection factor
   det_var = mrf.get_node_map().find(n4)->second;
@@ -354,3 +357,51 @@ BOOST_AUTO_TEST_CASE( HypothesesGraph_build_hyp_mrf ) {
     prune_inactive(*graph);
 
 }
+
+BOOST_AUTO_TEST_CASE( Chaingraph_solver_backends ) {
+  // two objects moving in parallel; every backend has to find the same tracks
+  TraxelStore ts;
+  for (int t = 0; t < 3; ++t) {
+    for (int i = 0; i < 2; ++i) {
+      Traxel tr;
+      feature_array com(feature_array::difference_type(3));
+      com[0] = 10 * i + t;
+      com[1] = 0;
+      com[2] = 0;
+      tr.features["com"] = com;
+      tr.Id = 10 * t + i;
+      tr.Timestep = t;
+      add(ts, tr);
+    }
+  }
+  SingleTimestepTraxel_HypothesesBuilder builder(&ts);
+  boost::shared_ptr<HypothesesGraph> graph(builder.build());
+
+  pgm::chaingraph::ECCV12ModelBuilder b;
+  b.with_detection_vars(ConstantFeature(10), ConstantFeature(200))
+    .appearance(ConstantFeature(500))
+    .disappearance(ConstantFeature(500))
+    .move(SquaredDistance())
+    .with_divisions(ConstantFeature(1000));
+
+  const vector<string> names = lp::available_solvers();
+  for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+    Chaingraph mrf(b, true, 0., false, 1e75, *it);
+    BOOST_CHECK_EQUAL(mrf.solver_backend(), *it);
+    mrf.formulate(*graph);
+    mrf.infer();
+    mrf.conclude(*graph);
+
+    property_map<arc_active, HypothesesGraph::base_graph>::type& active_arcs = graph->get(arc_active());
+    property_map<node_traxel, HypothesesGraph::base_graph>::type& traxels = graph->get(node_traxel());
+    size_t n_active = 0;
+    for (HypothesesGraph::ArcIt a(*graph); a != lemon::INVALID; ++a) {
+      if (active_arcs[a]) {
+        ++n_active;
+        // links only between objects of the same track
+        BOOST_CHECK_EQUAL(traxels[graph->source(a)].Id % 10, traxels[graph->target(a)].Id % 10);
+      }
+    }
+    BOOST_CHECK_EQUAL(n_active, 4u);
+  }
+}
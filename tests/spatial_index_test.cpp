@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE spatial_index_test
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "pgmlink/spatial_index.h"
+
+using namespace pgmlink;
+using namespace std;
+
+namespace {
+typedef SpatialIndex::Neighbor Neighbor;
+
+bool closer(const Neighbor& a, const Neighbor& b) {
+  return a.second < b.second || (a.second == b.second && a.first < b.first);
+}
+
+// exhaustive reference for KdTree::knn_in_range
+vector<Neighbor> brute_force(const vector<double>& coordinates, const vector<unsigned int>& ids,
+                             const double query[3], double radius, size_t k) {
+  vector<Neighbor> in_range;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    double d = 0;
+    for (size_t j = 0; j < 3; ++j) {
+      d += (coordinates[3 * i + j] - query[j]) * (coordinates[3 * i + j] - query[j]);
+    }
+    if (d <= radius * radius) {
+      in_range.push_back(Neighbor(ids[i], d));
+    }
+  }
+  sort(in_range.begin(), in_range.end(), closer);
+  if (in_range.size() > k) {
+    in_range.resize(k);
+  }
+  return in_range;
+}
+}
+
+BOOST_AUTO_TEST_CASE( KdTree_matches_brute_force ) {
+  srand(42);
+  vector<double> coordinates;
+  vector<unsigned int> ids;
+  for (unsigned int i = 0; i < 500; ++i) {
+    // integer coordinates on a small grid produce many ties
+    for (size_t j = 0; j < 3; ++j) {
+      coordinates.push_back(rand() % 20);
+    }
+    ids.push_back(1000 + i);
+  }
+  KdTree tree(coordinates, ids);
+  SpatialHashGrid grid(coordinates, ids, 2.5);
+  const SpatialIndex* indices[] = { &tree, &grid };
+  BOOST_CHECK_EQUAL(tree.size(), 500u);
+  BOOST_CHECK_EQUAL(grid.size(), 500u);
+
+  const size_t k = 6;
+  vector<Neighbor> neighbors(k);
+  for (size_t q = 0; q < 200; ++q) {
+    double query[3] = { rand() % 200 / 10. - 1, rand() % 200 / 10., rand() % 200 / 10. };
+    // radii below, at and above the grid cell size
+    double radius = rand() % 50 / 10.;
+    vector<Neighbor> expected = brute_force(coordinates, ids, query, radius, k);
+    size_t expected_count = brute_force(coordinates, ids, query, radius, ids.size()).size();
+    for (size_t j = 0; j < 2; ++j) {
+      size_t found = indices[j]->knn_in_range(query, radius, k, &neighbors[0]);
+      BOOST_REQUIRE_EQUAL(found, expected.size());
+      for (size_t i = 0; i < found; ++i) {
+        BOOST_CHECK_EQUAL(neighbors[i].first, expected[i].first);
+        BOOST_CHECK_EQUAL(neighbors[i].second, expected[i].second);
+      }
+      BOOST_CHECK_EQUAL(indices[j]->count_in_range(query, radius), expected_count);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Spatial_index_choice ) {
+  // 2d, one point per unit square
+  vector<double> dense;
+  vector<unsigned int> ids;
+  for (unsigned int i = 0; i < 100; ++i) {
+    dense.push_back(i % 10);
+    dense.push_back(i / 10);
+    dense.push_back(0);
+    ids.push_back(i);
+  }
+  BOOST_CHECK(prefer_grid_index(dense, 1.));
+  BOOST_CHECK(!prefer_grid_index(dense, 0.1));
+  BOOST_CHECK(!prefer_grid_index(vector<double>(dense.begin(), dense.begin() + 30), 1.));
+
+  boost::shared_ptr<const SpatialIndex> index = make_spatial_index(dense, ids, 1.);
+  BOOST_CHECK(dynamic_cast<const SpatialHashGrid*>(index.get()) != NULL);
+  index = make_spatial_index(dense, ids, 1., index_kd_tree);
+  BOOST_CHECK(dynamic_cast<const KdTree*>(index.get()) != NULL);
+  const double query[3] = { 5, 5, 0 };
+  BOOST_CHECK_EQUAL(index->count_in_range(query, 1.), 5u);
+  BOOST_CHECK_THROW(SpatialHashGrid(dense, ids, 0.), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE( KdTree_batch_query ) {
+  double points[] = { 0,0,0, 1,0,0, 0,2,0, 5,5,5 };
+  unsigned int point_ids[] = { 1, 2, 3, 4 };
+  KdTree tree(vector<double>(points, points + 12), vector<unsigned int>(point_ids, point_ids + 4));
+
+  double queries[] = { 0,0,0, 5,5,6, 100,100,100 };
+  const size_t k = 2;
+  Neighbor neighbors[3 * k];
+  size_t counts[3];
+  tree.knn_in_range(queries, 3, 2., k, neighbors, counts);
+
+  BOOST_CHECK_EQUAL(counts[0], 2u);
+  BOOST_CHECK_EQUAL(neighbors[0].first, 1u);
+  BOOST_CHECK_EQUAL(neighbors[0].second, 0.);
+  BOOST_CHECK_EQUAL(neighbors[1].first, 2u);
+  BOOST_CHECK_EQUAL(neighbors[1].second, 1.);
+  BOOST_CHECK_EQUAL(counts[1], 1u);
+  BOOST_CHECK_EQUAL(neighbors[k].first, 4u);
+  BOOST_CHECK_EQUAL(counts[2], 0u);
+
+  // the point at exactly the radius is in range
+  BOOST_CHECK_EQUAL(tree.count_in_range(queries, 2.), 3u);
+  BOOST_CHECK_EQUAL(KdTree().count_in_range(queries, 2.), 0u);
+  BOOST_CHECK_THROW(tree.count_in_range(queries, -1.), std::invalid_argument);
+}
+
+// EOF
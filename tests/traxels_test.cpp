@@ -328,5 +328,63 @@ BOOST_AUTO_TEST_CASE( global_fun_filter_by_fov )
   BOOST_CHECK_EQUAL(ts_out.size(), 2);
   BOOST_CHECK_EQUAL(ts_out.get<by_timeid>().count(tuple<int, unsigned int>(2,1)), 1);
   BOOST_CHECK_EQUAL(ts_out.get<by_timeid>().count(tuple<int, unsigned int>(1,2)), 1);
+
+  // index view
+  vector<const Traxel*> view = filter_by_fov(ts, fov);
+  BOOST_CHECK_EQUAL(view.size(), 2);
+  for(vector<const Traxel*>::const_iterator it = view.begin(); it != view.end(); ++it) {
+    BOOST_CHECK((*it)->Id == 1 || (*it)->Id == 2);
+    BOOST_CHECK_EQUAL(ts.get<by_timeid>().count(tuple<int, unsigned int>((*it)->Timestep, (*it)->Id)), 1);
+  }
 }
+
+BOOST_AUTO_TEST_CASE( Traxel_cached_coordinates )
+{
+  Traxel t;
+  t.Id = 1;
+  t.Timestep = 0;
+  feature_array com(3);
+  com[0] = 1; com[1] = 2; com[2] = 3;
+  t.features["com"] = com;
+  BOOST_CHECK(!t.has_cached_coordinates());
+  BOOST_CHECK_EQUAL(t.X(), 1);
+
+  TraxelStore ts;
+  add(ts, t);
+  const Traxel& stored = *ts.begin();
+  BOOST_CHECK(stored.has_cached_coordinates());
+  BOOST_CHECK_EQUAL(stored.X(), 1);
+  BOOST_CHECK_EQUAL(stored.Y(), 2);
+  BOOST_CHECK_EQUAL(stored.Z(), 3);
+  BOOST_CHECK_EQUAL(stored.X_corr(), 1);
+
+  // copies keep the cache until it is updated
+  Traxel copy = stored;
+  copy.features["com"][0] = 10;
+  copy.features["com_corrected"] = com;
+  copy.features["com_corrected"][0] = 5;
+  BOOST_CHECK_EQUAL(copy.X(), 1);
+  copy.update_coordinates();
+  BOOST_CHECK_EQUAL(copy.X(), 10);
+  BOOST_CHECK_EQUAL(copy.X_corr(), 5);
+  BOOST_CHECK_EQUAL(copy.distance_to(stored), 9);
+
+  // set_feature() refreshes the cache
+  feature_array moved(copy.features["com"]);
+  moved[1] = 7;
+  copy.set_feature("com", moved);
+  BOOST_CHECK(copy.has_cached_coordinates());
+  BOOST_CHECK_EQUAL(copy.X(), 10);
+  BOOST_CHECK_EQUAL(copy.Y(), 7);
+
+  // the cache is rebuilt for a new locator and dropped without position features
+  copy.locator()->x_scale = 2;
+  copy.set_locator(copy.locator()->clone());
+  BOOST_CHECK_EQUAL(copy.X(), 20);
+  copy.features.clear();
+  copy.update_coordinates();
+  BOOST_CHECK(!copy.has_cached_coordinates());
+  BOOST_CHECK_THROW(copy.X(), std::invalid_argument);
+}
+
 // EOF